@@ -1,6 +1,8 @@
 #include "dependency_graph.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <ranges>
@@ -11,6 +13,7 @@
 
 struct DependencyGraph::Builder final : ConstInstructionVisitor {
   DependencyGraph &graph;
+  std::vector<const RamInstruction *> rams;
 
   explicit Builder(DependencyGraph &g) : graph(g) {}
 
@@ -30,6 +33,22 @@ struct DependencyGraph::Builder final : ConstInstructionVisitor {
   void visit_slice(const SliceInstruction &inst) override;
   void visit_rom(const RomInstruction &inst) override;
   void visit_ram(const RamInstruction &inst) override;
+  void visit_gather(const GatherInstruction &inst) override;
+  void visit_add(const AddInstruction &inst) override;
+  void visit_sub(const SubInstruction &inst) override;
+  void visit_eq(const EqInstruction &inst) override;
+  void visit_lt(const LtInstruction &inst) override;
+  void visit_mul(const MulInstruction &inst) override;
+  void visit_shl(const ShlInstruction &inst) override;
+  void visit_shr(const ShrInstruction &inst) override;
+  void visit_asr(const AsrInstruction &inst) override;
+  void visit_reduce_or(const ReduceOrInstruction &inst) override;
+  void visit_reduce_and(const ReduceAndInstruction &inst) override;
+  void visit_delay(const DelayInstruction &inst) override;
+  void visit_lut(const LutInstruction &inst) override;
+  void visit_memo(const MemoInstruction &inst) override;
+  void visit_lazy_mux(const LazyMuxInstruction &inst) override;
+  void visit_enabled_reg(const EnabledRegInstruction &inst) override;
 };
 
 void DependencyGraph::Builder::visit_load(const LoadInstruction &inst) {
@@ -85,6 +104,89 @@ void DependencyGraph::Builder::visit_xnor(const XnorInstruction &inst) {
   graph.add_dependency(inst.output, inst.rhs);
 }
 
+void DependencyGraph::Builder::visit_add(const AddInstruction &inst) {
+  graph.add_dependency(inst.output, inst.lhs);
+  graph.add_dependency(inst.output, inst.rhs);
+}
+
+void DependencyGraph::Builder::visit_sub(const SubInstruction &inst) {
+  graph.add_dependency(inst.output, inst.lhs);
+  graph.add_dependency(inst.output, inst.rhs);
+}
+
+void DependencyGraph::Builder::visit_eq(const EqInstruction &inst) {
+  graph.add_dependency(inst.output, inst.lhs);
+  graph.add_dependency(inst.output, inst.rhs);
+}
+
+void DependencyGraph::Builder::visit_lt(const LtInstruction &inst) {
+  graph.add_dependency(inst.output, inst.lhs);
+  graph.add_dependency(inst.output, inst.rhs);
+}
+
+void DependencyGraph::Builder::visit_mul(const MulInstruction &inst) {
+  graph.add_dependency(inst.output, inst.lhs);
+  graph.add_dependency(inst.output, inst.rhs);
+}
+
+void DependencyGraph::Builder::visit_shl(const ShlInstruction &inst) {
+  graph.add_dependency(inst.output, inst.lhs);
+  graph.add_dependency(inst.output, inst.rhs);
+}
+
+void DependencyGraph::Builder::visit_shr(const ShrInstruction &inst) {
+  graph.add_dependency(inst.output, inst.lhs);
+  graph.add_dependency(inst.output, inst.rhs);
+}
+
+void DependencyGraph::Builder::visit_asr(const AsrInstruction &inst) {
+  graph.add_dependency(inst.output, inst.lhs);
+  graph.add_dependency(inst.output, inst.rhs);
+}
+
+void DependencyGraph::Builder::visit_reduce_or(const ReduceOrInstruction &inst) {
+  graph.add_dependency(inst.output, inst.input);
+}
+
+void DependencyGraph::Builder::visit_reduce_and(const ReduceAndInstruction &inst) {
+  graph.add_dependency(inst.output, inst.input);
+}
+
+void DependencyGraph::Builder::visit_delay(const DelayInstruction &inst) {
+  // Like REG, the input is read from a previous cycle.
+}
+
+void DependencyGraph::Builder::visit_lut(const LutInstruction &inst) {
+  for (const auto &input : inst.inputs)
+    graph.add_dependency(inst.output, input);
+}
+
+void DependencyGraph::Builder::visit_memo(const MemoInstruction &inst) {
+  // The body is evaluated at once and only reads the inputs (or its own registers).
+  for (const auto &input : inst.inputs)
+    graph.add_dependency(inst.output, input);
+}
+
+void DependencyGraph::Builder::visit_lazy_mux(const LazyMuxInstruction &inst) {
+  // The operands computed by a body are not scheduled on their own.
+  graph.add_dependency(inst.output, inst.choice);
+  if (inst.first_body.empty())
+    graph.add_dependency(inst.output, inst.first);
+  if (inst.second_body.empty())
+    graph.add_dependency(inst.output, inst.second);
+  for (const auto &input : inst.body_inputs)
+    graph.add_dependency(inst.output, input);
+}
+
+void DependencyGraph::Builder::visit_enabled_reg(const EnabledRegInstruction &inst) {
+  // Unlike `REG`, the input is read in the same cycle.
+  graph.add_dependency(inst.output, inst.enable);
+  if (inst.body.empty())
+    graph.add_dependency(inst.output, inst.input);
+  for (const auto &input : inst.body_inputs)
+    graph.add_dependency(inst.output, input);
+}
+
 void DependencyGraph::Builder::visit_select(const SelectInstruction &inst) {
   graph.add_dependency(inst.output, inst.input);
 }
@@ -99,10 +201,14 @@ void DependencyGraph::Builder::visit_rom(const RomInstruction &inst) {
 
 void DependencyGraph::Builder::visit_ram(const RamInstruction &inst) {
   graph.add_dependency(inst.output, inst.read_addr);
-  // There is no dependencies to the other registers.
-  // graph.add_dependency(inst.output, inst.write_enable);
-  // graph.add_dependency(inst.output, inst.write_addr);
-  // graph.add_dependency(inst.output, inst.write_data);
+  // The write port may depend on the read value, so its dependencies are only
+  // added when they do not create a cycle (see add_memory_write_dependencies()).
+  rams.push_back(&inst);
+}
+
+void DependencyGraph::Builder::visit_gather(const GatherInstruction &inst) {
+  for (const auto &part : inst.parts)
+    graph.add_dependency(inst.output, part.input);
 }
 
 // ========================================================
@@ -121,10 +227,41 @@ DependencyGraph DependencyGraph::build(const std::shared_ptr<Program> &program)
 
   for (const auto &instruction : program->instructions)
     instruction->visit(builder);
+  graph.add_memory_write_dependencies(builder.rams);
 
   return builder.graph;
 }
 
+void DependencyGraph::add_memory_write_dependencies(const std::vector<const RamInstruction *> &rams) {
+  // The RAM writes the values its write port has when it is executed, so the
+  // written values must be computed before it (whatever the schedule) unless
+  // they depend on the read value.
+  for (const auto *ram : rams) {
+    for (const auto input : {ram->write_enable, ram->write_addr, ram->write_data}) {
+      if (!reaches(input, ram->output))
+        add_dependency(ram->output, input);
+    }
+  }
+}
+
+bool DependencyGraph::reaches(reg_t from, reg_t to) const {
+  std::vector<bool> is_visited(m_adjacency_list.size(), false);
+  std::vector<reg_t> stack = {from};
+  while (!stack.empty()) {
+    const auto reg = stack.back();
+    stack.pop_back();
+    if (reg == to)
+      return true;
+    if (is_visited[reg.index])
+      continue;
+
+    is_visited[reg.index] = true;
+    for (const auto dependency : m_adjacency_list[reg.index])
+      stack.push_back(dependency);
+  }
+  return false;
+}
+
 bool DependencyGraph::depends(reg_t from, reg_t to) const {
   auto &edges = m_adjacency_list[from.index];
   auto it = std::ranges::find(edges, to);
@@ -168,7 +305,7 @@ struct DFSVisitor {
   }
 };
 
-void DependencyGraph::schedule(ReportManager &report_manager) {
+void DependencyGraph::schedule(ReportManager &report_manager, ScheduleStrategy strategy) {
   // The output register corresponds to the "label" of the equation.
   // So we do a mapping from the output register and its corresponding instruction.
   // Because a register may be written to multiple times, there can be many
@@ -182,7 +319,9 @@ void DependencyGraph::schedule(ReportManager &report_manager) {
   new_order.reserve(m_program->instructions.size());
 
   // Reorder instructions using the topological sort.
-  for (auto reg : topological_sort(report_manager)) {
+  const auto order =
+      (strategy == ScheduleStrategy::LOCALITY) ? locality_sort(report_manager) : topological_sort(report_manager);
+  for (auto reg : order) {
     auto range = reg_instruction_mapping.equal_range(reg);
     for (auto it = range.first; it != range.second; ++it)
       new_order.push_back(it->second);
@@ -199,20 +338,21 @@ void DependencyGraph::dump_dot(std::ostream &out) {
   std::cout << "digraph DependencyGraph {\n";
 
   for (std::uint_least32_t from = 0; from < m_adjacency_list.size(); ++from) {
-    const auto &reg_info = m_program->registers[from];
+    const auto name = m_program->registers.get_name({from});
+    const auto flags = m_program->registers.get_flags({from});
 
     std::cout << "  _" << from << "[label=\""
               << "%" << from;
 
-    if (!reg_info.name.empty()) {
-      std::cout << " (aka '" << reg_info.name << "')";
+    if (!name.empty()) {
+      std::cout << " (aka '" << name << "')";
     }
 
-    if (reg_info.flags & RIF_INPUT) {
+    if (flags & RIF_INPUT) {
       std::cout << "\\nINPUT";
     }
 
-    if (reg_info.flags & RIF_OUTPUT) {
+    if (flags & RIF_OUTPUT) {
       std::cout << "\\nOUTPUT";
     }
 
@@ -240,9 +380,48 @@ std::vector<reg_t> DependencyGraph::topological_sort(ReportManager &report_manag
       report_manager, m_adjacency_list, std::vector(m_adjacency_list.size(), VertexState::NOT_VISITED), {}};
 
   for (std::uint_least32_t i = 0; i < m_program->registers.size(); ++i) {
-    const auto &reg_info = m_program->registers[i];
     visitor.visit({i});
   }
 
   return visitor.topological_sort;
 }
+
+std::vector<reg_t> DependencyGraph::locality_sort(ReportManager &report_manager) const {
+  // The labels below are computed in a topological order (this also reports
+  // the cycles).
+  const auto order = topological_sort(report_manager);
+
+  // The count of temporaries needed to compute each register. The operands
+  // are computed one after the other and the first results are kept while
+  // computing the next ones, so the most demanding operands come first.
+  std::vector<std::uint_least32_t> needs(m_adjacency_list.size(), 1);
+  std::vector<std::vector<reg_t>> sorted_adjacency_list(m_adjacency_list.size());
+  std::vector<bool> is_read(m_adjacency_list.size(), false);
+  for (const auto reg : order) {
+    auto &dependencies = sorted_adjacency_list[reg.index];
+    for (const auto dependency : m_adjacency_list[reg.index]) {
+      if (std::ranges::find(dependencies, dependency) == dependencies.end())
+        dependencies.push_back(dependency);
+    }
+
+    std::ranges::stable_sort(dependencies, std::greater<>(), [&needs](reg_t dependency) {
+      return needs[dependency.index];
+    });
+    for (std::uint_least32_t i = 0; i < dependencies.size(); ++i) {
+      needs[reg.index] = std::max(needs[reg.index], needs[dependencies[i].index] + i);
+      is_read[dependencies[i].index] = true;
+    }
+  }
+
+  DFSVisitor visitor = {
+      report_manager, sorted_adjacency_list, std::vector(m_adjacency_list.size(), VertexState::NOT_VISITED), {}};
+
+  // Starting from the registers that are not read by another instruction
+  // avoids computing a value long before its first use.
+  for (std::uint_least32_t i = 0; i < m_program->registers.size(); ++i) {
+    if (!is_read[i])
+      visitor.visit({i});
+  }
+
+  return visitor.topological_sort;
+}
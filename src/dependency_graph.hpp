@@ -4,6 +4,20 @@
 #include "program.hpp"
 #include "report.hpp"
 
+/// The heuristic used by DependencyGraph::schedule() to choose one of the
+/// valid instruction orders.
+enum class ScheduleStrategy {
+  /// The postorder of a depth-first search started from each register in
+  /// index order.
+  DFS,
+  /// The postorder of a depth-first search started from the registers that
+  /// nothing reads, where the operand needing the most temporaries is
+  /// computed first (like the Sethi-Ullman labeling). The values computed
+  /// for an instruction stay live for a shorter time, so they are more likely
+  /// to still be in the cache when read.
+  LOCALITY,
+};
+
 // ========================================================
 // class DependencyGraph
 // ========================================================
@@ -29,7 +43,7 @@ public:
 
   /// Reorder the instructions of the graph's program so all all dependencies
   /// are respected. This function corresponds to the first questions of the Tutorial.
-  void schedule(ReportManager& report_manager);
+  void schedule(ReportManager& report_manager, ScheduleStrategy strategy = ScheduleStrategy::DFS);
 
   /// Same as dump_dot(std::ostream&) with the std::cout argument.
   void dump_dot();
@@ -42,10 +56,17 @@ private:
 
   /// Adds a dependency between two registers.
   void add_dependency(reg_t from, reg_t to);
+  /// Makes the given RAMs depend on their write port, when it does not depend on them.
+  void add_memory_write_dependencies(const std::vector<const RamInstruction *> &rams);
+  /// Returns true if \a from depends on \a to, directly or not.
+  [[nodiscard]] bool reaches(reg_t from, reg_t to) const;
 
   /// Computes a topological sort of the dependency graph. The topological sort
   /// is computed using a DFS.
   [[nodiscard]] std::vector<reg_t> topological_sort(ReportManager& report_manager) const;
+  /// Computes a topological sort of the dependency graph that keeps the values
+  /// live for a short time, see ScheduleStrategy::LOCALITY.
+  [[nodiscard]] std::vector<reg_t> locality_sort(ReportManager& report_manager) const;
 
 private:
   struct Builder;
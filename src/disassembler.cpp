@@ -21,7 +21,7 @@ struct DisassemblerVisitor final : ConstInstructionVisitor {
 
   void visit_const(const ConstInstruction &inst) override {
     const auto output = context->get_register_name(inst.output);
-    const auto bus_size = context->registers[inst.output.index].bus_size;
+    const auto bus_size = context->registers.get_bus_size(inst.output);
     out << fmt::format("{} = {:0{}b}", output, inst.value, bus_size);
   }
 
@@ -70,6 +70,103 @@ struct DisassemblerVisitor final : ConstInstructionVisitor {
 
   void visit_xnor(const XnorInstruction &inst) override { print_binary_instruction("XNOR", inst); }
 
+  void visit_add(const AddInstruction &inst) override { print_binary_instruction("ADD", inst); }
+
+  void visit_sub(const SubInstruction &inst) override { print_binary_instruction("SUB", inst); }
+
+  void visit_eq(const EqInstruction &inst) override { print_binary_instruction("EQ", inst); }
+
+  void visit_lt(const LtInstruction &inst) override { print_binary_instruction("LT", inst); }
+
+  void visit_mul(const MulInstruction &inst) override { print_binary_instruction("MUL", inst); }
+
+  void visit_shl(const ShlInstruction &inst) override { print_binary_instruction("SHL", inst); }
+
+  void visit_shr(const ShrInstruction &inst) override { print_binary_instruction("SHR", inst); }
+
+  void visit_asr(const AsrInstruction &inst) override { print_binary_instruction("ASR", inst); }
+
+  void visit_reduce_or(const ReduceOrInstruction &inst) override {
+    const auto output = context->get_register_name(inst.output);
+    const auto input = context->get_register_name(inst.input);
+    out << fmt::format("{} = REDOR {}", output, input);
+  }
+
+  void visit_reduce_and(const ReduceAndInstruction &inst) override {
+    const auto output = context->get_register_name(inst.output);
+    const auto input = context->get_register_name(inst.input);
+    out << fmt::format("{} = REDAND {}", output, input);
+  }
+
+  void visit_delay(const DelayInstruction &inst) override {
+    // There is no DELAY instruction in the Netlist language, so this is not parseable.
+    const auto output = context->get_register_name(inst.output);
+    const auto input = context->get_register_name(inst.input);
+    out << fmt::format("{} = DELAY {} {}", output, inst.depth, input);
+  }
+
+  void visit_lut(const LutInstruction &inst) override {
+    // There is no LUT instruction in the Netlist language, so this is not
+    // parseable. The inputs are followed by the packed words of the table.
+    const auto output = context->get_register_name(inst.output);
+    out << fmt::format("{} = LUT", output);
+    for (const auto &input : inst.inputs)
+      out << fmt::format(" {}", context->get_register_name(input));
+    out << " [";
+    for (std::size_t i = 0; i < inst.table.size(); ++i)
+      out << (i == 0 ? "" : ", ") << fmt::format("{:#x}", inst.table[i]);
+    out << "]";
+  }
+
+  void visit_memo(const MemoInstruction &inst) override {
+    // There is no MEMO instruction in the Netlist language, so this is not
+    // parseable. The body instructions are printed between braces.
+    const auto output = context->get_register_name(inst.output);
+    out << fmt::format("{} = MEMO", output);
+    for (const auto &input : inst.inputs)
+      out << fmt::format(" {}", context->get_register_name(input));
+    out << " {";
+    for (std::size_t i = 0; i < inst.body.size(); ++i) {
+      out << (i == 0 ? " " : "; ");
+      inst.body[i]->visit(*this);
+    }
+    out << " }";
+  }
+
+  void visit_lazy_mux(const LazyMuxInstruction &inst) override {
+    // Not parseable either, the two bodies are printed like the MEMO one.
+    const auto output = context->get_register_name(inst.output);
+    const auto choice = context->get_register_name(inst.choice);
+    const auto first = context->get_register_name(inst.first);
+    const auto second = context->get_register_name(inst.second);
+    out << fmt::format("{} = LAZYMUX {} {} {}", output, choice, first, second);
+    for (const auto *body : {&inst.first_body, &inst.second_body}) {
+      out << " {";
+      for (std::size_t i = 0; i < body->size(); ++i) {
+        out << (i == 0 ? " " : "; ");
+        (*body)[i]->visit(*this);
+      }
+      out << " }";
+    }
+  }
+
+  void visit_enabled_reg(const EnabledRegInstruction &inst) override {
+    // Not parseable either, the body is printed like the MEMO one.
+    const auto output = context->get_register_name(inst.output);
+    const auto enable = context->get_register_name(inst.enable);
+    const auto input = context->get_register_name(inst.input);
+    out << fmt::format("{} = REGEN {} {}", output, enable, input);
+    if (inst.body.empty())
+      return;
+
+    out << " {";
+    for (std::size_t i = 0; i < inst.body.size(); ++i) {
+      out << (i == 0 ? " " : "; ");
+      inst.body[i]->visit(*this);
+    }
+    out << " }";
+  }
+
   void visit_select(const SelectInstruction &inst) override {
     const auto output = context->get_register_name(inst.output);
     const auto input = context->get_register_name(inst.input);
@@ -99,6 +196,17 @@ struct DisassemblerVisitor final : ConstInstructionVisitor {
     out << fmt::format("{} = RAM {} {} {} {} {} {}", output, memory_info.addr_size, memory_info.word_size, read_addr,
                        write_enable, write_addr, write_data);
   }
+
+  void visit_gather(const GatherInstruction &inst) override {
+    // There is no GATHER instruction in the Netlist language, so this is not
+    // parseable. Each part is printed as `input[extract_mask -> deposit_mask]`.
+    const auto output = context->get_register_name(inst.output);
+    out << fmt::format("{} = GATHER {:#x}", output, inst.constant);
+    for (const auto &part : inst.parts) {
+      const auto input = context->get_register_name(part.input);
+      out << fmt::format(" {}[{:#x} -> {:#x}]", input, part.extract_mask, part.deposit_mask);
+    }
+  }
 };
 
 // ========================================================
@@ -145,12 +253,11 @@ void Disassembler::disassemble(const std::shared_ptr<Program> &program, std::ost
   out << "\n";
 
   out << "VAR ";
-  std::uint_least32_t i = 0;
-  for (auto it = program->registers.begin(); it != program->registers.end(); it++) {
-    if (it != program->registers.begin())
+  for (reg_index_t i = 0; i < program->registers.size(); ++i) {
+    if (i != 0)
       out << ", ";
-    out << program->get_register_name({i++});
-    out << ":" << it->bus_size;
+    out << program->get_register_name({i});
+    out << ":" << program->registers.get_bus_size({i});
   }
   out << "\n";
 
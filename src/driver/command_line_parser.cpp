@@ -1,4 +1,5 @@
 #include "command_line_parser.hpp"
+#include "passes/lut_mapping.hpp"
 #include "version.hpp"
 
 #include <cassert>
@@ -79,16 +80,119 @@ int CommandLineParser::parse_option(std::string_view option, int index) {
 
     m_options.backend = argument;
     return 1; // one argument
+  } else if (option == "--observe") {
+    std::string_view argument = get_argument(option, index);
+
+    while (true) {
+      const auto comma = argument.find(',');
+      const auto name = argument.substr(0, comma);
+      if (name.empty()) {
+        m_report_manager.report(ReportSeverity::ERROR)
+            .with_message("invalid argument to `{}', expected a comma-separated list of outputs", option)
+            .finish()
+            .exit();
+      }
+
+      m_options.observed_outputs.push_back(name);
+      if (comma == std::string_view::npos)
+        break;
+      argument.remove_prefix(comma + 1);
+    }
+
+    return 1; // one argument
+  } else if (option == "--fix-input") {
+    const std::string_view argument = get_argument(option, index);
+
+    // The value is given in binary, like the inputs queried during the simulation.
+    const auto equal = argument.find('=');
+    if (equal == 0 || equal == std::string_view::npos || equal + 1 == argument.size()) {
+      m_report_manager.report(ReportSeverity::ERROR)
+          .with_message("invalid argument to `{}', expected `name=value'", option)
+          .finish()
+          .exit();
+    }
+
+    reg_value_t value = 0;
+    const auto *value_begin = argument.data() + equal + 1;
+    const auto *value_end = argument.data() + argument.size();
+
+    const auto result = std::from_chars(value_begin, value_end, value, 2);
+    if (result.ec != std::errc() || result.ptr != value_end) {
+      m_report_manager.report(ReportSeverity::ERROR)
+          .with_message("invalid argument to `{}', expected a binary constant as value", option)
+          .finish()
+          .exit();
+    }
+
+    m_options.fixed_inputs.emplace_back(argument.substr(0, equal), value);
+    return 1; // one argument
+  } else if (option == "--lut-size") {
+    const std::string_view argument = get_argument(option, index);
+    unsigned value = 0;
+    const auto result = std::from_chars(argument.data(), argument.data() + argument.size(), value);
+    if (result.ec != std::errc() || result.ptr != argument.data() + argument.size() || value == 0 ||
+        value > LutMappingPass::MAX_INPUT_BITS) {
+      m_report_manager.report(ReportSeverity::ERROR)
+          .with_message("invalid argument to `{}', expected an integer between 1 and {}", option,
+                        LutMappingPass::MAX_INPUT_BITS)
+          .finish()
+          .exit();
+    }
+
+    m_options.lut_size = value;
+    return 1; // one argument
+  } else if (option == "-j" || option == "--jobs") {
+    const std::string_view argument = get_argument(option, index);
+    unsigned value = 0;
+    const auto result = std::from_chars(argument.data(), argument.data() + argument.size(), value);
+    if (result.ec != std::errc() || result.ptr != argument.data() + argument.size() || value == 0) {
+      m_report_manager.report(ReportSeverity::ERROR)
+          .with_message("invalid argument to `{}', expected a positive integer", option)
+          .finish()
+          .exit();
+    }
+
+    m_options.jobs = value;
+    return 1; // one argument
+  } else if (option == "--schedule-strategy") {
+    const std::string_view argument = get_argument(option, index);
+
+    if (argument == "dfs") {
+      m_options.schedule_strategy = ScheduleStrategy::DFS;
+    } else if (argument == "locality") {
+      m_options.schedule_strategy = ScheduleStrategy::LOCALITY;
+    } else {
+      m_report_manager.report(ReportSeverity::ERROR)
+          .with_message("invalid argument to `{}', expected `dfs' or `locality'", option)
+          .finish()
+          .exit();
+    }
+
+    return 1; // one argument
+  } else if (option == "--memoize") {
+    m_options.memoize = true;
+  } else if (option == "--memo-stats") {
+    m_options.memo_statistics = true;
+  } else if (option == "--lazy-mux") {
+    m_options.lazy_mux = true;
+  } else if (option == "--pack-bits") {
+    m_options.pack_bits = true;
+  } else if (option == "--strip-names") {
+    m_options.strip_names = true;
   } else if (option == "--syntax-only") {
     m_options.syntax_only = true;
   } else if (option == "--dep-graph") {
     m_options.dependency_graph = true;
   } else if (option == "--schedule") {
     m_options.schedule = true;
+  } else if (option == "--dump-lowered") {
+    m_options.dump_lowered = true;
   } else if (option == "--timeit") {
     m_options.timeit = true;
   } else if (option == "--fast") {
     m_options.fast = true;
+  } else if (option == "-O0" || option == "-O1" || option == "-O2" || option == "-O3") {
+    m_options.optimization_level = option[2] - '0';
   } else {
     m_report_manager.report(ReportSeverity::ERROR).with_message("unknown option `{}'", option).finish().print();
     print_help();
@@ -125,11 +229,23 @@ void CommandLineParser::print_help() const {
   print_help_line("-h, --help", "Show this message.");
   print_help_line("-v, --version", "Show the version of the program.");
   print_help_line("-n, --cycles", "The count of cycles to simulate the program.");
+  print_help_line("-j, --jobs N", "The count of threads parsing the input file (default is one per hardware thread).");
   print_help_line("--syntax-only", "Only parses the input file, no scheduling or simulation is done.");
   print_help_line("--dep-graph", "Outputs the dependency graph of the program in Graphviz DOT format.");
   print_help_line("--schedule", "Outputs the scheduled program.");
+  print_help_line("--dump-lowered", "Outputs the lowered program simulated by the backends.");
+  print_help_line("--schedule-strategy S", "The instruction order, `dfs' (default) or `locality' to use the cache better.");
   print_help_line("--timeit", "Outputs the simulation measured time.");
   print_help_line("--fast", "Enables fast mode when there is no inputs.");
+  print_help_line("-O0, ..., -O3", "The optimization level (default is -O0, no optimizations).");
+  print_help_line("--observe out1,out2", "Only simulates the logic needed to compute the given outputs.");
+  print_help_line("--fix-input name=value", "Fixes an input to a binary value and specializes the program for it.");
+  print_help_line("--lut-size K", "Replaces combinational cones of at most K input bits by lookup tables.");
+  print_help_line("--memoize", "Caches the results of large combinational cones during the simulation.");
+  print_help_line("--memo-stats", "Outputs the cache hits and misses of each memoized cone after the simulation.");
+  print_help_line("--lazy-mux", "Only evaluates the logic feeding the selected operand of multiplexers.");
+  print_help_line("--pack-bits", "Stores the single bit registers 64 per word to reduce the memory used.");
+  print_help_line("--strip-names", "Forgets the names of the registers that are neither inputs nor outputs.");
   fmt::println("");
   fmt::println("List of backends:");
   print_help_line("interpreter", "The classical interpreter backend, slow but the more complete.");
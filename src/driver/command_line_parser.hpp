@@ -1,17 +1,41 @@
 #ifndef NETLIST_SRC_DRIVER_COMMAND_LINE_PARSER_HPP
 #define NETLIST_SRC_DRIVER_COMMAND_LINE_PARSER_HPP
 
+#include "dependency_graph.hpp"
+#include "program.hpp"
 #include "report.hpp"
 
+#include <utility>
+#include <vector>
+
 struct CommandLineOptions {
   std::string_view input_file;
   std::string_view backend = "interpreter";
   bool syntax_only = false;
   bool dependency_graph = false;
   bool schedule = false;
+  bool dump_lowered = false;
   bool timeit = false;
   bool fast = false;
   size_t cycles = 0;
+  unsigned optimization_level = 0;
+  /// The maximal count of input bits of the lookup tables passed to `--lut-size`, zero if disabled.
+  unsigned lut_size = 0;
+  bool memoize = false;
+  bool memo_statistics = false;
+  bool lazy_mux = false;
+  /// Stores the single bit registers 64 per word in the simulator.
+  bool pack_bits = false;
+  /// The count of threads passed to `--jobs`, zero to use all the hardware threads.
+  unsigned jobs = 0;
+  /// Only keeps the names of the inputs and outputs in memory.
+  bool strip_names = false;
+  /// The heuristic passed to `--schedule-strategy`.
+  ScheduleStrategy schedule_strategy = ScheduleStrategy::DFS;
+  /// The outputs passed to `--observe`, if empty all outputs are observed.
+  std::vector<std::string_view> observed_outputs;
+  /// The inputs (and their value) passed to `--fix-input`.
+  std::vector<std::pair<std::string_view, reg_value_t>> fixed_inputs;
 };
 
 class CommandLineParser {
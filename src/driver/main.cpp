@@ -3,35 +3,70 @@
 #include "driver/command_line_parser.hpp"
 #include "lexer.hpp"
 #include "parser.hpp"
+#include "passes/input_specialization.hpp"
+#include "passes/lazy_mux.hpp"
+#include "passes/lut_mapping.hpp"
+#include "passes/memoization.hpp"
+#include "passes/output_cone.hpp"
+#include "passes/pass.hpp"
+#include "passes/register_allocation.hpp"
+#include "passes/register_renumbering.hpp"
 #include "simulator/simulator.hpp"
+#include "source_file.hpp"
 
+#include <algorithm>
 #include <charconv>
 #include <chrono>
-#include <fstream>
 #include <iostream>
+#include <thread>
 
-[[nodiscard]] std::string read_file(ReportManager &report_manager, std::string_view path) {
-  // From https://stackoverflow.com/a/116220/8959979
+[[nodiscard]] SourceFile read_file(ReportManager &report_manager, std::string_view path) {
+  auto file = SourceFile::open(path);
+  if (!file.has_value())
+    report_manager.report(ReportSeverity::ERROR).with_message("failed to read file `{}'", path).finish().exit();
+  return std::move(*file);
+}
 
-  try {
-    constexpr auto read_size = std::size_t(4096);
-    auto stream = std::ifstream(path.data());
-    stream.exceptions(std::ios_base::badbit);
+[[nodiscard]] static std::vector<reg_t> find_observed_outputs(ReportManager &report_manager, const Program &program,
+                                                              const std::vector<std::string_view> &names) {
+  std::vector<reg_t> outputs;
+  for (const auto name : names) {
+    const auto reg = program.find_register(name);
+    if (!reg.has_value() || !(program.registers.get_flags(*reg) & RIF_OUTPUT)) {
+      report_manager.report(ReportSeverity::ERROR)
+          .with_message("`{}' is not an output of the program", name)
+          .finish()
+          .exit();
+    }
 
-    if (!stream)
-      throw std::ios_base::failure("file does not exist");
+    outputs.push_back(reg.value());
+  }
+  return outputs;
+}
 
-    auto out = std::string();
-    auto buf = std::string(read_size, '\0');
-    while (stream.read(&buf[0], read_size)) {
-      out.append(buf, 0, stream.gcount());
+[[nodiscard]] static InputAssignment
+find_fixed_inputs(ReportManager &report_manager, const Program &program,
+                  const std::vector<std::pair<std::string_view, reg_value_t>> &fixed_inputs) {
+  InputAssignment assignment;
+  for (const auto &[name, value] : fixed_inputs) {
+    const auto reg = program.find_register(name);
+    if (!reg.has_value() || !(program.registers.get_flags(*reg) & RIF_INPUT)) {
+      report_manager.report(ReportSeverity::ERROR)
+          .with_message("`{}' is not an input of the program", name)
+          .finish()
+          .exit();
     }
-    out.append(buf, 0, stream.gcount());
-    return out;
-  } catch (const std::exception &) {
-    report_manager.report(ReportSeverity::ERROR).with_message("failed to read file `{}'", path).finish().exit();
-    return {}; // unreachable
+
+    if (std::ranges::find(assignment, reg.value(), &InputAssignment::value_type::first) != assignment.end()) {
+      report_manager.report(ReportSeverity::ERROR)
+          .with_message("the input `{}' is fixed more than once", name)
+          .finish()
+          .exit();
+    }
+
+    assignment.emplace_back(reg.value(), value);
   }
+  return assignment;
 }
 
 [[nodiscard]] std::string format_duration(const std::chrono::duration<double> &dur) {
@@ -78,7 +113,7 @@ static void print_program_outputs(const Simulator &simulator) {
     return;
 
   for (const auto output : program->get_outputs()) {
-    const auto bus_size = program->registers[output.index].bus_size;
+    const auto bus_size = program->registers.get_bus_size(output);
     fmt::println("=> {} = {:0{}b}", program->get_register_name(output), simulator.get_register(output), bus_size);
   }
 }
@@ -115,6 +150,16 @@ static void simulate_cycles_fast(ReportManager &report_manager, Simulator &simul
     fmt::println("The simulation took {}", format_duration(dur));
 }
 
+static void print_memo_statistics(const Simulator &simulator) {
+  const auto program = simulator.get_program();
+  for (const auto &statistics : simulator.get_backend()->get_memo_statistics()) {
+    const auto lookups = statistics.hits + statistics.misses;
+    const auto hit_rate = lookups == 0 ? 0.0 : 100.0 * static_cast<double>(statistics.hits) / lookups;
+    fmt::println("MEMO {}: {} hits, {} misses ({:.1f}% hit rate){}", program->get_register_name(statistics.output),
+                 statistics.hits, statistics.misses, hit_rate, statistics.is_disabled ? ", disabled" : "");
+  }
+}
+
 int main(int argc, const char *argv[]) {
   // I think that fmt::print() uses stdio.h internally but in some other parts
   // we use std::cout. So to be sure, we request synchronization.
@@ -124,35 +169,76 @@ int main(int argc, const char *argv[]) {
   CommandLineParser cmd_parser(report_manager, argc, argv);
   const auto options = cmd_parser.parse();
 
-  std::string source_code = read_file(report_manager, options.input_file);
-  report_manager.register_file_info(options.input_file, source_code);
+  // The lexer, the parser and the reports directly refer to the file content.
+  SourceFile source_file = read_file(report_manager, options.input_file);
+  report_manager.register_file_info(options.input_file, source_file);
 
-  Lexer lexer(report_manager, source_code.data());
+  Lexer lexer(report_manager, source_file);
   Parser parser(report_manager, lexer);
+  parser.set_thread_count(options.jobs != 0 ? options.jobs : std::thread::hardware_concurrency());
   std::shared_ptr<Program> program = parser.parse_program();
   assert(program != nullptr); // if we failed to parse the program then we should have exited before.
+  if (options.strip_names)
+    program->registers.strip_names();
 
   if (options.syntax_only)
     return EXIT_SUCCESS;
 
+  PassManager pass_manager;
+  if (!options.fixed_inputs.empty()) {
+    auto fixed_inputs = find_fixed_inputs(report_manager, *program, options.fixed_inputs);
+    pass_manager.add_pass(std::make_unique<InputSpecializationPass>(std::move(fixed_inputs)));
+  }
+  if (!options.observed_outputs.empty()) {
+    auto observed_outputs = find_observed_outputs(report_manager, *program, options.observed_outputs);
+    pass_manager.add_pass(std::make_unique<OutputConePass>(std::move(observed_outputs)));
+  }
+  pass_manager.add_default_passes(options.optimization_level);
+  if (options.lut_size != 0)
+    pass_manager.add_pass(std::make_unique<LutMappingPass>(options.lut_size));
+  if (options.memoize)
+    pass_manager.add_pass(std::make_unique<MemoizationPass>());
+  if (options.lazy_mux)
+    pass_manager.add_pass(std::make_unique<LazyMuxPass>());
+  pass_manager.run(program);
+
   DependencyGraph graph = DependencyGraph::build(program);
   if (options.dependency_graph) {
     graph.dump_dot();
     return EXIT_SUCCESS;
   }
 
-  graph.schedule(report_manager);
+  graph.schedule(report_manager, options.schedule_strategy);
+  if (options.optimization_level >= 2) {
+    // The temporaries never live at the same time share their storage.
+    RegisterAllocationPass allocation_pass;
+    allocation_pass.run(program);
+  }
+  if (options.optimization_level >= 1) {
+    // The memory layout of the registers follows the final instruction order.
+    RegisterRenumberingPass renumbering_pass;
+    renumbering_pass.run(program);
+  }
+
   if (options.schedule) {
     Disassembler::disassemble(program);
     return EXIT_SUCCESS;
   }
 
-  Simulator simulator(program);
+  if (options.dump_lowered) {
+    LoweredProgram::lower(*program, options.pack_bits).dump(std::cout);
+    return EXIT_SUCCESS;
+  }
+
+  Simulator simulator(program, options.pack_bits);
   if (options.fast) {
     simulate_cycles_fast(report_manager, simulator, options.cycles, options.timeit);
   } else {
     simulate_cycles(report_manager, simulator, options.cycles, options.timeit);
   }
 
+  if (options.memo_statistics)
+    print_memo_statistics(simulator);
+
   return EXIT_SUCCESS;
 }
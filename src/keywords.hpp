@@ -35,7 +35,7 @@
 #line 14 "src/keywords.def"
 struct KeywordInfo { const char* name; TokenKind token_kind; };
 #include <string.h>
-/* maximum key range = 46, duplicates = 0 */
+/* maximum key range = 33, duplicates = 0 */
 
 class KeywordHashTable
 {
@@ -50,32 +50,32 @@ KeywordHashTable::hash (const char *str, size_t len)
 {
   static const unsigned char asso_values[] =
     {
-      49, 49, 49, 49, 49, 49, 49, 49, 49, 49,
-      49, 49, 49, 49, 49, 49, 49, 49, 49, 49,
-      49, 49, 49, 49, 49, 49, 49, 49, 49, 49,
-      49, 49, 49, 49, 49, 49, 49, 49, 49, 49,
-      49, 49, 49, 49, 49, 49, 49, 49, 49, 49,
-      49, 49, 49, 49, 49, 49, 49, 49, 49, 49,
-      49, 49, 49, 49, 49, 25, 49,  0, 15,  0,
-      49,  0, 49,  0, 49, 49,  0, 10,  5, 15,
-       0, 49,  0,  0, 10,  0, 15, 49,  0, 49,
-      49, 49, 49, 49, 49, 49, 49, 49, 49, 49,
-      49, 49, 49, 49, 49, 49, 49, 49, 49, 49,
-      49, 49, 49, 49, 49, 49, 49, 49, 49, 49,
-      49, 49, 49, 49, 49, 49, 49, 49, 49, 49,
-      49, 49, 49, 49, 49, 49, 49, 49, 49, 49,
-      49, 49, 49, 49, 49, 49, 49, 49, 49, 49,
-      49, 49, 49, 49, 49, 49, 49, 49, 49, 49,
-      49, 49, 49, 49, 49, 49, 49, 49, 49, 49,
-      49, 49, 49, 49, 49, 49, 49, 49, 49, 49,
-      49, 49, 49, 49, 49, 49, 49, 49, 49, 49,
-      49, 49, 49, 49, 49, 49, 49, 49, 49, 49,
-      49, 49, 49, 49, 49, 49, 49, 49, 49, 49,
-      49, 49, 49, 49, 49, 49, 49, 49, 49, 49,
-      49, 49, 49, 49, 49, 49, 49, 49, 49, 49,
-      49, 49, 49, 49, 49, 49, 49, 49, 49, 49,
-      49, 49, 49, 49, 49, 49, 49, 49, 49, 49,
-      49, 49, 49, 49, 49, 49
+      35, 35, 35, 35, 35, 35, 35, 35, 35, 35,
+      35, 35, 35, 35, 35, 35, 35, 35, 35, 35,
+      35, 35, 35, 35, 35, 35, 35, 35, 35, 35,
+      35, 35, 35, 35, 35, 35, 35, 35, 35, 35,
+      35, 35, 35, 35, 35, 35, 35, 35, 35, 35,
+      35, 35, 35, 35, 35, 35, 35, 35, 35, 35,
+      35, 35, 35, 35, 35,  2,  6,  2,  8,  5,
+      35,  7,  3,  0, 35, 35, 12,  2,  0,  0,
+      12,  0,  7, 11, 17, 10,  3, 35,  1, 35,
+      35, 35, 35, 35, 35, 35, 35, 35, 35, 35,
+      35, 35, 35, 35, 35, 35, 35, 35, 35, 35,
+      35, 35, 35, 35, 35, 35, 35, 35, 35, 35,
+      35, 35, 35, 35, 35, 35, 35, 35, 35, 35,
+      35, 35, 35, 35, 35, 35, 35, 35, 35, 35,
+      35, 35, 35, 35, 35, 35, 35, 35, 35, 35,
+      35, 35, 35, 35, 35, 35, 35, 35, 35, 35,
+      35, 35, 35, 35, 35, 35, 35, 35, 35, 35,
+      35, 35, 35, 35, 35, 35, 35, 35, 35, 35,
+      35, 35, 35, 35, 35, 35, 35, 35, 35, 35,
+      35, 35, 35, 35, 35, 35, 35, 35, 35, 35,
+      35, 35, 35, 35, 35, 35, 35, 35, 35, 35,
+      35, 35, 35, 35, 35, 35, 35, 35, 35, 35,
+      35, 35, 35, 35, 35, 35, 35, 35, 35, 35,
+      35, 35, 35, 35, 35, 35, 35, 35, 35, 35,
+      35, 35, 35, 35, 35, 35, 35, 35, 35, 35,
+      35, 35, 35, 35, 35, 35
     };
   unsigned int hval = len;
 
@@ -99,66 +99,76 @@ KeywordHashTable::lookup (const char *str, size_t len)
 {
   enum
     {
-      TOTAL_KEYWORDS = 18,
+      TOTAL_KEYWORDS = 28,
       MIN_WORD_LENGTH = 2,
       MAX_WORD_LENGTH = 6,
-      MIN_HASH_VALUE = 3,
-      MAX_HASH_VALUE = 48
+      MIN_HASH_VALUE = 2,
+      MAX_HASH_VALUE = 34
     };
 
   static const struct KeywordInfo wordlist[] =
     {
-      {""}, {""}, {""},
-#line 28 "src/keywords.def"
-      {"REG",     TokenKind::KEY_REG},
-      {""},
-#line 31 "src/keywords.def"
-      {"SLICE",   TokenKind::KEY_SLICE},
-#line 30 "src/keywords.def"
-      {"SELECT",  TokenKind::KEY_SELECT},
+      {""}, {""},
 #line 19 "src/keywords.def"
       {"IN",      TokenKind::KEY_IN},
       {""}, {""},
-#line 17 "src/keywords.def"
-      {"INPUT",   TokenKind::KEY_INPUT},
-      {""}, {""},
-#line 27 "src/keywords.def"
-      {"MUX",     TokenKind::KEY_MUX},
-      {""}, {""}, {""},
-#line 23 "src/keywords.def"
-      {"OR",      TokenKind::KEY_OR},
-#line 25 "src/keywords.def"
-      {"XOR",     TokenKind::KEY_XOR},
-      {""}, {""}, {""}, {""},
-#line 24 "src/keywords.def"
-      {"NOR",     TokenKind::KEY_NOR},
 #line 26 "src/keywords.def"
       {"XNOR",    TokenKind::KEY_XNOR},
-      {""},
+#line 22 "src/keywords.def"
+      {"NAND",    TokenKind::KEY_NAND},
+#line 37 "src/keywords.def"
+      {"EQ",      TokenKind::KEY_EQ},
 #line 29 "src/keywords.def"
       {"CONCAT",  TokenKind::KEY_CONCAT},
-      {""},
+#line 23 "src/keywords.def"
+      {"OR",      TokenKind::KEY_OR},
+#line 24 "src/keywords.def"
+      {"NOR",     TokenKind::KEY_NOR},
+#line 25 "src/keywords.def"
+      {"XOR",     TokenKind::KEY_XOR},
 #line 32 "src/keywords.def"
       {"ROM",     TokenKind::KEY_ROM},
-      {""}, {""},
-#line 16 "src/keywords.def"
-      {"OUTPUT",  TokenKind::KEY_OUTPUT},
-      {""},
-#line 20 "src/keywords.def"
-      {"NOT",     TokenKind::KEY_NOT},
-      {""}, {""}, {""}, {""},
+#line 21 "src/keywords.def"
+      {"AND",     TokenKind::KEY_AND},
 #line 33 "src/keywords.def"
       {"RAM",     TokenKind::KEY_RAM},
-#line 22 "src/keywords.def"
-      {"NAND",    TokenKind::KEY_NAND},
-      {""}, {""}, {""},
 #line 18 "src/keywords.def"
       {"VAR",     TokenKind::KEY_VAR},
-      {""}, {""}, {""}, {""},
-#line 21 "src/keywords.def"
-      {"AND",     TokenKind::KEY_AND}
+#line 27 "src/keywords.def"
+      {"MUX",     TokenKind::KEY_MUX},
+#line 17 "src/keywords.def"
+      {"INPUT",   TokenKind::KEY_INPUT},
+      {""}, {""},
+#line 20 "src/keywords.def"
+      {"NOT",     TokenKind::KEY_NOT},
+#line 34 "src/keywords.def"
+      {"ADD",     TokenKind::KEY_ADD},
+#line 28 "src/keywords.def"
+      {"REG",     TokenKind::KEY_REG},
+#line 41 "src/keywords.def"
+      {"ASR",     TokenKind::KEY_ASR},
+#line 40 "src/keywords.def"
+      {"SHR",     TokenKind::KEY_SHR},
+#line 42 "src/keywords.def"
+      {"REDOR",   TokenKind::KEY_REDOR},
+#line 43 "src/keywords.def"
+      {"REDAND",  TokenKind::KEY_REDAND},
+#line 36 "src/keywords.def"
+      {"MUL",     TokenKind::KEY_MUL},
+#line 31 "src/keywords.def"
+      {"SLICE",   TokenKind::KEY_SLICE},
+#line 39 "src/keywords.def"
+      {"SHL",     TokenKind::KEY_SHL},
+#line 35 "src/keywords.def"
+      {"SUB",     TokenKind::KEY_SUB},
+#line 38 "src/keywords.def"
+      {"LT",      TokenKind::KEY_LT},
+      {""},
+#line 16 "src/keywords.def"
+      {"OUTPUT",  TokenKind::KEY_OUTPUT},
+#line 30 "src/keywords.def"
+      {"SELECT",  TokenKind::KEY_SELECT}
     };
-
   if (len <= MAX_WORD_LENGTH && len >= MIN_WORD_LENGTH)
     {
       unsigned int key = hash (str, len);
@@ -173,5 +183,5 @@ KeywordHashTable::lookup (const char *str, size_t len)
     }
   return 0;
 }
-#line 34 "src/keywords.def"
+#line 44 "src/keywords.def"
 
@@ -4,8 +4,21 @@
 
 #include <cassert>
 
-Lexer::Lexer(ReportManager &report_manager, const char *input)
-    : m_report_manager(report_manager), m_input(input), m_cursor(input) {
+Lexer::Lexer(ReportManager &report_manager, std::string_view input)
+    : m_report_manager(report_manager), m_input(input.data()), m_cursor(input.data()),
+      m_end(input.data() + input.size()), m_window_start(input.data()) {
+  assert(*m_end == '\0');
+}
+
+Lexer::Lexer(ReportManager &report_manager, SourceFile &source_file)
+    : Lexer(report_manager, source_file.get_content()) {
+  m_source_file = &source_file;
+}
+
+Lexer::Lexer(ReportManager &report_manager, const Lexer &lexer, std::uint64_t begin, std::uint64_t end)
+    : m_report_manager(report_manager), m_input(lexer.m_input), m_cursor(lexer.m_input + begin),
+      m_end(lexer.m_input + end), m_source_file(lexer.m_source_file), m_window_start(m_cursor) {
+  assert(begin <= end && lexer.m_input + end <= lexer.m_end);
 }
 
 /// Returns true if the given ASCII character is a whitespace.
@@ -22,33 +35,34 @@ Lexer::Lexer(ReportManager &report_manager, const char *input)
   }
 }
 
-/// Returns true if the given ASCII character is a valid first character for
-/// an identifier.
-[[nodiscard]] static inline bool is_start_ident(char ch) {
-  return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch == '_');
-}
-
-/// Returns true if the given ASCII character is a valid middle character for
-/// an identifier.
-[[nodiscard]] static inline bool is_cont_ident(char ch) {
-  return is_start_ident(ch) || is_digit(ch) || ch == '\'';
-}
-
 void Lexer::tokenize(Token &token) {
   // We use an infinite loop here to continue lexing when encountering an
   // unknown character (which we just ignore after emitting an error) or to
   // skip comments. Each successful token is directly returned inside the
   // loop.
   while (true) {
+    // The tokens already returned are not needed anymore (or are read again
+    // from the file), so the scanned part of the input can be dropped from
+    // memory. This is checked after each comment too, as they can be long.
+    if (m_source_file != nullptr && static_cast<std::size_t>(m_cursor - m_window_start) >= SourceFile::WINDOW_SIZE) {
+      m_source_file->discard(std::distance(m_input, m_window_start), std::distance(m_input, m_cursor));
+      m_window_start = m_cursor;
+    }
+
     skip_whitespace();
 
-    switch (*m_cursor) {
-    case '\0': // End-Of-Input reached!
+    // When only a range of the input is lexed, the whitespaces may be skipped
+    // past its end. A NUL character inside the input is an unknown character.
+    if (m_cursor >= m_end) {
+      // End-Of-Input reached!
+      m_cursor = m_end;
       token.kind = TokenKind::EOI;
       token.spelling = {};
       token.position = get_current_location();
       return;
+    }
 
+    switch (*m_cursor) {
     case '=':
       token.kind = TokenKind::EQUAL;
       token.spelling = std::string_view(m_cursor, /* count= */ 1);
@@ -83,15 +97,15 @@ void Lexer::tokenize(Token &token) {
         tokenize_integer(token);
         return;
       }
-
-      // Bad, we reached an unknown character.
-      m_report_manager.report(ReportSeverity::ERROR)
-          .with_location(get_current_location())
-          .with_message("unknown character found")
-          .finish()
-          .exit();
     }
     }
+
+    // Bad, we reached an unknown character.
+    m_report_manager.report(ReportSeverity::ERROR)
+        .with_location(get_current_location())
+        .with_message("unknown character found")
+        .finish()
+        .exit();
   }
 }
 
@@ -110,7 +124,7 @@ void Lexer::skip_comment() {
 
   // CR-LF line endings are also correctly recognized because of the second
   // byte LF.
-  while (*m_cursor != '\0' && *m_cursor != '\n') {
+  while (m_cursor < m_end && *m_cursor != '\n') {
     ++m_cursor;
   }
 }
@@ -2,6 +2,7 @@
 #define NETLIST_LEXER_HPP
 
 #include "report.hpp"
+#include "source_file.hpp"
 #include "token.hpp"
 
 /// \ingroup parser
@@ -13,7 +14,21 @@
 /// The Lexer is lazy, it only generates tokens as the user/parser request.
 class Lexer {
 public:
-  explicit Lexer(ReportManager &report_manager, const char *input);
+  /// \param input The source code, which must be followed by a NUL character
+  ///   (`input.data()[input.size()] == '\0'`), as a SourceFile content is.
+  explicit Lexer(ReportManager &report_manager, std::string_view input);
+  explicit Lexer(ReportManager &report_manager, const char *input)
+      : Lexer(report_manager, std::string_view(input)) {}
+  /// Lexes the content of \a source_file, only keeping the last
+  /// SourceFile::WINDOW_SIZE scanned bytes in memory (see SourceFile::discard()).
+  explicit Lexer(ReportManager &report_manager, SourceFile &source_file);
+  /// Lexes the bytes from \a begin to \a end of the input of \a lexer, which
+  /// must not be in the middle of a token. The locations are still relative to
+  /// the start of the input. This is used to parse parts of the input in parallel.
+  explicit Lexer(ReportManager &report_manager, const Lexer &lexer, std::uint64_t begin, std::uint64_t end);
+
+  /// Returns the whole input, even the bytes already scanned.
+  [[nodiscard]] std::string_view get_input() const { return {m_input, static_cast<std::size_t>(m_end - m_input)}; }
 
   /// Returns the next scanned token in the source code and advances the
   /// internal position of the lexer.
@@ -41,6 +56,12 @@ private:
   ReportManager &m_report_manager;
   const char *m_input = nullptr;
   const char *m_cursor = nullptr;
+  /// The end of the input, where the NUL sentinel is (unless only a range of the input is lexed).
+  const char *m_end = nullptr;
+  /// The source file of the input if it is lexed as a stream, or null.
+  SourceFile *m_source_file = nullptr;
+  /// The start of the input not yet discarded.
+  const char *m_window_start = nullptr;
 };
 
 #endif // NETLIST_LEXER_HPP
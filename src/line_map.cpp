@@ -1,44 +1,45 @@
 #include "line_map.hpp"
 
+#include <algorithm>
 #include <cassert>
 
-void LineMap::add_newline(uint32_t start_line_position) {
+void LineMap::add_newline(uint64_t start_line_position) {
   m_positions.push_back(start_line_position);
 }
 
-void LineMap::get_line_and_column_numbers(uint32_t position,
+void LineMap::get_line_and_column_numbers(uint64_t position,
                                           uint32_t &line_number,
                                           uint32_t &column_number) const {
   // Handle simple cases:
   if (m_positions.empty() || position < m_positions[0]) {
     line_number = 1;
-    column_number = position + 1;
+    column_number = static_cast<uint32_t>(position + 1);
     return;
   } else if (position >= m_positions.back()) {
     line_number = static_cast<uint32_t>(m_positions.size() + 1);
-    column_number = position - m_positions.back() + 1;
+    column_number = static_cast<uint32_t>(position - m_positions.back() + 1);
     return;
   }
 
   // General case (fallback to a binary search):
   const uint32_t upper_bound = search_rightmost(position);
   line_number = upper_bound + 2;
-  column_number = position - m_positions[upper_bound] + 1;
+  column_number = static_cast<uint32_t>(position - m_positions[upper_bound] + 1);
 }
 
-uint32_t LineMap::get_line_number(uint32_t position) const {
+uint32_t LineMap::get_line_number(uint64_t position) const {
   uint32_t line_number, column_number;
   get_line_and_column_numbers(position, line_number, column_number);
   return line_number;
 }
 
-uint32_t LineMap::get_column_number(uint32_t position) const {
+uint32_t LineMap::get_column_number(uint64_t position) const {
   uint32_t line_number, column_number;
   get_line_and_column_numbers(position, line_number, column_number);
   return column_number;
 }
 
-uint32_t LineMap::get_line_start_position(uint32_t line_number) const {
+uint64_t LineMap::get_line_start_position(uint32_t line_number) const {
   assert(line_number > 0 && line_number <= (m_positions.size() + 1));
 
   if (line_number == 1)
@@ -47,7 +48,7 @@ uint32_t LineMap::get_line_start_position(uint32_t line_number) const {
     return m_positions[line_number - 2];
 }
 
-uint32_t LineMap::search_rightmost(uint32_t position) const {
+uint32_t LineMap::search_rightmost(uint64_t position) const {
   uint32_t left = 0;
   uint32_t right = static_cast<uint32_t>(m_positions.size());
 
@@ -63,24 +64,31 @@ uint32_t LineMap::search_rightmost(uint32_t position) const {
   return right - 1;
 }
 
-void LineMap::prefill(std::string_view buffer) {
-  for (uint32_t i = 0; i < buffer.size(); ++i) {
+void LineMap::prefill(std::string_view buffer, uint64_t end) {
+  end = std::min<uint64_t>(end, buffer.size());
+  uint64_t i = m_prefilled_end;
+  for (; i < end; ++i) {
     switch (buffer[i]) {
     case '\n': // LF line ending
       add_newline(i + 1);
       break;
     case '\r':
       ++i;
-      if (buffer[i] == '\n') { // CR-LF line ending
+      if (i < buffer.size() && buffer[i] == '\n') { // CR-LF line ending
         add_newline(i + 1);
       } else { // CR line ending
         add_newline(i);
+        --i; // the next character is not part of the line ending
       }
       break;
     }
   }
+
+  // A CR-LF line ending may end past `end`.
+  m_prefilled_end = std::max(m_prefilled_end, i);
 }
 
 void LineMap::clear() {
   m_positions.clear();
+  m_prefilled_end = 0;
 }
@@ -8,7 +8,8 @@
 /// \ingroup report
 /// \brief The LineMap class provides functions to convert between character positions and line numbers.
 ///
-/// Character positions are a 0-based byte offset in the source file.
+/// Character positions are a 0-based byte offset in the source file, on 64 bits
+/// to support files larger than 4 GiB.
 /// Whereas, line and column numbers are 1-based like many code editors for convenience.
 ///
 /// The line map is populated either by calling the LineMap::add_newline()
@@ -16,6 +17,10 @@
 /// can convert from a byte offset in the source file to a line and column number using
 /// the LineMap::get_line_and_column_numbers() function.
 ///
+/// The line map may be filled lazily: LineMap::prefill() can stop at a given
+/// position and continue later from there. The positions before the end of the
+/// filled part of the buffer can then be converted.
+///
 /// Internally, the line map is implemented as a sorted array of newline positions. Therefore,
 /// all query functions should have a complexity of O(log n) with n the count of lines. Moreover,
 /// because new line positions are added in order, the internal list is always sorted without
@@ -24,31 +29,39 @@ class LineMap {
 public:
   /// Adds a new line position (the position of the first byte of the newline,
   /// that is the position just after the character `\n` or `\r\n`).
-  void add_newline(uint32_t start_line_position);
+  void add_newline(uint64_t start_line_position);
 
   /// Gets the line and column number corresponding to the given `position` byte
   /// position. Both line and column numbers are 1-based.
-  void get_line_and_column_numbers(uint32_t position, uint32_t &line_number,
+  void get_line_and_column_numbers(uint64_t position, uint32_t &line_number,
                                    uint32_t &column_number) const;
   /// Same as get_line_and_column_numbers().
-  [[nodiscard]] uint32_t get_line_number(uint32_t position) const;
+  [[nodiscard]] uint32_t get_line_number(uint64_t position) const;
   /// Same as get_line_and_column_numbers().
-  [[nodiscard]] uint32_t get_column_number(uint32_t position) const;
+  [[nodiscard]] uint32_t get_column_number(uint64_t position) const;
   /// Gets the position of the first byte at the given line (1-based number).
-  [[nodiscard]] uint32_t get_line_start_position(uint32_t line_number) const;
+  [[nodiscard]] uint64_t get_line_start_position(uint32_t line_number) const;
+  /// Gets the count of lines whose start is known.
+  [[nodiscard]] uint32_t get_line_count() const { return static_cast<uint32_t>(m_positions.size() + 1); }
 
   /// Prefills the line map with the line endings found in the given buffer.
   /// The LF, CR and CR-LF line endings are recognized.
-  void prefill(std::string_view buffer);
+  void prefill(std::string_view buffer) { prefill(buffer, buffer.size()); }
+  /// Same as prefill() but only scans the buffer up to the position \a end,
+  /// starting where the previous call stopped.
+  void prefill(std::string_view buffer, uint64_t end);
+  /// Gets the position up to which the buffer was scanned by prefill().
+  [[nodiscard]] uint64_t get_prefilled_end() const { return m_prefilled_end; }
 
   /// Clears the line map.
   void clear();
 
 private:
   /// Does a binary search on the positions.
-  [[nodiscard]] uint32_t search_rightmost(uint32_t position) const;
+  [[nodiscard]] uint32_t search_rightmost(uint64_t position) const;
 
-  std::vector<uint32_t> m_positions;
+  std::vector<uint64_t> m_positions;
+  uint64_t m_prefilled_end = 0;
 };
 
 #endif // NETLIST_LINE_MAP_HPP
@@ -3,6 +3,7 @@
 
 #include <cassert>
 #include <charconv>
+#include <thread>
 
 /// Returns the radix of the given integer literal if explicitly written.
 /// Otherwise returns 0.
@@ -41,17 +42,72 @@ template <typename T>
   return value;
 }
 
+/// Returns the value of the integer literal of \a bus_size bits split in 64-bit
+/// limbs, the lowest first, the bits not fitting in the bus size being ignored.
+[[nodiscard]] static std::vector<reg_value_t> parse_wide_integer_literal(std::string_view literal,
+                                                                        bus_size_t bus_size) {
+  unsigned radix = get_integer_literal_radix(literal);
+  if (radix > 0)
+    literal.remove_prefix(2);
+  else
+    radix = 2;
+
+  const auto get_digit_value = [](char ch) -> reg_value_t {
+    if (is_digit(ch))
+      return ch - '0';
+    return (ch | 0x20) - 'a' + 10; // lower case
+  };
+
+  WideBus bus;
+  bus.bus_size = bus_size;
+  std::vector<reg_value_t> limbs(bus.get_limb_count(), 0);
+  if (radix == 10) {
+    // limbs = limbs * 10 + digit, computed by halves of limbs to keep the carries.
+    for (const char ch : literal) {
+      reg_value_t carry = get_digit_value(ch);
+      for (auto &limb : limbs) {
+        const reg_value_t low = (limb & 0xffffffff) * 10 + carry;
+        const reg_value_t high = (limb >> 32) * 10 + (low >> 32);
+        limb = (high << 32) | (low & 0xffffffff);
+        carry = high >> 32;
+      }
+    }
+  } else {
+    // The digits never overlap two limbs as 64 is a multiple of both 1 and 4.
+    const unsigned digit_size = radix == 2 ? 1 : 4;
+    std::size_t bit = 0;
+    for (auto it = literal.rbegin(); it != literal.rend() && bit < bus_size; ++it, bit += digit_size)
+      limbs[bit / WideBus::LIMB_SIZE] |= get_digit_value(*it) << (bit % WideBus::LIMB_SIZE);
+  }
+
+  limbs.back() &= get_bus_mask(bus.get_limb_size(limbs.size() - 1));
+  return limbs;
+}
+
 Parser::Parser(ReportManager &report_manager, Lexer &lexer) : m_report_manager(report_manager), m_lexer(lexer) {
   // Gets the first token
   m_lexer.tokenize(m_token);
 }
 
+Parser::Parser(ReportManager &report_manager, Lexer &lexer, const Parser &parent)
+    : m_report_manager(report_manager), m_lexer(lexer), m_parent(&parent),
+      m_program_builder(parent.m_program_builder.get_registers()) {
+  // Gets the first token
+  m_lexer.tokenize(m_token);
+}
+
 std::shared_ptr<Program> Parser::parse_program() {
   parse_inputs();
   parse_outputs();
   parse_variables();
   parse_equations();
-  return m_program_builder.build();
+
+  const auto base_register_count = static_cast<reg_index_t>(m_program_builder.get_registers().size());
+  auto program = m_program_builder.build();
+  for (auto &chunk_program : m_chunk_programs)
+    append_program(*program, *chunk_program, base_register_count);
+  m_chunk_programs.clear();
+  return program;
 }
 
 /// Grammar:
@@ -199,6 +255,8 @@ void Parser::parse_variables() {
       /* allow_size_specifier= */ true,
       [this, &already_defined_variables](SourceLocation variable_location, std::string_view variable_name,
                                          size_t size_in_bits) {
+        check_limb_names(variable_location, variable_name, size_in_bits);
+
         auto it = m_variables.find(variable_name);
         if (it != m_variables.end()) {
           if (already_defined_variables.contains(variable_name)) {
@@ -217,11 +275,11 @@ void Parser::parse_variables() {
           if (it->second.is_output)
             flags |= RIF_OUTPUT;
           already_defined_variables.insert(variable_name);
-          it->second.reg = m_program_builder.add_register(size_in_bits, std::string{variable_name}, flags);
+          it->second.reg = add_register(size_in_bits, variable_name, flags);
           return true;
         }
 
-        const reg_t reg = m_program_builder.add_register(size_in_bits, std::string{variable_name});
+        const reg_t reg = add_register(size_in_bits, variable_name);
         const VariableInfo variable_info = {reg, variable_location,
                                             /* is_input= */ false,
                                             /* is_output= */ false};
@@ -231,6 +289,35 @@ void Parser::parse_variables() {
       });
 }
 
+/// Reports an error if the variable \a variable_name has the name of a limb of
+/// a wide variable, or if it is wide and one of its limbs has the name of a
+/// variable.
+void Parser::check_limb_names(SourceLocation variable_location, std::string_view variable_name,
+                              bus_size_t bus_size) {
+  const auto report_conflict = [this, variable_location, variable_name](std::string_view limb_name,
+                                                                        std::string_view wide_variable_name) {
+    m_report_manager.report(ReportSeverity::ERROR)
+        .with_location(variable_location)
+        .with_span({variable_location, (uint32_t)variable_name.size()})
+        .with_message("the variable `{}' has the name of a part of the variable `{}'", limb_name, wide_variable_name)
+        .with_note("the bits of a variable wider than {} bits are stored in variables named `{}', `{}', etc.",
+                   WideBus::LIMB_SIZE, wide_variable_name,
+                   WideBusBuilder::get_limb_name(wide_variable_name, WideBus::LIMB_SIZE))
+        .finish()
+        .exit();
+  };
+
+  if (const auto it = m_limb_names.find(std::string(variable_name)); it != m_limb_names.end())
+    report_conflict(variable_name, it->second);
+
+  for (bus_size_t offset = WideBus::LIMB_SIZE; offset < bus_size; offset += WideBus::LIMB_SIZE) {
+    auto limb_name = WideBusBuilder::get_limb_name(variable_name, offset);
+    if (m_variables.contains(limb_name))
+      report_conflict(limb_name, variable_name);
+    m_limb_names.emplace(std::move(limb_name), variable_name);
+  }
+}
+
 /// Grammar:
 /// ```
 /// equations := "IN" equation-list
@@ -245,10 +332,93 @@ void Parser::parse_equations() {
     consume(); // eat `IN`
   }
 
+  if (m_thread_count > 1 && parse_equations_in_parallel())
+    return;
+
   while (m_token.kind != TokenKind::EOI)
     parse_equation();
 }
 
+/// Returns the offset of the first line of \a input starting with `IDENTIFIER =`
+/// after the offset \a position, or the size of the input if there is none.
+[[nodiscard]] static std::uint64_t find_equation_start(std::string_view input, std::uint64_t position) {
+  while (true) {
+    position = input.find('\n', position);
+    if (position == std::string_view::npos)
+      return input.size();
+
+    // Matches `[ \t]*IDENTIFIER[ \t]*=` at the start of the next line. The
+    // input is followed by a NUL character, so this never reads past its end.
+    const char *cursor = input.data() + position + 1;
+    while (*cursor == ' ' || *cursor == '\t')
+      ++cursor;
+    if (is_start_ident(*cursor)) {
+      while (is_cont_ident(*cursor))
+        ++cursor;
+      while (*cursor == ' ' || *cursor == '\t')
+        ++cursor;
+      if (*cursor == '=')
+        return position + 1;
+    }
+
+    ++position;
+  }
+}
+
+namespace {
+/// Thrown by the reports of the threads parsing the equations in parallel, to abandon their chunk.
+struct ChunkError {};
+} // namespace
+
+bool Parser::parse_equations_in_parallel() {
+  const std::string_view input = m_lexer.get_input();
+  const std::uint64_t begin = m_token.kind == TokenKind::EOI ? input.size() : m_token.position.offset;
+  const std::uint64_t size = input.size() - begin;
+  const std::uint64_t chunk_count = std::min<std::uint64_t>(m_thread_count, size / MIN_CHUNK_SIZE);
+  if (chunk_count < 2)
+    return false;
+
+  // The chunks start at an equation, the first one at the current token.
+  std::vector<std::uint64_t> bounds = {begin};
+  for (std::uint64_t i = 1; i < chunk_count; ++i) {
+    const auto bound = find_equation_start(input, std::max(begin + i * size / chunk_count, bounds.back()));
+    if (bound < input.size())
+      bounds.push_back(bound);
+  }
+  bounds.push_back(input.size());
+  if (bounds.size() < 3)
+    return false;
+
+  std::vector<std::shared_ptr<Program>> chunk_programs(bounds.size() - 1);
+  std::vector<std::thread> threads;
+  threads.reserve(chunk_programs.size());
+  for (std::size_t i = 0; i < chunk_programs.size(); ++i) {
+    threads.emplace_back([this, &bounds, &chunk_programs, i] {
+      // The errors are not reported from here but by the sequential parse.
+      ReportManager report_manager;
+      report_manager.set_exit_handler([](const Report &) { throw ChunkError(); });
+      try {
+        Lexer lexer(report_manager, m_lexer, bounds[i], bounds[i + 1]);
+        Parser parser(report_manager, lexer, *this);
+        while (parser.m_token.kind != TokenKind::EOI)
+          parser.parse_equation();
+        chunk_programs[i] = parser.m_program_builder.build();
+      } catch (const ChunkError &) {
+        chunk_programs[i] = nullptr;
+      }
+    });
+  }
+
+  for (auto &thread : threads)
+    thread.join();
+
+  if (std::find(chunk_programs.begin(), chunk_programs.end(), nullptr) != chunk_programs.end())
+    return false;
+
+  m_chunk_programs = std::move(chunk_programs);
+  return true;
+}
+
 /// Grammar:
 /// ```
 /// equation := IDENTIFIER "=" expression
@@ -258,15 +428,15 @@ void Parser::parse_equation() {
     unexpected_token_error(m_token, "an equation label");
 
   std::string_view variable_label = m_token.spelling;
-  auto it = m_variables.find(variable_label);
-  if (it == m_variables.end()) {
+  const auto *variable = find_variable(variable_label);
+  if (variable == nullptr) {
     m_report_manager.report(ReportSeverity::ERROR)
         .with_location(m_token.position)
         .with_span({m_token.position, (uint32_t)variable_label.size()})
         .with_message("equation label `{}' not declared inside `VAR' declaration", variable_label)
         .finish()
         .exit();
-  } else if (it->second.is_input) {
+  } else if (variable->is_input) {
     m_report_manager.report(ReportSeverity::ERROR)
         .with_location(m_token.position)
         .with_span({m_token.position, (uint32_t)variable_label.size()})
@@ -282,7 +452,7 @@ void Parser::parse_equation() {
 
   consume(); // eat `=`
 
-  reg_t output_reg = it->second.reg;
+  reg_t output_reg = variable->reg;
   parse_expression(output_reg);
 }
 
@@ -293,6 +463,9 @@ void Parser::parse_equation() {
 ///             | not-expression
 ///             | reg-expression
 ///             | binary-expression
+///             | comparison-expression
+///             | shift-expression
+///             | reduce-expression
 ///             | mux-expression
 ///             | concat-expression
 ///             | select-expression
@@ -316,7 +489,20 @@ void Parser::parse_expression(reg_t output) {
   case TokenKind::KEY_NOR:
   case TokenKind::KEY_XOR:
   case TokenKind::KEY_XNOR:
+  case TokenKind::KEY_ADD:
+  case TokenKind::KEY_SUB:
+  case TokenKind::KEY_MUL:
     return parse_binary_expression(output);
+  case TokenKind::KEY_EQ:
+  case TokenKind::KEY_LT:
+    return parse_comparison_expression(output);
+  case TokenKind::KEY_SHL:
+  case TokenKind::KEY_SHR:
+  case TokenKind::KEY_ASR:
+    return parse_shift_expression(output);
+  case TokenKind::KEY_REDOR:
+  case TokenKind::KEY_REDAND:
+    return parse_reduce_expression(output);
   case TokenKind::KEY_MUX:
     return parse_mux_expression(output);
   case TokenKind::KEY_CONCAT:
@@ -361,7 +547,7 @@ void Parser::parse_expression(reg_t output) {
 /// ```
 /// constant := INTEGER <opt-size-specifier>
 /// ```
-std::pair<reg_value_t, bus_size_t> Parser::parse_constant(bus_size_t expected_bus_size) {
+std::pair<std::vector<reg_value_t>, bus_size_t> Parser::parse_constant(bus_size_t expected_bus_size) {
   assert(m_token.kind == TokenKind::INTEGER);
 
   unsigned radix = get_integer_literal_radix(m_token.spelling);
@@ -398,8 +584,20 @@ std::pair<reg_value_t, bus_size_t> Parser::parse_constant(bus_size_t expected_bu
         .exit();
   }
 
+  if (bus_size.value() > MAX_VARIABLE_SIZE) {
+    m_report_manager.report(ReportSeverity::ERROR)
+        .with_location(integer_token.position)
+        .with_span({integer_token.position, (std::uint_least32_t)integer_token.spelling.size()})
+        .with_message("but size greater than {} bits is not allowed", MAX_VARIABLE_SIZE)
+        .finish()
+        .exit();
+  }
+
+  if (bus_size.value() > WideBus::LIMB_SIZE)
+    return {parse_wide_integer_literal(integer_token.spelling, bus_size.value()), bus_size.value()};
+
   const auto value = parse_integer_literal<reg_value_t>(integer_token.spelling);
-  return {value, bus_size.value()};
+  return {{value}, bus_size.value()};
 }
 
 /// Grammar:
@@ -493,8 +691,8 @@ void Parser::check_invalid_digits(Token &token, unsigned int radix) {
   if (m_token.kind != TokenKind::IDENTIFIER)
     unexpected_token_error(m_token, "a register");
 
-  const auto it = m_variables.find(m_token.spelling);
-  if (it == m_variables.end()) {
+  const auto *variable = find_variable(m_token.spelling);
+  if (variable == nullptr) {
     m_report_manager.report(ReportSeverity::ERROR)
         .with_location(m_token.position)
         .with_span(get_current_token_range())
@@ -503,7 +701,7 @@ void Parser::check_invalid_digits(Token &token, unsigned int radix) {
         .exit();
   }
 
-  const bus_size_t register_bus_size = m_program_builder.get_register_bus_size(it->second.reg);
+  const bus_size_t register_bus_size = get_bus_size(variable->reg);
   if (expected_bus_size > 0 && register_bus_size != expected_bus_size) {
     m_report_manager.report(ReportSeverity::ERROR)
         .with_location(m_token.position)
@@ -514,7 +712,7 @@ void Parser::check_invalid_digits(Token &token, unsigned int radix) {
   }
 
   consume(); // eat IDENTIFIER
-  return it->second.reg;
+  return variable->reg;
 }
 
 /// Grammar:
@@ -532,9 +730,12 @@ reg_t Parser::parse_argument(bus_size_t expected_bus_size) {
     // _temp_0 = CONST 0110
     // output = AND a _temp_0
 
-    const auto [value, bus_size] = parse_constant(expected_bus_size);
-    const reg_t reg = m_program_builder.add_register(bus_size, {}, RIF_INTERNAL);
-    m_program_builder.add_const(reg, value);
+    const auto [limbs, bus_size] = parse_constant(expected_bus_size);
+    const reg_t reg = add_register(bus_size, {}, RIF_INTERNAL);
+    if (bus_size > WideBus::LIMB_SIZE)
+      m_wide_bus_builder.add_const(get_wide_bus(reg), limbs);
+    else
+      m_program_builder.add_const(reg, limbs.front());
     return reg;
   }
   default:
@@ -544,6 +745,23 @@ reg_t Parser::parse_argument(bus_size_t expected_bus_size) {
   }
 }
 
+/// Same as parse_argument() but reports an error if the argument is wider than 64 bits.
+reg_t Parser::parse_narrow_argument(bus_size_t expected_bus_size) {
+  const auto argument_token = m_token;
+  const auto reg = parse_argument(expected_bus_size);
+  if (is_wide(reg)) {
+    m_report_manager.report(ReportSeverity::ERROR)
+        .with_location(argument_token.position)
+        .with_span({argument_token.position, (uint32_t)argument_token.spelling.size()}, "has a bus size of {} bits",
+                   get_bus_size(reg))
+        .with_message("expected a bus size of at most {} bits", WideBus::LIMB_SIZE)
+        .finish()
+        .exit();
+  }
+
+  return reg;
+}
+
 /// Grammar:
 /// ```
 /// const-expression := <constant>
@@ -551,9 +769,12 @@ reg_t Parser::parse_argument(bus_size_t expected_bus_size) {
 void Parser::parse_const_expression(reg_t output) {
   assert(m_token.kind == TokenKind::INTEGER);
 
-  const bus_size_t output_bus_size = m_program_builder.get_register_bus_size(output);
-  const auto [value, bus_size] = parse_constant(output_bus_size);
-  m_program_builder.add_const(output, value);
+  const bus_size_t output_bus_size = get_bus_size(output);
+  const auto [limbs, bus_size] = parse_constant(output_bus_size);
+  if (output_bus_size > WideBus::LIMB_SIZE)
+    m_wide_bus_builder.add_const(get_wide_bus(output), limbs);
+  else
+    m_program_builder.add_const(output, limbs.front());
 }
 
 /// Grammar:
@@ -563,9 +784,12 @@ void Parser::parse_const_expression(reg_t output) {
 void Parser::parse_load_expression(reg_t output) {
   assert(m_token.kind == TokenKind::IDENTIFIER);
 
-  const bus_size_t output_bus_size = m_program_builder.get_register_bus_size(output);
+  const bus_size_t output_bus_size = get_bus_size(output);
   const auto input = parse_register(output_bus_size);
-  m_program_builder.add_load(output, input);
+  if (output_bus_size > WideBus::LIMB_SIZE)
+    m_wide_bus_builder.add_load(get_wide_bus(output), get_wide_bus(input));
+  else
+    m_program_builder.add_load(output, input);
 }
 
 /// Grammar:
@@ -576,9 +800,12 @@ void Parser::parse_not_expression(reg_t output) {
   assert(m_token.kind == TokenKind::KEY_NOT);
   consume(); // eat `NOT`
 
-  const bus_size_t output_bus_size = m_program_builder.get_register_bus_size(output);
+  const bus_size_t output_bus_size = get_bus_size(output);
   auto input = parse_argument(output_bus_size);
-  m_program_builder.add_not(output, input);
+  if (output_bus_size > WideBus::LIMB_SIZE)
+    m_wide_bus_builder.add_not(get_wide_bus(output), get_wide_bus(input));
+  else
+    m_program_builder.add_not(output, input);
 }
 
 /// Grammar:
@@ -589,9 +816,12 @@ void Parser::parse_reg_expression(reg_t output) {
   assert(m_token.kind == TokenKind::KEY_REG);
   consume(); // eat `REG`
 
-  const bus_size_t output_bus_size = m_program_builder.get_register_bus_size(output);
+  const bus_size_t output_bus_size = get_bus_size(output);
   auto input = parse_register(output_bus_size);
-  m_program_builder.add_reg(output, input);
+  if (output_bus_size > WideBus::LIMB_SIZE)
+    m_wide_bus_builder.add_reg(get_wide_bus(output), get_wide_bus(input));
+  else
+    m_program_builder.add_reg(output, input);
 }
 
 /// Grammar:
@@ -604,15 +834,22 @@ void Parser::parse_reg_expression(reg_t output) {
 ///                | "NOR"
 ///                | "XOR"
 ///                | "XNOR"
+///                | "ADD"
+///                | "SUB"
+///                | "MUL"
 /// ```
 void Parser::parse_binary_expression(reg_t output) {
+  const auto operator_token = m_token;
   auto token_kind = m_token.kind;
   consume(); // eat the binary operator keyword
 
-  const bus_size_t output_bus_size = m_program_builder.get_register_bus_size(output);
+  const bus_size_t output_bus_size = get_bus_size(output);
   auto lhs_reg = parse_argument(output_bus_size);
   auto rhs_reg = parse_argument(output_bus_size);
 
+  if (output_bus_size > WideBus::LIMB_SIZE)
+    return parse_wide_binary_expression(operator_token, output, lhs_reg, rhs_reg);
+
   switch (token_kind) {
   case TokenKind::KEY_AND:
     m_program_builder.add_and(output, lhs_reg, rhs_reg);
@@ -632,12 +869,181 @@ void Parser::parse_binary_expression(reg_t output) {
   case TokenKind::KEY_XNOR:
     m_program_builder.add_xnor(output, lhs_reg, rhs_reg);
     break;
+  case TokenKind::KEY_ADD:
+    m_program_builder.add_add(output, lhs_reg, rhs_reg);
+    break;
+  case TokenKind::KEY_SUB:
+    m_program_builder.add_sub(output, lhs_reg, rhs_reg);
+    break;
+  case TokenKind::KEY_MUL:
+    m_program_builder.add_mul(output, lhs_reg, rhs_reg);
+    break;
+  default:
+    assert(false && "unreachable code");
+    break;
+  }
+}
+
+void Parser::parse_wide_binary_expression(const Token &operator_token, reg_t output, reg_t lhs_reg, reg_t rhs_reg) {
+  const auto output_bus = get_wide_bus(output);
+  const auto lhs_bus = get_wide_bus(lhs_reg);
+  const auto rhs_bus = get_wide_bus(rhs_reg);
+
+  switch (operator_token.kind) {
+  case TokenKind::KEY_AND:
+    m_wide_bus_builder.add_and(output_bus, lhs_bus, rhs_bus);
+    break;
+  case TokenKind::KEY_NAND:
+    m_wide_bus_builder.add_nand(output_bus, lhs_bus, rhs_bus);
+    break;
+  case TokenKind::KEY_OR:
+    m_wide_bus_builder.add_or(output_bus, lhs_bus, rhs_bus);
+    break;
+  case TokenKind::KEY_NOR:
+    m_wide_bus_builder.add_nor(output_bus, lhs_bus, rhs_bus);
+    break;
+  case TokenKind::KEY_XOR:
+    m_wide_bus_builder.add_xor(output_bus, lhs_bus, rhs_bus);
+    break;
+  case TokenKind::KEY_XNOR:
+    m_wide_bus_builder.add_xnor(output_bus, lhs_bus, rhs_bus);
+    break;
+  case TokenKind::KEY_ADD:
+    m_wide_bus_builder.add_add(output_bus, lhs_bus, rhs_bus);
+    break;
+  case TokenKind::KEY_SUB:
+    m_wide_bus_builder.add_sub(output_bus, lhs_bus, rhs_bus);
+    break;
+  case TokenKind::KEY_MUL:
+    unsupported_wide_bus_error(operator_token);
+    break;
   default:
     assert(false && "unreachable code");
     break;
   }
 }
 
+/// Grammar:
+/// ```
+/// comparison-expression := comparison-opcode <arg> <arg>
+///
+/// comparison-opcode := "EQ"
+///                    | "LT"
+/// ```
+void Parser::parse_comparison_expression(reg_t output) {
+  auto token_kind = m_token.kind;
+  check_single_bit_output(output);
+  consume(); // eat the comparison operator keyword
+
+  // The operands may have any bus size, but the same one. The result is a single bit.
+  auto lhs_reg = parse_argument();
+  auto rhs_reg = parse_argument(get_bus_size(lhs_reg));
+
+  if (is_wide(lhs_reg)) {
+    if (token_kind == TokenKind::KEY_EQ)
+      m_wide_bus_builder.add_eq(output, get_wide_bus(lhs_reg), get_wide_bus(rhs_reg));
+    else
+      m_wide_bus_builder.add_lt(output, get_wide_bus(lhs_reg), get_wide_bus(rhs_reg));
+    return;
+  }
+
+  switch (token_kind) {
+  case TokenKind::KEY_EQ:
+    m_program_builder.add_eq(output, lhs_reg, rhs_reg);
+    break;
+  case TokenKind::KEY_LT:
+    m_program_builder.add_lt(output, lhs_reg, rhs_reg);
+    break;
+  default:
+    assert(false && "unreachable code");
+    break;
+  }
+}
+
+/// Reports an error if \a output, assigned by the current operator whose
+/// result is a single bit, is wider.
+void Parser::check_single_bit_output(reg_t output) {
+  const bus_size_t output_bus_size = get_bus_size(output);
+  if (output_bus_size != 1) {
+    m_report_manager.report(ReportSeverity::ERROR)
+        .with_location(m_token.position)
+        .with_span(get_current_token_range(), "has a result of 1 bit")
+        .with_message("the result is assigned to a variable with a bus size of {} bit(s)", output_bus_size)
+        .finish()
+        .exit();
+  }
+}
+
+/// Reports an error for the operator \a operator_token, which does not support
+/// buses wider than 64 bits.
+void Parser::unsupported_wide_bus_error(const Token &operator_token) {
+  m_report_manager.report(ReportSeverity::ERROR)
+      .with_location(operator_token.position)
+      .with_span({operator_token.position, (uint32_t)operator_token.spelling.size()})
+      .with_message("`{}' is not supported on buses wider than {} bits", operator_token.spelling, WideBus::LIMB_SIZE)
+      .finish()
+      .exit();
+}
+
+/// Grammar:
+/// ```
+/// shift-expression := shift-opcode <arg> <arg>
+///
+/// shift-opcode := "SHL"
+///               | "SHR"
+///               | "ASR"
+/// ```
+void Parser::parse_shift_expression(reg_t output) {
+  const auto operator_token = m_token;
+  auto token_kind = m_token.kind;
+  consume(); // eat the shift operator keyword
+
+  // The shift amount may have any bus size.
+  const bus_size_t output_bus_size = get_bus_size(output);
+  auto value_reg = parse_argument(output_bus_size);
+  auto amount_reg = parse_narrow_argument();
+  if (output_bus_size > WideBus::LIMB_SIZE)
+    unsupported_wide_bus_error(operator_token);
+
+  switch (token_kind) {
+  case TokenKind::KEY_SHL:
+    m_program_builder.add_shl(output, value_reg, amount_reg);
+    break;
+  case TokenKind::KEY_SHR:
+    m_program_builder.add_shr(output, value_reg, amount_reg);
+    break;
+  case TokenKind::KEY_ASR:
+    m_program_builder.add_asr(output, value_reg, amount_reg);
+    break;
+  default:
+    assert(false && "unreachable code");
+    break;
+  }
+}
+
+/// Grammar:
+/// ```
+/// reduce-expression := "REDOR" <arg>
+///                    | "REDAND" <arg>
+/// ```
+void Parser::parse_reduce_expression(reg_t output) {
+  auto token_kind = m_token.kind;
+  check_single_bit_output(output);
+  consume(); // eat the reduction operator keyword
+
+  auto input = parse_argument();
+  if (is_wide(input)) {
+    if (token_kind == TokenKind::KEY_REDOR)
+      m_wide_bus_builder.add_reduce_or(output, get_wide_bus(input));
+    else
+      m_wide_bus_builder.add_reduce_and(output, get_wide_bus(input));
+  } else if (token_kind == TokenKind::KEY_REDOR) {
+    m_program_builder.add_reduce_or(output, input);
+  } else {
+    m_program_builder.add_reduce_and(output, input);
+  }
+}
+
 /// Grammar:
 /// ```
 /// mux-expression := "MUX" <arg> <arg> <arg>
@@ -646,11 +1052,14 @@ void Parser::parse_mux_expression(reg_t output) {
   assert(m_token.kind == TokenKind::KEY_MUX);
   consume(); // eat `MUX`
 
-  const bus_size_t output_bus_size = m_program_builder.get_register_bus_size(output);
+  const bus_size_t output_bus_size = get_bus_size(output);
   auto choice = parse_argument(/*expected_bus_size=*/1);
   auto first = parse_argument(output_bus_size);
   auto second = parse_argument(output_bus_size);
-  m_program_builder.add_mux(output, choice, first, second);
+  if (output_bus_size > WideBus::LIMB_SIZE)
+    m_wide_bus_builder.add_mux(get_wide_bus(output), choice, get_wide_bus(first), get_wide_bus(second));
+  else
+    m_program_builder.add_mux(output, choice, first, second);
 }
 
 /// Grammar:
@@ -663,7 +1072,10 @@ void Parser::parse_concat_expression(reg_t output) {
 
   auto lhs = parse_argument();
   auto rhs = parse_argument();
-  m_program_builder.add_concat(output, lhs, rhs);
+  if (is_wide(output) || is_wide(lhs) || is_wide(rhs))
+    m_wide_bus_builder.add_concat(get_wide_bus(output), get_wide_bus(lhs), get_wide_bus(rhs));
+  else
+    m_program_builder.add_concat(output, lhs, rhs);
 }
 
 /// Grammar:
@@ -678,7 +1090,10 @@ void Parser::parse_select_expression(reg_t output) {
   const auto i = parse_bus_size(/*as_index=*/true);
   const auto input = parse_argument();
 
-  m_program_builder.add_select(output, i, input);
+  if (is_wide(output) || is_wide(input))
+    m_wide_bus_builder.add_slice(get_wide_bus(output), i, i, get_wide_bus(input));
+  else
+    m_program_builder.add_select(output, i, input);
 }
 
 /// Grammar:
@@ -694,7 +1109,10 @@ void Parser::parse_slice_expression(reg_t output) {
   const auto end = parse_bus_size(/*as_index=*/true);
   const auto input = parse_argument();
 
-  m_program_builder.add_slice(output, start, end, input);
+  if (is_wide(output) || is_wide(input))
+    m_wide_bus_builder.add_slice(get_wide_bus(output), start, end, get_wide_bus(input));
+  else
+    m_program_builder.add_slice(output, start, end, input);
 }
 
 /// Grammar:
@@ -706,11 +1124,14 @@ void Parser::parse_rom_expression(reg_t output) {
 
   consume(); // eat `ROM`
 
-  const auto addr_size = parse_bus_size();
-  const auto word_size = parse_bus_size();
+  const auto addr_size = parse_address_size();
+  const auto word_size = parse_word_size(output);
   const auto read_addr = parse_argument(addr_size);
 
-  m_program_builder.add_rom(output, addr_size, word_size, read_addr);
+  if (word_size > WideBus::LIMB_SIZE)
+    m_wide_bus_builder.add_rom(get_wide_bus(output), addr_size, read_addr);
+  else
+    m_program_builder.add_rom(output, addr_size, word_size, read_addr);
 }
 
 /// Grammar:
@@ -722,14 +1143,84 @@ void Parser::parse_ram_expression(reg_t output) {
 
   consume(); // eat `RAM`
 
+  const auto addr_size = parse_address_size();
+  const auto word_size = parse_word_size(output);
+  const auto read_addr = parse_narrow_argument();
+  const auto write_enable = parse_narrow_argument();
+  const auto write_addr = parse_narrow_argument();
+
+  if (word_size > WideBus::LIMB_SIZE) {
+    const auto write_data = parse_argument(word_size);
+    m_wide_bus_builder.add_ram(get_wide_bus(output), addr_size, read_addr, write_enable, write_addr,
+                               get_wide_bus(write_data));
+  } else {
+    const auto write_data = parse_narrow_argument();
+    m_program_builder.add_ram(output, addr_size, word_size, read_addr, write_enable, write_addr, write_data);
+  }
+}
+
+reg_t Parser::add_register(bus_size_t bus_size, std::string_view name, unsigned flags) {
+  if (bus_size <= WideBus::LIMB_SIZE)
+    return m_program_builder.add_register(bus_size, std::string{name}, flags);
+
+  const auto bus = m_wide_bus_builder.add_register(bus_size, name, flags);
+  m_wide_bus_sizes.insert({bus.first.index, bus_size});
+  return bus.first;
+}
+
+bus_size_t Parser::get_bus_size(reg_t reg) const {
+  if (!m_wide_bus_sizes.empty()) {
+    const auto it = m_wide_bus_sizes.find(reg.index);
+    if (it != m_wide_bus_sizes.end())
+      return it->second;
+  }
+
+  // The variables of a chunk of the equations are registers of the parent parser.
+  if (m_parent != nullptr && reg.index < m_parent->m_program_builder.get_registers().size())
+    return m_parent->get_bus_size(reg);
+
+  return m_program_builder.get_register_bus_size(reg);
+}
+
+const Parser::VariableInfo *Parser::find_variable(std::string_view name) const {
+  const auto &variables = m_parent != nullptr ? m_parent->m_variables : m_variables;
+  const auto it = variables.find(name);
+  return it != variables.end() ? &it->second : nullptr;
+}
+
+/// Same as parse_bus_size() but reports an error if the address size of a
+/// memory is wider than 64 bits.
+bus_size_t Parser::parse_address_size() {
+  const auto size_token = m_token;
   const auto addr_size = parse_bus_size();
+  if (addr_size > WideBus::LIMB_SIZE) {
+    m_report_manager.report(ReportSeverity::ERROR)
+        .with_location(size_token.position)
+        .with_span({size_token.position, (uint32_t)size_token.spelling.size()})
+        .with_message("address size greater than {} bits is not allowed", WideBus::LIMB_SIZE)
+        .finish()
+        .exit();
+  }
+
+  return addr_size;
+}
+
+/// Same as parse_bus_size() but reports an error if the word size of a memory
+/// is wider than 64 bits and is not the bus size of its \a output.
+bus_size_t Parser::parse_word_size(reg_t output) {
+  const auto size_token = m_token;
   const auto word_size = parse_bus_size();
-  const auto read_addr = parse_argument();
-  const auto write_enable = parse_argument();
-  const auto write_addr = parse_argument();
-  const auto write_data = parse_argument();
+  const auto output_bus_size = get_bus_size(output);
+  if ((word_size > WideBus::LIMB_SIZE || output_bus_size > WideBus::LIMB_SIZE) && word_size != output_bus_size) {
+    m_report_manager.report(ReportSeverity::ERROR)
+        .with_location(size_token.position)
+        .with_span({size_token.position, (uint32_t)size_token.spelling.size()})
+        .with_message("the result is assigned to a variable with a bus size of {} bit(s)", output_bus_size)
+        .finish()
+        .exit();
+  }
 
-  m_program_builder.add_ram(output, addr_size, word_size, read_addr, write_enable, write_addr, write_data);
+  return word_size;
 }
 
 void Parser::consume() {
@@ -4,7 +4,9 @@
 #include "lexer.hpp"
 #include "program.hpp"
 #include "report.hpp"
+#include "wide_bus.hpp"
 
+#include <algorithm>
 #include <functional>
 #include <unordered_map>
 #include <unordered_set>
@@ -19,46 +21,89 @@
 /// stops at the first error encountered. All errors and warnings are emitted
 /// using the report API via the given ReportManager instance.
 ///
+/// The variables and constants wider than 64 bits are split into several
+/// registers and the operations on them are expanded by a WideBusBuilder.
+///
+/// The equations of large inputs may be parsed by several threads (see
+/// set_thread_count()). The input following the `IN` keyword is then split in
+/// chunks at the starts of lines beginning with `IDENTIFIER =`, each chunk is
+/// parsed by its own thread and the parts of the program are appended in order,
+/// giving the same program as a sequential parse. If an error is found in any
+/// chunk, the equations are parsed again sequentially so that the first error
+/// of the input is reported, as usual.
+///
 /// If you are curious, the parser is implemented internally using the recursive
 /// descent algorithm.
 class Parser {
 public:
   explicit Parser(ReportManager &report_manager, Lexer &lexer);
 
+  /// Sets the maximal count of threads used to parse the equations, 1 by default.
+  void set_thread_count(unsigned thread_count) { m_thread_count = std::max(thread_count, 1u); }
+
   [[nodiscard]] std::shared_ptr<Program> parse_program();
 
 private:
+  /// Creates the parser of a chunk of the equations, the variables being the ones of \a parent.
+  explicit Parser(ReportManager &report_manager, Lexer &lexer, const Parser &parent);
+
   /// Consumes the current token and gets the next one.
   void consume();
 
-  static constexpr size_t MAX_VARIABLE_SIZE = 64;
+  static constexpr size_t MAX_VARIABLE_SIZE = 65536;
   std::optional<bus_size_t> parse_size_specifier();
   void parse_variables_common(bool allow_size_specifier,
                               const std::function<bool(SourceLocation, std::string_view, size_t)> &handler);
   void parse_inputs();
   void parse_outputs();
   void parse_variables();
+  void check_limb_names(SourceLocation variable_location, std::string_view variable_name, bus_size_t bus_size);
 
-  [[nodiscard]] std::pair<reg_value_t, bus_size_t> parse_constant(bus_size_t expected_bus_size = 0);
+  /// Returns the value of the constant, split in 64-bit limbs (see WideBus), and its bus size.
+  [[nodiscard]] std::pair<std::vector<reg_value_t>, bus_size_t> parse_constant(bus_size_t expected_bus_size = 0);
   [[nodiscard]] bus_size_t parse_bus_size(bool as_index = false);
   void check_invalid_digits(Token &token, unsigned radix);
 
+  /// The minimal count of bytes of the equations parsed by each thread.
+  static constexpr std::size_t MIN_CHUNK_SIZE = 256 * 1024;
   void parse_equations();
+  /// Parses the equations from the current token with several threads, returns false if not possible.
+  bool parse_equations_in_parallel();
   void parse_equation();
   void parse_expression(reg_t output);
   [[nodiscard]] reg_t parse_register(bus_size_t expected_bus_size = 0);
   [[nodiscard]] reg_t parse_argument(bus_size_t expected_bus_size = 0);
+  [[nodiscard]] reg_t parse_narrow_argument(bus_size_t expected_bus_size = 0);
   void parse_const_expression(reg_t output);
   void parse_load_expression(reg_t output);
   void parse_not_expression(reg_t output);
   void parse_reg_expression(reg_t output);
   void parse_binary_expression(reg_t output);
+  void parse_wide_binary_expression(const Token &operator_token, reg_t output, reg_t lhs_reg, reg_t rhs_reg);
+  void parse_comparison_expression(reg_t output);
+  void parse_shift_expression(reg_t output);
+  void parse_reduce_expression(reg_t output);
   void parse_mux_expression(reg_t output);
   void parse_concat_expression(reg_t output);
   void parse_select_expression(reg_t output);
   void parse_slice_expression(reg_t output);
   void parse_rom_expression(reg_t output);
   void parse_ram_expression(reg_t output);
+  [[nodiscard]] bus_size_t parse_address_size();
+  [[nodiscard]] bus_size_t parse_word_size(reg_t output);
+  void check_single_bit_output(reg_t output);
+  void unsupported_wide_bus_error(const Token &operator_token);
+
+  /// Adds the register(s) of a variable or a constant, split in limbs if wider than 64 bits.
+  [[nodiscard]] reg_t add_register(bus_size_t bus_size, std::string_view name = {}, unsigned flags = 0);
+  /// Returns the bus size of \a reg, which is the size of the whole bus for the first limb of a wide bus.
+  [[nodiscard]] bus_size_t get_bus_size(reg_t reg) const;
+  [[nodiscard]] WideBus get_wide_bus(reg_t reg) const { return {reg, get_bus_size(reg)}; }
+  [[nodiscard]] bool is_wide(reg_t reg) const { return get_bus_size(reg) > WideBus::LIMB_SIZE; }
+
+  struct VariableInfo;
+  /// Returns the variable named \a name, or null if not declared.
+  [[nodiscard]] const VariableInfo *find_variable(std::string_view name) const;
 
   void unexpected_token_error(const Token &token, std::string_view expected_token_name);
   [[nodiscard]] SourceRange get_current_token_range() const;
@@ -67,7 +112,11 @@ private:
   ReportManager &m_report_manager;
   Lexer &m_lexer;
   Token m_token;
+  /// The parser of the declarations if this parser only parses a chunk of the equations, or null.
+  const Parser *m_parent = nullptr;
+  unsigned m_thread_count = 1;
   ProgramBuilder m_program_builder;
+  WideBusBuilder m_wide_bus_builder{m_program_builder};
 
   struct VariableInfo {
     /// The register allocated to this variable in the generated bytecode.
@@ -83,6 +132,12 @@ private:
   };
 
   std::unordered_map<std::string_view, VariableInfo> m_variables;
+  /// The bus sizes of the buses wider than 64 bits, indexed by their first limb.
+  std::unordered_map<reg_index_t, bus_size_t> m_wide_bus_sizes;
+  /// The names of the limbs of the wide variables (but the first one) and the name of their variable.
+  std::unordered_map<std::string, std::string_view> m_limb_names;
+  /// The parts of the program parsed in parallel, appended to it in order when built.
+  std::vector<std::shared_ptr<Program>> m_chunk_programs;
 };
 
 /// @}
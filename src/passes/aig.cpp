@@ -0,0 +1,214 @@
+#include "aig.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <queue>
+
+// ========================================================
+// class Aig
+// ========================================================
+
+Aig::Aig() {
+  m_nodes.push_back({NO_FANIN, NO_FANIN, 0}); // the constant false
+}
+
+Aig::lit_t Aig::add_input() {
+  const auto node = static_cast<node_t>(m_nodes.size());
+  m_nodes.push_back({NO_FANIN, NO_FANIN, 0});
+  m_inputs.push_back(node);
+  return make_literal(node);
+}
+
+Aig::lit_t Aig::make_and(lit_t a, lit_t b) {
+  if (a > b)
+    std::swap(a, b);
+
+  // One-level rules, the constants have the smallest literals.
+  if (a == FALSE || a == negate(b))
+    return FALSE;
+  if (a == TRUE || a == b)
+    return b;
+
+  if (const auto result = simplify_and(a, b); result != NO_FANIN)
+    return result;
+  if (const auto result = simplify_and(b, a); result != NO_FANIN)
+    return result;
+
+  return make_and_node(a, b);
+}
+
+/// Applies the two-level rules where \a a is an AND node, returns NO_FANIN if none applies.
+Aig::lit_t Aig::simplify_and(lit_t a, lit_t b) {
+  const auto node_a = get_node(a);
+  if (!is_and(node_a))
+    return NO_FANIN;
+
+  const lit_t a_fanins[] = {get_fanin0(node_a), get_fanin1(node_a)};
+  for (int i = 0; i < 2; ++i) {
+    if (!is_complemented(a)) {
+      // (x & y) & !x = 0 and (x & y) & x = x & y
+      if (a_fanins[i] == negate(b))
+        return FALSE;
+      if (a_fanins[i] == b)
+        return a;
+    } else {
+      // !(x & y) & !x = !x and !(x & y) & x = !y & x
+      if (a_fanins[i] == negate(b))
+        return b;
+      if (a_fanins[i] == b)
+        return make_and(negate(a_fanins[1 - i]), b);
+    }
+  }
+
+  const auto node_b = get_node(b);
+  if (!is_and(node_b))
+    return NO_FANIN;
+
+  const lit_t b_fanins[] = {get_fanin0(node_b), get_fanin1(node_b)};
+  for (int i = 0; i < 2; ++i) {
+    for (int j = 0; j < 2; ++j) {
+      if (!is_complemented(a) && !is_complemented(b)) {
+        // (x & y) & (!x & z) = 0
+        if (a_fanins[i] == negate(b_fanins[j]))
+          return FALSE;
+      } else if (!is_complemented(a) && is_complemented(b)) {
+        // (x & y) & !(!x & z) = x & y and (x & y) & !(x & z) = (x & y) & !z
+        if (a_fanins[i] == negate(b_fanins[j]))
+          return a;
+        if (a_fanins[i] == b_fanins[j])
+          return make_and(a, negate(b_fanins[1 - j]));
+      } else if (is_complemented(a) && is_complemented(b)) {
+        // !(x & y) & !(x & !y) = !x
+        if (a_fanins[i] == b_fanins[j] && a_fanins[1 - i] == negate(b_fanins[1 - j]))
+          return negate(a_fanins[i]);
+      }
+    }
+  }
+
+  return NO_FANIN;
+}
+
+Aig::lit_t Aig::make_and_node(lit_t a, lit_t b) {
+  assert(a < b);
+  const auto key = (static_cast<std::uint_least64_t>(a) << 32) | b;
+  if (const auto it = m_strash.find(key); it != m_strash.end())
+    return make_literal(it->second);
+
+  const auto node = static_cast<node_t>(m_nodes.size());
+  const auto level = 1 + std::max(get_level(get_node(a)), get_level(get_node(b)));
+  m_nodes.push_back({a, b, level});
+  m_strash.emplace(key, node);
+  return make_literal(node);
+}
+
+Aig::lit_t Aig::make_xor(lit_t a, lit_t b) {
+  return make_or(make_and(a, negate(b)), make_and(negate(a), b));
+}
+
+Aig::lit_t Aig::make_mux(lit_t choice, lit_t first, lit_t second) {
+  return make_or(make_and(choice, second), make_and(negate(choice), first));
+}
+
+std::vector<std::uint_least32_t> Aig::count_fanouts(const std::vector<lit_t> &roots) const {
+  std::vector<std::uint_least32_t> fanouts(m_nodes.size(), 0);
+  for (const auto root : roots)
+    ++fanouts[get_node(root)];
+
+  // The fanins have smaller indices, so a node is reached before its fanins.
+  for (auto node = m_nodes.size(); node-- > 1;) {
+    if (fanouts[node] == 0 || !is_and(node))
+      continue;
+
+    ++fanouts[get_node(get_fanin0(node))];
+    ++fanouts[get_node(get_fanin1(node))];
+  }
+
+  return fanouts;
+}
+
+std::vector<Aig::lit_t> Aig::copy_inputs(const Aig &source) {
+  std::vector<lit_t> mapping(source.get_node_count(), FALSE);
+  for (const auto input : source.get_inputs())
+    mapping[input] = add_input();
+  return mapping;
+}
+
+Aig Aig::rebuild(std::vector<lit_t> &roots) const {
+  const auto fanouts = count_fanouts(roots);
+  Aig result;
+  auto mapping = result.copy_inputs(*this);
+  const auto map = [&mapping](lit_t lit) { return mapping[get_node(lit)] ^ (lit & 1); };
+
+  for (node_t node = 1; node < m_nodes.size(); ++node) {
+    if (fanouts[node] != 0 && is_and(node))
+      mapping[node] = result.make_and(map(get_fanin0(node)), map(get_fanin1(node)));
+  }
+
+  for (auto &root : roots)
+    root = map(root);
+  return result;
+}
+
+Aig Aig::balance(std::vector<lit_t> &roots) const {
+  const auto fanouts = count_fanouts(roots);
+
+  // The nodes only read by a non-complemented edge of an AND node are merged
+  // with that node.
+  std::vector<bool> is_absorbed(m_nodes.size(), false);
+  for (node_t node = 1; node < m_nodes.size(); ++node) {
+    if (fanouts[node] == 0 || !is_and(node))
+      continue;
+
+    for (const auto fanin : {get_fanin0(node), get_fanin1(node)}) {
+      if (!is_complemented(fanin) && is_and(get_node(fanin)) && fanouts[get_node(fanin)] == 1)
+        is_absorbed[get_node(fanin)] = true;
+    }
+  }
+
+  Aig result;
+  auto mapping = result.copy_inputs(*this);
+  const auto map = [&mapping](lit_t lit) { return mapping[get_node(lit)] ^ (lit & 1); };
+
+  std::vector<lit_t> leaves;
+  std::vector<lit_t> stack;
+  for (node_t node = 1; node < m_nodes.size(); ++node) {
+    if (fanouts[node] == 0 || !is_and(node) || is_absorbed[node])
+      continue;
+
+    // Flattens the tree of AND nodes rooted at node.
+    leaves.clear();
+    stack = {get_fanin0(node), get_fanin1(node)};
+    while (!stack.empty()) {
+      const auto lit = stack.back();
+      stack.pop_back();
+      if (is_absorbed[get_node(lit)] && !is_complemented(lit)) {
+        stack.push_back(get_fanin0(get_node(lit)));
+        stack.push_back(get_fanin1(get_node(lit)));
+      } else {
+        leaves.push_back(map(lit));
+      }
+    }
+
+    // The two shallowest operands are combined first, so the deepest ones are
+    // near the root.
+    using Entry = std::pair<std::uint_least32_t, lit_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<>> queue;
+    for (const auto leaf : leaves)
+      queue.emplace(result.get_level(get_node(leaf)), leaf);
+    while (queue.size() > 1) {
+      const auto a = queue.top().second;
+      queue.pop();
+      const auto b = queue.top().second;
+      queue.pop();
+      const auto lit = result.make_and(a, b);
+      queue.emplace(result.get_level(get_node(lit)), lit);
+    }
+
+    mapping[node] = queue.top().second;
+  }
+
+  for (auto &root : roots)
+    root = map(root);
+  return result;
+}
@@ -0,0 +1,103 @@
+#ifndef NETLIST_SRC_PASSES_AIG_HPP
+#define NETLIST_SRC_PASSES_AIG_HPP
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// ========================================================
+// class Aig
+// ========================================================
+
+/// \ingroup passes
+/// \brief An And-Inverter Graph (AIG): boolean functions built from 2-input
+/// AND nodes and complemented edges.
+///
+/// Nodes are referenced by literals: `2 * node` for the node itself and
+/// `2 * node + 1` for its complement. The node 0 is the constant false, so the
+/// literals FALSE and TRUE are the constants. The other nodes are either
+/// inputs, created by add_input(), or AND nodes whose fanins always have a
+/// smaller index (so the index order is a topological order).
+///
+/// AND nodes are structurally hashed and make_and() applies the two-level
+/// rules of Brummayer and Biere (contradiction, idempotence, subsumption,
+/// substitution and resolution), so simple redundancies never create nodes.
+class Aig {
+public:
+  using lit_t = std::uint_least32_t;
+  using node_t = std::uint_least32_t;
+
+  static constexpr lit_t FALSE = 0;
+  static constexpr lit_t TRUE = 1;
+
+  Aig();
+
+  [[nodiscard]] static lit_t make_literal(node_t node, bool is_complemented = false) {
+    return 2 * node + (is_complemented ? 1 : 0);
+  }
+  [[nodiscard]] static node_t get_node(lit_t lit) { return lit >> 1; }
+  [[nodiscard]] static bool is_complemented(lit_t lit) { return (lit & 1) != 0; }
+  [[nodiscard]] static lit_t negate(lit_t lit) { return lit ^ 1; }
+  [[nodiscard]] static bool is_constant(lit_t lit) { return get_node(lit) == 0; }
+
+  /// \brief Returns the count of nodes, including the constant and the inputs.
+  [[nodiscard]] std::size_t get_node_count() const { return m_nodes.size(); }
+  [[nodiscard]] bool is_input(node_t node) const { return node != 0 && m_nodes[node].fanin0 == NO_FANIN; }
+  [[nodiscard]] bool is_and(node_t node) const { return m_nodes[node].fanin0 != NO_FANIN; }
+  [[nodiscard]] lit_t get_fanin0(node_t node) const { return m_nodes[node].fanin0; }
+  [[nodiscard]] lit_t get_fanin1(node_t node) const { return m_nodes[node].fanin1; }
+  /// \brief Returns the length of the longest path from an input to \a node.
+  [[nodiscard]] std::uint_least32_t get_level(node_t node) const { return m_nodes[node].level; }
+
+  /// \brief Returns the positive literal of a new input.
+  [[nodiscard]] lit_t add_input();
+  /// \brief Returns the input nodes, in creation order.
+  [[nodiscard]] const std::vector<node_t> &get_inputs() const { return m_inputs; }
+
+  [[nodiscard]] lit_t make_and(lit_t a, lit_t b);
+  [[nodiscard]] lit_t make_or(lit_t a, lit_t b) { return negate(make_and(negate(a), negate(b))); }
+  [[nodiscard]] lit_t make_xor(lit_t a, lit_t b);
+  /// \brief Returns `choice ? second : first`, like the `MUX` instruction.
+  [[nodiscard]] lit_t make_mux(lit_t choice, lit_t first, lit_t second);
+
+  /// \brief Returns the count of references to each node by the AND nodes
+  /// reachable from \a roots and by \a roots themselves.
+  [[nodiscard]] std::vector<std::uint_least32_t> count_fanouts(const std::vector<lit_t> &roots) const;
+
+  /// \brief Copies the logic reachable from \a roots into a new graph, rebuilding
+  /// each node with make_and() (which removes the unreachable nodes and
+  /// applies the rewriting rules again) and updates \a roots.
+  ///
+  /// All inputs are kept, in the same order.
+  [[nodiscard]] Aig rebuild(std::vector<lit_t> &roots) const;
+
+  /// \brief Copies the logic reachable from \a roots into a new graph with a
+  /// minimal depth and updates \a roots.
+  ///
+  /// Each maximal tree of AND nodes (through non-complemented edges and nodes
+  /// without other fanouts) is flattened into a multi-input AND whose operands
+  /// are then combined by increasing level, like the `balance` command of ABC.
+  /// All inputs are kept, in the same order. The count of AND nodes does not increase.
+  [[nodiscard]] Aig balance(std::vector<lit_t> &roots) const;
+
+private:
+  static constexpr lit_t NO_FANIN = static_cast<lit_t>(-1);
+
+  struct Node {
+    lit_t fanin0;
+    lit_t fanin1;
+    std::uint_least32_t level;
+  };
+
+  [[nodiscard]] lit_t simplify_and(lit_t a, lit_t b);
+  [[nodiscard]] lit_t make_and_node(lit_t a, lit_t b);
+  /// Adds the inputs of \a source and returns the literals of this graph
+  /// corresponding to its nodes (only the constant and the inputs are set).
+  [[nodiscard]] std::vector<lit_t> copy_inputs(const Aig &source);
+
+  std::vector<Node> m_nodes;
+  std::vector<node_t> m_inputs;
+  std::unordered_map<std::uint_least64_t, node_t> m_strash;
+};
+
+#endif // NETLIST_SRC_PASSES_AIG_HPP
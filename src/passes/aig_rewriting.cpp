@@ -0,0 +1,448 @@
+#include "aig_rewriting.hpp"
+#include "aig.hpp"
+#include "cone.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <unordered_map>
+
+namespace {
+constexpr Aig::lit_t NO_LITERAL = std::numeric_limits<Aig::lit_t>::max();
+
+/// Returns true if \a instruction is lowered to the AIG when its result has a single bit.
+[[nodiscard]] bool is_bit_logic(const Instruction *instruction) {
+  return dynamic_cast<const ConstInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const LoadInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const NotInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const AndInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const NandInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const OrInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const NorInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const XorInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const XnorInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const MuxInstruction *>(instruction) != nullptr;
+}
+
+/// The instruction computing a node of the AIG when it is raised back.
+struct Gate {
+  enum Kind : std::uint_least8_t {
+    AND, // AND lhs rhs
+    NOR, // NOR lhs rhs
+    XOR, // XOR lhs rhs
+    MUX, // MUX choice first second
+  };
+
+  Kind kind = AND;
+  /// The literals read by the instruction.
+  Aig::lit_t operands[3] = {};
+  /// True if the instruction computes the complement of the node (only for XOR and MUX).
+  bool is_negated = false;
+
+  [[nodiscard]] std::size_t get_operand_count() const { return kind == MUX ? 3 : 2; }
+  /// Returns true if the complement of the instruction is also an instruction (e.g. `NAND` for `AND`).
+  [[nodiscard]] bool is_invertible() const { return kind != MUX; }
+};
+
+class AigRewriter {
+public:
+  AigRewriter(const std::shared_ptr<Program> &program, bool balance)
+      : m_program(program), m_def_use(DefUseInfo::build(*program)), m_balance(balance) {}
+
+  bool run() {
+    if (!lower())
+      return false;
+
+    std::vector<Aig::lit_t> roots;
+    for (const auto &root : m_roots)
+      roots.push_back(root.second);
+    m_aig = m_aig.rebuild(roots);
+    if (m_balance)
+      m_aig = m_aig.balance(roots);
+    for (std::size_t i = 0; i < roots.size(); ++i)
+      m_roots[i].second = roots[i];
+
+    plan_gates();
+    const auto [instruction_count, depth] = raise(/* emit= */ false);
+    if (instruction_count > m_lowered_count || (instruction_count == m_lowered_count && depth >= m_lowered_depth))
+      return false;
+
+    erase_instructions_if(*m_program, [this](const Instruction *instruction) {
+      return m_is_lowered[instruction->output.index];
+    });
+    (void)raise(/* emit= */ true);
+    erase_dead_instructions(*m_program);
+    return true;
+  }
+
+private:
+  [[nodiscard]] bool is_lowered_instruction(const Instruction *instruction) const {
+    // Registers written by the user are not only defined by their instruction.
+    const auto &registers = m_program->registers;
+    const auto output = instruction->output;
+    return registers.get_bus_size(output) == 1 && (registers.get_flags(output) & RIF_INPUT) == 0 &&
+           is_bit_logic(instruction);
+  }
+
+  /// Returns the literal of \a reg, registers that are not lowered become inputs of the AIG.
+  [[nodiscard]] Aig::lit_t get_literal(reg_t reg) {
+    if (m_literals[reg.index] == NO_LITERAL) {
+      assert(!m_is_lowered[reg.index]);
+      m_literals[reg.index] = m_aig.add_input();
+      m_leaves.push_back(reg);
+    }
+
+    return m_literals[reg.index];
+  }
+
+  [[nodiscard]] Aig::lit_t lower_instruction(const Instruction *instruction) {
+    if (const auto *constant = dynamic_cast<const ConstInstruction *>(instruction))
+      return Aig::make_literal(0, (constant->value & 1) != 0);
+    if (const auto *load = dynamic_cast<const LoadInstruction *>(instruction))
+      return get_literal(load->input);
+    if (const auto *not_gate = dynamic_cast<const NotInstruction *>(instruction))
+      return Aig::negate(get_literal(not_gate->input));
+    if (const auto *mux = dynamic_cast<const MuxInstruction *>(instruction))
+      return m_aig.make_mux(get_literal(mux->choice), get_literal(mux->first), get_literal(mux->second));
+
+    const auto *binary = static_cast<const BinaryInstruction *>(instruction);
+    const auto lhs = get_literal(binary->lhs);
+    const auto rhs = get_literal(binary->rhs);
+    if (dynamic_cast<const AndInstruction *>(instruction) != nullptr)
+      return m_aig.make_and(lhs, rhs);
+    if (dynamic_cast<const NandInstruction *>(instruction) != nullptr)
+      return Aig::negate(m_aig.make_and(lhs, rhs));
+    if (dynamic_cast<const OrInstruction *>(instruction) != nullptr)
+      return m_aig.make_or(lhs, rhs);
+    if (dynamic_cast<const NorInstruction *>(instruction) != nullptr)
+      return Aig::negate(m_aig.make_or(lhs, rhs));
+    if (dynamic_cast<const XorInstruction *>(instruction) != nullptr)
+      return m_aig.make_xor(lhs, rhs);
+    return Aig::negate(m_aig.make_xor(lhs, rhs));
+  }
+
+  /// Builds the AIG of the 1-bit logic, returns false if there is none.
+  bool lower() {
+    const auto order = sort_combinational(*m_program, m_def_use);
+    if (!order.has_value())
+      return false; // combinational loop, reported later by the scheduler
+
+    const auto register_count = m_program->registers.size();
+    m_literals.assign(register_count, NO_LITERAL);
+    m_is_lowered.assign(register_count, false);
+    std::vector<std::uint_least32_t> levels(register_count, 0);
+    for (const auto *instruction : *order) {
+      if (!is_lowered_instruction(instruction))
+        continue;
+
+      const auto output = instruction->output.index;
+      m_literals[output] = lower_instruction(instruction);
+      m_is_lowered[output] = true;
+      ++m_lowered_count;
+      if (dynamic_cast<const ConstInstruction *>(instruction) == nullptr) {
+        for (const auto input : get_instruction_inputs(*instruction))
+          levels[output] = std::max(levels[output], levels[input.index]);
+        ++levels[output];
+      }
+    }
+
+    if (m_lowered_count == 0)
+      return false;
+
+    // The lowered registers read by other instructions or observed by the user
+    // must keep their value.
+    std::vector<bool> is_root(register_count, false);
+    for (const auto *instruction : m_program->instructions) {
+      if (m_is_lowered[instruction->output.index])
+        continue;
+
+      for (const auto input : get_instruction_inputs(*instruction))
+        is_root[input.index] = true;
+    }
+
+    for (reg_index_t i = 0; i < register_count; ++i) {
+      if (m_is_lowered[i] && (is_root[i] || (m_program->registers.get_flags({i}) & RIF_OUTPUT))) {
+        m_roots.emplace_back(reg_t{i}, m_literals[i]);
+        m_lowered_depth = std::max(m_lowered_depth, levels[i]);
+      }
+    }
+
+    return true;
+  }
+
+  /// Returns the instruction computing \a node, before choosing the polarity of its operands.
+  [[nodiscard]] Gate match_gate(Aig::node_t node, const std::vector<std::uint_least32_t> &fanouts) const {
+    const auto lhs = m_aig.get_fanin0(node);
+    const auto rhs = m_aig.get_fanin1(node);
+    Gate gate;
+    gate.operands[0] = lhs;
+    gate.operands[1] = rhs;
+    if (!Aig::is_complemented(lhs) || !Aig::is_complemented(rhs))
+      return gate;
+
+    // node = !(c & x) & !(!c & y), that is !(c ? x : y), when the inner nodes
+    // are not used elsewhere.
+    const auto p = Aig::get_node(lhs);
+    const auto q = Aig::get_node(rhs);
+    if (!m_aig.is_and(p) || !m_aig.is_and(q) || fanouts[p] != 1 || fanouts[q] != 1)
+      return gate;
+
+    const Aig::lit_t p_fanins[] = {m_aig.get_fanin0(p), m_aig.get_fanin1(p)};
+    const Aig::lit_t q_fanins[] = {m_aig.get_fanin0(q), m_aig.get_fanin1(q)};
+    for (int i = 0; i < 2; ++i) {
+      for (int j = 0; j < 2; ++j) {
+        if (p_fanins[i] != Aig::negate(q_fanins[j]))
+          continue;
+
+        const auto c = p_fanins[i];
+        const auto x = p_fanins[1 - i];
+        const auto y = q_fanins[1 - j];
+        if (x == Aig::negate(y)) {
+          // !(c ? x : !x) = XOR c x
+          gate.kind = Gate::XOR;
+          gate.operands[0] = c;
+          gate.operands[1] = x;
+        } else {
+          gate.kind = Gate::MUX;
+          gate.operands[0] = c;
+          gate.operands[1] = y;
+          gate.operands[2] = x;
+          gate.is_negated = true;
+        }
+        return gate;
+      }
+    }
+
+    return gate;
+  }
+
+  /// Returns the count of `NOT` instructions needed if \a lit also needs a register.
+  [[nodiscard]] std::size_t get_cost(Aig::lit_t lit) const {
+    if (m_is_needed[lit])
+      return 0;
+    // The inputs only have a positive register, the gates have the one
+    // they compute first for free.
+    if (m_aig.is_input(Aig::get_node(lit)))
+      return Aig::is_complemented(lit) ? 1 : 0;
+    return m_is_needed[Aig::negate(lit)] ? 1 : 0;
+  }
+
+  /// Chooses the polarity of the operands of \a gate (computing \a node) that
+  /// needs the fewest `NOT` instructions given the literals already needed.
+  void choose_polarities(Aig::node_t node, Gate &gate) const {
+    auto &operands = gate.operands;
+    const auto flip = [](Aig::lit_t &lit) { lit = Aig::negate(lit); };
+    switch (gate.kind) {
+    case Gate::AND:
+    case Gate::NOR:
+      // x & y = NOR !x !y
+      if (get_cost(Aig::negate(operands[0])) + get_cost(Aig::negate(operands[1])) <
+          get_cost(operands[0]) + get_cost(operands[1])) {
+        gate.kind = Gate::NOR;
+        flip(operands[0]);
+        flip(operands[1]);
+      }
+      break;
+    case Gate::XOR:
+      // XOR !x y = XNOR x y
+      for (int i = 0; i < 2; ++i) {
+        if (get_cost(Aig::negate(operands[i])) < get_cost(operands[i])) {
+          flip(operands[i]);
+          gate.is_negated = !gate.is_negated;
+        }
+      }
+      break;
+    case Gate::MUX: {
+      // MUX !c x y = MUX c y x and MUX c !x !y = NOT (MUX c x y)
+      if (get_cost(Aig::negate(operands[0])) < get_cost(operands[0])) {
+        flip(operands[0]);
+        std::swap(operands[1], operands[2]);
+      }
+
+      // The MUX only computes one polarity of the node.
+      const auto positive = Aig::make_literal(node);
+      const auto get_output_cost = [&](bool is_negated) -> std::size_t {
+        return m_is_needed[is_negated ? positive : Aig::negate(positive)] ? 1 : 0;
+      };
+      if (get_cost(Aig::negate(operands[1])) + get_cost(Aig::negate(operands[2])) +
+              get_output_cost(!gate.is_negated) <
+          get_cost(operands[1]) + get_cost(operands[2]) + get_output_cost(gate.is_negated)) {
+        flip(operands[1]);
+        flip(operands[2]);
+        gate.is_negated = !gate.is_negated;
+      }
+      break;
+    }
+    }
+  }
+
+  /// Chooses the instruction of each node and the literals that need a register.
+  void plan_gates() {
+    std::vector<Aig::lit_t> roots;
+    for (const auto &root : m_roots)
+      roots.push_back(root.second);
+    const auto fanouts = m_aig.count_fanouts(roots);
+
+    m_gates.assign(m_aig.get_node_count(), {});
+    m_is_needed.assign(2 * m_aig.get_node_count(), false);
+    for (const auto root : roots)
+      m_is_needed[root] = true;
+
+    // The users of a node have larger indices, so all the literals needed by
+    // them are known when the node is visited.
+    for (auto node = m_aig.get_node_count(); node-- > 1;) {
+      const auto lit = Aig::make_literal(node);
+      if (!m_aig.is_and(node) || (!m_is_needed[lit] && !m_is_needed[Aig::negate(lit)]))
+        continue;
+
+      auto &gate = m_gates[node];
+      gate = match_gate(node, fanouts);
+      choose_polarities(node, gate);
+      for (std::size_t i = 0; i < gate.get_operand_count(); ++i)
+        m_is_needed[gate.operands[i]] = true;
+    }
+  }
+
+  struct Value {
+    reg_t reg;
+    std::uint_least32_t level = 0;
+  };
+
+  /// Creates the instructions computing the roots (or only counts them if
+  /// \a emit is false) and returns their count and their depth.
+  std::pair<std::size_t, std::uint_least32_t> raise(bool emit) {
+    ProgramBuilder builder(m_program);
+    std::size_t instruction_count = 0;
+    std::vector<Value> values(2 * m_aig.get_node_count());
+
+    // The first root with a given literal directly receives its value.
+    std::unordered_map<Aig::lit_t, reg_t> root_registers;
+    for (const auto &[reg, lit] : m_roots)
+      root_registers.try_emplace(lit, reg);
+    const auto get_output = [&](Aig::lit_t lit) {
+      if (const auto it = root_registers.find(lit); it != root_registers.end())
+        return it->second;
+      return emit ? builder.add_register(1) : reg_t{};
+    };
+
+    const auto add_not = [&](Aig::lit_t lit) {
+      const auto &input = values[Aig::negate(lit)];
+      values[lit] = {get_output(lit), input.level + 1};
+      if (emit)
+        builder.add_not(values[lit].reg, input.reg);
+      ++instruction_count;
+    };
+
+    const auto &inputs = m_aig.get_inputs();
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+      const auto lit = Aig::make_literal(inputs[i]);
+      values[lit] = {m_leaves[i], 0};
+      if (m_is_needed[Aig::negate(lit)])
+        add_not(Aig::negate(lit));
+    }
+
+    for (Aig::node_t node = 1; node < m_aig.get_node_count(); ++node) {
+      const auto positive = Aig::make_literal(node);
+      const auto negative = Aig::negate(positive);
+      if (!m_aig.is_and(node) || (!m_is_needed[positive] && !m_is_needed[negative]))
+        continue;
+
+      // An invertible gate directly computes the first needed polarity, the
+      // other one is the NOT of it.
+      const auto &gate = m_gates[node];
+      auto lit = gate.is_negated ? negative : positive;
+      if (gate.is_invertible())
+        lit = m_is_needed[positive] ? positive : negative;
+
+      std::uint_least32_t level = 0;
+      reg_t operands[3];
+      for (std::size_t i = 0; i < gate.get_operand_count(); ++i) {
+        operands[i] = values[gate.operands[i]].reg;
+        level = std::max(level, values[gate.operands[i]].level);
+      }
+
+      values[lit] = {get_output(lit), level + 1};
+      ++instruction_count;
+      if (emit) {
+        const auto output = values[lit].reg;
+        const bool is_inverted = gate.is_negated != (lit == negative);
+        switch (gate.kind) {
+        case Gate::AND:
+          is_inverted ? (void)builder.add_nand(output, operands[0], operands[1])
+                      : (void)builder.add_and(output, operands[0], operands[1]);
+          break;
+        case Gate::NOR:
+          is_inverted ? (void)builder.add_or(output, operands[0], operands[1])
+                      : (void)builder.add_nor(output, operands[0], operands[1]);
+          break;
+        case Gate::XOR:
+          is_inverted ? (void)builder.add_xnor(output, operands[0], operands[1])
+                      : (void)builder.add_xor(output, operands[0], operands[1]);
+          break;
+        case Gate::MUX:
+          assert(!is_inverted);
+          builder.add_mux(output, operands[0], operands[1], operands[2]);
+          break;
+        }
+      }
+
+      if (m_is_needed[Aig::negate(lit)])
+        add_not(Aig::negate(lit));
+    }
+
+    // The other roots are copies.
+    std::uint_least32_t depth = 0;
+    for (const auto &[reg, lit] : m_roots) {
+      if (Aig::is_constant(lit)) {
+        if (emit)
+          builder.add_const(reg, lit == Aig::TRUE ? 1 : 0);
+        ++instruction_count;
+        continue;
+      }
+
+      auto level = values[lit].level;
+      if (values[lit].reg != reg) {
+        if (emit)
+          builder.add_load(reg, values[lit].reg);
+        ++instruction_count;
+        ++level;
+      }
+
+      depth = std::max(depth, level);
+    }
+
+    return {instruction_count, depth};
+  }
+
+private:
+  std::shared_ptr<Program> m_program;
+  DefUseInfo m_def_use;
+  bool m_balance;
+
+  Aig m_aig;
+  /// The literal of each register (lowered or input of the AIG).
+  std::vector<Aig::lit_t> m_literals;
+  std::vector<bool> m_is_lowered;
+  std::size_t m_lowered_count = 0;
+  std::uint_least32_t m_lowered_depth = 0;
+  /// The register of each input of the AIG.
+  std::vector<reg_t> m_leaves;
+  /// The lowered registers that must keep their value, and their literal.
+  std::vector<std::pair<reg_t, Aig::lit_t>> m_roots;
+
+  std::vector<Gate> m_gates;
+  /// The literals needing a register, indexed by literal.
+  std::vector<bool> m_is_needed;
+};
+} // namespace
+
+// ========================================================
+// class AigRewritingPass
+// ========================================================
+
+bool AigRewritingPass::run(const std::shared_ptr<Program> &program) {
+  assert(program != nullptr);
+
+  AigRewriter rewriter(program, m_balance);
+  return rewriter.run();
+}
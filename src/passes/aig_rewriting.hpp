@@ -0,0 +1,41 @@
+#ifndef NETLIST_SRC_PASSES_AIG_REWRITING_HPP
+#define NETLIST_SRC_PASSES_AIG_REWRITING_HPP
+
+#include "pass.hpp"
+
+// ========================================================
+// class AigRewritingPass
+// ========================================================
+
+/// \ingroup passes
+/// \brief Minimizes the 1-bit logic of the program by rewriting it as an
+/// And-Inverter Graph (see Aig).
+///
+/// The 1-bit `NOT`, `AND`, `NAND`, `OR`, `NOR`, `XOR`, `XNOR`, `MUX`, `CONST`
+/// and copy instructions are lowered to a single AIG whose inputs are the other
+/// registers they read. Building the graph merges the structurally equal gates
+/// (even across the whole program) and applies local rewriting rules. If
+/// requested, the graph is then balanced to reduce its depth.
+///
+/// The graph is finally raised back to instructions: the AND trees matching a
+/// multiplexer or an exclusive or become `MUX` and `XOR`/`XNOR` again, and the
+/// complemented edges are folded into `NAND`, `OR` and `NOR` when possible.
+/// The registers read outside of the logic keep their values, the others
+/// disappear.
+///
+/// The program is only changed if the new logic has fewer instructions, or as
+/// many instructions but a smaller depth.
+class AigRewritingPass final : public Pass {
+public:
+  /// \param balance True to also minimize the depth of the logic.
+  explicit AigRewritingPass(bool balance = false) : m_balance(balance) {}
+
+  [[nodiscard]] std::string_view get_name() const override { return "aig-rewriting"; }
+
+  bool run(const std::shared_ptr<Program> &program) override;
+
+private:
+  bool m_balance;
+};
+
+#endif // NETLIST_SRC_PASSES_AIG_REWRITING_HPP
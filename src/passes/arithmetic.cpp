@@ -0,0 +1,561 @@
+#include "arithmetic.hpp"
+#include "bit_algebra.hpp"
+#include "bit_gather.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <optional>
+#include <random>
+#include <unordered_map>
+
+namespace {
+/// Cones with more gates than this are not considered.
+constexpr std::size_t MAX_CONE_GATES = 4096;
+/// Cones with more leaf bits than this are not considered.
+constexpr std::size_t MAX_CONE_LEAVES = 128;
+/// The node limit of the BDD used to prove a match.
+constexpr std::size_t MAX_BDD_NODES = 1 << 18;
+
+/// Returns true if each bit of the result of \a instruction only depends on
+/// the same bit of its operands (and on the choice for `MUX`).
+[[nodiscard]] bool is_bitwise_gate(const Instruction *instruction) {
+  return dynamic_cast<const NotInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const AndInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const NandInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const OrInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const NorInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const XorInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const XnorInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const MuxInstruction *>(instruction) != nullptr;
+}
+
+/// Returns a key identifying the (non-constant) bit \a source.
+[[nodiscard]] std::uint_least64_t get_bit_key(BitSource source) {
+  return (std::uint_least64_t(source.reg.index) << 6) | source.bit;
+}
+
+/// The functions recognized by the pass.
+enum class ArithmeticKind {
+  ADD,          // X + Y
+  SUB,          // X - Y
+  SUB_REVERSED, // Y - X
+  INCREMENT,    // X + 1
+  DECREMENT,    // X - 1
+  EQ,           // X == Y
+  LT,           // X < Y
+  LT_REVERSED,  // Y < X
+  CARRY,        // the carry out of X + Y
+  EQ_CONSTANT,  // X == K
+};
+
+struct ArithmeticMatch {
+  ArithmeticKind kind;
+  /// True if the result is the negation of the function (only for 1-bit results).
+  bool negated = false;
+  /// The constant K of EQ_CONSTANT.
+  reg_value_t constant = 0;
+};
+
+/// Returns the value of the function \a kind for the operands \a x and \a y of \a width bits.
+[[nodiscard]] reg_value_t evaluate_kind(ArithmeticKind kind, reg_value_t x, reg_value_t y, bus_size_t width) {
+  switch (kind) {
+  case ArithmeticKind::ADD:
+    return x + y;
+  case ArithmeticKind::SUB:
+    return x - y;
+  case ArithmeticKind::SUB_REVERSED:
+    return y - x;
+  case ArithmeticKind::INCREMENT:
+    return x + 1;
+  case ArithmeticKind::DECREMENT:
+    return x - 1;
+  case ArithmeticKind::EQ:
+    return x == y;
+  case ArithmeticKind::LT:
+    return x < y;
+  case ArithmeticKind::LT_REVERSED:
+    return y < x;
+  case ArithmeticKind::CARRY:
+    return (~x & get_bus_mask(width)) < y;
+  case ArithmeticKind::EQ_CONSTANT:
+    break;
+  }
+
+  assert(false && "unreachable");
+  return 0;
+}
+
+/// Builds the BDD of each bit of the function \a kind, as a textbook circuit,
+/// for the operands \a x and \a y (from the least significant bit). The result
+/// has \a result_size bits; the operands are zero-extended to it if needed.
+[[nodiscard]] std::vector<BddManager::node_t> build_reference(BddManager &manager, ArithmeticKind kind,
+                                                              std::vector<BddManager::node_t> x,
+                                                              std::vector<BddManager::node_t> y,
+                                                              bus_size_t result_size) {
+  using node_t = BddManager::node_t;
+
+  // Returns the sum bits and the carry out of x + y + carry.
+  const auto ripple_carry = [&manager](const std::vector<node_t> &lhs, const std::vector<node_t> &rhs, node_t carry) {
+    std::vector<node_t> sum;
+    for (std::size_t i = 0; i < lhs.size(); ++i) {
+      const auto partial = manager.bdd_xor(lhs[i], rhs[i]);
+      sum.push_back(manager.bdd_xor(partial, carry));
+      carry = manager.bdd_or(manager.bdd_and(lhs[i], rhs[i]), manager.bdd_and(partial, carry));
+    }
+    return std::make_pair(sum, carry);
+  };
+  const auto negate = [&manager](std::vector<node_t> bits) {
+    for (auto &bit : bits)
+      bit = manager.bdd_not(bit);
+    return bits;
+  };
+
+  switch (kind) {
+  case ArithmeticKind::ADD:
+  case ArithmeticKind::SUB:
+  case ArithmeticKind::SUB_REVERSED:
+  case ArithmeticKind::INCREMENT:
+  case ArithmeticKind::DECREMENT: {
+    x.resize(result_size, BddManager::ZERO);
+    y.resize(result_size, BddManager::ZERO);
+    if (kind == ArithmeticKind::SUB_REVERSED)
+      std::swap(x, y);
+    if (kind == ArithmeticKind::INCREMENT)
+      std::ranges::fill(y, BddManager::ZERO);
+    if (kind == ArithmeticKind::DECREMENT)
+      std::ranges::fill(y, BddManager::ONE);
+
+    if (kind == ArithmeticKind::SUB || kind == ArithmeticKind::SUB_REVERSED)
+      return ripple_carry(x, negate(y), BddManager::ONE).first;
+    return ripple_carry(x, y, BddManager::get_constant(kind == ArithmeticKind::INCREMENT)).first;
+  }
+  case ArithmeticKind::EQ: {
+    auto result = BddManager::ONE;
+    for (std::size_t i = 0; i < x.size(); ++i)
+      result = manager.bdd_and(result, manager.bdd_not(manager.bdd_xor(x[i], y[i])));
+    return {result};
+  }
+  case ArithmeticKind::LT:
+  case ArithmeticKind::LT_REVERSED:
+    // X < Y if and only if X + ~Y + 1 has no carry out.
+    if (kind == ArithmeticKind::LT_REVERSED)
+      std::swap(x, y);
+    return {manager.bdd_not(ripple_carry(x, negate(y), BddManager::ONE).second)};
+  case ArithmeticKind::CARRY:
+    return {ripple_carry(x, y, BddManager::ZERO).second};
+  case ArithmeticKind::EQ_CONSTANT:
+    break;
+  }
+
+  assert(false && "unreachable");
+  return {};
+}
+
+/// The gates computing some bits, as found by ArithmeticRewriter::collect_bit().
+struct Cone {
+  /// The bits, not computed by a gate, read by the gates.
+  std::vector<BitSource> leaves;
+  std::size_t gate_count = 0;
+};
+
+struct ArithmeticRewriter {
+  Program &program;
+  DefUseInfo def_use;
+  ProgramBuilder builder;
+  /// True for registers read by an instruction that is not a bitwise gate.
+  std::vector<bool> has_non_gate_users;
+  /// The previous definitions of the rewritten registers.
+  std::vector<const Instruction *> to_delete;
+
+  explicit ArithmeticRewriter(const std::shared_ptr<Program> &p)
+      : program(*p), def_use(DefUseInfo::build(*p)), builder(p), has_non_gate_users(p->registers.size(), false) {
+    for (const auto *instruction : program.instructions) {
+      if (is_bitwise_gate(instruction))
+        continue;
+
+      for (const auto input : get_instruction_inputs(*instruction))
+        has_non_gate_users[input.index] = true;
+    }
+  }
+
+  [[nodiscard]] bus_size_t get_bus_size(reg_t reg) const { return program.registers.get_bus_size(reg); }
+
+  /// Returns the gate computing \a source or null.
+  [[nodiscard]] const Instruction *get_gate(BitSource source) const {
+    if (source.is_constant() || source.reg.index >= def_use.definitions.size())
+      return nullptr;
+
+    const auto *definition = def_use.definitions[source.reg.index];
+    return is_bitwise_gate(definition) ? definition : nullptr;
+  }
+
+  /// Calls \a f with the register and the bit index of each operand bit
+  /// needed to compute the bit \a bit of \a gate.
+  template <class F> static bool for_each_operand_bit(const Instruction *gate, bus_size_t bit, F f) {
+    if (const auto *not_gate = dynamic_cast<const NotInstruction *>(gate))
+      return f(not_gate->input, bit);
+    if (const auto *mux = dynamic_cast<const MuxInstruction *>(gate))
+      return f(mux->choice, 0) && f(mux->first, bit) && f(mux->second, bit);
+
+    const auto *binary = dynamic_cast<const BinaryInstruction *>(gate);
+    assert(binary != nullptr);
+    return f(binary->lhs, bit) && f(binary->rhs, bit);
+  }
+
+  /// Adds the gates computing the bit \a bit of \a reg to \a cone.
+  ///
+  /// \a visited maps the visited bits to true once they are fully collected.
+  /// Returns false if the cone is too large or has a combinational loop.
+  bool collect_bit(Cone &cone, std::unordered_map<std::uint_least64_t, bool> &visited, reg_t reg, bus_size_t bit) const {
+    const auto source = trace_bit(program, def_use, reg, bit);
+    if (source.is_constant())
+      return true;
+
+    const auto key = get_bit_key(source);
+    if (const auto [it, inserted] = visited.try_emplace(key, false); !inserted)
+      return it->second; // still false while visiting it, that is in a loop
+
+    const auto *gate = get_gate(source);
+    if (gate == nullptr) {
+      visited[key] = true;
+      cone.leaves.push_back(source);
+      return cone.leaves.size() <= MAX_CONE_LEAVES;
+    }
+
+    if (++cone.gate_count > MAX_CONE_GATES)
+      return false;
+    if (!for_each_operand_bit(gate, source.bit, [&](reg_t input, bus_size_t input_bit) {
+          return collect_bit(cone, visited, input, input_bit);
+        }))
+      return false;
+
+    visited[key] = true;
+    return true;
+  }
+
+  /// Evaluates the bit \a bit of \a reg. The values of the cone leaves must be in \a values.
+  template <class Algebra>
+  typename Algebra::value_type evaluate(const Algebra &algebra,
+                                        std::unordered_map<std::uint_least64_t, typename Algebra::value_type> &values,
+                                        reg_t reg, bus_size_t bit) const {
+    const auto source = trace_bit(program, def_use, reg, bit);
+    if (source.is_constant())
+      return algebra.make_constant(source.bit != 0);
+
+    const auto key = get_bit_key(source);
+    if (const auto it = values.find(key); it != values.end())
+      return it->second;
+
+    const auto *gate = get_gate(source);
+    assert(gate != nullptr);
+    const auto operand = [&](reg_t input, bus_size_t input_bit) { return evaluate(algebra, values, input, input_bit); };
+
+    typename Algebra::value_type value;
+    if (const auto *not_gate = dynamic_cast<const NotInstruction *>(gate)) {
+      value = algebra.make_not(operand(not_gate->input, source.bit));
+    } else if (const auto *mux = dynamic_cast<const MuxInstruction *>(gate)) {
+      value = algebra.make_mux(operand(mux->choice, 0), operand(mux->first, source.bit),
+                               operand(mux->second, source.bit));
+    } else {
+      const auto *binary = static_cast<const BinaryInstruction *>(gate);
+      const auto lhs = operand(binary->lhs, source.bit);
+      const auto rhs = operand(binary->rhs, source.bit);
+      if (dynamic_cast<const AndInstruction *>(gate) != nullptr)
+        value = algebra.make_and(lhs, rhs);
+      else if (dynamic_cast<const NandInstruction *>(gate) != nullptr)
+        value = algebra.make_not(algebra.make_and(lhs, rhs));
+      else if (dynamic_cast<const OrInstruction *>(gate) != nullptr)
+        value = algebra.make_or(lhs, rhs);
+      else if (dynamic_cast<const NorInstruction *>(gate) != nullptr)
+        value = algebra.make_not(algebra.make_or(lhs, rhs));
+      else if (dynamic_cast<const XorInstruction *>(gate) != nullptr)
+        value = algebra.make_xor(lhs, rhs);
+      else
+        value = algebra.make_not(algebra.make_xor(lhs, rhs));
+    }
+
+    values.emplace(key, value);
+    return value;
+  }
+
+  /// Returns the BDD of each bit of \a reg where the bit i of the operand j is
+  /// the variable `i * operands.size() + j`. The variables of the operands are
+  /// interleaved from the least significant bit to keep the BDDs of arithmetic
+  /// functions small.
+  [[nodiscard]] std::vector<BddManager::node_t>
+  build_cone_bdds(BddManager &manager, std::vector<std::vector<BddManager::node_t>> &operand_variables, reg_t reg,
+                  const std::vector<BitSources> &operands) const {
+    std::unordered_map<std::uint_least64_t, BddManager::node_t> values;
+    operand_variables.assign(operands.size(), {});
+    for (std::size_t i = 0; i < operands.front().size(); ++i) {
+      for (std::size_t j = 0; j < operands.size(); ++j) {
+        const auto variable = manager.get_variable(static_cast<BddManager::var_t>(i * operands.size() + j));
+        values.emplace(get_bit_key(operands[j][i]), variable);
+        operand_variables[j].push_back(variable);
+      }
+    }
+
+    const BddAlgebra algebra{manager};
+    std::vector<BddManager::node_t> bits;
+    for (bus_size_t i = 0; i < get_bus_size(reg); ++i)
+      bits.push_back(evaluate(algebra, values, reg, i));
+    return bits;
+  }
+
+  /// Proves that \a reg computes \a match of the operands.
+  [[nodiscard]] bool prove(reg_t reg, const std::vector<BitSources> &operands, const ArithmeticMatch &match) const {
+    BddManager manager(MAX_BDD_NODES);
+    std::vector<std::vector<BddManager::node_t>> variables;
+    const auto bits = build_cone_bdds(manager, variables, reg, operands);
+    variables.resize(2);
+    auto expected = build_reference(manager, match.kind, variables[0], variables[1], get_bus_size(reg));
+    if (match.negated)
+      expected.front() = manager.bdd_not(expected.front());
+    return !manager.has_overflowed() && bits == expected;
+  }
+
+  /// Tries to find a constant K such that the 1-bit register \a reg is `X == K` or its negation.
+  [[nodiscard]] std::optional<ArithmeticMatch> match_eq_constant(reg_t reg, const BitSources &operand) const {
+    BddManager manager(MAX_BDD_NODES);
+    std::vector<std::vector<BddManager::node_t>> variables;
+    const auto bit = build_cone_bdds(manager, variables, reg, {operand}).front();
+    if (manager.has_overflowed())
+      return std::nullopt;
+
+    const auto width = static_cast<BddManager::var_t>(operand.size());
+    for (const bool negated : {false, true}) {
+      const auto minterm = manager.get_single_minterm(negated ? manager.bdd_not(bit) : bit, width);
+      if (!minterm.has_value())
+        continue;
+
+      reg_value_t constant = 0;
+      for (std::size_t i = 0; i < minterm->size(); ++i)
+        constant |= reg_value_t((*minterm)[i]) << i;
+      return ArithmeticMatch{ArithmeticKind::EQ_CONSTANT, negated, constant};
+    }
+
+    return std::nullopt;
+  }
+
+  /// Returns true if \a bits are exactly the bits of a register, in order.
+  [[nodiscard]] bool is_whole_register(const BitSources &bits) const {
+    if (bits.front().is_constant() || get_bus_size(bits.front().reg) != bits.size())
+      return false;
+    for (bus_size_t i = 0; i < bits.size(); ++i) {
+      if (bits[i] != BitSource{bits.front().reg, i})
+        return false;
+    }
+    return true;
+  }
+
+  /// Replaces the definition of \a reg by \a match of the operands if that is cheaper than \a cone.
+  bool replace(reg_t reg, std::vector<BitSources> operands, const ArithmeticMatch &match, const Cone &cone) {
+    const auto bus_size = get_bus_size(reg);
+    const auto operand_width = operands.front().size();
+
+    // Word results are computed on zero-extended operands.
+    if (bus_size > 1) {
+      for (auto &operand : operands)
+        operand.resize(bus_size);
+    }
+
+    std::size_t cost = 1 + match.negated;
+    for (const auto &operand : operands)
+      cost += !is_whole_register(operand);
+    if (match.kind == ArithmeticKind::INCREMENT || match.kind == ArithmeticKind::DECREMENT ||
+        match.kind == ArithmeticKind::EQ_CONSTANT || match.kind == ArithmeticKind::CARRY)
+      ++cost;
+    if (cone.gate_count <= cost)
+      return false;
+
+    const auto x = build_bits_register(builder, operands[0]);
+    const auto y = operands.size() > 1 ? build_bits_register(builder, operands[1]) : reg_t{};
+    const auto result = match.negated ? builder.add_register(1) : reg;
+    const auto add_constant = [this](bus_size_t size, reg_value_t value) {
+      const auto constant = builder.add_register(size);
+      builder.add_const(constant, value);
+      return constant;
+    };
+
+    switch (match.kind) {
+    case ArithmeticKind::ADD:
+      builder.add_add(result, x, y);
+      break;
+    case ArithmeticKind::SUB:
+      builder.add_sub(result, x, y);
+      break;
+    case ArithmeticKind::SUB_REVERSED:
+      builder.add_sub(result, y, x);
+      break;
+    case ArithmeticKind::INCREMENT:
+      builder.add_add(result, x, add_constant(bus_size, 1));
+      break;
+    case ArithmeticKind::DECREMENT:
+      builder.add_sub(result, x, add_constant(bus_size, 1));
+      break;
+    case ArithmeticKind::EQ:
+      builder.add_eq(result, x, y);
+      break;
+    case ArithmeticKind::LT:
+      builder.add_lt(result, x, y);
+      break;
+    case ArithmeticKind::LT_REVERSED:
+      builder.add_lt(result, y, x);
+      break;
+    case ArithmeticKind::CARRY: {
+      // X + Y overflows if and only if Y > ~X.
+      const auto not_x = builder.add_register(operand_width);
+      builder.add_not(not_x, x);
+      builder.add_lt(result, not_x, y);
+    } break;
+    case ArithmeticKind::EQ_CONSTANT:
+      builder.add_eq(result, x, add_constant(operand_width, match.constant));
+      break;
+    }
+
+    if (match.negated)
+      builder.add_not(reg, result);
+
+    to_delete.push_back(def_use.definitions[reg.index]);
+    return true;
+  }
+
+  /// Tries to rewrite the definition of \a reg as an arithmetic instruction.
+  bool try_rewrite(reg_t reg) {
+    const auto bus_size = get_bus_size(reg);
+
+    Cone cone;
+    std::unordered_map<std::uint_least64_t, bool> visited;
+    for (bus_size_t i = 0; i < bus_size; ++i) {
+      if (!collect_bit(cone, visited, reg, i))
+        return false;
+    }
+    if (cone.gate_count < 2 || cone.leaves.empty())
+      return false;
+
+    // The operands are the ranges of bits read in at most two registers.
+    std::map<reg_index_t, std::pair<bus_size_t, bus_size_t>> ranges;
+    for (const auto leaf : cone.leaves) {
+      const auto [it, inserted] = ranges.try_emplace(leaf.reg.index, leaf.bit, leaf.bit);
+      it->second.first = std::min(it->second.first, leaf.bit);
+      it->second.second = std::max(it->second.second, leaf.bit);
+    }
+    if (ranges.size() > 2)
+      return false;
+
+    std::vector<BitSources> operands;
+    for (const auto &[index, range] : ranges) {
+      auto &operand = operands.emplace_back();
+      for (bus_size_t i = range.first; i <= range.second; ++i)
+        operand.push_back({{index}, i});
+    }
+
+    const auto width = operands.front().size();
+    if ((operands.size() == 2 && operands[1].size() != width) || (bus_size > 1 && width > bus_size))
+      return false;
+
+    // Simulates the cone on random patterns.
+    std::mt19937_64 random(0x5EED);
+    std::unordered_map<std::uint_least64_t, WordAlgebra::value_type> values;
+    std::vector<std::vector<WordAlgebra::value_type>> operand_words;
+    for (const auto &operand : operands) {
+      auto &words = operand_words.emplace_back();
+      for (const auto bit : operand) {
+        words.push_back(random());
+        values.emplace(get_bit_key(bit), words.back());
+      }
+    }
+
+    std::vector<WordAlgebra::value_type> output_words;
+    for (bus_size_t i = 0; i < bus_size; ++i)
+      output_words.push_back(evaluate(WordAlgebra{}, values, reg, i));
+
+    // Transposes the simulation words to get the values of each pattern.
+    const auto get_pattern = [](const std::vector<WordAlgebra::value_type> &words, unsigned pattern) {
+      reg_value_t value = 0;
+      for (std::size_t i = 0; i < words.size(); ++i)
+        value |= ((words[i] >> pattern) & 1) << i;
+      return value;
+    };
+
+    std::vector<ArithmeticMatch> hypotheses;
+    if (bus_size > 1 && operands.size() == 2) {
+      hypotheses = {{ArithmeticKind::ADD}, {ArithmeticKind::SUB}, {ArithmeticKind::SUB_REVERSED}};
+    } else if (bus_size > 1) {
+      hypotheses = {{ArithmeticKind::INCREMENT}, {ArithmeticKind::DECREMENT}};
+    } else if (operands.size() == 2) {
+      for (const bool negated : {false, true}) {
+        for (const auto kind :
+             {ArithmeticKind::EQ, ArithmeticKind::LT, ArithmeticKind::LT_REVERSED, ArithmeticKind::CARRY})
+          hypotheses.push_back({kind, negated});
+      }
+    } else {
+      // X == K is almost always false (or true when negated) on random patterns of wide operands.
+      if (width >= 8 && output_words.front() != 0 && output_words.front() != ~WordAlgebra::value_type(0))
+        return false;
+
+      const auto match = match_eq_constant(reg, operands.front());
+      return match.has_value() && replace(reg, operands, *match, cone);
+    }
+
+    const auto output_mask = get_bus_mask(bus_size);
+    for (const auto &hypothesis : hypotheses) {
+      bool is_plausible = true;
+      for (unsigned pattern = 0; is_plausible && pattern < 64; ++pattern) {
+        const auto x = get_pattern(operand_words[0], pattern);
+        const auto y = operand_words.size() > 1 ? get_pattern(operand_words[1], pattern) : 0;
+        auto expected = evaluate_kind(hypothesis.kind, x, y, width);
+        if (hypothesis.negated)
+          expected = ~expected;
+        is_plausible = (expected & output_mask) == get_pattern(output_words, pattern);
+      }
+
+      if (is_plausible && prove(reg, operands, hypothesis))
+        return replace(reg, operands, hypothesis, cone);
+    }
+
+    return false;
+  }
+};
+} // namespace
+
+// ========================================================
+// class ArithmeticPass
+// ========================================================
+
+bool ArithmeticPass::run(const std::shared_ptr<Program> &program) {
+  assert(program != nullptr);
+
+  // Buses are matched first so the 1-bit gates that only computed their bits
+  // are removed before looking for 1-bit candidates.
+  bool modified = false;
+  for (const bool is_bus : {true, false}) {
+    ArithmeticRewriter rewriter(program);
+
+    const auto register_count = static_cast<reg_index_t>(program->registers.size());
+    for (reg_index_t i = 0; i < register_count; ++i) {
+      const auto *definition = rewriter.def_use.definitions[i];
+      if (is_bus) {
+        if (dynamic_cast<const ConcatInstruction *>(definition) != nullptr ||
+            dynamic_cast<const GatherInstruction *>(definition) != nullptr)
+          rewriter.try_rewrite({i});
+      } else if (is_bitwise_gate(definition) && program->registers.get_bus_size({i}) == 1 &&
+                 (rewriter.has_non_gate_users[i] || (program->registers.get_flags({i}) & RIF_OUTPUT))) {
+        rewriter.try_rewrite({i});
+      }
+    }
+
+    if (rewriter.to_delete.empty())
+      continue;
+
+    std::ranges::sort(rewriter.to_delete);
+    erase_instructions_if(*program, [&rewriter](const Instruction *instruction) {
+      return std::ranges::binary_search(rewriter.to_delete, instruction);
+    });
+    erase_dead_instructions(*program);
+    modified = true;
+  }
+
+  return modified;
+}
@@ -0,0 +1,41 @@
+#ifndef NETLIST_SRC_PASSES_ARITHMETIC_HPP
+#define NETLIST_SRC_PASSES_ARITHMETIC_HPP
+
+#include "pass.hpp"
+
+// ========================================================
+// class ArithmeticPass
+// ========================================================
+
+/// \ingroup passes
+/// \brief Recognizes bit-blasted arithmetic and replaces it by `ADD`, `SUB`, `EQ` and `LT`.
+///
+/// Netlists produced by logic synthesis compute additions as ripple-carry
+/// chains of `XOR`/`AND`/`OR` gates and comparisons as trees of `XNOR` and
+/// `AND` gates, which costs dozens of instructions where the host machine
+/// needs a single one.
+///
+/// For each candidate register (a bus built from bits with `CONCAT` or
+/// GatherInstruction, or a 1-bit gate used outside of gates), this pass
+/// collects the cone of bitwise gates computing it. If the leaves of the cone
+/// are the bits of at most two registers, the cone is matched against the
+/// following functions of the operands `X` and `Y` formed by these bits:
+/// - for buses: `X + Y`, `X - Y`, `Y - X`, `X + 1` and `X - 1`
+///   (the operands are zero-extended to the bus size);
+/// - for single bits: `X == Y`, `X < Y`, `Y < X`, the carry out of `X + Y`,
+///   `X == K` for a constant `K`, and their negations.
+///
+/// Each hypothesis is first filtered by a bit-parallel simulation of the cone
+/// on 64 random input patterns, then formally proven with binary decision
+/// diagrams (see BddManager). The cone is only replaced when the proof succeeds
+/// and when it has more gates than the instructions replacing it.
+///
+/// Additions with a carry in are not recognized.
+class ArithmeticPass final : public Pass {
+public:
+  [[nodiscard]] std::string_view get_name() const override { return "arithmetic"; }
+
+  bool run(const std::shared_ptr<Program> &program) override;
+};
+
+#endif // NETLIST_SRC_PASSES_ARITHMETIC_HPP
@@ -0,0 +1,108 @@
+#include "bdd.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+// ========================================================
+// class BddManager
+// ========================================================
+
+/// The variable of the terminal nodes, below all other variables.
+static constexpr BddManager::var_t TERMINAL_VAR = std::numeric_limits<BddManager::var_t>::max();
+
+std::size_t BddManager::TripleHash::operator()(const std::tuple<node_t, node_t, node_t> &key) const {
+  const auto [a, b, c] = key;
+  std::uint_least64_t hash = a;
+  hash = hash * 0x9E3779B97F4A7C15 + b;
+  hash = hash * 0x9E3779B97F4A7C15 + c;
+  return static_cast<std::size_t>(hash ^ (hash >> 32));
+}
+
+BddManager::BddManager(std::size_t max_nodes) : m_max_nodes(max_nodes) {
+  m_nodes.push_back({TERMINAL_VAR, ZERO, ZERO});
+  m_nodes.push_back({TERMINAL_VAR, ONE, ONE});
+}
+
+BddManager::node_t BddManager::get_variable(var_t var) {
+  assert(var != TERMINAL_VAR);
+  return make_node(var, ZERO, ONE);
+}
+
+BddManager::node_t BddManager::make_node(var_t var, node_t low, node_t high) {
+  if (low == high)
+    return low;
+
+  const auto key = std::make_tuple(var, low, high);
+  if (const auto it = m_unique_table.find(key); it != m_unique_table.end())
+    return it->second;
+
+  if (m_nodes.size() >= m_max_nodes) {
+    m_overflowed = true;
+    return ZERO;
+  }
+
+  const auto node = static_cast<node_t>(m_nodes.size());
+  m_nodes.push_back({var, low, high});
+  m_unique_table.emplace(key, node);
+  return node;
+}
+
+BddManager::node_t BddManager::ite(node_t f, node_t g, node_t h) {
+  // Terminal cases.
+  if (f == ONE)
+    return g;
+  if (f == ZERO)
+    return h;
+  if (g == h)
+    return g;
+  if (g == ONE && h == ZERO)
+    return f;
+  if (m_overflowed)
+    return ZERO;
+
+  const auto key = std::make_tuple(f, g, h);
+  if (const auto it = m_ite_cache.find(key); it != m_ite_cache.end())
+    return it->second;
+
+  // Shannon expansion on the top variable.
+  const auto var = std::min({get_var(f), get_var(g), get_var(h)});
+  const auto cofactor = [this, var](node_t node, bool value) {
+    if (get_var(node) != var)
+      return node;
+    return value ? m_nodes[node].high : m_nodes[node].low;
+  };
+
+  const auto high = ite(cofactor(f, true), cofactor(g, true), cofactor(h, true));
+  const auto low = ite(cofactor(f, false), cofactor(g, false), cofactor(h, false));
+  const auto result = make_node(var, low, high);
+  m_ite_cache.emplace(key, result);
+  return result;
+}
+
+std::optional<std::vector<bool>> BddManager::get_single_minterm(node_t f, var_t var_count) const {
+  std::vector<bool> assignment;
+  assignment.reserve(var_count);
+
+  // The function is a single minterm if it is a chain testing all variables in
+  // order where, at each node, exactly one branch is ZERO.
+  for (var_t var = 0; var < var_count; ++var) {
+    if (get_var(f) != var)
+      return std::nullopt;
+
+    const auto &node = m_nodes[f];
+    if (node.low == ZERO) {
+      assignment.push_back(true);
+      f = node.high;
+    } else if (node.high == ZERO) {
+      assignment.push_back(false);
+      f = node.low;
+    } else {
+      return std::nullopt;
+    }
+  }
+
+  if (f != ONE)
+    return std::nullopt;
+  return assignment;
+}
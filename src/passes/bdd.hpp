@@ -0,0 +1,81 @@
+#ifndef NETLIST_SRC_PASSES_BDD_HPP
+#define NETLIST_SRC_PASSES_BDD_HPP
+
+#include <cstdint>
+#include <optional>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+// ========================================================
+// class BddManager
+// ========================================================
+
+/// \ingroup passes
+/// \brief A minimal package for reduced ordered binary decision diagrams (ROBDD).
+///
+/// BDDs are a canonical representation of boolean functions: two functions
+/// built by the same manager are equivalent if and only if they are the same
+/// node. Passes use them to formally prove that a rewrite preserves the
+/// semantics of the program.
+///
+/// The variables are ordered by their index (variable 0 is at the top). The
+/// size of a BDD heavily depends on the variable order and is exponential in
+/// the worst case, so the manager has a limit on the count of nodes it can
+/// create. When this limit is reached, has_overflowed() returns true and the
+/// results of all operations are meaningless.
+class BddManager {
+public:
+  using node_t = std::uint_least32_t;
+  using var_t = std::uint_least32_t;
+
+  /// The constant false function.
+  static constexpr node_t ZERO = 0;
+  /// The constant true function.
+  static constexpr node_t ONE = 1;
+
+  explicit BddManager(std::size_t max_nodes = 1 << 20);
+
+  /// \brief Returns true if the node limit was reached.
+  [[nodiscard]] bool has_overflowed() const { return m_overflowed; }
+  /// \brief Returns the count of nodes created so far (including the terminals).
+  [[nodiscard]] std::size_t get_node_count() const { return m_nodes.size(); }
+
+  /// \brief Returns the function that is true if and only if \a var is true.
+  [[nodiscard]] node_t get_variable(var_t var);
+  /// \brief Returns the constant function \a value.
+  [[nodiscard]] static node_t get_constant(bool value) { return value ? ONE : ZERO; }
+
+  /// \brief Returns `if f then g else h`.
+  [[nodiscard]] node_t ite(node_t f, node_t g, node_t h);
+  [[nodiscard]] node_t bdd_not(node_t f) { return ite(f, ZERO, ONE); }
+  [[nodiscard]] node_t bdd_and(node_t f, node_t g) { return ite(f, g, ZERO); }
+  [[nodiscard]] node_t bdd_or(node_t f, node_t g) { return ite(f, ONE, g); }
+  [[nodiscard]] node_t bdd_xor(node_t f, node_t g) { return ite(f, bdd_not(g), g); }
+
+  /// \brief If \a f is true for a single assignment of the variables `0` to
+  /// `var_count - 1` (and does not depend on other variables), returns that assignment.
+  [[nodiscard]] std::optional<std::vector<bool>> get_single_minterm(node_t f, var_t var_count) const;
+
+private:
+  struct Node {
+    var_t var;
+    node_t low;  // the cofactor when var is false
+    node_t high; // the cofactor when var is true
+  };
+
+  [[nodiscard]] var_t get_var(node_t f) const { return m_nodes[f].var; }
+  [[nodiscard]] node_t make_node(var_t var, node_t low, node_t high);
+
+  struct TripleHash {
+    std::size_t operator()(const std::tuple<node_t, node_t, node_t> &key) const;
+  };
+
+  std::vector<Node> m_nodes;
+  std::unordered_map<std::tuple<node_t, node_t, node_t>, node_t, TripleHash> m_unique_table;
+  std::unordered_map<std::tuple<node_t, node_t, node_t>, node_t, TripleHash> m_ite_cache;
+  std::size_t m_max_nodes;
+  bool m_overflowed = false;
+};
+
+#endif // NETLIST_SRC_PASSES_BDD_HPP
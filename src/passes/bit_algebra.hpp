@@ -0,0 +1,44 @@
+#ifndef NETLIST_SRC_PASSES_BIT_ALGEBRA_HPP
+#define NETLIST_SRC_PASSES_BIT_ALGEBRA_HPP
+
+#include "bdd.hpp"
+
+#include <cstdint>
+
+/// \ingroup passes
+/// \brief Evaluates gates on 64 simulation patterns at once.
+///
+/// Passes evaluate their logic with templates parameterized by an algebra, so
+/// that the same code runs a bit-parallel simulation (WordAlgebra) and a formal
+/// proof (BddAlgebra).
+struct WordAlgebra {
+  using value_type = std::uint_least64_t;
+
+  [[nodiscard]] value_type make_constant(bool value) const { return value ? ~value_type(0) : 0; }
+  [[nodiscard]] value_type make_not(value_type a) const { return ~a; }
+  [[nodiscard]] value_type make_and(value_type a, value_type b) const { return a & b; }
+  [[nodiscard]] value_type make_or(value_type a, value_type b) const { return a | b; }
+  [[nodiscard]] value_type make_xor(value_type a, value_type b) const { return a ^ b; }
+  [[nodiscard]] value_type make_mux(value_type choice, value_type first, value_type second) const {
+    return (choice & second) | (~choice & first);
+  }
+};
+
+/// \ingroup passes
+/// \brief Evaluates gates symbolically as BDDs.
+struct BddAlgebra {
+  using value_type = BddManager::node_t;
+
+  BddManager &manager;
+
+  [[nodiscard]] value_type make_constant(bool value) const { return BddManager::get_constant(value); }
+  [[nodiscard]] value_type make_not(value_type a) const { return manager.bdd_not(a); }
+  [[nodiscard]] value_type make_and(value_type a, value_type b) const { return manager.bdd_and(a, b); }
+  [[nodiscard]] value_type make_or(value_type a, value_type b) const { return manager.bdd_or(a, b); }
+  [[nodiscard]] value_type make_xor(value_type a, value_type b) const { return manager.bdd_xor(a, b); }
+  [[nodiscard]] value_type make_mux(value_type choice, value_type first, value_type second) const {
+    return manager.ite(choice, second, first);
+  }
+};
+
+#endif // NETLIST_SRC_PASSES_BIT_ALGEBRA_HPP
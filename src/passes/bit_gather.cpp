@@ -0,0 +1,362 @@
+#include "bit_gather.hpp"
+
+#include "utils.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <map>
+#include <optional>
+
+namespace {
+/// Returns true if the instruction only moves bits around.
+[[nodiscard]] bool is_permutation(const Instruction *instruction) {
+  return dynamic_cast<const LoadInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const SelectInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const SliceInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const ConcatInstruction *>(instruction) != nullptr;
+}
+
+struct BitGatherAnalysis {
+  const Program &program;
+  const DefUseInfo &def_use;
+  /// Roots of the permutation trees, that is registers defined by a permutation
+  /// instruction and used by something else than another permutation instruction.
+  std::vector<bool> is_root;
+  /// Registers whose definition was inlined into a tree (intermediate nodes and constants).
+  std::vector<bool> is_folded;
+
+  std::vector<std::optional<BitSources>> cache;
+  /// For each expanded register, true if at least one of its operands was folded.
+  std::vector<bool> has_folded_operand;
+  std::vector<bool> in_progress;
+
+  BitGatherAnalysis(const Program &p, const DefUseInfo &du)
+      : program(p), def_use(du), is_root(p.registers.size(), false), is_folded(p.registers.size(), false),
+        cache(p.registers.size()), has_folded_operand(p.registers.size(), false),
+        in_progress(p.registers.size(), false) {
+    std::vector<bool> has_other_use(p.registers.size(), false);
+    for (const auto *instruction : program.instructions) {
+      if (is_permutation(instruction))
+        continue;
+
+      for (const auto input : get_instruction_inputs(*instruction))
+        has_other_use[input.index] = true;
+    }
+
+    for (reg_index_t i = 0; i < program.registers.size(); ++i) {
+      const auto *definition = def_use.definitions[i];
+      if (definition == nullptr || !is_permutation(definition))
+        continue;
+
+      is_root[i] = has_other_use[i] || (program.registers.get_flags({i}) & RIF_OUTPUT);
+    }
+  }
+
+  [[nodiscard]] bus_size_t get_bus_size(reg_t reg) const { return program.registers.get_bus_size(reg); }
+
+  /// Returns the bits of \a reg as seen by another instruction of a tree.
+  /// \a folded is set to true if the definition of reg was inlined.
+  BitSources get_operand_bits(reg_t reg, bool &folded) {
+    const auto *definition = def_use.definitions[reg.index];
+    if (definition != nullptr && !is_root[reg.index] && !in_progress[reg.index]) {
+      if (const auto *const_inst = dynamic_cast<const ConstInstruction *>(definition)) {
+        BitSources bits(get_bus_size(reg));
+        for (bus_size_t i = 0; i < bits.size(); ++i)
+          bits[i].bit = (const_inst->value >> i) & 1;
+        is_folded[reg.index] = true;
+        folded = true;
+        return bits;
+      }
+
+      if (is_permutation(definition)) {
+        const auto &bits = expand(reg);
+        if (bits.has_value()) {
+          is_folded[reg.index] = true;
+          folded = true;
+          return bits.value();
+        }
+      }
+    }
+
+    // A leaf of the tree.
+    BitSources bits(get_bus_size(reg));
+    for (bus_size_t i = 0; i < bits.size(); ++i)
+      bits[i] = {reg, i};
+    return bits;
+  }
+
+  /// Computes the bits of \a reg, a register defined by a permutation instruction,
+  /// in terms of the leaves of its tree. Returns std::nullopt if the instruction
+  /// is malformed (e.g. an out of bounds `SELECT`).
+  const std::optional<BitSources> &expand(reg_t reg) {
+    if (cache[reg.index].has_value())
+      return cache[reg.index];
+
+    const auto *definition = def_use.definitions[reg.index];
+    assert(definition != nullptr && is_permutation(definition));
+
+    in_progress[reg.index] = true;
+
+    const auto output_size = get_bus_size(reg);
+    bool folded = false;
+    std::optional<BitSources> result;
+    if (const auto *load = dynamic_cast<const LoadInstruction *>(definition)) {
+      result = get_operand_bits(load->input, folded);
+    } else if (const auto *select = dynamic_cast<const SelectInstruction *>(definition)) {
+      if (select->i < get_bus_size(select->input)) {
+        const auto bits = get_operand_bits(select->input, folded);
+        result = BitSources{bits[select->i]};
+      }
+    } else if (const auto *slice = dynamic_cast<const SliceInstruction *>(definition)) {
+      if (slice->start <= slice->end && slice->end < get_bus_size(slice->input)) {
+        const auto bits = get_operand_bits(slice->input, folded);
+        result = BitSources(bits.begin() + slice->start, bits.begin() + slice->end + 1);
+      }
+    } else if (const auto *concat = dynamic_cast<const ConcatInstruction *>(definition)) {
+      auto bits = get_operand_bits(concat->lhs, folded);
+      const auto rhs_bits = get_operand_bits(concat->rhs, folded);
+      bits.insert(bits.end(), rhs_bits.begin(), rhs_bits.end());
+      result = std::move(bits);
+    }
+
+    // Output bits not computed by the instruction are zero.
+    if (result.has_value())
+      result->resize(output_size);
+
+    in_progress[reg.index] = false;
+    has_folded_operand[reg.index] = folded;
+    cache[reg.index] = std::move(result);
+    return cache[reg.index];
+  }
+};
+
+/// Appends to \a parts the parts needed to move the bits described by \a pairs
+/// (a list of source bit and destination bit) from \a input.
+void build_parts(reg_t input, const std::vector<std::pair<bus_size_t, bus_size_t>> &pairs,
+                 std::vector<GatherInstruction::Part> &parts) {
+  // Groups the bits by shift amount, each group is a part computed with a single shift.
+  std::map<int, GatherInstruction::Part> shift_groups;
+  bool is_order_preserving = true;
+  for (std::size_t i = 0; i < pairs.size(); ++i) {
+    const auto [src, dst] = pairs[i];
+    const int shift = static_cast<int>(dst) - static_cast<int>(src);
+    auto &part = shift_groups[shift];
+    part.input = input;
+    part.extract_mask |= reg_value_t(1) << src;
+    part.deposit_mask |= reg_value_t(1) << dst;
+
+    // The pairs are sorted by source bit.
+    if (i > 0 && pairs[i - 1].second > dst)
+      is_order_preserving = false;
+  }
+
+  // A shift is cheaper than PEXT/PDEP (which also may not be available), so
+  // we only use a single PEXT/PDEP pair when it replaces many shifts.
+  constexpr std::size_t MAX_SHIFT_PARTS = 2;
+  if (is_order_preserving && shift_groups.size() > MAX_SHIFT_PARTS) {
+    GatherInstruction::Part part;
+    part.input = input;
+    for (const auto &[shift, group] : shift_groups) {
+      part.extract_mask |= group.extract_mask;
+      part.deposit_mask |= group.deposit_mask;
+    }
+    parts.push_back(part);
+  } else {
+    for (const auto &[shift, group] : shift_groups)
+      parts.push_back(group);
+  }
+}
+
+} // namespace
+
+void build_bit_gather(ProgramBuilder &builder, reg_t output, const BitSources &bits) {
+  // Is it a constant?
+  reg_value_t constant = 0;
+  std::vector<reg_t> inputs;
+  for (bus_size_t i = 0; i < bits.size(); ++i) {
+    if (bits[i].is_constant()) {
+      constant |= reg_value_t(bits[i].bit) << i;
+    } else if (std::ranges::find(inputs, bits[i].reg) == inputs.end()) {
+      inputs.push_back(bits[i].reg);
+    }
+  }
+
+  if (inputs.empty()) {
+    builder.add_const(output, constant);
+    return;
+  }
+
+  // Is it a plain copy or a single bit selection?
+  if (inputs.size() == 1 && constant == 0) {
+    const auto input = inputs.front();
+    if (bits.size() == 1 && !bits[0].is_constant()) {
+      (void)builder.add_select(output, bits[0].bit, input);
+      return;
+    }
+
+    bool is_identity = bits.size() == builder.get_register_bus_size(input);
+    for (bus_size_t i = 0; is_identity && i < bits.size(); ++i)
+      is_identity = !bits[i].is_constant() && bits[i].bit == i;
+    if (is_identity) {
+      (void)builder.add_load(output, input);
+      return;
+    }
+  }
+
+  std::vector<GatherInstruction::Part> parts;
+  for (const auto input : inputs) {
+    std::vector<std::pair<bus_size_t, bus_size_t>> pairs;
+    for (bus_size_t i = 0; i < bits.size(); ++i) {
+      if (!bits[i].is_constant() && bits[i].reg == input)
+        pairs.emplace_back(bits[i].bit, i);
+    }
+
+    std::ranges::sort(pairs);
+    build_parts(input, pairs, parts);
+  }
+
+  (void)builder.add_gather(output, std::move(parts), constant);
+}
+
+reg_t build_bits_register(ProgramBuilder &builder, const BitSources &bits) {
+  assert(!bits.empty());
+
+  // Is it already an existing register?
+  const auto reg = bits.front().reg;
+  bool is_identity = !bits.front().is_constant() && builder.get_register_bus_size(reg) == bits.size();
+  for (bus_size_t i = 0; is_identity && i < bits.size(); ++i)
+    is_identity = bits[i].reg == reg && bits[i].bit == i;
+  if (is_identity)
+    return reg;
+
+  const auto output = builder.add_register(bits.size());
+  build_bit_gather(builder, output, bits);
+  return output;
+}
+
+BitSource trace_bit(const Program &program, const DefUseInfo &def_use, reg_t reg, bus_size_t bit) {
+  const auto get_bus_size = [&program](reg_t r) { return program.registers.get_bus_size(r); };
+
+  // The bound protects against (invalid) combinational loops.
+  for (std::size_t steps = 0; steps <= program.instructions.size(); ++steps) {
+    if (reg.index >= def_use.definitions.size())
+      break;
+    const auto *definition = def_use.definitions[reg.index];
+    if (definition == nullptr)
+      break;
+
+    if (const auto *load = dynamic_cast<const LoadInstruction *>(definition)) {
+      reg = load->input;
+    } else if (const auto *select = dynamic_cast<const SelectInstruction *>(definition)) {
+      if (select->i >= get_bus_size(select->input))
+        break;
+      reg = select->input;
+      bit = select->i;
+    } else if (const auto *slice = dynamic_cast<const SliceInstruction *>(definition)) {
+      if (slice->end >= get_bus_size(slice->input))
+        break;
+      reg = slice->input;
+      bit += slice->start;
+    } else if (const auto *concat = dynamic_cast<const ConcatInstruction *>(definition)) {
+      if (bit < concat->offset) {
+        reg = concat->lhs;
+      } else if (bit - concat->offset < get_bus_size(concat->rhs)) {
+        reg = concat->rhs;
+        bit -= concat->offset;
+      } else {
+        return {{}, 0};
+      }
+    } else if (const auto *gather = dynamic_cast<const GatherInstruction *>(definition)) {
+      const reg_value_t bit_mask = reg_value_t(1) << bit;
+      if (gather->constant & bit_mask)
+        return {{}, 1};
+
+      const auto it = std::ranges::find_if(gather->parts, [bit_mask](const auto &part) {
+        return (part.deposit_mask & bit_mask) != 0;
+      });
+      if (it == gather->parts.end())
+        return {{}, 0};
+
+      // The bit of rank r in the deposit mask comes from the bit of rank r in the extract mask.
+      const auto rank = std::popcount(it->deposit_mask & (bit_mask - 1));
+      bit = std::countr_zero(deposit_bits(reg_value_t(1) << rank, it->extract_mask));
+      reg = it->input;
+    } else if (const auto *constant = dynamic_cast<const ConstInstruction *>(definition)) {
+      return {{}, static_cast<bus_size_t>((constant->value >> bit) & 1)};
+    } else {
+      break;
+    }
+  }
+
+  return {reg, bit};
+}
+
+// ========================================================
+// class BitGatherPass
+// ========================================================
+
+bool BitGatherPass::run(const std::shared_ptr<Program> &program) {
+  assert(program != nullptr);
+
+  auto def_use = DefUseInfo::build(*program);
+  BitGatherAnalysis analysis(*program, def_use);
+  ProgramBuilder builder(program);
+
+  std::vector<Instruction *> to_delete;
+  auto remove_definition = [&](reg_index_t reg) {
+    auto *definition = def_use.definitions[reg];
+    for (const auto input : get_instruction_inputs(*definition))
+      def_use.use_counts[input.index]--;
+    def_use.definitions[reg] = nullptr;
+    to_delete.push_back(definition);
+  };
+
+  // Replaces each tree (with at least two instructions) by a single instruction.
+  const auto register_count = static_cast<reg_index_t>(program->registers.size());
+  for (reg_index_t i = 0; i < register_count; ++i) {
+    if (!analysis.is_root[i])
+      continue;
+
+    const auto &bits = analysis.expand({i});
+    if (!bits.has_value() || !analysis.has_folded_operand[i])
+      continue;
+
+    remove_definition(i);
+    build_bit_gather(builder, {i}, bits.value());
+    for (const auto input : get_instruction_inputs(*program->instructions.back()))
+      def_use.use_counts[input.index]++;
+  }
+
+  if (to_delete.empty())
+    return false;
+
+  // Removes the now dead intermediate instructions of the trees.
+  std::vector<reg_index_t> worklist;
+  for (reg_index_t i = 0; i < register_count; ++i) {
+    if (analysis.is_folded[i])
+      worklist.push_back(i);
+  }
+
+  while (!worklist.empty()) {
+    const auto reg = worklist.back();
+    worklist.pop_back();
+
+    if (def_use.definitions[reg] == nullptr || def_use.use_counts[reg] > 0 ||
+        (program->registers.get_flags({reg}) & RIF_OUTPUT))
+      continue;
+
+    const auto inputs = get_instruction_inputs(*def_use.definitions[reg]);
+    remove_definition(reg);
+    for (const auto input : inputs) {
+      if (analysis.is_folded[input.index])
+        worklist.push_back(input.index);
+    }
+  }
+
+  std::sort(to_delete.begin(), to_delete.end());
+  erase_instructions_if(*program, [&to_delete](const Instruction *instruction) {
+    return std::binary_search(to_delete.begin(), to_delete.end(), instruction);
+  });
+  return true;
+}
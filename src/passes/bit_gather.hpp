@@ -0,0 +1,64 @@
+#ifndef NETLIST_SRC_PASSES_BIT_GATHER_HPP
+#define NETLIST_SRC_PASSES_BIT_GATHER_HPP
+
+#include "pass.hpp"
+
+/// \ingroup passes
+/// \brief The origin of a single bit of a register.
+struct BitSource {
+  /// The register from which the bit comes from or an invalid register if the bit is constant.
+  reg_t reg = {};
+  /// The bit index inside `reg` or the constant bit value (0 or 1) if `reg` is invalid.
+  bus_size_t bit = 0;
+
+  [[nodiscard]] bool is_constant() const { return reg.index == reg_t{}.index; }
+  [[nodiscard]] bool operator==(const BitSource &) const = default;
+};
+
+/// \ingroup passes
+/// \brief The origin of each bit of a register, from the least significant bit.
+using BitSources = std::vector<BitSource>;
+
+/// \ingroup passes
+/// \brief Appends the cheapest instruction computing \a output from the given bits.
+///
+/// Depending on \a bits, this is a `CONST`, a `SELECT`, a `LOAD` or a GatherInstruction.
+void build_bit_gather(ProgramBuilder &builder, reg_t output, const BitSources &bits);
+
+/// \ingroup passes
+/// \brief Returns a register whose bits are \a bits.
+///
+/// This is the register of \a bits if they are exactly all its bits in order,
+/// otherwise a new register defined by build_bit_gather().
+[[nodiscard]] reg_t build_bits_register(ProgramBuilder &builder, const BitSources &bits);
+
+/// \ingroup passes
+/// \brief Finds where the bit \a bit of \a reg comes from.
+///
+/// This follows the instructions that only move bits around (`LOAD`, `SELECT`,
+/// `SLICE`, `CONCAT` and GatherInstruction) and folds `CONST` instructions.
+[[nodiscard]] BitSource trace_bit(const Program &program, const DefUseInfo &def_use, reg_t reg, bus_size_t bit);
+
+// ========================================================
+// class BitGatherPass
+// ========================================================
+
+/// \ingroup passes
+/// \brief Collapses trees of `SELECT`, `SLICE`, `CONCAT` and `LOAD` instructions.
+///
+/// Netlists generated from bit-level HDL compilers are full of long chains of
+/// instructions that only move bits around. For each such tree, this pass
+/// computes where each output bit comes from and replaces the whole tree by a
+/// single GatherInstruction (or by a single `SELECT` or `LOAD` if that is enough).
+/// Constants (`CONST` instructions) feeding the trees are also folded in.
+///
+/// The intermediate instructions of the trees are removed once they are no
+/// longer used.
+class BitGatherPass final : public Pass {
+public:
+  [[nodiscard]] std::string_view get_name() const override { return "bit-gather"; }
+
+  bool run(const std::shared_ptr<Program> &program) override;
+};
+
+#endif // NETLIST_SRC_PASSES_BIT_GATHER_HPP
@@ -0,0 +1,195 @@
+#include "cone.hpp"
+
+#include <algorithm>
+
+bool is_combinational(const Instruction *instruction) {
+  return dynamic_cast<const RegInstruction *>(instruction) == nullptr &&
+         dynamic_cast<const DelayInstruction *>(instruction) == nullptr &&
+         dynamic_cast<const MemoryInstruction *>(instruction) == nullptr &&
+         dynamic_cast<const MemoInstruction *>(instruction) == nullptr &&
+         dynamic_cast<const LazyMuxInstruction *>(instruction) == nullptr &&
+         dynamic_cast<const EnabledRegInstruction *>(instruction) == nullptr;
+}
+
+std::optional<std::vector<Instruction *>> sort_combinational(const Program &program, const DefUseInfo &def_use) {
+  const auto is_candidate = [&def_use](const Instruction *instruction) {
+    return is_combinational(instruction) && def_use.definitions[instruction->output.index] == instruction;
+  };
+
+  enum : std::uint_least8_t { NOT_VISITED, IN_PROGRESS, VISITED };
+  std::vector<std::uint_least8_t> states(program.registers.size(), NOT_VISITED);
+  std::vector<Instruction *> order;
+
+  struct Frame {
+    Instruction *instruction;
+    std::vector<reg_t> inputs;
+    std::size_t next_input = 0;
+  };
+  std::vector<Frame> stack;
+
+  for (auto *root : program.instructions) {
+    if (!is_candidate(root) || states[root->output.index] != NOT_VISITED)
+      continue;
+
+    states[root->output.index] = IN_PROGRESS;
+    stack.push_back({root, get_instruction_inputs(*root)});
+    while (!stack.empty()) {
+      auto &frame = stack.back();
+      if (frame.next_input == frame.inputs.size()) {
+        states[frame.instruction->output.index] = VISITED;
+        order.push_back(frame.instruction);
+        stack.pop_back();
+        continue;
+      }
+
+      const auto input = frame.inputs[frame.next_input++];
+      auto *definition = def_use.definitions[input.index];
+      if (definition == nullptr || !is_candidate(definition) || states[input.index] == VISITED)
+        continue;
+      if (states[input.index] == IN_PROGRESS)
+        return std::nullopt;
+
+      states[input.index] = IN_PROGRESS;
+      stack.push_back({definition, get_instruction_inputs(*definition)});
+    }
+  }
+
+  return order;
+}
+
+std::size_t Cone::get_gate_count() const {
+  return std::ranges::count_if(instructions, [](const Instruction *instruction) {
+    return dynamic_cast<const ConstInstruction *>(instruction) == nullptr;
+  });
+}
+
+// ========================================================
+// class ConeCover
+// ========================================================
+
+ConeCover::ConeCover(const Program &program, bus_size_t max_input_bits)
+    : m_program(program), m_def_use(DefUseInfo::build(program)), m_max_input_bits(max_input_bits),
+      m_is_covered(program.registers.size(), false) {
+  // The only instruction reading each register (if it is read once).
+  std::vector<const Instruction *> users(program.registers.size(), nullptr);
+  for (const auto *instruction : program.instructions) {
+    for (const auto input : get_instruction_inputs(*instruction))
+      users[input.index] = instruction;
+  }
+
+  // The registers that must be computed by their own instruction start a cone.
+  for (const auto *instruction : program.instructions) {
+    const auto output = instruction->output;
+    if (get_definition(output) != instruction || dynamic_cast<const ConstInstruction *>(instruction) != nullptr)
+      continue;
+
+    if (is_exposed(output) || !is_combinational(users[output.index]))
+      m_roots.push_back(output);
+  }
+}
+
+const Instruction *ConeCover::get_definition(reg_t reg) const {
+  // Registers written by the user are not only defined by their instruction.
+  if (m_program.registers.get_flags(reg) & RIF_INPUT)
+    return nullptr;
+
+  const auto *definition = m_def_use.definitions[reg.index];
+  return (definition != nullptr && is_combinational(definition)) ? definition : nullptr;
+}
+
+bool ConeCover::is_exposed(reg_t reg) const {
+  // Only registers used once are absorbed, so their only user is in the cone.
+  return (m_program.registers.get_flags(reg) & RIF_OUTPUT) || m_def_use.use_counts[reg.index] != 1;
+}
+
+std::optional<Cone> ConeCover::next() {
+  while (!m_roots.empty()) {
+    const auto root = m_roots.back();
+    m_roots.pop_back();
+    if (m_is_covered[root.index])
+      continue;
+
+    m_is_covered[root.index] = true;
+    auto cone = grow(get_definition(root));
+    if (!cone.has_value())
+      continue;
+
+    for (const auto *instruction : cone->instructions)
+      m_is_covered[instruction->output.index] = true;
+    return cone;
+  }
+
+  return std::nullopt;
+}
+
+std::optional<Cone> ConeCover::grow(const Instruction *root) {
+  std::vector<const Instruction *> members = {root};
+  std::vector<const Instruction *> constants;
+  std::vector<reg_t> inputs;
+  std::vector<reg_t> kept_inputs;
+  bus_size_t input_bits = 0; // the bits of both inputs and kept_inputs
+  bool has_loop = false;
+
+  const auto is_known = [&](reg_t reg) {
+    return std::ranges::find(inputs, reg) != inputs.end() || std::ranges::find(kept_inputs, reg) != kept_inputs.end();
+  };
+  const auto add_input = [&](reg_t input) {
+    // Absorbed registers are only read by the instruction absorbing them, so
+    // a member read again means a loop.
+    has_loop |= std::ranges::find(members, m_def_use.definitions[input.index]) != members.end();
+    if (!is_known(input)) {
+      inputs.push_back(input);
+      input_bits += get_bus_size(input);
+    }
+  };
+  for (const auto input : get_instruction_inputs(*root))
+    add_input(input);
+
+  // Each input read only by the cone is replaced by the inputs of its
+  // definition if they still fit. Constants are always absorbed.
+  while (!inputs.empty() && !has_loop) {
+    const auto input = inputs.back();
+    inputs.pop_back();
+    const auto *definition = get_definition(input);
+    if (dynamic_cast<const ConstInstruction *>(definition) != nullptr) {
+      constants.push_back(definition);
+      input_bits -= get_bus_size(input);
+      continue;
+    }
+
+    if (definition == nullptr || m_is_covered[input.index] || is_exposed(input)) {
+      kept_inputs.push_back(input);
+      continue;
+    }
+
+    auto new_bits = input_bits - get_bus_size(input);
+    for (const auto operand : get_instruction_inputs(*definition)) {
+      if (!is_known(operand))
+        new_bits += get_bus_size(operand);
+    }
+
+    if (new_bits > m_max_input_bits) {
+      kept_inputs.push_back(input);
+      m_roots.push_back(input);
+      continue;
+    }
+
+    members.push_back(definition);
+    input_bits -= get_bus_size(input);
+    for (const auto operand : get_instruction_inputs(*definition))
+      add_input(operand);
+  }
+
+  // The inputs of the root alone may already be too wide. Loops are reported
+  // later by the scheduler.
+  if (has_loop || input_bits > m_max_input_bits)
+    return std::nullopt;
+
+  // Each member is discovered after the only instruction reading it, so the
+  // reverse order is an evaluation order. Constants have no inputs.
+  Cone cone;
+  cone.instructions = std::move(constants);
+  cone.instructions.insert(cone.instructions.end(), members.rbegin(), members.rend());
+  cone.inputs = std::move(kept_inputs);
+  return cone;
+}
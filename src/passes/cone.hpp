@@ -0,0 +1,78 @@
+#ifndef NETLIST_SRC_PASSES_CONE_HPP
+#define NETLIST_SRC_PASSES_CONE_HPP
+
+#include "pass.hpp"
+
+#include <optional>
+
+/// \ingroup passes
+/// \brief Returns true if \a instruction computes its result from the current
+/// values of its inputs only.
+///
+/// This is false for `REG`, `DELAY`, `REGEN`, memories, MemoInstruction (whose
+/// evaluation has side effects on the memoization cache) and LazyMuxInstruction
+/// (whose bodies must stay guarded).
+[[nodiscard]] bool is_combinational(const Instruction *instruction);
+
+/// \ingroup passes
+/// \brief Sorts the combinational instructions so that the definition of each
+/// register comes before its uses.
+///
+/// Only the combinational instructions that are the single definition of their
+/// register are returned, the results of the others are leaves. Returns nothing
+/// if there is a combinational loop.
+[[nodiscard]] std::optional<std::vector<Instruction *>> sort_combinational(const Program &program,
+                                                                           const DefUseInfo &def_use);
+
+/// \ingroup passes
+/// \brief A fanout-free cone of combinational instructions computing a single register.
+struct Cone {
+  /// The instructions of the cone, in evaluation order (the root is last).
+  std::vector<const Instruction *> instructions;
+  /// The inputs of the cone (its leaves), without duplicates.
+  std::vector<reg_t> inputs;
+
+  /// \brief Returns the register computed by the cone.
+  [[nodiscard]] reg_t get_root() const { return instructions.back()->output; }
+  /// \brief Returns the count of instructions of the cone, excluding the constants.
+  [[nodiscard]] std::size_t get_gate_count() const;
+};
+
+// ========================================================
+// class ConeCover
+// ========================================================
+
+/// \ingroup passes
+/// \brief Covers the combinational instructions of a program with disjoint cones.
+///
+/// A cone starts at an instruction whose result is used more than once, by a
+/// non-combinational instruction or is an output. It then absorbs the
+/// instructions computing its inputs when they are only used by the cone, as
+/// long as the inputs fit in a given count of bits. So the instructions are
+/// never duplicated. The instructions that do not fit start their own cone.
+/// Constants are absorbed by all cones reading them.
+///
+/// The program must not be modified while the cones are enumerated.
+class ConeCover {
+public:
+  ConeCover(const Program &program, bus_size_t max_input_bits);
+
+  /// \brief Returns the next cone or std::nullopt if all instructions were covered.
+  [[nodiscard]] std::optional<Cone> next();
+
+private:
+  [[nodiscard]] bus_size_t get_bus_size(reg_t reg) const { return m_program.registers.get_bus_size(reg); }
+  [[nodiscard]] const Instruction *get_definition(reg_t reg) const;
+  [[nodiscard]] bool is_exposed(reg_t reg) const;
+  [[nodiscard]] std::optional<Cone> grow(const Instruction *root);
+
+private:
+  const Program &m_program;
+  DefUseInfo m_def_use;
+  bus_size_t m_max_input_bits;
+  /// The registers whose definition was already put in a cone.
+  std::vector<bool> m_is_covered;
+  std::vector<reg_t> m_roots;
+};
+
+#endif // NETLIST_SRC_PASSES_CONE_HPP
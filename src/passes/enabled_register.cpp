@@ -0,0 +1,71 @@
+#include "enabled_register.hpp"
+#include "guarded_logic.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+// ========================================================
+// class EnabledRegisterPass
+// ========================================================
+
+bool EnabledRegisterPass::run(const std::shared_ptr<Program> &program) {
+  assert(program != nullptr);
+
+  const auto def_use = DefUseInfo::build(*program);
+
+  struct Match {
+    reg_t output;
+    reg_t enable;
+    reg_t input;
+    bool is_enable_inverted;
+  };
+  std::vector<Match> matches;
+  std::vector<const Instruction *> to_delete;
+  for (const auto *instruction : program->instructions) {
+    // Registers written by the user are not only defined by their instruction.
+    const auto *reg = dynamic_cast<const RegInstruction *>(instruction);
+    if (reg == nullptr || def_use.definitions[reg->output.index] != reg ||
+        (program->registers.get_flags(reg->output) & RIF_INPUT))
+      continue;
+
+    const auto d = reg->input;
+    const auto *mux = dynamic_cast<const MuxInstruction *>(def_use.definitions[d.index]);
+    if (mux == nullptr || (program->registers.get_flags(d) & RIF_INPUT))
+      continue;
+
+    // The hold operand must be the register itself (if both operands are, the
+    // register is constant and nothing is gained).
+    const auto q = reg->output;
+    if (mux->first == q && mux->second != q) {
+      matches.push_back({d, mux->choice, mux->second, false});
+    } else if (mux->second == q && mux->first != q) {
+      matches.push_back({d, mux->choice, mux->first, true});
+    } else {
+      continue;
+    }
+
+    to_delete.push_back(mux);
+  }
+
+  if (matches.empty())
+    return false;
+
+  std::ranges::sort(to_delete);
+  erase_instructions_if(*program, [&to_delete](const Instruction *instruction) {
+    return std::ranges::binary_search(to_delete, instruction);
+  });
+
+  ProgramBuilder builder(program);
+  for (const auto &match : matches) {
+    auto enable = match.enable;
+    if (match.is_enable_inverted) {
+      enable = builder.add_register(1);
+      builder.add_not(enable, match.enable);
+    }
+
+    builder.add_enabled_reg(match.output, enable, match.input);
+  }
+
+  move_guarded_logic(*program, /* make_muxes_lazy= */ false);
+  return true;
+}
@@ -0,0 +1,34 @@
+#ifndef NETLIST_SRC_PASSES_ENABLED_REGISTER_HPP
+#define NETLIST_SRC_PASSES_ENABLED_REGISTER_HPP
+
+#include "pass.hpp"
+
+// ========================================================
+// class EnabledRegisterPass
+// ========================================================
+
+/// \ingroup passes
+/// \brief Recognizes flip-flops with an enable and replaces their `MUX` by `REGEN`.
+///
+/// A flip-flop with an enable is written in netlists as a `REG` whose input
+/// selects between its own value (hold) and a new value:
+/// ```
+/// q = REG d
+/// d = MUX en q x
+/// ```
+/// (or `d = MUX en x q` when it holds while `en` is one). This pass replaces
+/// the `MUX` by `d = REGEN en x` (see EnabledRegInstruction, an inverted
+/// enable is computed with a `NOT`), which does nothing at all while the
+/// register is disabled.
+///
+/// Then, the combinational logic only used to compute `x` is moved into the
+/// body of the `REGEN` (see move_guarded_logic()), so whole idle units behind
+/// a disabled register stop being evaluated.
+class EnabledRegisterPass final : public Pass {
+public:
+  [[nodiscard]] std::string_view get_name() const override { return "enabled-register"; }
+
+  bool run(const std::shared_ptr<Program> &program) override;
+};
+
+#endif // NETLIST_SRC_PASSES_ENABLED_REGISTER_HPP
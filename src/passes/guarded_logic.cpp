@@ -0,0 +1,199 @@
+#include "guarded_logic.hpp"
+#include "cone.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <unordered_map>
+
+namespace {
+/// A guarded body, made of the index of the register defined by the guarding
+/// instruction and of the guarded operand (`first` or `second` of a `MUX`, or
+/// the input of a `REGEN`).
+using slot_t = std::uint_least64_t;
+constexpr slot_t NO_SLOT = std::numeric_limits<slot_t>::max();
+
+slot_t make_slot(reg_t guard_output, bool is_second) {
+  return 2 * static_cast<slot_t>(guard_output.index) + (is_second ? 1 : 0);
+}
+
+class GuardedLogicBuilder {
+public:
+  GuardedLogicBuilder(Program &program, bool make_muxes_lazy)
+      : m_program(program), m_def_use(DefUseInfo::build(program)), m_make_muxes_lazy(make_muxes_lazy),
+        m_readers(program.registers.size()), m_slots(program.registers.size(), NO_SLOT) {
+    for (const auto *instruction : program.instructions) {
+      for (const auto input : get_instruction_inputs(*instruction))
+        m_readers[input.index].push_back(instruction);
+    }
+  }
+
+  bool run() {
+    const auto order = sort_combinational(m_program, m_def_use);
+    if (!order.has_value())
+      return false; // combinational loop, reported later by the scheduler
+
+    // Sinks first, so the slots of all readers are known.
+    for (auto it = order->rbegin(); it != order->rend(); ++it)
+      assign_slot(**it);
+
+    return build_bodies(*order);
+  }
+
+private:
+  /// Returns the body needing \a reg to evaluate \a reader.
+  [[nodiscard]] slot_t get_reader_slot(const Instruction *reader, reg_t reg) const {
+    if (m_def_use.definitions[reader->output.index] != reader)
+      return NO_SLOT;
+
+    if (const auto *mux = dynamic_cast<const MuxInstruction *>(reader); mux != nullptr && m_make_muxes_lazy) {
+      const bool is_first = mux->first == reg;
+      const bool is_second = mux->second == reg;
+      if (mux->choice != reg && is_first != is_second)
+        return make_slot(mux->output, is_second);
+    }
+
+    if (const auto *enabled_reg = dynamic_cast<const EnabledRegInstruction *>(reader)) {
+      if (enabled_reg->body.empty() && enabled_reg->input == reg && enabled_reg->enable != reg)
+        return make_slot(enabled_reg->output, false);
+      return NO_SLOT;
+    }
+
+    // The register is needed whenever the reader is evaluated.
+    return m_slots[reader->output.index];
+  }
+
+  void assign_slot(const Instruction &instruction) {
+    const auto output = instruction.output;
+    if (dynamic_cast<const ConstInstruction *>(&instruction) != nullptr ||
+        (m_program.registers.get_flags(output) & RIF_OUTPUT) != 0)
+      return;
+
+    const auto &readers = m_readers[output.index];
+    if (readers.empty())
+      return;
+
+    const auto slot = get_reader_slot(readers.front(), output);
+    for (const auto *reader : readers) {
+      if (get_reader_slot(reader, output) != slot)
+        return;
+    }
+
+    m_slots[output.index] = slot;
+  }
+
+  /// Moves the instructions into their body and replaces the `MUX` instructions
+  /// having a non-empty body. Returns true if the program was modified.
+  bool build_bodies(const std::vector<Instruction *> &order) {
+    std::unordered_map<slot_t, std::vector<Instruction *>> bodies;
+    std::unordered_map<const Instruction *, Instruction *> replacements;
+    for (auto *instruction : order) {
+      auto *replacement = instruction;
+      if (const auto *mux = dynamic_cast<const MuxInstruction *>(instruction); mux != nullptr && m_make_muxes_lazy) {
+        auto first_body = extract_body(bodies, make_slot(mux->output, false));
+        auto second_body = extract_body(bodies, make_slot(mux->output, true));
+        if (!first_body.empty() || !second_body.empty()) {
+          auto *lazy_mux = new LazyMuxInstruction();
+          lazy_mux->output = mux->output;
+          lazy_mux->choice = mux->choice;
+          lazy_mux->first = mux->first;
+          lazy_mux->second = mux->second;
+          lazy_mux->first_body = std::move(first_body);
+          lazy_mux->second_body = std::move(second_body);
+          lazy_mux->body_inputs = collect_body_inputs({&lazy_mux->first_body, &lazy_mux->second_body});
+          replacements.emplace(instruction, lazy_mux);
+          replacement = lazy_mux;
+        }
+      }
+
+      const auto slot = m_slots[instruction->output.index];
+      if (slot != NO_SLOT)
+        bodies[slot].push_back(replacement);
+    }
+
+    // The `REGEN` instructions are not combinational so they stay at the top level.
+    bool has_enabled_reg_body = false;
+    for (auto *instruction : m_program.instructions) {
+      auto *enabled_reg = dynamic_cast<EnabledRegInstruction *>(instruction);
+      if (enabled_reg == nullptr || m_def_use.definitions[enabled_reg->output.index] != enabled_reg)
+        continue;
+
+      auto body = extract_body(bodies, make_slot(enabled_reg->output, false));
+      if (body.empty())
+        continue;
+
+      enabled_reg->body = std::move(body);
+      enabled_reg->body_inputs = collect_body_inputs({&enabled_reg->body});
+      has_enabled_reg_body = true;
+    }
+
+    if (replacements.empty() && !has_enabled_reg_body)
+      return false;
+
+    std::vector<Instruction *> instructions;
+    instructions.reserve(m_program.instructions.size());
+    for (auto *instruction : m_program.instructions) {
+      // Only candidates have a slot and they are the only definition of their register.
+      if (m_slots[instruction->output.index] != NO_SLOT)
+        continue;
+
+      const auto it = replacements.find(instruction);
+      instructions.push_back(it != replacements.end() ? it->second : instruction);
+    }
+
+    m_program.instructions = std::move(instructions);
+    for (const auto &[mux, lazy_mux] : replacements)
+      delete mux;
+    return true;
+  }
+
+  static std::vector<Instruction *> extract_body(std::unordered_map<slot_t, std::vector<Instruction *>> &bodies,
+                                                 slot_t slot) {
+    const auto it = bodies.find(slot);
+    if (it == bodies.end())
+      return {};
+
+    auto body = std::move(it->second);
+    bodies.erase(it);
+    return body;
+  }
+
+  /// Returns the registers read by \a bodies but defined outside of them.
+  static std::vector<reg_t> collect_body_inputs(std::initializer_list<const std::vector<Instruction *> *> bodies) {
+    std::vector<reg_t> defined;
+    for (const auto *body : bodies) {
+      for (const auto *instruction : *body)
+        defined.push_back(instruction->output);
+    }
+    std::ranges::sort(defined);
+
+    std::vector<reg_t> inputs;
+    for (const auto *body : bodies) {
+      for (const auto *instruction : *body) {
+        for (const auto input : get_instruction_inputs(*instruction)) {
+          if (!std::ranges::binary_search(defined, input))
+            inputs.push_back(input);
+        }
+      }
+    }
+
+    std::ranges::sort(inputs);
+    const auto duplicates = std::ranges::unique(inputs);
+    inputs.erase(duplicates.begin(), duplicates.end());
+    return inputs;
+  }
+
+  Program &m_program;
+  DefUseInfo m_def_use;
+  bool m_make_muxes_lazy;
+  /// The instructions reading each register (once per operand).
+  std::vector<std::vector<const Instruction *>> m_readers;
+  /// The body in which the definition of each register is moved, if any.
+  std::vector<slot_t> m_slots;
+};
+} // namespace
+
+bool move_guarded_logic(Program &program, bool make_muxes_lazy) {
+  GuardedLogicBuilder builder(program, make_muxes_lazy);
+  return builder.run();
+}
@@ -0,0 +1,23 @@
+#ifndef NETLIST_SRC_PASSES_GUARDED_LOGIC_HPP
+#define NETLIST_SRC_PASSES_GUARDED_LOGIC_HPP
+
+#include "pass.hpp"
+
+/// \ingroup passes
+/// \brief Moves the combinational logic only needed by guarded operands into the bodies guarding them.
+///
+/// The guarded operands are the input of EnabledRegInstruction (only needed
+/// when `enable` is one) and, if \a make_muxes_lazy is true, the `first` and
+/// `second` operands of `MUX` instructions. The `MUX` instructions with at
+/// least one non-empty body are replaced by LazyMuxInstruction.
+///
+/// An instruction is moved when it is combinational and when all its uses are,
+/// directly or transitively, a single guarded operand. Outputs, constants and
+/// instructions also read by a `REG`, a memory or another operand are never
+/// moved. A `MUX` moved into a body may itself be made lazy, so the bodies
+/// can be nested.
+///
+/// \return True if the program was modified.
+bool move_guarded_logic(Program &program, bool make_muxes_lazy);
+
+#endif // NETLIST_SRC_PASSES_GUARDED_LOGIC_HPP
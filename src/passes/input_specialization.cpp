@@ -0,0 +1,29 @@
+#include "input_specialization.hpp"
+#include "peephole.hpp"
+
+#include <cassert>
+
+// ========================================================
+// class InputSpecializationPass
+// ========================================================
+
+bool InputSpecializationPass::run(const std::shared_ptr<Program> &program) {
+  assert(program != nullptr);
+
+  if (m_fixed_inputs.empty())
+    return false;
+
+  ProgramBuilder builder(program);
+  for (const auto &[input, value] : m_fixed_inputs) {
+    assert(input.index < program->registers.size());
+    const auto flags = program->registers.get_flags(input);
+    assert(flags & RIF_INPUT);
+
+    program->registers.set_flags(input, flags & ~RIF_INPUT);
+    builder.add_const(input, value & get_bus_mask(program->registers.get_bus_size(input)));
+  }
+
+  PeepholePass peephole;
+  (void)peephole.run(program);
+  return true;
+}
@@ -0,0 +1,37 @@
+#ifndef NETLIST_SRC_PASSES_INPUT_SPECIALIZATION_HPP
+#define NETLIST_SRC_PASSES_INPUT_SPECIALIZATION_HPP
+
+#include "pass.hpp"
+
+#include <utility>
+
+/// \ingroup passes
+/// \brief A list of inputs with the value they are fixed to.
+using InputAssignment = std::vector<std::pair<reg_t, reg_value_t>>;
+
+// ========================================================
+// class InputSpecializationPass
+// ========================================================
+
+/// \ingroup passes
+/// \brief Specializes a program for some inputs fixed to a value for the whole simulation.
+///
+/// Each fixed input is defined by a `CONST` instruction and is no longer an
+/// input. Then the constants are propagated and the dead logic is removed
+/// (see PeepholePass), so entire sub-blocks configured by these inputs may vanish.
+///
+/// The registers are not renumbered so the specialized program can be used in
+/// place of the original one.
+class InputSpecializationPass final : public Pass {
+public:
+  explicit InputSpecializationPass(InputAssignment fixed_inputs) : m_fixed_inputs(std::move(fixed_inputs)) {}
+
+  [[nodiscard]] std::string_view get_name() const override { return "input-specialization"; }
+
+  bool run(const std::shared_ptr<Program> &program) override;
+
+private:
+  InputAssignment m_fixed_inputs;
+};
+
+#endif // NETLIST_SRC_PASSES_INPUT_SPECIALIZATION_HPP
@@ -0,0 +1,241 @@
+#include "known_bits.hpp"
+
+#include <algorithm>
+
+namespace {
+/// Returns the known bits of a value that is only known to be canonical for the given bus size.
+[[nodiscard]] constexpr KnownBits zero_extended(bus_size_t bus_size) {
+  return {~get_bus_mask(bus_size), 0};
+}
+
+/// Returns the common knowledge of \a a and \a b.
+[[nodiscard]] constexpr KnownBits meet(const KnownBits &a, const KnownBits &b) {
+  return {a.zero & b.zero, a.one & b.one};
+}
+
+[[nodiscard]] constexpr KnownBits invert(const KnownBits &a) {
+  return {a.one, a.zero};
+}
+} // namespace
+
+// ========================================================
+// struct KnownBitsAnalysis::Visitor
+// ========================================================
+
+/// Computes the known bits of the output of the visited instruction from the
+/// current known bits of its inputs.
+struct KnownBitsAnalysis::Visitor final : ConstInstructionVisitor {
+  const Program &program;
+  std::vector<KnownBits> &known_bits;
+  /// The known bits of each memory block words.
+  std::vector<KnownBits> memory_known_bits;
+  KnownBits result;
+
+  Visitor(const Program &p, std::vector<KnownBits> &kb) : program(p), known_bits(kb) {
+    memory_known_bits.reserve(program.memories.size());
+    for (const auto &memory : program.memories)
+      memory_known_bits.push_back(zero_extended(memory.word_size));
+  }
+
+  [[nodiscard]] const KnownBits &get(reg_t reg) const { return known_bits[reg.index]; }
+
+  void visit_const(const ConstInstruction &inst) override { result = {~inst.value, inst.value}; }
+  void visit_load(const LoadInstruction &inst) override { result = get(inst.input); }
+  void visit_not(const NotInstruction &inst) override { result = invert(get(inst.input)); }
+
+  [[nodiscard]] KnownBits compute_and(reg_t lhs, reg_t rhs) const {
+    return {get(lhs).zero | get(rhs).zero, get(lhs).one & get(rhs).one};
+  }
+  [[nodiscard]] KnownBits compute_or(reg_t lhs, reg_t rhs) const {
+    return {get(lhs).zero & get(rhs).zero, get(lhs).one | get(rhs).one};
+  }
+  [[nodiscard]] KnownBits compute_xor(reg_t lhs, reg_t rhs) const {
+    const auto &a = get(lhs);
+    const auto &b = get(rhs);
+    return {(a.zero & b.zero) | (a.one & b.one), (a.zero & b.one) | (a.one & b.zero)};
+  }
+
+  void visit_and(const AndInstruction &inst) override { result = compute_and(inst.lhs, inst.rhs); }
+  void visit_nand(const NandInstruction &inst) override { result = invert(compute_and(inst.lhs, inst.rhs)); }
+  void visit_or(const OrInstruction &inst) override { result = compute_or(inst.lhs, inst.rhs); }
+  void visit_nor(const NorInstruction &inst) override { result = invert(compute_or(inst.lhs, inst.rhs)); }
+  void visit_xor(const XorInstruction &inst) override { result = compute_xor(inst.lhs, inst.rhs); }
+  void visit_xnor(const XnorInstruction &inst) override { result = invert(compute_xor(inst.lhs, inst.rhs)); }
+
+  // The carries may propagate everywhere.
+  void visit_add(const AddInstruction &inst) override { result = {}; }
+  void visit_sub(const SubInstruction &inst) override { result = {}; }
+  void visit_eq(const EqInstruction &inst) override { result = zero_extended(1); }
+  void visit_lt(const LtInstruction &inst) override { result = zero_extended(1); }
+  void visit_mul(const MulInstruction &inst) override { result = {}; }
+  void visit_shl(const ShlInstruction &inst) override { result = {}; }
+  // Backends mask the shifted operand of SHR, and ASR masks its result.
+  void visit_shr(const ShrInstruction &inst) override { result = zero_extended(program.registers.get_bus_size(inst.lhs)); }
+  void visit_asr(const AsrInstruction &inst) override { result = zero_extended(program.registers.get_bus_size(inst.output)); }
+  void visit_reduce_or(const ReduceOrInstruction &inst) override { result = zero_extended(1); }
+  void visit_reduce_and(const ReduceAndInstruction &inst) override { result = zero_extended(1); }
+
+  void visit_concat(const ConcatInstruction &inst) override {
+    // Backends mask the left operand (see InterpreterBackend).
+    const auto lhs_mask = get_bus_mask(inst.offset);
+    const auto &lhs = get(inst.lhs);
+    const auto &rhs = get(inst.rhs);
+    const reg_value_t rhs_zero = inst.offset >= 64 ? ~reg_value_t(0) : (rhs.zero << inst.offset) | lhs_mask;
+    const reg_value_t rhs_one = inst.offset >= 64 ? 0 : (rhs.one << inst.offset);
+    result = {(lhs.zero | ~lhs_mask) & rhs_zero, (lhs.one & lhs_mask) | rhs_one};
+  }
+
+  void visit_reg(const RegInstruction &inst) override {
+    // Registers are zero at the first cycle.
+    result = meet(get(inst.input), zero_extended(0));
+  }
+
+  void visit_delay(const DelayInstruction &inst) override { result = meet(get(inst.input), zero_extended(0)); }
+
+  void visit_lut(const LutInstruction &inst) override {
+    // The table is at most a few thousands entries, so all are looked at.
+    bus_size_t input_bits = 0;
+    for (const auto &input : inst.inputs)
+      input_bits += program.registers.get_bus_size(input);
+
+    KnownBits known_bits = {~reg_value_t(0), ~reg_value_t(0)};
+    for (std::size_t i = 0; i < (std::size_t(1) << input_bits); ++i)
+      known_bits = meet(known_bits, {~inst.get_entry(i), inst.get_entry(i)});
+    result = known_bits;
+  }
+
+  void visit_memo(const MemoInstruction &inst) override {
+    // The body registers are only defined inside the body.
+    for (const auto *instruction : inst.body) {
+      instruction->visit(*this);
+      known_bits[instruction->output.index] = result;
+    }
+  }
+
+  void visit_lazy_mux(const LazyMuxInstruction &inst) override {
+    for (const auto *instruction : inst.first_body) {
+      instruction->visit(*this);
+      known_bits[instruction->output.index] = result;
+    }
+    for (const auto *instruction : inst.second_body) {
+      instruction->visit(*this);
+      known_bits[instruction->output.index] = result;
+    }
+
+    const auto &choice = get(inst.choice);
+    if (choice.zero & 1) {
+      result = get(inst.first);
+    } else if (choice.one & 1) {
+      result = get(inst.second);
+    } else {
+      result = meet(get(inst.first), get(inst.second));
+    }
+  }
+
+  void visit_enabled_reg(const EnabledRegInstruction &inst) override {
+    for (const auto *instruction : inst.body) {
+      instruction->visit(*this);
+      known_bits[instruction->output.index] = result;
+    }
+
+    // The output is zero until the first enabled cycle.
+    result = meet(get(inst.input), zero_extended(0));
+  }
+
+  void visit_mux(const MuxInstruction &inst) override {
+    const auto &choice = get(inst.choice);
+    if (choice.zero & 1) {
+      result = get(inst.first);
+    } else if (choice.one & 1) {
+      result = get(inst.second);
+    } else {
+      result = meet(get(inst.first), get(inst.second));
+    }
+  }
+
+  void visit_slice(const SliceInstruction &inst) override {
+    const auto mask = get_bus_mask(inst.end - inst.start + 1);
+    const auto &input = get(inst.input);
+    result = {((input.zero >> inst.start) & mask) | ~mask, (input.one >> inst.start) & mask};
+  }
+
+  void visit_select(const SelectInstruction &inst) override {
+    const auto &input = get(inst.input);
+    result = {((input.zero >> inst.i) & 1) | ~reg_value_t(1), (input.one >> inst.i) & 1};
+  }
+
+  void visit_rom(const RomInstruction &inst) override { result = memory_known_bits[inst.memory_block]; }
+
+  void visit_ram(const RamInstruction &inst) override {
+    auto &memory = memory_known_bits[inst.memory_block];
+    memory = meet(memory, get(inst.write_data));
+    result = memory;
+  }
+
+  void visit_gather(const GatherInstruction &inst) override {
+    reg_value_t deposit_mask = 0;
+    for (const auto &part : inst.parts)
+      deposit_mask |= part.deposit_mask;
+    result = {~(deposit_mask | inst.constant), inst.constant};
+  }
+};
+
+// ========================================================
+// class KnownBitsAnalysis
+// ========================================================
+
+KnownBitsAnalysis KnownBitsAnalysis::analyze(const Program &program) {
+  const auto register_count = program.registers.size();
+
+  KnownBitsAnalysis analysis;
+  analysis.m_bus_sizes = program.registers.get_bus_sizes();
+
+  // The registers defined by the program start with no value at all (the top
+  // of the lattice) while the other registers are always zero except inputs
+  // which are only modified outside the program.
+  constexpr KnownBits undefined = {~reg_value_t(0), ~reg_value_t(0)};
+  analysis.m_known_bits.resize(register_count, zero_extended(0));
+  for (const auto *instruction : program.instructions)
+    analysis.m_known_bits[instruction->output.index] = undefined;
+  for (reg_index_t i = 0; i < register_count; ++i) {
+    if (program.registers.get_flags({i}) & RIF_INPUT)
+      analysis.m_known_bits[i] = zero_extended(program.registers.get_bus_size({i}));
+  }
+
+  // Registers written by the user or defined multiple times merge all their
+  // values. Their facts are never reset (even by their first definition in an
+  // iteration), otherwise they would oscillate between the facts of each
+  // definition.
+  std::vector<bool> is_merged(register_count, false);
+  std::vector<bool> is_defined(register_count, false);
+  for (const auto *instruction : program.instructions) {
+    const auto output = instruction->output.index;
+    is_merged[output] = is_defined[output] || (program.registers.get_flags({output}) & RIF_INPUT);
+    is_defined[output] = true;
+  }
+
+  // All transfer functions are monotone and the facts can only be weakened at
+  // each iteration, so the fixed point is reached in a bounded number of
+  // iterations (usually two or three for a scheduled program).
+  Visitor visitor(program, analysis.m_known_bits);
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (const auto *instruction : program.instructions) {
+      instruction->visit(visitor);
+
+      const auto output = instruction->output.index;
+      auto &known_bits = analysis.m_known_bits[output];
+      auto new_known_bits = visitor.result;
+      if (is_merged[output])
+        new_known_bits = meet(new_known_bits, known_bits);
+
+      if (new_known_bits.zero != known_bits.zero || new_known_bits.one != known_bits.one) {
+        known_bits = new_known_bits;
+        changed = true;
+      }
+    }
+  }
+
+  return analysis;
+}
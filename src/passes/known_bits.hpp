@@ -0,0 +1,61 @@
+#ifndef NETLIST_SRC_PASSES_KNOWN_BITS_HPP
+#define NETLIST_SRC_PASSES_KNOWN_BITS_HPP
+
+#include "program.hpp"
+
+// ========================================================
+// class KnownBitsAnalysis
+// ========================================================
+
+/// \ingroup passes
+/// \brief The bits of a register value that are known at compile time.
+struct KnownBits {
+  /// The bits known to be zero.
+  reg_value_t zero = 0;
+  /// The bits known to be one.
+  reg_value_t one = 0;
+};
+
+/// \ingroup passes
+/// \brief A dataflow analysis computing the bits known to be zero or one for
+/// each register of a program, at any cycle.
+///
+/// Backends do not mask the results of instructions such as `NOT` or `NAND` and
+/// therefore the bits of a register value above its bus size may contain
+/// garbage. The main purpose of this analysis is to prove which registers are
+/// canonical (see is_canonical()) so backends only need to mask the values of
+/// the other registers, and only when the high bits are observable (MUX
+/// choice, memory addresses, etc.).
+///
+/// The analysis assumes that inputs are always canonical (this is ensured by
+/// Simulator::set_register()) and that all registers and memories are
+/// zero-initialized.
+class KnownBitsAnalysis {
+public:
+  [[nodiscard]] static KnownBitsAnalysis analyze(const Program &program);
+
+  /// \brief Returns the known bits of the given register.
+  [[nodiscard]] const KnownBits &get_known_bits(reg_t reg) const { return m_known_bits[reg.index]; }
+
+  /// \brief Returns true if the bits of \a reg at position \a width and above are known to be zero.
+  [[nodiscard]] bool is_zero_extended(reg_t reg, bus_size_t width) const {
+    return (m_known_bits[reg.index].zero | get_bus_mask(width)) == ~reg_value_t(0);
+  }
+  /// \brief Returns true if the bits of \a reg above its bus size are known to be zero.
+  [[nodiscard]] bool is_canonical(reg_t reg) const { return is_zero_extended(reg, m_bus_sizes[reg.index]); }
+
+  /// \brief Returns the mask to apply on the value of \a reg to only keep its \a width
+  /// lowest bits, or all ones if the other bits are already known to be zero.
+  [[nodiscard]] reg_value_t get_mask(reg_t reg, bus_size_t width) const {
+    return is_zero_extended(reg, width) ? ~reg_value_t(0) : get_bus_mask(width);
+  }
+  /// \brief Same as get_mask() with the bus size of \a reg as width.
+  [[nodiscard]] reg_value_t get_mask(reg_t reg) const { return get_mask(reg, m_bus_sizes[reg.index]); }
+
+private:
+  struct Visitor;
+  std::vector<KnownBits> m_known_bits;
+  std::vector<bus_size_t> m_bus_sizes;
+};
+
+#endif // NETLIST_SRC_PASSES_KNOWN_BITS_HPP
@@ -0,0 +1,13 @@
+#include "lazy_mux.hpp"
+#include "guarded_logic.hpp"
+
+#include <cassert>
+
+// ========================================================
+// class LazyMuxPass
+// ========================================================
+
+bool LazyMuxPass::run(const std::shared_ptr<Program> &program) {
+  assert(program != nullptr);
+  return move_guarded_logic(*program, /* make_muxes_lazy= */ true);
+}
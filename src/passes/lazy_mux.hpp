@@ -0,0 +1,32 @@
+#ifndef NETLIST_SRC_PASSES_LAZY_MUX_HPP
+#define NETLIST_SRC_PASSES_LAZY_MUX_HPP
+
+#include "pass.hpp"
+
+// ========================================================
+// class LazyMuxPass
+// ========================================================
+
+/// \ingroup passes
+/// \brief Replaces `MUX` instructions by LazyMuxInstruction that only evaluate the selected operand.
+///
+/// A `MUX` needs both of its operands even though it only uses one of them,
+/// so the whole fan-in cone of the unselected operand is computed for nothing.
+/// This pass finds, for each operand of each `MUX`, the combinational
+/// instructions whose result is exclusively used (directly or transitively)
+/// to compute that operand. These instructions are moved into a guarded body
+/// of a LazyMuxInstruction and are only evaluated when `choice` selects that
+/// operand.
+///
+/// Nested multiplexers are supported: a `MUX` that exclusively feeds an operand
+/// of another one is itself made lazy and moved into the outer body. Outputs,
+/// constants and instructions also read by a `REG`, a memory or another
+/// operand are never moved.
+class LazyMuxPass final : public Pass {
+public:
+  [[nodiscard]] std::string_view get_name() const override { return "lazy-mux"; }
+
+  bool run(const std::shared_ptr<Program> &program) override;
+};
+
+#endif // NETLIST_SRC_PASSES_LAZY_MUX_HPP
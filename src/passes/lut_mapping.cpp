@@ -0,0 +1,151 @@
+#include "lut_mapping.hpp"
+#include "cone.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace {
+// ========================================================
+// struct ConeEvaluator
+// ========================================================
+
+/// Computes the value of the instructions of a cone for given values of its inputs.
+///
+/// The values are kept canonical (the bits above the bus size are zero).
+struct ConeEvaluator final : ConstInstructionVisitor {
+  const Program &program;
+  /// The value of each register, only those of the cone are meaningful.
+  std::vector<reg_value_t> values;
+
+  explicit ConeEvaluator(const Program &p) : program(p), values(p.registers.size()) {}
+
+  void evaluate(const Instruction &instruction) {
+    instruction.visit(*this);
+    values[instruction.output.index] &= get_bus_mask(program.registers.get_bus_size(instruction.output));
+  }
+
+  [[nodiscard]] reg_value_t get(reg_t reg) const { return values[reg.index]; }
+  void set(const Instruction &inst, reg_value_t value) { values[inst.output.index] = value; }
+
+  void visit_const(const ConstInstruction &inst) override { set(inst, inst.value); }
+  void visit_load(const LoadInstruction &inst) override { set(inst, get(inst.input)); }
+  void visit_not(const NotInstruction &inst) override { set(inst, ~get(inst.input)); }
+  void visit_and(const AndInstruction &inst) override { set(inst, get(inst.lhs) & get(inst.rhs)); }
+  void visit_nand(const NandInstruction &inst) override { set(inst, ~(get(inst.lhs) & get(inst.rhs))); }
+  void visit_or(const OrInstruction &inst) override { set(inst, get(inst.lhs) | get(inst.rhs)); }
+  void visit_nor(const NorInstruction &inst) override { set(inst, ~(get(inst.lhs) | get(inst.rhs))); }
+  void visit_xor(const XorInstruction &inst) override { set(inst, get(inst.lhs) ^ get(inst.rhs)); }
+  void visit_xnor(const XnorInstruction &inst) override { set(inst, ~(get(inst.lhs) ^ get(inst.rhs))); }
+  void visit_add(const AddInstruction &inst) override { set(inst, get(inst.lhs) + get(inst.rhs)); }
+  void visit_sub(const SubInstruction &inst) override { set(inst, get(inst.lhs) - get(inst.rhs)); }
+  void visit_eq(const EqInstruction &inst) override { set(inst, get(inst.lhs) == get(inst.rhs)); }
+  void visit_lt(const LtInstruction &inst) override { set(inst, get(inst.lhs) < get(inst.rhs)); }
+  void visit_mul(const MulInstruction &inst) override { set(inst, get(inst.lhs) * get(inst.rhs)); }
+  void visit_shl(const ShlInstruction &inst) override { set(inst, shift_left(get(inst.lhs), get(inst.rhs))); }
+  void visit_shr(const ShrInstruction &inst) override { set(inst, shift_right(get(inst.lhs), get(inst.rhs))); }
+  void visit_asr(const AsrInstruction &inst) override {
+    const auto bus_size = program.registers.get_bus_size(inst.output);
+    set(inst, arithmetic_shift_right(get(inst.lhs), get(inst.rhs), bus_size));
+  }
+  void visit_reduce_or(const ReduceOrInstruction &inst) override { set(inst, get(inst.input) != 0); }
+  void visit_reduce_and(const ReduceAndInstruction &inst) override {
+    set(inst, get(inst.input) == get_bus_mask(program.registers.get_bus_size(inst.input)));
+  }
+  void visit_mux(const MuxInstruction &inst) override {
+    set(inst, get(inst.choice) == 0 ? get(inst.first) : get(inst.second));
+  }
+  void visit_concat(const ConcatInstruction &inst) override {
+    set(inst, get(inst.lhs) | shift_left(get(inst.rhs), inst.offset));
+  }
+  void visit_select(const SelectInstruction &inst) override { set(inst, shift_right(get(inst.input), inst.i) & 1); }
+  void visit_slice(const SliceInstruction &inst) override {
+    set(inst, shift_right(get(inst.input), inst.start) & get_bus_mask(inst.end - inst.start + 1));
+  }
+  void visit_gather(const GatherInstruction &inst) override {
+    reg_value_t value = inst.constant;
+    for (const auto &part : inst.parts)
+      value |= deposit_bits(extract_bits(get(part.input), part.extract_mask), part.deposit_mask);
+    set(inst, value);
+  }
+  void visit_lut(const LutInstruction &inst) override {
+    std::size_t index = 0;
+    bus_size_t offset = 0;
+    for (const auto &input : inst.inputs) {
+      index |= get(input) << offset;
+      offset += program.registers.get_bus_size(input);
+    }
+    set(inst, inst.get_entry(index));
+  }
+
+  // Never part of a cone, see is_combinational().
+  void visit_reg(const RegInstruction &inst) override { assert(false); }
+  void visit_delay(const DelayInstruction &inst) override { assert(false); }
+  void visit_rom(const RomInstruction &inst) override { assert(false); }
+  void visit_ram(const RamInstruction &inst) override { assert(false); }
+  void visit_memo(const MemoInstruction &inst) override { assert(false); }
+  void visit_lazy_mux(const LazyMuxInstruction &inst) override { assert(false); }
+  void visit_enabled_reg(const EnabledRegInstruction &inst) override { assert(false); }
+};
+
+/// Computes the truth table of \a cone, the entry `i` being the value of the
+/// root when the inputs of the cone are the bits of `i`.
+[[nodiscard]] std::vector<reg_value_t> compute_table(const Program &program, ConeEvaluator &evaluator,
+                                                     const Cone &cone) {
+  bus_size_t input_bits = 0;
+  for (const auto input : cone.inputs)
+    input_bits += program.registers.get_bus_size(input);
+
+  std::vector<reg_value_t> entries(std::size_t(1) << input_bits);
+  for (std::size_t index = 0; index < entries.size(); ++index) {
+    bus_size_t offset = 0;
+    for (const auto input : cone.inputs) {
+      const auto bus_size = program.registers.get_bus_size(input);
+      evaluator.values[input.index] = (index >> offset) & get_bus_mask(bus_size);
+      offset += bus_size;
+    }
+
+    for (const auto *instruction : cone.instructions)
+      evaluator.evaluate(*instruction);
+    entries[index] = evaluator.values[cone.get_root().index];
+  }
+
+  return entries;
+}
+} // namespace
+
+// ========================================================
+// class LutMappingPass
+// ========================================================
+
+bool LutMappingPass::run(const std::shared_ptr<Program> &program) {
+  assert(program != nullptr);
+  assert(m_max_input_bits >= 1 && m_max_input_bits <= MAX_INPUT_BITS);
+
+  // The definitions of the roots are replaced by the LUT instructions, the
+  // other instructions of the cones are then removed as dead code.
+  std::vector<const Instruction *> to_delete;
+  {
+    ConeCover cover(*program, m_max_input_bits);
+    ConeEvaluator evaluator(*program);
+    ProgramBuilder builder(program);
+    while (const auto cone = cover.next()) {
+      // A single instruction is cheaper than a lookup.
+      if (cone->get_gate_count() < 2)
+        continue;
+
+      builder.add_lut(cone->get_root(), cone->inputs, compute_table(*program, evaluator, *cone));
+      to_delete.push_back(cone->instructions.back());
+    }
+  }
+
+  if (to_delete.empty())
+    return false;
+
+  std::ranges::sort(to_delete);
+  erase_instructions_if(*program, [&to_delete](const Instruction *instruction) {
+    return std::ranges::binary_search(to_delete, instruction);
+  });
+  erase_dead_instructions(*program);
+  return true;
+}
@@ -0,0 +1,39 @@
+#ifndef NETLIST_SRC_PASSES_LUT_MAPPING_HPP
+#define NETLIST_SRC_PASSES_LUT_MAPPING_HPP
+
+#include "pass.hpp"
+
+// ========================================================
+// class LutMappingPass
+// ========================================================
+
+/// \ingroup passes
+/// \brief Replaces small cones of combinational logic by lookup tables.
+///
+/// This is the technology mapping done for FPGAs, but for simulation speed:
+/// the combinational instructions are covered by cones whose inputs have at
+/// most K bits in total (see ConeCover). The truth table of each cone is
+/// computed once and the cone is replaced by a single LutInstruction indexed by
+/// the concatenation of its inputs, so dozens of gates become one table lookup.
+/// A cone is only replaced when it has at least two instructions.
+///
+/// The tables have `2^K` entries packed in 64-bit words, for example a cone
+/// with a 1-bit output and K = 8 takes 32 bytes.
+class LutMappingPass final : public Pass {
+public:
+  static constexpr unsigned DEFAULT_MAX_INPUT_BITS = 8;
+  /// The maximal value of K, the tables being exponential in K.
+  static constexpr unsigned MAX_INPUT_BITS = 16;
+
+  /// \param max_input_bits The maximal count of input bits (K) of a cone, in the range [1, MAX_INPUT_BITS].
+  explicit LutMappingPass(unsigned max_input_bits = DEFAULT_MAX_INPUT_BITS) : m_max_input_bits(max_input_bits) {}
+
+  [[nodiscard]] std::string_view get_name() const override { return "lut-mapping"; }
+
+  bool run(const std::shared_ptr<Program> &program) override;
+
+private:
+  unsigned m_max_input_bits;
+};
+
+#endif // NETLIST_SRC_PASSES_LUT_MAPPING_HPP
@@ -0,0 +1,51 @@
+#include "memoization.hpp"
+#include "cone.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+// ========================================================
+// class MemoizationPass
+// ========================================================
+
+bool MemoizationPass::run(const std::shared_ptr<Program> &program) {
+  assert(program != nullptr);
+  assert(m_cache_bits >= 1 && m_cache_bits <= 16);
+
+  // The keys of the caches are a single word.
+  constexpr bus_size_t max_input_bits = 64;
+
+  // The instructions moved into the bodies (except the constants that may be
+  // used elsewhere and are removed later if dead).
+  std::vector<const Instruction *> to_delete;
+  std::vector<MemoInstruction *> memos;
+  {
+    ConeCover cover(*program, max_input_bits);
+    while (const auto cone = cover.next()) {
+      if (cone->get_gate_count() < m_min_gate_count)
+        continue;
+
+      auto *memo = new MemoInstruction();
+      memo->output = cone->get_root();
+      memo->inputs = cone->inputs;
+      memo->cache_bits = m_cache_bits;
+      for (const auto *instruction : cone->instructions) {
+        memo->body.push_back(clone_instruction(*instruction));
+        if (dynamic_cast<const ConstInstruction *>(instruction) == nullptr)
+          to_delete.push_back(instruction);
+      }
+      memos.push_back(memo);
+    }
+  }
+
+  if (memos.empty())
+    return false;
+
+  std::ranges::sort(to_delete);
+  erase_instructions_if(*program, [&to_delete](const Instruction *instruction) {
+    return std::ranges::binary_search(to_delete, instruction);
+  });
+  program->instructions.insert(program->instructions.end(), memos.begin(), memos.end());
+  erase_dead_instructions(*program);
+  return true;
+}
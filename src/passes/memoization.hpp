@@ -0,0 +1,44 @@
+#ifndef NETLIST_SRC_PASSES_MEMOIZATION_HPP
+#define NETLIST_SRC_PASSES_MEMOIZATION_HPP
+
+#include "pass.hpp"
+
+// ========================================================
+// class MemoizationPass
+// ========================================================
+
+/// \ingroup passes
+/// \brief Wraps large combinational cones into MemoInstruction.
+///
+/// Some wide cones (instruction decoders, ALU control logic, etc.) have many
+/// input bits but see very few distinct input patterns at runtime. This pass
+/// covers the program with cones whose inputs fit in 64 bits (see ConeCover)
+/// and moves the cones with at least a given count of instructions into the
+/// body of a MemoInstruction. The simulator then caches the results of each
+/// cone in a small direct-mapped table indexed by its inputs and skips the
+/// body on a hit.
+///
+/// The simulator counts the hits and misses of each cone and disables the
+/// caches with a low hit rate after some cycles, so the selection of the cones
+/// is refined by profiling at runtime.
+class MemoizationPass final : public Pass {
+public:
+  static constexpr std::size_t DEFAULT_MIN_GATE_COUNT = 16;
+  static constexpr unsigned DEFAULT_CACHE_BITS = 8;
+
+  /// \param min_gate_count The minimal count of instructions of a memoized cone.
+  /// \param cache_bits The base 2 logarithm of the count of cache entries, in the range [1,16].
+  explicit MemoizationPass(std::size_t min_gate_count = DEFAULT_MIN_GATE_COUNT,
+                           unsigned cache_bits = DEFAULT_CACHE_BITS)
+      : m_min_gate_count(min_gate_count), m_cache_bits(cache_bits) {}
+
+  [[nodiscard]] std::string_view get_name() const override { return "memoization"; }
+
+  bool run(const std::shared_ptr<Program> &program) override;
+
+private:
+  std::size_t m_min_gate_count;
+  unsigned m_cache_bits;
+};
+
+#endif // NETLIST_SRC_PASSES_MEMOIZATION_HPP
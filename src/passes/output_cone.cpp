@@ -0,0 +1,80 @@
+#include "output_cone.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+// ========================================================
+// class OutputConePass
+// ========================================================
+
+bool OutputConePass::run(const std::shared_ptr<Program> &program) {
+  assert(program != nullptr);
+
+  const auto register_count = program->registers.size();
+
+  // All definitions of each register (a register may be defined more than once).
+  std::vector<std::vector<Instruction *>> definitions(register_count);
+  for (auto *instruction : program->instructions)
+    definitions[instruction->output.index].push_back(instruction);
+
+  // Marks the registers in the cone, get_instruction_inputs() also returns the
+  // inputs of REG and of RAM write ports so state is followed across cycles.
+  std::vector<bool> is_live(register_count, false);
+  std::vector<reg_t> worklist;
+  for (const auto output : m_observed_outputs) {
+    assert(output.index < register_count);
+    if (!is_live[output.index]) {
+      is_live[output.index] = true;
+      worklist.push_back(output);
+    }
+  }
+
+  while (!worklist.empty()) {
+    const auto reg = worklist.back();
+    worklist.pop_back();
+
+    for (const auto *definition : definitions[reg.index]) {
+      for (const auto input : get_instruction_inputs(*definition)) {
+        if (!is_live[input.index]) {
+          is_live[input.index] = true;
+          worklist.push_back(input);
+        }
+      }
+    }
+  }
+
+  bool modified = false;
+  for (reg_index_t i = 0; i < register_count; ++i) {
+    auto flags = program->registers.get_flags({i});
+    if ((flags & RIF_OUTPUT) && std::ranges::find(m_observed_outputs, reg_t{i}) == m_observed_outputs.end()) {
+      flags &= ~RIF_OUTPUT;
+      modified = true;
+    }
+
+    if ((flags & RIF_INPUT) && !is_live[i]) {
+      flags &= ~RIF_INPUT;
+      modified = true;
+    }
+    program->registers.set_flags({i}, flags);
+  }
+
+  const auto instruction_count = program->instructions.size();
+  erase_instructions_if(*program, [&is_live](const Instruction *instruction) {
+    return !is_live[instruction->output.index];
+  });
+  if (program->instructions.size() == instruction_count)
+    return modified;
+
+  // Removes the memory blocks whose instruction was erased and renumbers the others.
+  std::vector<MemoryInfo> memories;
+  for (auto *instruction : program->instructions) {
+    if (auto *memory_instruction = dynamic_cast<MemoryInstruction *>(instruction)) {
+      auto &memory_info = memories.emplace_back(program->memories[memory_instruction->memory_block]);
+      assert(memory_info.parent == instruction);
+      memory_instruction->memory_block = memories.size() - 1;
+    }
+  }
+
+  program->memories = std::move(memories);
+  return true;
+}
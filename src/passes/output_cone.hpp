@@ -0,0 +1,34 @@
+#ifndef NETLIST_SRC_PASSES_OUTPUT_CONE_HPP
+#define NETLIST_SRC_PASSES_OUTPUT_CONE_HPP
+
+#include "pass.hpp"
+
+// ========================================================
+// class OutputConePass
+// ========================================================
+
+/// \ingroup passes
+/// \brief Reduces a program to the logic needed to compute some of its outputs.
+///
+/// The pass keeps the transitive fan-in cone of the observed outputs, including
+/// the state (`REG` and `RAM` write ports) feeding into that cone across
+/// cycles. All other instructions and memories are removed. The other outputs
+/// and the inputs that do not influence the observed outputs lose their flag,
+/// so they are no longer printed or queried by the driver.
+///
+/// Unlike other passes, this one changes the observable behavior of the
+/// program and it is therefore only enabled on request (see the `--observe`
+/// option of the driver).
+class OutputConePass final : public Pass {
+public:
+  explicit OutputConePass(std::vector<reg_t> observed_outputs) : m_observed_outputs(std::move(observed_outputs)) {}
+
+  [[nodiscard]] std::string_view get_name() const override { return "output-cone"; }
+
+  bool run(const std::shared_ptr<Program> &program) override;
+
+private:
+  std::vector<reg_t> m_observed_outputs;
+};
+
+#endif // NETLIST_SRC_PASSES_OUTPUT_CONE_HPP
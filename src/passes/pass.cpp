@@ -0,0 +1,120 @@
+#include "pass.hpp"
+#include "aig_rewriting.hpp"
+#include "arithmetic.hpp"
+#include "bit_gather.hpp"
+#include "enabled_register.hpp"
+#include "peephole.hpp"
+#include "sequential_redundancy.hpp"
+#include "shift_register.hpp"
+#include "word_level.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <unordered_set>
+
+// ========================================================
+// class PassManager
+// ========================================================
+
+void PassManager::add_pass(std::unique_ptr<Pass> pass) {
+  assert(pass != nullptr);
+  m_passes.push_back(std::move(pass));
+}
+
+void PassManager::add_default_passes(unsigned optimization_level) {
+  if (optimization_level >= 1) {
+    add_pass(std::make_unique<PeepholePass>());
+    add_pass(std::make_unique<SequentialRedundancyPass>());
+    add_pass(std::make_unique<BitGatherPass>());
+    add_pass(std::make_unique<ArithmeticPass>());
+    add_pass(std::make_unique<WordLevelPass>());
+    if (optimization_level >= 2)
+      add_pass(std::make_unique<AigRewritingPass>(/* balance= */ optimization_level >= 3));
+    add_pass(std::make_unique<PeepholePass>());
+    add_pass(std::make_unique<ShiftRegisterPass>());
+    add_pass(std::make_unique<EnabledRegisterPass>());
+  }
+}
+
+bool PassManager::run(const std::shared_ptr<Program> &program) {
+  assert(program != nullptr);
+
+  bool modified = false;
+  for (const auto &pass : m_passes)
+    modified |= pass->run(program);
+  return modified;
+}
+
+// ========================================================
+// Utilities for passes
+// ========================================================
+
+DefUseInfo DefUseInfo::build(const Program &program) {
+  DefUseInfo info;
+  info.definitions.resize(program.registers.size(), nullptr);
+  info.use_counts.resize(program.registers.size(), 0);
+
+  std::vector<bool> already_defined(program.registers.size(), false);
+  for (auto *instruction : program.instructions) {
+    const auto output = instruction->output.index;
+    if (already_defined[output]) {
+      info.definitions[output] = nullptr; // defined more than once
+    } else {
+      info.definitions[output] = instruction;
+      already_defined[output] = true;
+    }
+
+    for (const auto input : get_instruction_inputs(*instruction))
+      info.use_counts[input.index]++;
+  }
+
+  return info;
+}
+
+void erase_instructions_if(Program &program, const std::function<bool(const Instruction *)> &predicate) {
+  auto &instructions = program.instructions;
+  auto it = std::remove_if(instructions.begin(), instructions.end(), [&predicate](Instruction *instruction) {
+    if (!predicate(instruction))
+      return false;
+
+    delete instruction;
+    return true;
+  });
+  instructions.erase(it, instructions.end());
+}
+
+bool erase_dead_instructions(Program &program) {
+  auto def_use = DefUseInfo::build(program);
+
+  std::vector<reg_index_t> worklist;
+  for (reg_index_t i = 0; i < program.registers.size(); ++i) {
+    if (def_use.use_counts[i] == 0)
+      worklist.push_back(i);
+  }
+
+  std::unordered_set<const Instruction *> dead_instructions;
+  while (!worklist.empty()) {
+    const auto reg = worklist.back();
+    worklist.pop_back();
+
+    const auto *definition = def_use.definitions[reg];
+    if (definition == nullptr || def_use.use_counts[reg] > 0 || (program.registers.get_flags({reg}) & RIF_OUTPUT) ||
+        dynamic_cast<const MemoryInstruction *>(definition) != nullptr)
+      continue;
+
+    dead_instructions.insert(definition);
+    def_use.definitions[reg] = nullptr;
+    for (const auto input : get_instruction_inputs(*definition)) {
+      if (--def_use.use_counts[input.index] == 0)
+        worklist.push_back(input.index);
+    }
+  }
+
+  if (dead_instructions.empty())
+    return false;
+
+  erase_instructions_if(program, [&dead_instructions](const Instruction *instruction) {
+    return dead_instructions.contains(instruction);
+  });
+  return true;
+}
@@ -0,0 +1,105 @@
+#ifndef NETLIST_SRC_PASSES_PASS_HPP
+#define NETLIST_SRC_PASSES_PASS_HPP
+
+#include "program.hpp"
+
+#include <functional>
+#include <string_view>
+
+/// \addtogroup passes The optimization passes
+/// Transformations applied on a Netlist program before its simulation.
+/// @{
+
+// ========================================================
+// class Pass
+// ========================================================
+
+/// \brief The interface for all passes transforming a Netlist program.
+///
+/// A pass takes a parsed program and rewrites it in place, keeping its observable
+/// behavior (the values of its outputs at each cycle) unchanged. Unless stated
+/// otherwise, passes do not require the program to be scheduled and do not keep
+/// it scheduled: new instructions are appended at the end of the program. So
+/// the scheduling must be done after running the passes. See DependencyGraph.
+///
+/// Passes are usually not run directly but via the PassManager.
+class Pass {
+public:
+  virtual ~Pass() = default;
+
+  /// \brief Returns the pass name.
+  [[nodiscard]] virtual std::string_view get_name() const = 0;
+
+  /// \brief Runs the pass on the given program.
+  ///
+  /// \param program The program to transform.
+  /// \return True if the program was modified.
+  virtual bool run(const std::shared_ptr<Program> &program) = 0;
+};
+
+// ========================================================
+// class PassManager
+// ========================================================
+
+/// \brief Runs a sequence of passes over a program.
+///
+/// Example of usage:
+/// ```
+/// std::shared_ptr<Program> program = /* ... */;
+/// PassManager pass_manager;
+/// pass_manager.add_default_passes(/* optimization_level= */ 1);
+/// pass_manager.run(program);
+/// // then schedule the program
+/// ```
+class PassManager {
+public:
+  /// \brief Adds the given pass at the end of the pipeline.
+  void add_pass(std::unique_ptr<Pass> pass);
+  /// \brief Adds the passes enabled at the given optimization level.
+  ///
+  /// The level 0 does not add any pass. The level 2 also rewrites the 1-bit
+  /// logic (see AigRewritingPass) and the level 3 also balances it.
+  void add_default_passes(unsigned optimization_level);
+
+  /// \brief Runs all passes, in order, on the given program.
+  /// \return True if the program was modified by at least one pass.
+  bool run(const std::shared_ptr<Program> &program);
+
+private:
+  std::vector<std::unique_ptr<Pass>> m_passes;
+};
+
+// ========================================================
+// Utilities for passes
+// ========================================================
+
+/// \brief Def-use information about the registers of a program.
+///
+/// The information is computed once by build() and it is not updated when the
+/// program is modified. Passes are responsible to keep it coherent if needed.
+struct DefUseInfo {
+  /// The instruction defining each register. It is null if the register is
+  /// not defined by any instruction (e.g. inputs) or if it is defined more than once.
+  std::vector<Instruction *> definitions;
+  /// The count of instruction operands reading each register.
+  std::vector<std::uint_least32_t> use_counts;
+
+  [[nodiscard]] static DefUseInfo build(const Program &program);
+};
+
+/// \brief Removes (and deletes) all instructions of \a program for which \a predicate returns true.
+///
+/// The relative order of the remaining instructions is kept.
+void erase_instructions_if(Program &program, const std::function<bool(const Instruction *)> &predicate);
+
+/// \brief Removes the instructions whose result is never used.
+///
+/// Instructions defining an output, memory instructions (`ROM` and `RAM`) and
+/// registers defined more than once are always kept.
+///
+/// \return True if at least one instruction was removed.
+bool erase_dead_instructions(Program &program);
+
+/// @}
+
+#endif // NETLIST_SRC_PASSES_PASS_HPP
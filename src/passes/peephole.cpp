@@ -0,0 +1,398 @@
+#include "peephole.hpp"
+
+#include <cassert>
+#include <optional>
+
+namespace {
+// ========================================================
+// struct PeepholeContext
+// ========================================================
+
+/// The information available to the peephole rules.
+struct PeepholeContext {
+  const Program &program;
+  DefUseInfo &def_use;
+
+  [[nodiscard]] bus_size_t get_bus_size(reg_t reg) const { return program.registers.get_bus_size(reg); }
+
+  /// Returns the instruction defining \a reg, or null if unknown.
+  [[nodiscard]] const Instruction *get_definition(reg_t reg) const { return def_use.definitions[reg.index]; }
+
+  /// Returns the instruction defining \a reg if it is of type T, or null otherwise.
+  template <class T> [[nodiscard]] const T *get_definition_as(reg_t reg) const {
+    return dynamic_cast<const T *>(get_definition(reg));
+  }
+
+  /// Returns the value of \a reg if it is a constant.
+  [[nodiscard]] std::optional<reg_value_t> get_constant(reg_t reg) const {
+    if (const auto *inst = get_definition_as<ConstInstruction>(reg))
+      return inst->value & get_bus_mask(get_bus_size(reg));
+    return std::nullopt;
+  }
+
+  /// Returns true if \a reg is the constant \a value.
+  [[nodiscard]] bool is_constant(reg_t reg, reg_value_t value) const {
+    const auto constant = get_constant(reg);
+    return constant.has_value() && constant.value() == (value & get_bus_mask(get_bus_size(reg)));
+  }
+};
+
+// ========================================================
+// Instruction factories
+// ========================================================
+
+Instruction *make_const(reg_t output, reg_value_t value) {
+  auto *inst = new ConstInstruction();
+  inst->output = output;
+  inst->value = value;
+  return inst;
+}
+
+template <class T> Instruction *make_unary(reg_t output, reg_t input) {
+  auto *inst = new T();
+  inst->output = output;
+  inst->input = input;
+  return inst;
+}
+
+template <class T> Instruction *make_binary(reg_t output, reg_t lhs, reg_t rhs) {
+  auto *inst = new T();
+  inst->output = output;
+  inst->lhs = lhs;
+  inst->rhs = rhs;
+  return inst;
+}
+
+// ========================================================
+// Constant folding
+// ========================================================
+
+/// Evaluates an instruction whose operands are all constants.
+struct ConstantEvaluator final : ConstInstructionVisitor {
+  const PeepholeContext &ctx;
+  std::optional<reg_value_t> result;
+
+  explicit ConstantEvaluator(const PeepholeContext &c) : ctx(c) {}
+
+  void visit_const(const ConstInstruction &inst) override {}
+  void visit_load(const LoadInstruction &inst) override { result = ctx.get_constant(inst.input); }
+  void visit_not(const NotInstruction &inst) override {
+    if (const auto value = ctx.get_constant(inst.input))
+      result = ~value.value();
+  }
+  // The value of a register in the previous cycle is not a constant (it is
+  // zero at the first cycle) and memories are not constant either.
+  void visit_reg(const RegInstruction &inst) override {}
+  void visit_delay(const DelayInstruction &inst) override {}
+  void visit_memo(const MemoInstruction &inst) override {}
+  void visit_lazy_mux(const LazyMuxInstruction &inst) override {}
+  void visit_enabled_reg(const EnabledRegInstruction &inst) override {}
+  void visit_lut(const LutInstruction &inst) override {
+    std::size_t index = 0;
+    bus_size_t offset = 0;
+    for (const auto &input : inst.inputs) {
+      const auto value = ctx.get_constant(input);
+      if (!value.has_value())
+        return;
+      index |= value.value() << offset;
+      offset += ctx.get_bus_size(input);
+    }
+    result = inst.get_entry(index);
+  }
+  void visit_rom(const RomInstruction &inst) override {}
+  void visit_ram(const RamInstruction &inst) override {}
+  void visit_mux(const MuxInstruction &inst) override {
+    const auto choice = ctx.get_constant(inst.choice);
+    const auto first = ctx.get_constant(inst.first);
+    const auto second = ctx.get_constant(inst.second);
+    if (choice.has_value() && first.has_value() && second.has_value())
+      result = choice.value() == 0 ? first.value() : second.value();
+  }
+  void visit_concat(const ConcatInstruction &inst) override {
+    const auto lhs = ctx.get_constant(inst.lhs);
+    const auto rhs = ctx.get_constant(inst.rhs);
+    if (lhs.has_value() && rhs.has_value())
+      result = lhs.value() | (inst.offset >= 64 ? 0 : (rhs.value() << inst.offset));
+  }
+  void visit_and(const AndInstruction &inst) override { visit_binary(inst, [](auto a, auto b) { return a & b; }); }
+  void visit_nand(const NandInstruction &inst) override {
+    visit_binary(inst, [](auto a, auto b) { return ~(a & b); });
+  }
+  void visit_or(const OrInstruction &inst) override { visit_binary(inst, [](auto a, auto b) { return a | b; }); }
+  void visit_nor(const NorInstruction &inst) override { visit_binary(inst, [](auto a, auto b) { return ~(a | b); }); }
+  void visit_xor(const XorInstruction &inst) override { visit_binary(inst, [](auto a, auto b) { return a ^ b; }); }
+  void visit_xnor(const XnorInstruction &inst) override {
+    visit_binary(inst, [](auto a, auto b) { return ~(a ^ b); });
+  }
+  void visit_add(const AddInstruction &inst) override { visit_binary(inst, [](auto a, auto b) { return a + b; }); }
+  void visit_sub(const SubInstruction &inst) override { visit_binary(inst, [](auto a, auto b) { return a - b; }); }
+  void visit_eq(const EqInstruction &inst) override {
+    visit_binary(inst, [](auto a, auto b) { return reg_value_t(a == b); });
+  }
+  void visit_lt(const LtInstruction &inst) override {
+    visit_binary(inst, [](auto a, auto b) { return reg_value_t(a < b); });
+  }
+  void visit_mul(const MulInstruction &inst) override { visit_binary(inst, [](auto a, auto b) { return a * b; }); }
+  void visit_shl(const ShlInstruction &inst) override { visit_binary(inst, shift_left); }
+  void visit_shr(const ShrInstruction &inst) override { visit_binary(inst, shift_right); }
+  void visit_asr(const AsrInstruction &inst) override {
+    const auto bus_size = ctx.get_bus_size(inst.output);
+    visit_binary(inst, [bus_size](auto a, auto b) { return arithmetic_shift_right(a, b, bus_size); });
+  }
+  void visit_reduce_or(const ReduceOrInstruction &inst) override {
+    if (const auto value = ctx.get_constant(inst.input))
+      result = value.value() != 0;
+  }
+  void visit_reduce_and(const ReduceAndInstruction &inst) override {
+    if (const auto value = ctx.get_constant(inst.input))
+      result = value.value() == get_bus_mask(ctx.get_bus_size(inst.input));
+  }
+  void visit_select(const SelectInstruction &inst) override {
+    if (const auto value = ctx.get_constant(inst.input); value.has_value() && inst.i < 64)
+      result = (value.value() >> inst.i) & 1;
+  }
+  void visit_slice(const SliceInstruction &inst) override {
+    if (const auto value = ctx.get_constant(inst.input); value.has_value() && inst.start <= inst.end && inst.end < 64)
+      result = (value.value() >> inst.start) & get_bus_mask(inst.end - inst.start + 1);
+  }
+  void visit_gather(const GatherInstruction &inst) override {
+    reg_value_t value = inst.constant;
+    for (const auto &part : inst.parts) {
+      const auto input = ctx.get_constant(part.input);
+      if (!input.has_value())
+        return;
+
+      // Moves the bits one by one, this is slow but simple.
+      auto extract_mask = part.extract_mask;
+      auto deposit_mask = part.deposit_mask;
+      while (extract_mask != 0) {
+        if (input.value() & extract_mask & -extract_mask)
+          value |= deposit_mask & -deposit_mask;
+        extract_mask &= extract_mask - 1;
+        deposit_mask &= deposit_mask - 1;
+      }
+    }
+    result = value;
+  }
+
+  template <class F> void visit_binary(const BinaryInstruction &inst, F f) {
+    const auto lhs = ctx.get_constant(inst.lhs);
+    const auto rhs = ctx.get_constant(inst.rhs);
+    if (lhs.has_value() && rhs.has_value())
+      result = f(lhs.value(), rhs.value());
+  }
+};
+
+// ========================================================
+// The rules
+// ========================================================
+
+/// `op a b` where all operands are constants -> `CONST`
+Instruction *rewrite_constant_folding(const PeepholeContext &ctx, const Instruction &inst) {
+  ConstantEvaluator evaluator(ctx);
+  inst.visit(evaluator);
+  if (!evaluator.result.has_value())
+    return nullptr;
+
+  return make_const(inst.output, evaluator.result.value() & get_bus_mask(ctx.get_bus_size(inst.output)));
+}
+
+/// `NOT (NOT x)` -> `x`
+/// `NOT (AND a b)` -> `NAND a b` (and likewise for the other binary operators)
+Instruction *rewrite_not_of_negatable(const PeepholeContext &ctx, const Instruction &inst) {
+  const auto *not_inst = dynamic_cast<const NotInstruction *>(&inst);
+  if (not_inst == nullptr)
+    return nullptr;
+
+  const auto *definition = ctx.get_definition(not_inst->input);
+  if (const auto *inner = dynamic_cast<const NotInstruction *>(definition))
+    return make_unary<LoadInstruction>(inst.output, inner->input);
+
+  const auto *binary = dynamic_cast<const BinaryInstruction *>(definition);
+  if (binary == nullptr)
+    return nullptr;
+
+  if (dynamic_cast<const AndInstruction *>(binary))
+    return make_binary<NandInstruction>(inst.output, binary->lhs, binary->rhs);
+  if (dynamic_cast<const NandInstruction *>(binary))
+    return make_binary<AndInstruction>(inst.output, binary->lhs, binary->rhs);
+  if (dynamic_cast<const OrInstruction *>(binary))
+    return make_binary<NorInstruction>(inst.output, binary->lhs, binary->rhs);
+  if (dynamic_cast<const NorInstruction *>(binary))
+    return make_binary<OrInstruction>(inst.output, binary->lhs, binary->rhs);
+  if (dynamic_cast<const XorInstruction *>(binary))
+    return make_binary<XnorInstruction>(inst.output, binary->lhs, binary->rhs);
+  if (dynamic_cast<const XnorInstruction *>(binary))
+    return make_binary<XorInstruction>(inst.output, binary->lhs, binary->rhs);
+  return nullptr;
+}
+
+/// `AND x x` -> `x`, `OR x x` -> `x`
+/// `NAND x x` -> `NOT x`, `NOR x x` -> `NOT x`
+/// `XOR x x` -> `0`, `XNOR x x` -> `1...1`
+Instruction *rewrite_same_operands(const PeepholeContext &ctx, const Instruction &inst) {
+  const auto *binary = dynamic_cast<const BinaryInstruction *>(&inst);
+  if (binary == nullptr || binary->lhs != binary->rhs)
+    return nullptr;
+
+  const auto x = binary->lhs;
+  if (dynamic_cast<const AndInstruction *>(binary) || dynamic_cast<const OrInstruction *>(binary))
+    return make_unary<LoadInstruction>(inst.output, x);
+  if (dynamic_cast<const NandInstruction *>(binary) || dynamic_cast<const NorInstruction *>(binary))
+    return make_unary<NotInstruction>(inst.output, x);
+  if (dynamic_cast<const XorInstruction *>(binary))
+    return make_const(inst.output, 0);
+  if (dynamic_cast<const XnorInstruction *>(binary))
+    return make_const(inst.output, get_bus_mask(ctx.get_bus_size(inst.output)));
+  return nullptr;
+}
+
+/// `AND x 0` -> `0`, `AND x 1...1` -> `x`, `OR x 0` -> `x`, `XOR x 1...1` -> `NOT x`, etc.
+Instruction *rewrite_constant_operand(const PeepholeContext &ctx, const Instruction &inst) {
+  const auto *binary = dynamic_cast<const BinaryInstruction *>(&inst);
+  if (binary == nullptr)
+    return nullptr;
+
+  const auto ones = get_bus_mask(ctx.get_bus_size(inst.output));
+  for (const auto &[constant, x] : {std::pair{binary->lhs, binary->rhs}, std::pair{binary->rhs, binary->lhs}}) {
+    const bool is_zero = ctx.is_constant(constant, 0);
+    const bool is_ones = ctx.is_constant(constant, ones);
+    if (!is_zero && !is_ones)
+      continue;
+
+    if (dynamic_cast<const AndInstruction *>(binary))
+      return is_zero ? make_const(inst.output, 0) : make_unary<LoadInstruction>(inst.output, x);
+    if (dynamic_cast<const NandInstruction *>(binary))
+      return is_zero ? make_const(inst.output, ones) : make_unary<NotInstruction>(inst.output, x);
+    if (dynamic_cast<const OrInstruction *>(binary))
+      return is_zero ? make_unary<LoadInstruction>(inst.output, x) : make_const(inst.output, ones);
+    if (dynamic_cast<const NorInstruction *>(binary))
+      return is_zero ? make_unary<NotInstruction>(inst.output, x) : make_const(inst.output, 0);
+    if (dynamic_cast<const XorInstruction *>(binary))
+      return is_zero ? make_unary<LoadInstruction>(inst.output, x) : make_unary<NotInstruction>(inst.output, x);
+    if (dynamic_cast<const XnorInstruction *>(binary))
+      return is_zero ? make_unary<NotInstruction>(inst.output, x) : make_unary<LoadInstruction>(inst.output, x);
+  }
+
+  return nullptr;
+}
+
+/// `MUX c a a` -> `a`
+/// `MUX 0 a b` -> `a`, `MUX 1 a b` -> `b`
+Instruction *rewrite_mux(const PeepholeContext &ctx, const Instruction &inst) {
+  const auto *mux = dynamic_cast<const MuxInstruction *>(&inst);
+  if (mux == nullptr)
+    return nullptr;
+
+  if (mux->first == mux->second)
+    return make_unary<LoadInstruction>(inst.output, mux->first);
+
+  if (const auto choice = ctx.get_constant(mux->choice))
+    return make_unary<LoadInstruction>(inst.output, choice.value() == 0 ? mux->first : mux->second);
+
+  return nullptr;
+}
+
+/// `SLICE 0 (n-1) x` -> `x` where x is a n-bit register
+/// `SELECT 0 x` -> `x` where x is a 1-bit register
+Instruction *rewrite_full_slice(const PeepholeContext &ctx, const Instruction &inst) {
+  if (const auto *slice = dynamic_cast<const SliceInstruction *>(&inst)) {
+    if (slice->start == 0 && slice->end + 1 == ctx.get_bus_size(slice->input) &&
+        ctx.get_bus_size(inst.output) == ctx.get_bus_size(slice->input))
+      return make_unary<LoadInstruction>(inst.output, slice->input);
+  } else if (const auto *select = dynamic_cast<const SelectInstruction *>(&inst)) {
+    if (select->i == 0 && ctx.get_bus_size(select->input) == 1 && ctx.get_bus_size(inst.output) == 1)
+      return make_unary<LoadInstruction>(inst.output, select->input);
+  }
+
+  return nullptr;
+}
+
+/// A peephole rule. Given an instruction, returns a new instruction computing
+/// the same output more efficiently or null if the rule does not apply.
+struct PeepholeRule {
+  const char *name;
+  Instruction *(*rewrite)(const PeepholeContext &ctx, const Instruction &inst);
+};
+
+/// The rules applied by PeepholePass, in order. To add a new rule, just append
+/// it to this table.
+const PeepholeRule PEEPHOLE_RULES[] = {
+    {"constant-folding", &rewrite_constant_folding},
+    {"not-of-negatable", &rewrite_not_of_negatable},
+    {"same-operands", &rewrite_same_operands},
+    {"constant-operand", &rewrite_constant_operand},
+    {"mux", &rewrite_mux},
+    {"full-slice", &rewrite_full_slice},
+};
+
+/// Replaces operands defined by a `LOAD` instruction by the loaded register.
+/// Returns true if at least one operand was replaced.
+bool forward_loads(PeepholeContext &ctx, Instruction &inst) {
+  bool changed = false;
+  rewrite_instruction_inputs(inst, [&](reg_t &reg) {
+    // Loops are not possible in a valid program, but we are not sure the program is valid yet.
+    for (int depth = 0; depth < 64; ++depth) {
+      const auto *load = ctx.get_definition_as<LoadInstruction>(reg);
+      if (load == nullptr || load->input == reg || ctx.get_bus_size(load->input) != ctx.get_bus_size(reg))
+        return;
+
+      ctx.def_use.use_counts[reg.index]--;
+      ctx.def_use.use_counts[load->input.index]++;
+      reg = load->input;
+      changed = true;
+    }
+  });
+  return changed;
+}
+} // namespace
+
+// ========================================================
+// class PeepholePass
+// ========================================================
+
+bool PeepholePass::run(const std::shared_ptr<Program> &program) {
+  assert(program != nullptr);
+
+  auto def_use = DefUseInfo::build(*program);
+  PeepholeContext ctx = {*program, def_use};
+
+  bool modified = false;
+  bool changed;
+  do {
+    changed = false;
+    for (auto &instruction : program->instructions) {
+      changed |= forward_loads(ctx, *instruction);
+
+      // Applies the rules on the instruction until none match.
+      bool rewritten;
+      do {
+        rewritten = false;
+        for (const auto &rule : PEEPHOLE_RULES) {
+          auto *replacement = rule.rewrite(ctx, *instruction);
+          if (replacement == nullptr)
+            continue;
+
+          assert(replacement->output == instruction->output);
+          for (const auto input : get_instruction_inputs(*instruction))
+            def_use.use_counts[input.index]--;
+          for (const auto input : get_instruction_inputs(*replacement))
+            def_use.use_counts[input.index]++;
+          if (def_use.definitions[instruction->output.index] == instruction)
+            def_use.definitions[instruction->output.index] = replacement;
+
+          delete instruction;
+          instruction = replacement;
+          rewritten = true;
+          changed = true;
+          break;
+        }
+      } while (rewritten);
+    }
+
+    modified |= changed;
+  } while (changed);
+
+  modified |= erase_dead_instructions(*program);
+  return modified;
+}
@@ -0,0 +1,28 @@
+#ifndef NETLIST_SRC_PASSES_PEEPHOLE_HPP
+#define NETLIST_SRC_PASSES_PEEPHOLE_HPP
+
+#include "pass.hpp"
+
+// ========================================================
+// class PeepholePass
+// ========================================================
+
+/// \ingroup passes
+/// \brief A rule-driven algebraic simplifier.
+///
+/// Each instruction is matched against a table of rewriting rules (see
+/// peephole.cpp) such as `NOT (NOT x) -> x`, `XOR x x -> 0` or `MUX c a a -> a`.
+/// Instructions with only constant operands are folded. The rules are applied
+/// until a fixed point is reached.
+///
+/// Moreover, operands defined by a `LOAD` instruction are replaced by the loaded
+/// register (copy propagation) and the instructions whose result is no longer
+/// used are removed.
+class PeepholePass final : public Pass {
+public:
+  [[nodiscard]] std::string_view get_name() const override { return "peephole"; }
+
+  bool run(const std::shared_ptr<Program> &program) override;
+};
+
+#endif // NETLIST_SRC_PASSES_PEEPHOLE_HPP
@@ -0,0 +1,143 @@
+#include "register_allocation.hpp"
+
+#include <cassert>
+
+namespace {
+constexpr std::size_t NO_USE = SIZE_MAX;
+
+/// Marks the registers defined by the instructions of \a body (and of their own bodies).
+void pin_body(const std::vector<Instruction *> &body, std::vector<bool> &is_pinned) {
+  for (const auto *instruction : body) {
+    is_pinned[instruction->output.index] = true;
+    if (const auto *memo = dynamic_cast<const MemoInstruction *>(instruction)) {
+      pin_body(memo->body, is_pinned);
+    } else if (const auto *lazy_mux = dynamic_cast<const LazyMuxInstruction *>(instruction)) {
+      pin_body(lazy_mux->first_body, is_pinned);
+      pin_body(lazy_mux->second_body, is_pinned);
+    } else if (const auto *enabled_reg = dynamic_cast<const EnabledRegInstruction *>(instruction)) {
+      pin_body(enabled_reg->body, is_pinned);
+    }
+  }
+}
+} // namespace
+
+// ========================================================
+// class RegisterAllocationPass
+// ========================================================
+
+bool RegisterAllocationPass::run(const std::shared_ptr<Program> &program) {
+  assert(program != nullptr);
+
+  const auto register_count = program->registers.size();
+  const auto &instructions = program->instructions;
+
+  // The registers that keep their own storage, and the position of the last
+  // instruction reading the others.
+  std::vector<bool> is_pinned(register_count, false);
+  std::vector<std::uint_least32_t> definition_counts(register_count, 0);
+  std::vector<std::size_t> last_uses(register_count, NO_USE);
+  for (std::size_t i = 0; i < instructions.size(); ++i) {
+    const auto *instruction = instructions[i];
+    for (const auto input : get_instruction_inputs(*instruction)) {
+      // Read before being defined, so the value comes from the previous cycle.
+      if (definition_counts[input.index] == 0)
+        is_pinned[input.index] = true;
+      last_uses[input.index] = i;
+    }
+    ++definition_counts[instruction->output.index];
+
+    // The sequential elements and the memory ports keep their registers.
+    if (const auto *reg = dynamic_cast<const RegInstruction *>(instruction)) {
+      is_pinned[reg->input.index] = true;
+      is_pinned[reg->output.index] = true;
+    } else if (const auto *delay = dynamic_cast<const DelayInstruction *>(instruction)) {
+      is_pinned[delay->input.index] = true;
+      is_pinned[delay->output.index] = true;
+    } else if (const auto *rom = dynamic_cast<const RomInstruction *>(instruction)) {
+      is_pinned[rom->read_addr.index] = true;
+      is_pinned[rom->output.index] = true;
+    } else if (const auto *ram = dynamic_cast<const RamInstruction *>(instruction)) {
+      for (const auto port : {ram->read_addr, ram->write_enable, ram->write_addr, ram->write_data, ram->output})
+        is_pinned[port.index] = true;
+    } else if (const auto *memo = dynamic_cast<const MemoInstruction *>(instruction)) {
+      is_pinned[memo->output.index] = true;
+      pin_body(memo->body, is_pinned);
+    } else if (const auto *lazy_mux = dynamic_cast<const LazyMuxInstruction *>(instruction)) {
+      pin_body(lazy_mux->first_body, is_pinned);
+      pin_body(lazy_mux->second_body, is_pinned);
+    } else if (const auto *enabled_reg = dynamic_cast<const EnabledRegInstruction *>(instruction)) {
+      is_pinned[enabled_reg->enable.index] = true;
+      is_pinned[enabled_reg->input.index] = true;
+      is_pinned[enabled_reg->output.index] = true;
+      pin_body(enabled_reg->body, is_pinned);
+    }
+  }
+
+  for (reg_index_t i = 0; i < register_count; ++i) {
+    if ((program->registers.get_flags({i}) & (RIF_INPUT | RIF_OUTPUT)) || definition_counts[i] != 1)
+      is_pinned[i] = true;
+  }
+
+  // Linear scan over the instructions. The operands read for the last time
+  // are freed before allocating the output, as all instructions read their
+  // operands before writing their output.
+  std::vector<reg_t> allocated(register_count);
+  std::vector<std::vector<reg_t>> free_registers; // by bus size
+  const auto free_register = [&](reg_t reg) {
+    const auto bus_size = program->registers.get_bus_size(reg);
+    if (free_registers.size() <= bus_size)
+      free_registers.resize(bus_size + 1);
+    free_registers[bus_size].push_back(allocated[reg.index]);
+  };
+
+  bool changed = false;
+  for (std::size_t i = 0; i < instructions.size(); ++i) {
+    const auto *instruction = instructions[i];
+    for (const auto input : get_instruction_inputs(*instruction)) {
+      if (!is_pinned[input.index] && last_uses[input.index] == i) {
+        free_register(input);
+        last_uses[input.index] = NO_USE; // read twice by this instruction
+      }
+    }
+
+    const auto output = instruction->output;
+    if (is_pinned[output.index])
+      continue;
+
+    const auto bus_size = program->registers.get_bus_size(output);
+    if (bus_size < free_registers.size() && !free_registers[bus_size].empty()) {
+      allocated[output.index] = free_registers[bus_size].back();
+      free_registers[bus_size].pop_back();
+      changed = true;
+    } else {
+      allocated[output.index] = output;
+    }
+
+    // The value is never read, its register is free again.
+    if (last_uses[output.index] == NO_USE)
+      free_register(output);
+  }
+
+  if (!changed)
+    return false;
+
+  // The allocated registers are numbered without gaps, in their previous
+  // order. The registers sharing another one lose their name.
+  std::vector<reg_t> new_names(register_count);
+  reg_index_t next_index = 0;
+  for (reg_index_t i = 0; i < register_count; ++i) {
+    if (is_pinned[i] || allocated[i] == reg_t{i})
+      new_names[i] = reg_t{next_index++};
+  }
+  for (reg_index_t i = 0; i < register_count; ++i) {
+    if (is_pinned[i] || allocated[i] == reg_t{i})
+      continue;
+
+    new_names[i] = new_names[allocated[i].index];
+    program->registers.set_name({i}, {});
+    program->registers.set_name(allocated[i], {});
+  }
+
+  rename_registers(*program, new_names);
+  return true;
+}
@@ -0,0 +1,39 @@
+#ifndef NETLIST_SRC_PASSES_REGISTER_ALLOCATION_HPP
+#define NETLIST_SRC_PASSES_REGISTER_ALLOCATION_HPP
+
+#include "pass.hpp"
+
+// ========================================================
+// class RegisterAllocationPass
+// ========================================================
+
+/// \ingroup passes
+/// \brief Lets the temporaries whose values are never needed at the same time
+/// share the same register.
+///
+/// Most registers only hold a value between the instruction defining it and
+/// its last use in the same cycle. The live range of each such register is
+/// computed over the scheduled instructions and a linear scan gives it a
+/// register freed by a previous temporary of the same bus size (the last freed
+/// one, which is the most likely to still be in the cache). The simulator
+/// then only stores as many values as the widest set of values live at once,
+/// plus the registers below.
+///
+/// The inputs, the outputs, the operands and outputs of the sequential
+/// instructions (`REG`, `DELAY` and `REGEN`, whose values cross cycles) and of
+/// the memory ports (`ROM` and `RAM`), the outputs of `MEMO` (its cache is
+/// attached to the register) and the registers defined in bodies or not
+/// exactly once keep their own register. The merged registers lose their
+/// name.
+///
+/// Like RegisterRenumberingPass, this pass depends on the final order of the
+/// instructions. Moreover, the registers are not defined once anymore and the
+/// program cannot be scheduled again, so it must be the last pass.
+class RegisterAllocationPass final : public Pass {
+public:
+  [[nodiscard]] std::string_view get_name() const override { return "register-allocation"; }
+
+  bool run(const std::shared_ptr<Program> &program) override;
+};
+
+#endif // NETLIST_SRC_PASSES_REGISTER_ALLOCATION_HPP
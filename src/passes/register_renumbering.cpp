@@ -0,0 +1,81 @@
+#include "register_renumbering.hpp"
+
+#include <cassert>
+
+namespace {
+class RegisterNumbering {
+public:
+  explicit RegisterNumbering(const Program &program) : m_new_names(program.registers.size()) {}
+
+  /// Gives the next number to \a reg if it does not have one yet.
+  void add(reg_t reg) {
+    if (m_new_names[reg.index] == reg_t{})
+      m_new_names[reg.index] = reg_t{m_next_index++};
+  }
+
+  /// Numbers the registers of \a instruction in evaluation order.
+  void add_instruction(const Instruction *instruction) {
+    for (const auto input : get_instruction_inputs(*instruction))
+      add(input);
+
+    if (const auto *memo = dynamic_cast<const MemoInstruction *>(instruction)) {
+      add_body(memo->body);
+    } else if (const auto *lazy_mux = dynamic_cast<const LazyMuxInstruction *>(instruction)) {
+      add_body(lazy_mux->first_body);
+      add_body(lazy_mux->second_body);
+    } else if (const auto *enabled_reg = dynamic_cast<const EnabledRegInstruction *>(instruction)) {
+      add_body(enabled_reg->body);
+    }
+
+    add(instruction->output);
+  }
+
+  void add_body(const std::vector<Instruction *> &body) {
+    for (const auto *instruction : body)
+      add_instruction(instruction);
+  }
+
+  [[nodiscard]] const std::vector<reg_t> &get_new_names() const { return m_new_names; }
+
+private:
+  std::vector<reg_t> m_new_names;
+  reg_index_t m_next_index = 0;
+};
+} // namespace
+
+// ========================================================
+// class RegisterRenumberingPass
+// ========================================================
+
+bool RegisterRenumberingPass::run(const std::shared_ptr<Program> &program) {
+  assert(program != nullptr);
+
+  RegisterNumbering numbering(*program);
+  for (const auto input : program->get_inputs())
+    numbering.add(input);
+  for (const auto output : program->get_outputs())
+    numbering.add(output);
+  for (const auto *instruction : program->instructions) {
+    if (const auto *reg = dynamic_cast<const RegInstruction *>(instruction))
+      numbering.add(reg->input);
+    else if (const auto *delay = dynamic_cast<const DelayInstruction *>(instruction))
+      numbering.add(delay->input);
+  }
+
+  for (const auto *instruction : program->instructions)
+    numbering.add_instruction(instruction);
+
+  // The registers that are never used keep their relative order at the end.
+  for (reg_index_t i = 0; i < program->registers.size(); ++i)
+    numbering.add(reg_t{i});
+
+  const auto &new_names = numbering.get_new_names();
+  bool is_identity = true;
+  for (reg_index_t i = 0; i < new_names.size() && is_identity; ++i)
+    is_identity = new_names[i].index == i;
+  if (is_identity)
+    return false;
+
+  rename_registers(*program, new_names);
+  return true;
+}
@@ -0,0 +1,35 @@
+#ifndef NETLIST_SRC_PASSES_REGISTER_RENUMBERING_HPP
+#define NETLIST_SRC_PASSES_REGISTER_RENUMBERING_HPP
+
+#include "pass.hpp"
+
+// ========================================================
+// class RegisterRenumberingPass
+// ========================================================
+
+/// \ingroup passes
+/// \brief Renumbers the registers so that the instructions executed one after
+/// the other access neighboring registers.
+///
+/// Registers are numbered in declaration order by the parser and the passes,
+/// while the simulator stores the value of the register `i` at index `i` of
+/// an array. On large programs, consecutive instructions then read values far
+/// apart in memory and most accesses miss the caches.
+///
+/// The new numbering puts first the inputs, then the outputs and then the
+/// registers read by `REG` and `DELAY` (which are all accessed together at
+/// each cycle), each group in its previous relative order so the inputs and
+/// outputs are still queried and printed in the same order. The other
+/// registers follow in order of first use by the instructions. Names and flags
+/// move with their register (see rename_registers()).
+///
+/// Unlike the other passes, this one depends on the final order of the
+/// instructions and must therefore run after the scheduling.
+class RegisterRenumberingPass final : public Pass {
+public:
+  [[nodiscard]] std::string_view get_name() const override { return "register-renumbering"; }
+
+  bool run(const std::shared_ptr<Program> &program) override;
+};
+
+#endif // NETLIST_SRC_PASSES_REGISTER_RENUMBERING_HPP
@@ -0,0 +1,525 @@
+#include "sequential_redundancy.hpp"
+#include "bit_algebra.hpp"
+#include "cone.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <functional>
+#include <limits>
+#include <map>
+#include <optional>
+#include <random>
+#include <unordered_map>
+
+namespace {
+/// The count of simulated cycles (each one on 64 random patterns).
+constexpr std::size_t SIMULATION_CYCLES = 64;
+/// The node limit of the BDD used to prove each candidate class.
+constexpr std::size_t MAX_BDD_NODES = 1 << 16;
+
+/// Evaluates instructions bit by bit with an algebra (see WordAlgebra and BddAlgebra).
+///
+/// The value of each register is a vector of algebra values, one per bit of
+/// its bus (from the least significant bit). The instructions that are not
+/// supported give fresh values created by a callback (random words or new BDD
+/// variables), as if they were inputs.
+template <class Algebra> struct BitEvaluator final : ConstInstructionVisitor {
+  using value_type = typename Algebra::value_type;
+  using bits_type = std::vector<value_type>;
+
+  const Program &program;
+  const Algebra &algebra;
+  std::function<value_type()> make_fresh;
+  std::vector<bits_type> values;
+  bits_type result;
+
+  BitEvaluator(const Program &p, const Algebra &a, std::function<value_type()> fresh)
+      : program(p), algebra(a), make_fresh(std::move(fresh)), values(p.registers.size()) {}
+
+  [[nodiscard]] bus_size_t get_bus_size(reg_t reg) const { return program.registers.get_bus_size(reg); }
+  [[nodiscard]] const bits_type &get(reg_t reg) const { return values[reg.index]; }
+
+  [[nodiscard]] bits_type make_fresh_bits(bus_size_t bus_size) const {
+    bits_type bits(bus_size);
+    for (auto &bit : bits)
+      bit = make_fresh();
+    return bits;
+  }
+
+  void evaluate(const Instruction &instruction) {
+    result.clear();
+    instruction.visit(*this);
+    values[instruction.output.index] = std::move(result);
+  }
+
+  void visit_const(const ConstInstruction &inst) override {
+    for (bus_size_t i = 0; i < get_bus_size(inst.output); ++i)
+      result.push_back(algebra.make_constant((inst.value >> i) & 1));
+  }
+
+  void visit_load(const LoadInstruction &inst) override { result = get(inst.input); }
+
+  void visit_not(const NotInstruction &inst) override {
+    for (const auto bit : get(inst.input))
+      result.push_back(algebra.make_not(bit));
+  }
+
+  template <class F> void visit_bitwise(const BinaryInstruction &inst, F f) {
+    const auto &lhs = get(inst.lhs);
+    const auto &rhs = get(inst.rhs);
+    for (std::size_t i = 0; i < lhs.size(); ++i)
+      result.push_back(f(lhs[i], rhs[i]));
+  }
+
+  void visit_and(const AndInstruction &inst) override {
+    visit_bitwise(inst, [this](value_type a, value_type b) { return algebra.make_and(a, b); });
+  }
+  void visit_nand(const NandInstruction &inst) override {
+    visit_bitwise(inst, [this](value_type a, value_type b) { return algebra.make_not(algebra.make_and(a, b)); });
+  }
+  void visit_or(const OrInstruction &inst) override {
+    visit_bitwise(inst, [this](value_type a, value_type b) { return algebra.make_or(a, b); });
+  }
+  void visit_nor(const NorInstruction &inst) override {
+    visit_bitwise(inst, [this](value_type a, value_type b) { return algebra.make_not(algebra.make_or(a, b)); });
+  }
+  void visit_xor(const XorInstruction &inst) override {
+    visit_bitwise(inst, [this](value_type a, value_type b) { return algebra.make_xor(a, b); });
+  }
+  void visit_xnor(const XnorInstruction &inst) override {
+    visit_bitwise(inst, [this](value_type a, value_type b) { return algebra.make_not(algebra.make_xor(a, b)); });
+  }
+
+  void visit_mux(const MuxInstruction &inst) override {
+    const auto choice = get(inst.choice).front();
+    const auto &first = get(inst.first);
+    const auto &second = get(inst.second);
+    for (std::size_t i = 0; i < first.size(); ++i)
+      result.push_back(algebra.make_mux(choice, first[i], second[i]));
+  }
+
+  void visit_concat(const ConcatInstruction &inst) override {
+    result = get(inst.lhs);
+    const auto &rhs = get(inst.rhs);
+    result.insert(result.end(), rhs.begin(), rhs.end());
+  }
+
+  void visit_select(const SelectInstruction &inst) override { result.push_back(get(inst.input)[inst.i]); }
+
+  void visit_slice(const SliceInstruction &inst) override {
+    const auto &input = get(inst.input);
+    result.assign(input.begin() + inst.start, input.begin() + inst.end + 1);
+  }
+
+  void visit_gather(const GatherInstruction &inst) override {
+    for (bus_size_t i = 0; i < get_bus_size(inst.output); ++i)
+      result.push_back(algebra.make_constant((inst.constant >> i) & 1));
+
+    for (const auto &part : inst.parts) {
+      const auto &input = get(part.input);
+      auto extract_mask = part.extract_mask;
+      auto deposit_mask = part.deposit_mask;
+      while (extract_mask != 0) {
+        result[std::countr_zero(deposit_mask)] = input[std::countr_zero(extract_mask)];
+        extract_mask &= extract_mask - 1;
+        deposit_mask &= deposit_mask - 1;
+      }
+    }
+  }
+
+  /// Returns the bits of `lhs + rhs + carry` (and the carry out in \a carry).
+  [[nodiscard]] bits_type add(const bits_type &lhs, const bits_type &rhs, value_type &carry) const {
+    bits_type sum;
+    for (std::size_t i = 0; i < lhs.size(); ++i) {
+      const auto propagate = algebra.make_xor(lhs[i], rhs[i]);
+      sum.push_back(algebra.make_xor(propagate, carry));
+      carry = algebra.make_or(algebra.make_and(lhs[i], rhs[i]), algebra.make_and(propagate, carry));
+    }
+    return sum;
+  }
+
+  [[nodiscard]] bits_type invert(const bits_type &bits) const {
+    bits_type inverted;
+    for (const auto bit : bits)
+      inverted.push_back(algebra.make_not(bit));
+    return inverted;
+  }
+
+  void visit_add(const AddInstruction &inst) override {
+    auto carry = algebra.make_constant(false);
+    result = add(get(inst.lhs), get(inst.rhs), carry);
+  }
+
+  void visit_sub(const SubInstruction &inst) override {
+    // lhs - rhs = lhs + ~rhs + 1
+    auto carry = algebra.make_constant(true);
+    result = add(get(inst.lhs), invert(get(inst.rhs)), carry);
+  }
+
+  void visit_eq(const EqInstruction &inst) override {
+    const auto &lhs = get(inst.lhs);
+    const auto &rhs = get(inst.rhs);
+    auto equal = algebra.make_constant(true);
+    for (std::size_t i = 0; i < lhs.size(); ++i)
+      equal = algebra.make_and(equal, algebra.make_not(algebra.make_xor(lhs[i], rhs[i])));
+    result.push_back(equal);
+  }
+
+  void visit_lt(const LtInstruction &inst) override {
+    // lhs < rhs if and only if lhs - rhs borrows, that is lhs + ~rhs + 1 does not carry out.
+    auto carry = algebra.make_constant(true);
+    (void)add(get(inst.lhs), invert(get(inst.rhs)), carry);
+    result.push_back(algebra.make_not(carry));
+  }
+
+  void visit_reduce_or(const ReduceOrInstruction &inst) override {
+    auto any = algebra.make_constant(false);
+    for (const auto bit : get(inst.input))
+      any = algebra.make_or(any, bit);
+    result.push_back(any);
+  }
+
+  void visit_reduce_and(const ReduceAndInstruction &inst) override {
+    auto all = algebra.make_constant(true);
+    for (const auto bit : get(inst.input))
+      all = algebra.make_and(all, bit);
+    result.push_back(all);
+  }
+
+  // Not supported, the results are arbitrary.
+  void visit_unsupported(const Instruction &inst) { result = make_fresh_bits(get_bus_size(inst.output)); }
+
+  void visit_mul(const MulInstruction &inst) override { visit_unsupported(inst); }
+  void visit_shl(const ShlInstruction &inst) override { visit_unsupported(inst); }
+  void visit_shr(const ShrInstruction &inst) override { visit_unsupported(inst); }
+  void visit_asr(const AsrInstruction &inst) override { visit_unsupported(inst); }
+  void visit_lut(const LutInstruction &inst) override { visit_unsupported(inst); }
+  // Not combinational, the results are leaves set by the caller.
+  void visit_reg(const RegInstruction &inst) override { visit_unsupported(inst); }
+  void visit_delay(const DelayInstruction &inst) override { visit_unsupported(inst); }
+  void visit_rom(const RomInstruction &inst) override { visit_unsupported(inst); }
+  void visit_ram(const RamInstruction &inst) override { visit_unsupported(inst); }
+  void visit_memo(const MemoInstruction &inst) override { visit_unsupported(inst); }
+  void visit_lazy_mux(const LazyMuxInstruction &inst) override { visit_unsupported(inst); }
+  void visit_enabled_reg(const EnabledRegInstruction &inst) override { visit_unsupported(inst); }
+};
+
+class RegisterCorrespondence {
+public:
+  explicit RegisterCorrespondence(Program &program) : m_program(program), m_def_use(DefUseInfo::build(program)) {}
+
+  bool run() {
+    auto order = sort_combinational(m_program, m_def_use);
+    if (!order.has_value())
+      return false; // combinational loop, reported later by the scheduler
+
+    // Registers written by the user are not only defined by their instruction.
+    m_is_computed.assign(m_program.registers.size(), false);
+    for (auto *instruction : *order) {
+      if ((m_program.registers.get_flags(instruction->output) & RIF_INPUT) == 0) {
+        m_order.push_back(instruction);
+        m_is_computed[instruction->output.index] = true;
+      }
+    }
+    for (const auto *instruction : m_program.instructions) {
+      const auto *reg = dynamic_cast<const RegInstruction *>(instruction);
+      if (reg != nullptr && m_def_use.definitions[reg->output.index] == reg &&
+          (m_program.registers.get_flags(reg->output) & RIF_INPUT) == 0)
+        m_registers.push_back(reg);
+    }
+
+    if (m_registers.empty())
+      return false;
+
+    find_candidates();
+    if (m_classes.empty() && m_zero_registers.empty())
+      return false;
+
+    prove();
+    return apply();
+  }
+
+private:
+  /// Indices in m_registers.
+  using Class = std::vector<std::size_t>;
+
+  /// Simulates the program on random inputs and groups the registers with the same trace.
+  void find_candidates() {
+    std::mt19937_64 random(0x5EED);
+    const WordAlgebra algebra;
+    BitEvaluator<WordAlgebra> evaluator(m_program, algebra, [&random] { return random(); });
+
+    std::vector<std::vector<WordAlgebra::value_type>> states;
+    for (const auto *reg : m_registers)
+      states.emplace_back(m_program.registers.get_bus_size(reg->output), 0);
+
+    std::vector<std::uint_least64_t> signatures(m_registers.size(), 0);
+    std::vector<bool> is_zero(m_registers.size(), true);
+    for (std::size_t cycle = 0; cycle < SIMULATION_CYCLES; ++cycle) {
+      // The inputs and the other sequential instructions are random.
+      for (reg_index_t i = 0; i < m_program.registers.size(); ++i) {
+        if (!m_is_computed[i])
+          evaluator.values[i] = evaluator.make_fresh_bits(m_program.registers.get_bus_size({i}));
+      }
+      for (std::size_t i = 0; i < m_registers.size(); ++i)
+        evaluator.values[m_registers[i]->output.index] = states[i];
+      for (const auto *instruction : m_order)
+        evaluator.evaluate(*instruction);
+
+      for (std::size_t i = 0; i < m_registers.size(); ++i) {
+        for (const auto word : states[i]) {
+          signatures[i] = (std::rotl(signatures[i], 5) ^ word) * 0x9E3779B97F4A7C15;
+          is_zero[i] = is_zero[i] && word == 0;
+        }
+      }
+
+      for (std::size_t i = 0; i < m_registers.size(); ++i)
+        states[i] = evaluator.values[m_registers[i]->input.index];
+    }
+
+    std::map<std::pair<bus_size_t, std::uint_least64_t>, Class> groups;
+    for (std::size_t i = 0; i < m_registers.size(); ++i) {
+      if (is_zero[i]) {
+        m_zero_registers.push_back(i);
+      } else {
+        const auto bus_size = m_program.registers.get_bus_size(m_registers[i]->output);
+        groups[{bus_size, signatures[i]}].push_back(i);
+      }
+    }
+
+    for (auto &[key, members] : groups) {
+      if (members.size() >= 2)
+        m_classes.push_back(std::move(members));
+    }
+  }
+
+  /// Returns the instructions of m_order needed to compute \a roots (in
+  /// evaluation order) and appends the leaves of that logic to \a leaves.
+  [[nodiscard]] std::vector<const Instruction *> collect_cone(const std::vector<reg_t> &roots,
+                                                              std::vector<reg_t> &leaves) {
+    std::vector<const Instruction *> cone;
+    std::vector<reg_t> stack = roots;
+    while (!stack.empty()) {
+      const auto reg = stack.back();
+      stack.pop_back();
+      if (m_is_visited[reg.index])
+        continue;
+
+      m_is_visited[reg.index] = true;
+      m_visited.push_back(reg);
+      if (!m_is_computed[reg.index]) {
+        leaves.push_back(reg);
+        continue;
+      }
+
+      const auto *definition = m_def_use.definitions[reg.index];
+      cone.push_back(definition);
+      for (const auto input : get_instruction_inputs(*definition))
+        stack.push_back(input);
+    }
+
+    for (const auto reg : m_visited)
+      m_is_visited[reg.index] = false;
+    m_visited.clear();
+
+    std::ranges::sort(cone, {}, [this](const Instruction *instruction) {
+      return m_positions[instruction->output.index];
+    });
+    return cone;
+  }
+
+  /// Computes the next state of the \a registers (indices in m_registers) assuming
+  /// the candidate relations hold in the current state, all with the same BDD
+  /// manager. Returns nothing if the BDDs are too large.
+  [[nodiscard]] std::optional<std::vector<std::vector<BddManager::node_t>>>
+  compute_next_states(const Class &registers) {
+    BddManager manager(MAX_BDD_NODES);
+    const BddAlgebra algebra{manager};
+    BddManager::var_t next_var = 0;
+    BitEvaluator<BddAlgebra> evaluator(m_program, algebra, [&manager, &next_var] {
+      return manager.get_variable(next_var++);
+    });
+    evaluator.values = std::move(m_bdd_values);
+
+    std::vector<reg_t> roots;
+    for (const auto i : registers)
+      roots.push_back(m_registers[i]->input);
+    std::vector<reg_t> leaves;
+    const auto cone = collect_cone(roots, leaves);
+
+    // The induction hypothesis: the members of a class share the same
+    // variables and the zero registers are zero.
+    std::unordered_map<std::size_t, std::vector<BddManager::node_t>> class_bits;
+    for (const auto leaf : leaves) {
+      const auto bus_size = m_program.registers.get_bus_size(leaf);
+      const auto hypothesis = m_hypotheses[leaf.index];
+      if (hypothesis == ZERO_HYPOTHESIS) {
+        evaluator.values[leaf.index].assign(bus_size, BddManager::ZERO);
+      } else if (hypothesis != NO_HYPOTHESIS) {
+        auto [it, inserted] = class_bits.try_emplace(hypothesis);
+        if (inserted)
+          it->second = evaluator.make_fresh_bits(bus_size);
+        evaluator.values[leaf.index] = it->second;
+      } else {
+        evaluator.values[leaf.index] = evaluator.make_fresh_bits(bus_size);
+      }
+    }
+
+    for (const auto *instruction : cone)
+      evaluator.evaluate(*instruction);
+
+    std::vector<std::vector<BddManager::node_t>> next_states;
+    for (const auto root : roots)
+      next_states.push_back(evaluator.values[root.index]);
+    m_bdd_values = std::move(evaluator.values);
+    if (manager.has_overflowed())
+      return std::nullopt;
+    return next_states;
+  }
+
+  /// Refines the candidates until they are inductive.
+  void prove() {
+    m_positions.assign(m_program.registers.size(), 0);
+    for (std::size_t i = 0; i < m_order.size(); ++i)
+      m_positions[m_order[i]->output.index] = i;
+    m_is_visited.assign(m_program.registers.size(), false);
+    m_bdd_values.resize(m_program.registers.size());
+
+    bool changed = true;
+    while (changed) {
+      m_hypotheses.assign(m_program.registers.size(), NO_HYPOTHESIS);
+      for (std::size_t k = 0; k < m_classes.size(); ++k) {
+        for (const auto i : m_classes[k])
+          m_hypotheses[m_registers[i]->output.index] = k;
+      }
+      for (const auto i : m_zero_registers)
+        m_hypotheses[m_registers[i]->output.index] = ZERO_HYPOTHESIS;
+
+      // Each class is checked separately so that a large cone only fails its
+      // own class. The classes are split by next state.
+      changed = false;
+      Class new_zero_registers;
+      for (const auto i : m_zero_registers) {
+        const auto next_states = compute_next_states({i});
+        if (next_states.has_value() && std::ranges::all_of(next_states->front(), [](BddManager::node_t bit) {
+              return bit == BddManager::ZERO;
+            })) {
+          new_zero_registers.push_back(i);
+        } else {
+          changed = true;
+        }
+      }
+
+      std::vector<Class> new_classes;
+      for (const auto &members : m_classes) {
+        const auto next_states = compute_next_states(members);
+        if (!next_states.has_value()) {
+          changed = true;
+          continue;
+        }
+
+        std::map<std::vector<BddManager::node_t>, Class> groups;
+        for (std::size_t j = 0; j < members.size(); ++j)
+          groups[(*next_states)[j]].push_back(members[j]);
+        changed |= groups.size() != 1;
+        for (auto &[next_state, group] : groups) {
+          if (group.size() >= 2)
+            new_classes.push_back(std::move(group));
+        }
+      }
+
+      m_classes = std::move(new_classes);
+      m_zero_registers = std::move(new_zero_registers);
+    }
+  }
+
+  /// Replaces the proven registers, returns true if the program was modified.
+  bool apply() {
+    if (m_classes.empty() && m_zero_registers.empty())
+      return false;
+
+    // The representative of each class is its first register in program order.
+    std::unordered_map<const Instruction *, reg_t> replacements;
+    std::unordered_map<reg_index_t, reg_t> renames;
+    for (auto &members : m_classes) {
+      std::ranges::sort(members);
+      const auto representative = m_registers[members.front()]->output;
+      for (std::size_t j = 1; j < members.size(); ++j) {
+        const auto *reg = m_registers[members[j]];
+        replacements.emplace(reg, representative);
+        if ((m_program.registers.get_flags(reg->output) & RIF_OUTPUT) == 0)
+          renames.emplace(reg->output.index, representative);
+      }
+    }
+
+    std::vector<bool> is_zero(m_program.registers.size(), false);
+    for (const auto i : m_zero_registers)
+      is_zero[m_registers[i]->output.index] = true;
+
+    for (auto *&instruction : m_program.instructions) {
+      rewrite_instruction_inputs(*instruction, [&renames](reg_t &reg) {
+        if (const auto it = renames.find(reg.index); it != renames.end())
+          reg = it->second;
+      });
+
+      Instruction *replacement = nullptr;
+      if (const auto it = replacements.find(instruction); it != replacements.end()) {
+        // Outputs must still be defined, the others are now dead.
+        auto *load = new LoadInstruction();
+        load->input = it->second;
+        replacement = load;
+      } else if (dynamic_cast<const RegInstruction *>(instruction) != nullptr && is_zero[instruction->output.index]) {
+        auto *constant = new ConstInstruction();
+        constant->value = 0;
+        replacement = constant;
+      }
+
+      if (replacement != nullptr) {
+        replacement->output = instruction->output;
+        delete instruction;
+        instruction = replacement;
+      }
+    }
+
+    erase_dead_instructions(m_program);
+    return true;
+  }
+
+  Program &m_program;
+  DefUseInfo m_def_use;
+  /// The combinational instructions in evaluation order.
+  std::vector<Instruction *> m_order;
+  /// True for the registers computed by m_order, the others are leaves.
+  std::vector<bool> m_is_computed;
+  /// The `REG` instructions that may be merged.
+  std::vector<const RegInstruction *> m_registers;
+  /// The candidate classes of equal registers (indices in m_registers).
+  std::vector<Class> m_classes;
+  /// The candidate registers that are always zero (indices in m_registers).
+  Class m_zero_registers;
+
+  // The state of the induction, indexed by register.
+  static constexpr std::size_t NO_HYPOTHESIS = std::numeric_limits<std::size_t>::max();
+  static constexpr std::size_t ZERO_HYPOTHESIS = NO_HYPOTHESIS - 1;
+  /// The candidate class of each register, or one of the above values.
+  std::vector<std::size_t> m_hypotheses;
+  /// The index in m_order of the definition of each computed register.
+  std::vector<std::size_t> m_positions;
+  std::vector<bool> m_is_visited;
+  std::vector<reg_t> m_visited;
+  /// The storage of the BDD evaluator, kept between the proofs.
+  std::vector<std::vector<BddManager::node_t>> m_bdd_values;
+};
+} // namespace
+
+// ========================================================
+// class SequentialRedundancyPass
+// ========================================================
+
+bool SequentialRedundancyPass::run(const std::shared_ptr<Program> &program) {
+  assert(program != nullptr);
+
+  RegisterCorrespondence correspondence(*program);
+  return correspondence.run();
+}
@@ -0,0 +1,42 @@
+#ifndef NETLIST_SRC_PASSES_SEQUENTIAL_REDUNDANCY_HPP
+#define NETLIST_SRC_PASSES_SEQUENTIAL_REDUNDANCY_HPP
+
+#include "pass.hpp"
+
+// ========================================================
+// class SequentialRedundancyPass
+// ========================================================
+
+/// \ingroup passes
+/// \brief Merges the `REG` instructions that always hold the same value and
+/// removes the ones that are always zero.
+///
+/// Flattened designs often carry duplicated pipeline registers or state bits
+/// that never change. This pass looks for such registers in all the reachable
+/// states (this is known as register correspondence):
+/// 1. the program is simulated from the initial state on 64 random input
+///    sequences at once, and the registers with the same trace are candidates
+///    to be equal (or to be zero if their trace is always zero);
+/// 2. the candidates are proven by induction with binary decision diagrams
+///    (see BddManager): all registers are zero in the initial state and, if
+///    all candidate relations hold in a state, the pass checks that they hold
+///    in the next state. The candidates that fail are split and the induction
+///    is repeated until a fixed point is reached.
+///
+/// The registers equal to another one are then replaced by it and the zero
+/// registers by a constant. Since all registers start at zero, a register can
+/// never be the complement of another one.
+///
+/// Instructions that are not supported by the symbolic evaluation (memories,
+/// multiplications, variable shifts, etc.) are seen as producing arbitrary
+/// values, which only makes the proofs more conservative. Each candidate
+/// class is proven with its own BDDs, and the classes whose BDDs grow too
+/// large are dropped.
+class SequentialRedundancyPass final : public Pass {
+public:
+  [[nodiscard]] std::string_view get_name() const override { return "sequential-redundancy"; }
+
+  bool run(const std::shared_ptr<Program> &program) override;
+};
+
+#endif // NETLIST_SRC_PASSES_SEQUENTIAL_REDUNDANCY_HPP
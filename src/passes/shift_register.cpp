@@ -0,0 +1,103 @@
+#include "shift_register.hpp"
+
+#include <cassert>
+
+namespace {
+/// The position of a register in a chain of `REG` instructions.
+struct ChainLink {
+  /// The register read by the first `REG` of the chain.
+  reg_t root = {};
+  /// The count of `REG` instructions between the root and the register (zero if not computed yet).
+  std::uint_least32_t depth = 0;
+};
+
+struct ChainAnalysis {
+  const Program &program;
+  const DefUseInfo &def_use;
+  std::vector<ChainLink> links;
+
+  ChainAnalysis(const Program &p, const DefUseInfo &info)
+      : program(p), def_use(info), links(p.registers.size()) {}
+
+  /// Returns the `REG` instruction defining \a reg or null.
+  [[nodiscard]] const RegInstruction *get_reg_definition(reg_t reg) const {
+    // Registers written by the user are not only defined by their instruction.
+    if (program.registers.get_flags(reg) & RIF_INPUT)
+      return nullptr;
+    return dynamic_cast<const RegInstruction *>(def_use.definitions[reg.index]);
+  }
+
+  /// Computes the link of \a reg which must be defined by a `REG` instruction.
+  const ChainLink &compute(reg_t reg) {
+    constexpr auto in_progress = UINT_LEAST32_MAX;
+
+    // Walks up the chain until the root or an already computed link is found.
+    std::vector<reg_t> path;
+    auto current = reg;
+    ChainLink base;
+    while (links[current.index].depth == 0) {
+      path.push_back(current);
+      links[current.index].depth = in_progress;
+
+      const auto input = get_reg_definition(current)->input;
+      // Chains looping on themselves (e.g. `a = REG b` and `b = REG a`) are
+      // cut at an arbitrary position, the links are still correct.
+      if (get_reg_definition(input) == nullptr || links[input.index].depth == in_progress) {
+        base = {input, 0};
+        break;
+      }
+
+      current = input;
+    }
+
+    if (links[current.index].depth != in_progress)
+      base = links[current.index];
+
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+      base.depth++;
+      links[it->index] = base;
+    }
+
+    return links[reg.index];
+  }
+};
+} // namespace
+
+// ========================================================
+// class ShiftRegisterPass
+// ========================================================
+
+bool ShiftRegisterPass::run(const std::shared_ptr<Program> &program) {
+  assert(program != nullptr);
+
+  const auto def_use = DefUseInfo::build(*program);
+  ChainAnalysis analysis(*program, def_use);
+
+  // All links are computed before modifying the program as the def-use
+  // information refers to the `REG` instructions.
+  std::vector<std::uint_least32_t> depths(program->instructions.size());
+  for (std::size_t i = 0; i < program->instructions.size(); ++i) {
+    const auto *reg = dynamic_cast<const RegInstruction *>(program->instructions[i]);
+    if (reg != nullptr && analysis.get_reg_definition(reg->output) == reg)
+      depths[i] = analysis.compute(reg->output).depth;
+  }
+
+  bool modified = false;
+  for (std::size_t i = 0; i < program->instructions.size(); ++i) {
+    if (depths[i] < 2)
+      continue;
+
+    auto &instruction = program->instructions[i];
+    auto *delay = new DelayInstruction();
+    delay->output = instruction->output;
+    delay->input = analysis.links[delay->output.index].root;
+    delay->depth = depths[i];
+    delete instruction;
+    instruction = delay;
+    modified = true;
+  }
+
+  if (modified)
+    erase_dead_instructions(*program);
+  return modified;
+}
@@ -0,0 +1,35 @@
+#ifndef NETLIST_SRC_PASSES_SHIFT_REGISTER_HPP
+#define NETLIST_SRC_PASSES_SHIFT_REGISTER_HPP
+
+#include "pass.hpp"
+
+// ========================================================
+// class ShiftRegisterPass
+// ========================================================
+
+/// \ingroup passes
+/// \brief Replaces chains of `REG` instructions by `DELAY` instructions.
+///
+/// Delay lines and pipelines appear in netlists as long chains of registers:
+/// ```
+/// r1 = REG r0
+/// r2 = REG r1
+/// r3 = REG r2
+/// ```
+/// Each `REG` costs a copy per cycle. This pass computes, for each register
+/// defined by `REG`, the start of its chain and its depth in the chain, then
+/// replaces the `REG` instructions of depth two or more by a DelayInstruction
+/// reading the start of the chain (here `r3 = DELAY 3 r0`). The intermediate
+/// registers that are not used anymore are then removed.
+///
+/// Simulators implement the delays of a register with a ring buffer, so a
+/// delay line of N stages costs O(1) per cycle instead of O(N). Banks of
+/// parallel 1-bit shift registers are handled once merged by the WordLevelPass.
+class ShiftRegisterPass final : public Pass {
+public:
+  [[nodiscard]] std::string_view get_name() const override { return "shift-register"; }
+
+  bool run(const std::shared_ptr<Program> &program) override;
+};
+
+#endif // NETLIST_SRC_PASSES_SHIFT_REGISTER_HPP
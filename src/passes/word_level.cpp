@@ -0,0 +1,147 @@
+#include "word_level.hpp"
+#include "bit_gather.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <typeinfo>
+
+namespace {
+/// Returns true if \a instruction can be merged with other instructions of the same kind.
+[[nodiscard]] bool is_mergeable(const Instruction *instruction) {
+  return dynamic_cast<const NotInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const AndInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const NandInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const OrInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const NorInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const XorInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const XnorInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const MuxInstruction *>(instruction) != nullptr ||
+         dynamic_cast<const RegInstruction *>(instruction) != nullptr;
+}
+
+struct WordLevelRewriter {
+  Program &program;
+  DefUseInfo def_use;
+  ProgramBuilder builder;
+  /// The previous definitions of the rewritten registers.
+  std::vector<const Instruction *> to_delete;
+
+  explicit WordLevelRewriter(const std::shared_ptr<Program> &p)
+      : program(*p), def_use(DefUseInfo::build(*p)), builder(p) {}
+
+  [[nodiscard]] bus_size_t get_bus_size(reg_t reg) const { return program.registers.get_bus_size(reg); }
+
+  [[nodiscard]] BitSource trace_bit(reg_t reg, bus_size_t bit) const {
+    return ::trace_bit(program, def_use, reg, bit);
+  }
+
+  /// Returns a register whose bits are the given ones, creating it if needed.
+  [[nodiscard]] reg_t get_operand(const BitSources &bits) {
+    const auto operand = build_bits_register(builder, bits);
+    def_use.definitions.resize(program.registers.size(), nullptr);
+    def_use.use_counts.resize(program.registers.size(), 0);
+    return operand;
+  }
+
+  /// Tries to rewrite the definition of \a reg as a single wide instruction.
+  bool try_rewrite(reg_t reg) {
+    const auto bus_size = get_bus_size(reg);
+    if (bus_size < 2)
+      return false;
+
+    // Finds the 1-bit instructions computing each bit of `reg`.
+    std::vector<const Instruction *> bit_instructions;
+    for (bus_size_t i = 0; i < bus_size; ++i) {
+      const auto source = trace_bit(reg, i);
+      if (source.is_constant() || source.reg == reg)
+        return false;
+
+      const auto *definition = def_use.definitions[source.reg.index];
+      if (definition == nullptr || get_bus_size(source.reg) != 1 || !is_mergeable(definition))
+        return false;
+
+      if (!bit_instructions.empty() && typeid(*definition) != typeid(*bit_instructions.front()))
+        return false;
+
+      // The 1-bit instructions must not be needed elsewhere, otherwise the
+      // rewrite would only add work.
+      if (def_use.use_counts[source.reg.index] != 1 || (program.registers.get_flags(source.reg) & RIF_OUTPUT) ||
+          std::ranges::find(bit_instructions, definition) != bit_instructions.end())
+        return false;
+
+      bit_instructions.push_back(definition);
+    }
+
+    // Gathers the operands bits.
+    const auto operand_count = get_instruction_inputs(*bit_instructions.front()).size();
+    std::vector<BitSources> operands_bits(operand_count);
+    for (const auto *instruction : bit_instructions) {
+      const auto inputs = get_instruction_inputs(*instruction);
+      for (std::size_t j = 0; j < operand_count; ++j) {
+        if (get_bus_size(inputs[j]) != 1)
+          return false;
+        operands_bits[j].push_back(trace_bit(inputs[j], 0));
+      }
+    }
+
+    // The MUX choice must be the same for all bits.
+    const bool is_mux = dynamic_cast<const MuxInstruction *>(bit_instructions.front()) != nullptr;
+    if (is_mux) {
+      auto &choice_bits = operands_bits.front();
+      if (std::ranges::any_of(choice_bits, [&](const auto &bit) { return bit != choice_bits.front(); }))
+        return false;
+      choice_bits.resize(1);
+    }
+
+    std::vector<reg_t> operands;
+    for (const auto &bits : operands_bits)
+      operands.push_back(get_operand(bits));
+
+    // The wide instruction is a copy of the 1-bit ones with other operands.
+    auto *wide_instruction = clone_instruction(*bit_instructions.front());
+    wide_instruction->output = reg;
+    std::size_t j = 0;
+    rewrite_instruction_inputs(*wide_instruction, [&](reg_t &input) { input = operands[j++]; });
+
+    to_delete.push_back(def_use.definitions[reg.index]);
+    program.instructions.push_back(wide_instruction);
+    return true;
+  }
+};
+} // namespace
+
+// ========================================================
+// class WordLevelPass
+// ========================================================
+
+bool WordLevelPass::run(const std::shared_ptr<Program> &program) {
+  assert(program != nullptr);
+
+  bool modified = false;
+  while (true) {
+    WordLevelRewriter rewriter(program);
+
+    // Only registers made of bits of other registers are candidates.
+    const auto register_count = static_cast<reg_index_t>(program->registers.size());
+    for (reg_index_t i = 0; i < register_count; ++i) {
+      const auto *definition = rewriter.def_use.definitions[i];
+      if (dynamic_cast<const ConcatInstruction *>(definition) != nullptr ||
+          dynamic_cast<const GatherInstruction *>(definition) != nullptr)
+        rewriter.try_rewrite({i});
+    }
+
+    if (rewriter.to_delete.empty())
+      break;
+
+    std::ranges::sort(rewriter.to_delete);
+    erase_instructions_if(*program, [&rewriter](const Instruction *instruction) {
+      return std::ranges::binary_search(rewriter.to_delete, instruction);
+    });
+    // The now unused 1-bit instructions must be removed before the next
+    // iteration so their operands are seen as used only once.
+    erase_dead_instructions(*program);
+    modified = true;
+  }
+
+  return modified;
+}
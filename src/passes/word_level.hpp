@@ -0,0 +1,37 @@
+#ifndef NETLIST_SRC_PASSES_WORD_LEVEL_HPP
+#define NETLIST_SRC_PASSES_WORD_LEVEL_HPP
+
+#include "pass.hpp"
+
+// ========================================================
+// class WordLevelPass
+// ========================================================
+
+/// \ingroup passes
+/// \brief Merges parallel 1-bit operations into a single wide operation.
+///
+/// Bit-blasted netlists compute an operation on a bus as one 1-bit instruction
+/// per bit whose results are concatenated, for example:
+/// ```
+/// o0 = OR (SELECT 0 a) (SELECT 0 b)
+/// o1 = OR (SELECT 1 a) (SELECT 1 b)
+/// o = CONCAT o0 o1
+/// ```
+/// This pass detects registers built from the bits of isomorphic 1-bit
+/// instructions (same opcode, and same choice for `MUX`) and replaces them by a
+/// single instruction on the whole bus (here `o = OR a b`). The operands of the
+/// wide instruction are gathered from the operands of the 1-bit instructions
+/// (see build_bit_gather()), so they are free when they come from the same buses
+/// at matching bit positions. This is repeated until a fixed point is reached
+/// because the gathered operands may themselves be made of parallel 1-bit
+/// instructions.
+///
+/// `NOT`, binary gates, `MUX` and `REG` instructions are merged.
+class WordLevelPass final : public Pass {
+public:
+  [[nodiscard]] std::string_view get_name() const override { return "word-level"; }
+
+  bool run(const std::shared_ptr<Program> &program) override;
+};
+
+#endif // NETLIST_SRC_PASSES_WORD_LEVEL_HPP
@@ -1,36 +1,102 @@
 #include "program.hpp"
 
 #include <algorithm>
+#include <bit>
 #include <cassert>
 #include <fmt/format.h>
 #include <iostream>
 #include <ostream>
 
+// ========================================================
+// class RegisterTable
+// ========================================================
+
+RegisterTable::RegisterTable() : m_name_offsets{0} {}
+
+void RegisterTable::reserve(std::size_t count) {
+  m_bus_sizes.reserve(count);
+  m_flags.reserve(count);
+  m_name_ids.reserve(count);
+}
+
+reg_t RegisterTable::add(bus_size_t bus_size, std::string_view name, unsigned flags) {
+  assert(size() < UINT_LEAST32_MAX && "too many registers allocated");
+
+  const reg_t reg = {static_cast<reg_index_t>(size())};
+  m_bus_sizes.push_back(bus_size);
+  m_flags.push_back(static_cast<std::uint_least8_t>(flags));
+  m_name_ids.push_back(0);
+  set_name(reg, name);
+  return reg;
+}
+
+std::string_view RegisterTable::get_name(reg_t reg) const {
+  const auto name_id = m_name_ids[reg.index];
+  if (name_id == 0)
+    return {};
+
+  const auto begin = m_name_offsets[name_id - 1];
+  return std::string_view(m_name_arena).substr(begin, m_name_offsets[name_id] - begin);
+}
+
+void RegisterTable::set_name(reg_t reg, std::string_view name) {
+  if (name.empty()) {
+    m_name_ids[reg.index] = 0;
+    return;
+  }
+
+  assert(m_name_offsets.size() < UINT_LEAST32_MAX && "too many names allocated");
+  m_name_arena.append(name);
+  m_name_ids[reg.index] = static_cast<std::uint_least32_t>(m_name_offsets.size());
+  m_name_offsets.push_back(m_name_arena.size());
+}
+
+void RegisterTable::strip_names() {
+  RegisterTable stripped;
+  stripped.reserve(size());
+  for (reg_index_t i = 0; i < size(); ++i) {
+    const auto flags = get_flags({i});
+    stripped.add(get_bus_size({i}), (flags & (RIF_INPUT | RIF_OUTPUT)) ? get_name({i}) : std::string_view(), flags);
+  }
+
+  stripped.m_name_arena.shrink_to_fit();
+  stripped.m_name_offsets.shrink_to_fit();
+  *this = std::move(stripped);
+}
+
 // ========================================================
 // struct Program
 // ========================================================
 
 bool Program::has_inputs() const {
-  return std::ranges::any_of(registers, [](const auto &register_info) { return register_info.flags & RIF_INPUT; });
+  for (reg_index_t i = 0; i < registers.size(); ++i) {
+    if (registers.get_flags({i}) & RIF_INPUT)
+      return true;
+  }
+  return false;
 }
 
 std::vector<reg_t> Program::get_inputs() const {
   std::vector<reg_t> inputs;
   for (reg_index_t i = 0; i < registers.size(); ++i) {
-    if (registers[i].flags & RIF_INPUT)
+    if (registers.get_flags({i}) & RIF_INPUT)
       inputs.push_back({i});
   }
   return inputs;
 }
 
 bool Program::has_outputs() const {
-  return std::ranges::any_of(registers, [](const auto &register_info) { return register_info.flags & RIF_OUTPUT; });
+  for (reg_index_t i = 0; i < registers.size(); ++i) {
+    if (registers.get_flags({i}) & RIF_OUTPUT)
+      return true;
+  }
+  return false;
 }
 
 std::vector<reg_t> Program::get_outputs() const {
   std::vector<reg_t> outputs;
   for (reg_index_t i = 0; i < registers.size(); ++i) {
-    if (registers[i].flags & RIF_OUTPUT)
+    if (registers.get_flags({i}) & RIF_OUTPUT)
       outputs.push_back({i});
   }
   return outputs;
@@ -39,11 +105,379 @@ std::vector<reg_t> Program::get_outputs() const {
 std::string Program::get_register_name(reg_t reg) const {
   assert(reg.index < registers.size());
 
-  const auto &register_info = registers[reg.index];
-  if (register_info.name.empty())
+  const auto name = registers.get_name(reg);
+  if (name.empty())
     return fmt::format("__r{}", reg.index);
   else
-    return register_info.name;
+    return std::string(name);
+}
+
+std::shared_ptr<Program> Program::clone() const {
+  auto program = std::make_shared<Program>();
+  program->registers = registers;
+  program->memories = memories;
+  program->instructions.reserve(instructions.size());
+  for (const auto *instruction : instructions) {
+    auto *copy = clone_instruction(*instruction);
+    program->instructions.push_back(copy);
+    if (const auto *memory_instruction = dynamic_cast<const MemoryInstruction *>(copy))
+      program->memories[memory_instruction->memory_block].parent = copy;
+  }
+  return program;
+}
+
+std::optional<reg_t> Program::find_register(std::string_view name) const {
+  for (reg_index_t i = 0; i < registers.size(); ++i) {
+    if (registers.get_name({i}) == name)
+      return reg_t{i};
+  }
+  return std::nullopt;
+}
+
+// ========================================================
+// get_instruction_inputs()
+// ========================================================
+
+namespace {
+struct InputsCollector final : ConstInstructionVisitor {
+  std::vector<reg_t> inputs;
+
+  void visit_const(const ConstInstruction &inst) override {}
+  void visit_load(const LoadInstruction &inst) override { inputs.push_back(inst.input); }
+  void visit_not(const NotInstruction &inst) override { inputs.push_back(inst.input); }
+  void visit_reg(const RegInstruction &inst) override { inputs.push_back(inst.input); }
+  void visit_mux(const MuxInstruction &inst) override { inputs.insert(inputs.end(), {inst.choice, inst.first, inst.second}); }
+  void visit_concat(const ConcatInstruction &inst) override { inputs.insert(inputs.end(), {inst.lhs, inst.rhs}); }
+  void visit_and(const AndInstruction &inst) override { visit_binary(inst); }
+  void visit_nand(const NandInstruction &inst) override { visit_binary(inst); }
+  void visit_or(const OrInstruction &inst) override { visit_binary(inst); }
+  void visit_nor(const NorInstruction &inst) override { visit_binary(inst); }
+  void visit_xor(const XorInstruction &inst) override { visit_binary(inst); }
+  void visit_xnor(const XnorInstruction &inst) override { visit_binary(inst); }
+  void visit_add(const AddInstruction &inst) override { visit_binary(inst); }
+  void visit_sub(const SubInstruction &inst) override { visit_binary(inst); }
+  void visit_eq(const EqInstruction &inst) override { visit_binary(inst); }
+  void visit_lt(const LtInstruction &inst) override { visit_binary(inst); }
+  void visit_mul(const MulInstruction &inst) override { visit_binary(inst); }
+  void visit_shl(const ShlInstruction &inst) override { visit_binary(inst); }
+  void visit_shr(const ShrInstruction &inst) override { visit_binary(inst); }
+  void visit_asr(const AsrInstruction &inst) override { visit_binary(inst); }
+  void visit_reduce_or(const ReduceOrInstruction &inst) override { inputs.push_back(inst.input); }
+  void visit_reduce_and(const ReduceAndInstruction &inst) override { inputs.push_back(inst.input); }
+  void visit_delay(const DelayInstruction &inst) override { inputs.push_back(inst.input); }
+  void visit_lut(const LutInstruction &inst) override { inputs.insert(inputs.end(), inst.inputs.begin(), inst.inputs.end()); }
+  void visit_memo(const MemoInstruction &inst) override {
+    inputs.insert(inputs.end(), inst.inputs.begin(), inst.inputs.end());
+  }
+  void visit_lazy_mux(const LazyMuxInstruction &inst) override {
+    inputs.push_back(inst.choice);
+    if (inst.first_body.empty())
+      inputs.push_back(inst.first);
+    if (inst.second_body.empty())
+      inputs.push_back(inst.second);
+    inputs.insert(inputs.end(), inst.body_inputs.begin(), inst.body_inputs.end());
+  }
+  void visit_enabled_reg(const EnabledRegInstruction &inst) override {
+    inputs.push_back(inst.enable);
+    if (inst.body.empty())
+      inputs.push_back(inst.input);
+    inputs.insert(inputs.end(), inst.body_inputs.begin(), inst.body_inputs.end());
+  }
+  void visit_select(const SelectInstruction &inst) override { inputs.push_back(inst.input); }
+  void visit_slice(const SliceInstruction &inst) override { inputs.push_back(inst.input); }
+  void visit_rom(const RomInstruction &inst) override { inputs.push_back(inst.read_addr); }
+  void visit_ram(const RamInstruction &inst) override {
+    inputs.insert(inputs.end(), {inst.read_addr, inst.write_enable, inst.write_addr, inst.write_data});
+  }
+  void visit_gather(const GatherInstruction &inst) override {
+    for (const auto &part : inst.parts)
+      inputs.push_back(part.input);
+  }
+
+  void visit_binary(const BinaryInstruction &inst) { inputs.insert(inputs.end(), {inst.lhs, inst.rhs}); }
+};
+} // namespace
+
+std::vector<reg_t> get_instruction_inputs(const Instruction &instruction) {
+  InputsCollector collector;
+  instruction.visit(collector);
+  return std::move(collector.inputs);
+}
+
+namespace {
+// The visitor API only gives const access to instructions, however the
+// rewritten instruction is known to be mutable (see rewrite_instruction_inputs()).
+struct InputsRewriter final : ConstInstructionVisitor {
+  const std::function<void(reg_t &)> &callback;
+  /// True to also rewrite the registers defined in the bodies (see rename_registers()).
+  bool is_renaming_bodies = false;
+
+  explicit InputsRewriter(const std::function<void(reg_t &)> &cb) : callback(cb) {}
+
+  void rewrite(const reg_t &reg) { callback(const_cast<reg_t &>(reg)); }
+
+  void visit_const(const ConstInstruction &inst) override {}
+  void visit_load(const LoadInstruction &inst) override { rewrite(inst.input); }
+  void visit_not(const NotInstruction &inst) override { rewrite(inst.input); }
+  void visit_reg(const RegInstruction &inst) override { rewrite(inst.input); }
+  void visit_mux(const MuxInstruction &inst) override {
+    rewrite(inst.choice);
+    rewrite(inst.first);
+    rewrite(inst.second);
+  }
+  void visit_concat(const ConcatInstruction &inst) override {
+    rewrite(inst.lhs);
+    rewrite(inst.rhs);
+  }
+  void visit_and(const AndInstruction &inst) override { visit_binary(inst); }
+  void visit_nand(const NandInstruction &inst) override { visit_binary(inst); }
+  void visit_or(const OrInstruction &inst) override { visit_binary(inst); }
+  void visit_nor(const NorInstruction &inst) override { visit_binary(inst); }
+  void visit_xor(const XorInstruction &inst) override { visit_binary(inst); }
+  void visit_xnor(const XnorInstruction &inst) override { visit_binary(inst); }
+  void visit_add(const AddInstruction &inst) override { visit_binary(inst); }
+  void visit_sub(const SubInstruction &inst) override { visit_binary(inst); }
+  void visit_eq(const EqInstruction &inst) override { visit_binary(inst); }
+  void visit_lt(const LtInstruction &inst) override { visit_binary(inst); }
+  void visit_mul(const MulInstruction &inst) override { visit_binary(inst); }
+  void visit_shl(const ShlInstruction &inst) override { visit_binary(inst); }
+  void visit_shr(const ShrInstruction &inst) override { visit_binary(inst); }
+  void visit_asr(const AsrInstruction &inst) override { visit_binary(inst); }
+  void visit_reduce_or(const ReduceOrInstruction &inst) override { rewrite(inst.input); }
+  void visit_reduce_and(const ReduceAndInstruction &inst) override { rewrite(inst.input); }
+  void visit_delay(const DelayInstruction &inst) override { rewrite(inst.input); }
+  void visit_lut(const LutInstruction &inst) override {
+    for (const auto &input : inst.inputs)
+      rewrite(input);
+  }
+  void visit_memo(const MemoInstruction &inst) override {
+    for (const auto &input : inst.inputs)
+      rewrite_body_input(input, inst.body);
+    rewrite_body(inst.body);
+  }
+  void visit_lazy_mux(const LazyMuxInstruction &inst) override {
+    rewrite(inst.choice);
+    if (inst.first_body.empty() || is_renaming_bodies)
+      rewrite(inst.first);
+    if (inst.second_body.empty() || is_renaming_bodies)
+      rewrite(inst.second);
+    for (const auto &input : inst.body_inputs) {
+      const auto old_input = input;
+      rewrite_body_input(input, inst.first_body);
+      rename_in_body(old_input, input, inst.second_body);
+    }
+    rewrite_body(inst.first_body);
+    rewrite_body(inst.second_body);
+  }
+  void visit_enabled_reg(const EnabledRegInstruction &inst) override {
+    rewrite(inst.enable);
+    if (inst.body.empty() || is_renaming_bodies)
+      rewrite(inst.input);
+    for (const auto &input : inst.body_inputs)
+      rewrite_body_input(input, inst.body);
+    rewrite_body(inst.body);
+  }
+  void visit_select(const SelectInstruction &inst) override { rewrite(inst.input); }
+  void visit_slice(const SliceInstruction &inst) override { rewrite(inst.input); }
+  void visit_rom(const RomInstruction &inst) override { rewrite(inst.read_addr); }
+  void visit_ram(const RamInstruction &inst) override {
+    rewrite(inst.read_addr);
+    rewrite(inst.write_enable);
+    rewrite(inst.write_addr);
+    rewrite(inst.write_data);
+  }
+  void visit_gather(const GatherInstruction &inst) override {
+    for (const auto &part : inst.parts)
+      rewrite(part.input);
+  }
+
+  void visit_binary(const BinaryInstruction &inst) {
+    rewrite(inst.lhs);
+    rewrite(inst.rhs);
+  }
+
+  /// Rewrites \a input, and its uses in \a body which reads it directly.
+  void rewrite_body_input(const reg_t &input, const std::vector<Instruction *> &body) {
+    const auto old_input = input;
+    rewrite(input);
+    rename_in_body(old_input, input, body);
+  }
+
+  void rename_in_body(reg_t old_input, reg_t new_input, const std::vector<Instruction *> &body) const {
+    // When renaming the bodies, their uses of the input are renamed with the rest.
+    if (old_input == new_input || is_renaming_bodies)
+      return;
+
+    for (auto *instruction : body) {
+      rewrite_instruction_inputs(*instruction, [old_input, new_input](reg_t &reg) {
+        if (reg == old_input)
+          reg = new_input;
+      });
+    }
+  }
+
+  /// Rewrites the outputs and the operands of the instructions of \a body when renaming the bodies.
+  void rewrite_body(const std::vector<Instruction *> &body) {
+    if (!is_renaming_bodies)
+      return;
+
+    for (const auto *instruction : body) {
+      rewrite(instruction->output);
+      instruction->visit(*this);
+    }
+  }
+};
+} // namespace
+
+void rewrite_instruction_inputs(Instruction &instruction, const std::function<void(reg_t &)> &callback) {
+  InputsRewriter rewriter(callback);
+  instruction.visit(rewriter);
+}
+
+void rename_registers(Program &program, const std::vector<reg_t> &new_names) {
+  assert(new_names.size() == program.registers.size());
+
+  const std::function<void(reg_t &)> rename = [&new_names](reg_t &reg) { reg = new_names[reg.index]; };
+  InputsRewriter rewriter(rename);
+  rewriter.is_renaming_bodies = true;
+  for (auto *instruction : program.instructions) {
+    rename(instruction->output);
+    instruction->visit(rewriter);
+  }
+
+  // The merged registers have the same bus size, combine their flags and
+  // keep the first name.
+  reg_index_t register_count = 0;
+  for (const auto new_name : new_names)
+    register_count = std::max(register_count, new_name.index + 1);
+  std::vector<reg_t> merged_registers(register_count);
+  std::vector<unsigned> merged_flags(register_count, RIF_NONE);
+  for (reg_index_t i = 0; i < program.registers.size(); ++i) {
+    auto &merged_register = merged_registers[new_names[i].index];
+    if (merged_register == reg_t{} || program.registers.get_name(merged_register).empty())
+      merged_register = reg_t{i};
+    assert(program.registers.get_bus_size(merged_register) == program.registers.get_bus_size({i}));
+    merged_flags[new_names[i].index] |= program.registers.get_flags({i});
+  }
+
+  RegisterTable registers;
+  registers.reserve(register_count);
+  for (reg_index_t i = 0; i < register_count; ++i) {
+    const auto reg = merged_registers[i];
+    registers.add(program.registers.get_bus_size(reg), program.registers.get_name(reg), merged_flags[i]);
+  }
+  program.registers = std::move(registers);
+}
+
+void append_program(Program &program, Program &part, reg_index_t base_register_count) {
+  const reg_index_t register_offset = static_cast<reg_index_t>(program.registers.size()) - base_register_count;
+  const auto memory_offset = static_cast<std::uint_least32_t>(program.memories.size());
+
+  program.registers.reserve(program.registers.size() + part.registers.size());
+  for (reg_index_t i = 0; i < part.registers.size(); ++i)
+    program.registers.add(part.registers.get_bus_size({i}), part.registers.get_name({i}), part.registers.get_flags({i}));
+
+  const std::function<void(reg_t &)> rename = [base_register_count, register_offset](reg_t &reg) {
+    if (reg.index >= base_register_count)
+      reg.index += register_offset;
+  };
+  for (auto *instruction : part.instructions) {
+    rename(instruction->output);
+    rewrite_instruction_inputs(*instruction, rename);
+    if (auto *memory_instruction = dynamic_cast<MemoryInstruction *>(instruction))
+      memory_instruction->memory_block += memory_offset;
+  }
+
+  program.instructions.insert(program.instructions.end(), part.instructions.begin(), part.instructions.end());
+  part.instructions.clear(); // now owned by program
+  program.memories.insert(program.memories.end(), part.memories.begin(), part.memories.end());
+  part.memories.clear();
+}
+
+// ========================================================
+// clone_instruction()
+// ========================================================
+
+namespace {
+struct InstructionCloner final : ConstInstructionVisitor {
+  Instruction *result = nullptr;
+
+  void visit_const(const ConstInstruction &inst) override { result = new ConstInstruction(inst); }
+  void visit_load(const LoadInstruction &inst) override { result = new LoadInstruction(inst); }
+  void visit_not(const NotInstruction &inst) override { result = new NotInstruction(inst); }
+  void visit_reg(const RegInstruction &inst) override { result = new RegInstruction(inst); }
+  void visit_mux(const MuxInstruction &inst) override { result = new MuxInstruction(inst); }
+  void visit_concat(const ConcatInstruction &inst) override { result = new ConcatInstruction(inst); }
+  void visit_and(const AndInstruction &inst) override { result = new AndInstruction(inst); }
+  void visit_nand(const NandInstruction &inst) override { result = new NandInstruction(inst); }
+  void visit_or(const OrInstruction &inst) override { result = new OrInstruction(inst); }
+  void visit_nor(const NorInstruction &inst) override { result = new NorInstruction(inst); }
+  void visit_xor(const XorInstruction &inst) override { result = new XorInstruction(inst); }
+  void visit_xnor(const XnorInstruction &inst) override { result = new XnorInstruction(inst); }
+  void visit_select(const SelectInstruction &inst) override { result = new SelectInstruction(inst); }
+  void visit_slice(const SliceInstruction &inst) override { result = new SliceInstruction(inst); }
+  void visit_rom(const RomInstruction &inst) override { result = new RomInstruction(inst); }
+  void visit_ram(const RamInstruction &inst) override { result = new RamInstruction(inst); }
+  void visit_gather(const GatherInstruction &inst) override { result = new GatherInstruction(inst); }
+  void visit_add(const AddInstruction &inst) override { result = new AddInstruction(inst); }
+  void visit_sub(const SubInstruction &inst) override { result = new SubInstruction(inst); }
+  void visit_eq(const EqInstruction &inst) override { result = new EqInstruction(inst); }
+  void visit_lt(const LtInstruction &inst) override { result = new LtInstruction(inst); }
+  void visit_mul(const MulInstruction &inst) override { result = new MulInstruction(inst); }
+  void visit_shl(const ShlInstruction &inst) override { result = new ShlInstruction(inst); }
+  void visit_shr(const ShrInstruction &inst) override { result = new ShrInstruction(inst); }
+  void visit_asr(const AsrInstruction &inst) override { result = new AsrInstruction(inst); }
+  void visit_reduce_or(const ReduceOrInstruction &inst) override { result = new ReduceOrInstruction(inst); }
+  void visit_reduce_and(const ReduceAndInstruction &inst) override { result = new ReduceAndInstruction(inst); }
+  void visit_delay(const DelayInstruction &inst) override { result = new DelayInstruction(inst); }
+  void visit_lut(const LutInstruction &inst) override { result = new LutInstruction(inst); }
+  void visit_memo(const MemoInstruction &inst) override { result = new MemoInstruction(inst); }
+  void visit_lazy_mux(const LazyMuxInstruction &inst) override { result = new LazyMuxInstruction(inst); }
+  void visit_enabled_reg(const EnabledRegInstruction &inst) override { result = new EnabledRegInstruction(inst); }
+};
+} // namespace
+
+Instruction *clone_instruction(const Instruction &instruction) {
+  InstructionCloner cloner;
+  instruction.visit(cloner);
+  return cloner.result;
+}
+
+// ========================================================
+// struct MemoInstruction
+// ========================================================
+
+MemoInstruction::MemoInstruction(const MemoInstruction &other)
+    : Instruction(other), inputs(other.inputs), cache_bits(other.cache_bits) {
+  body.reserve(other.body.size());
+  for (const auto *instruction : other.body)
+    body.push_back(clone_instruction(*instruction));
+}
+
+// ========================================================
+// struct LazyMuxInstruction
+// ========================================================
+
+LazyMuxInstruction::LazyMuxInstruction(const LazyMuxInstruction &other)
+    : Instruction(other), choice(other.choice), first(other.first), second(other.second),
+      body_inputs(other.body_inputs) {
+  first_body.reserve(other.first_body.size());
+  for (const auto *instruction : other.first_body)
+    first_body.push_back(clone_instruction(*instruction));
+  second_body.reserve(other.second_body.size());
+  for (const auto *instruction : other.second_body)
+    second_body.push_back(clone_instruction(*instruction));
+}
+
+// ========================================================
+// struct EnabledRegInstruction
+// ========================================================
+
+EnabledRegInstruction::EnabledRegInstruction(const EnabledRegInstruction &other)
+    : Instruction(other), enable(other.enable), input(other.input), body_inputs(other.body_inputs) {
+  body.reserve(other.body.size());
+  for (const auto *instruction : other.body)
+    body.push_back(clone_instruction(*instruction));
 }
 
 // ========================================================
@@ -51,19 +485,14 @@ std::string Program::get_register_name(reg_t reg) const {
 // ========================================================
 
 reg_t ProgramBuilder::add_register(bus_size_t bus_size, const std::string &name, unsigned flags) {
-  assert(m_program->registers.size() < UINT_LEAST32_MAX && "too many registers allocated");
-
-  reg_t reg = {static_cast<std::uint_least32_t>(m_program->registers.size())};
-  RegisterInfo &info = m_program->registers.emplace_back();
-  info.name = name;
-  info.bus_size = bus_size;
-  info.flags = flags;
-  return reg;
+  return {m_first_register + m_program->registers.add(bus_size, name, flags).index};
 }
 
 bus_size_t ProgramBuilder::get_register_bus_size(reg_t reg) const {
   assert(check_reg(reg));
-  return m_program->registers[reg.index].bus_size;
+  if (reg.index < m_first_register)
+    return m_base_registers->get_bus_size(reg);
+  return m_program->registers.get_bus_size({reg.index - m_first_register});
 }
 
 ConstInstruction &ProgramBuilder::add_const(reg_t output, reg_value_t value) {
@@ -162,6 +591,114 @@ XnorInstruction &ProgramBuilder::add_xnor(reg_t output, reg_t lhs, reg_t rhs) {
   return *inst;
 }
 
+AddInstruction &ProgramBuilder::add_add(reg_t output, reg_t lhs, reg_t rhs) {
+  assert(check_reg(output) && check_reg(lhs) && check_reg(rhs));
+
+  auto *inst = new AddInstruction();
+  inst->output = output;
+  inst->lhs = lhs;
+  inst->rhs = rhs;
+  m_program->instructions.push_back(inst);
+  return *inst;
+}
+
+SubInstruction &ProgramBuilder::add_sub(reg_t output, reg_t lhs, reg_t rhs) {
+  assert(check_reg(output) && check_reg(lhs) && check_reg(rhs));
+
+  auto *inst = new SubInstruction();
+  inst->output = output;
+  inst->lhs = lhs;
+  inst->rhs = rhs;
+  m_program->instructions.push_back(inst);
+  return *inst;
+}
+
+EqInstruction &ProgramBuilder::add_eq(reg_t output, reg_t lhs, reg_t rhs) {
+  assert(check_reg(output) && check_reg(lhs) && check_reg(rhs));
+
+  auto *inst = new EqInstruction();
+  inst->output = output;
+  inst->lhs = lhs;
+  inst->rhs = rhs;
+  m_program->instructions.push_back(inst);
+  return *inst;
+}
+
+LtInstruction &ProgramBuilder::add_lt(reg_t output, reg_t lhs, reg_t rhs) {
+  assert(check_reg(output) && check_reg(lhs) && check_reg(rhs));
+
+  auto *inst = new LtInstruction();
+  inst->output = output;
+  inst->lhs = lhs;
+  inst->rhs = rhs;
+  m_program->instructions.push_back(inst);
+  return *inst;
+}
+
+MulInstruction &ProgramBuilder::add_mul(reg_t output, reg_t lhs, reg_t rhs) {
+  assert(check_reg(output) && check_reg(lhs) && check_reg(rhs));
+
+  auto *inst = new MulInstruction();
+  inst->output = output;
+  inst->lhs = lhs;
+  inst->rhs = rhs;
+  m_program->instructions.push_back(inst);
+  return *inst;
+}
+
+ShlInstruction &ProgramBuilder::add_shl(reg_t output, reg_t lhs, reg_t rhs) {
+  assert(check_reg(output) && check_reg(lhs) && check_reg(rhs));
+
+  auto *inst = new ShlInstruction();
+  inst->output = output;
+  inst->lhs = lhs;
+  inst->rhs = rhs;
+  m_program->instructions.push_back(inst);
+  return *inst;
+}
+
+ShrInstruction &ProgramBuilder::add_shr(reg_t output, reg_t lhs, reg_t rhs) {
+  assert(check_reg(output) && check_reg(lhs) && check_reg(rhs));
+
+  auto *inst = new ShrInstruction();
+  inst->output = output;
+  inst->lhs = lhs;
+  inst->rhs = rhs;
+  m_program->instructions.push_back(inst);
+  return *inst;
+}
+
+AsrInstruction &ProgramBuilder::add_asr(reg_t output, reg_t lhs, reg_t rhs) {
+  assert(check_reg(output) && check_reg(lhs) && check_reg(rhs));
+
+  auto *inst = new AsrInstruction();
+  inst->output = output;
+  inst->lhs = lhs;
+  inst->rhs = rhs;
+  m_program->instructions.push_back(inst);
+  return *inst;
+}
+
+ReduceOrInstruction &ProgramBuilder::add_reduce_or(reg_t output, reg_t input) {
+  assert(check_reg(output) && check_reg(input));
+
+  auto *inst = new ReduceOrInstruction();
+  inst->output = output;
+  inst->input = input;
+  m_program->instructions.push_back(inst);
+  return *inst;
+}
+
+ReduceAndInstruction &ProgramBuilder::add_reduce_and(reg_t output, reg_t input) {
+  assert(check_reg(output) && check_reg(input));
+
+  auto *inst = new ReduceAndInstruction();
+  inst->output = output;
+  inst->input = input;
+  m_program->instructions.push_back(inst);
+  return *inst;
+}
+
 ConcatInstruction &ProgramBuilder::add_concat(reg_t output, reg_t lhs, reg_t rhs) {
   assert(check_reg(output) && check_reg(lhs) && check_reg(rhs));
 
@@ -169,7 +706,7 @@ ConcatInstruction &ProgramBuilder::add_concat(reg_t output, reg_t lhs, reg_t rhs
   inst->output = output;
   inst->lhs = lhs;
   inst->rhs = rhs;
-  inst->offset = m_program->registers[lhs.index].bus_size;
+  inst->offset = get_register_bus_size(lhs);
   m_program->instructions.push_back(inst);
   return *inst;
 }
@@ -258,10 +795,92 @@ RamInstruction &ProgramBuilder::add_ram(reg_t output, bus_size_t addr_size, bus_
   return *inst;
 }
 
+GatherInstruction &ProgramBuilder::add_gather(reg_t output, std::vector<GatherInstruction::Part> parts,
+                                              reg_value_t constant) {
+  assert(check_reg(output));
+
+  for (auto &part : parts) {
+    assert(check_reg(part.input));
+    assert(std::popcount(part.extract_mask) == std::popcount(part.deposit_mask));
+
+    // Detects if the part is just a shift of the input bits. This is the case
+    // when the lowest set bits of both masks are shifted by the same amount as
+    // the masks themselves.
+    part.is_shift = false;
+    part.shift = 0;
+    if (part.extract_mask == 0)
+      continue;
+
+    const int shift = std::countr_zero(part.deposit_mask) - std::countr_zero(part.extract_mask);
+    const reg_value_t shifted_mask = shift >= 0 ? (part.extract_mask << shift) : (part.extract_mask >> -shift);
+    if (shifted_mask == part.deposit_mask) {
+      part.is_shift = true;
+      part.shift = shift;
+    }
+  }
+
+  auto *inst = new GatherInstruction();
+  inst->output = output;
+  inst->parts = std::move(parts);
+  inst->constant = constant;
+  m_program->instructions.push_back(inst);
+  return *inst;
+}
+
+DelayInstruction &ProgramBuilder::add_delay(reg_t output, reg_t input, std::uint_least32_t depth) {
+  assert(check_reg(output) && check_reg(input) && depth >= 1);
+
+  auto *inst = new DelayInstruction();
+  inst->output = output;
+  inst->input = input;
+  inst->depth = depth;
+  m_program->instructions.push_back(inst);
+  return *inst;
+}
+
+LutInstruction &ProgramBuilder::add_lut(reg_t output, std::vector<reg_t> inputs, const std::vector<reg_value_t> &entries) {
+  assert(check_reg(output));
+  bus_size_t input_bits = 0;
+  for (const auto input : inputs) {
+    assert(check_reg(input));
+    input_bits += get_register_bus_size(input);
+  }
+  assert(input_bits < 32 && entries.size() == (std::size_t(1) << input_bits));
+
+  auto *inst = new LutInstruction();
+  inst->output = output;
+  inst->inputs = std::move(inputs);
+  inst->entry_shift = std::bit_width(std::bit_ceil(get_register_bus_size(output))) - 1;
+
+  // Packs the entries into 64-bit words.
+  const unsigned word_shift = 6 - inst->entry_shift;
+  const auto entry_mask = get_bus_mask(get_register_bus_size(output));
+  inst->table.resize(std::max<std::size_t>(1, entries.size() >> word_shift));
+  for (std::size_t i = 0; i < entries.size(); ++i) {
+    const auto bit = (i & ((std::size_t(1) << word_shift) - 1)) << inst->entry_shift;
+    inst->table[i >> word_shift] |= (entries[i] & entry_mask) << bit;
+  }
+
+  m_program->instructions.push_back(inst);
+  return *inst;
+}
+
+EnabledRegInstruction &ProgramBuilder::add_enabled_reg(reg_t output, reg_t enable, reg_t input) {
+  assert(check_reg(output) && check_reg(enable) && check_reg(input));
+  assert(get_register_bus_size(enable) == 1);
+
+  auto *inst = new EnabledRegInstruction();
+  inst->output = output;
+  inst->enable = enable;
+  inst->input = input;
+  m_program->instructions.push_back(inst);
+  return *inst;
+}
+
 std::shared_ptr<Program> ProgramBuilder::build() {
   return std::move(m_program);
 }
 
 bool ProgramBuilder::check_reg(reg_t reg) const {
-  return reg.index < m_program->registers.size();
+  return reg.index < m_first_register + m_program->registers.size();
 }
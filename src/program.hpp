@@ -2,14 +2,46 @@
 #define NETLIST_PROGRAM_HPP
 
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 using reg_index_t = std::uint_least32_t;
 using reg_value_t = std::uint_least64_t;
 using bus_size_t = std::uint_least32_t;
 
+/// \brief Returns a mask whose \a bus_size lowest bits are set.
+[[nodiscard]] constexpr reg_value_t get_bus_mask(bus_size_t bus_size) {
+  return bus_size >= 64 ? ~reg_value_t(0) : ((reg_value_t(1) << bus_size) - 1);
+}
+
+/// \brief Returns \a value shifted left by \a amount bits (zero if \a amount is 64 or more).
+[[nodiscard]] constexpr reg_value_t shift_left(reg_value_t value, reg_value_t amount) {
+  return amount >= 64 ? 0 : (value << amount);
+}
+
+/// \brief Returns \a value logically shifted right by \a amount bits (zero if \a amount is 64 or more).
+[[nodiscard]] constexpr reg_value_t shift_right(reg_value_t value, reg_value_t amount) {
+  return amount >= 64 ? 0 : (value >> amount);
+}
+
+/// \brief Returns the \a bus_size bits \a value arithmetically shifted right by \a amount bits.
+///
+/// The sign bit is the bit `bus_size - 1` of \a value and the result is masked to \a bus_size bits.
+[[nodiscard]] constexpr reg_value_t arithmetic_shift_right(reg_value_t value, reg_value_t amount, bus_size_t bus_size) {
+  const auto mask = get_bus_mask(bus_size);
+  value &= mask;
+  const bool is_negative = bus_size > 0 && ((value >> (bus_size - 1)) & 1) != 0;
+  if (amount >= bus_size)
+    return is_negative ? mask : 0;
+
+  const auto result = value >> amount;
+  return is_negative ? result | (mask & ~(mask >> amount)) : result;
+}
+
 /// \brief A register name to be used in a Netlist program.
 ///
 /// This is just a wrapper around a register's index that provides type safety.
@@ -34,6 +66,22 @@ struct SelectInstruction;
 struct SliceInstruction;
 struct RomInstruction;
 struct RamInstruction;
+struct GatherInstruction;
+struct AddInstruction;
+struct SubInstruction;
+struct EqInstruction;
+struct LtInstruction;
+struct MulInstruction;
+struct ShlInstruction;
+struct ShrInstruction;
+struct AsrInstruction;
+struct ReduceOrInstruction;
+struct ReduceAndInstruction;
+struct DelayInstruction;
+struct LutInstruction;
+struct MemoInstruction;
+struct LazyMuxInstruction;
+struct EnabledRegInstruction;
 
 /// Utility class implementing the visitor pattern for instructions.
 struct ConstInstructionVisitor {
@@ -55,6 +103,22 @@ struct ConstInstructionVisitor {
   virtual void visit_slice(const SliceInstruction &inst) = 0;
   virtual void visit_rom(const RomInstruction &inst) = 0;
   virtual void visit_ram(const RamInstruction &inst) = 0;
+  virtual void visit_gather(const GatherInstruction &inst) = 0;
+  virtual void visit_add(const AddInstruction &inst) = 0;
+  virtual void visit_sub(const SubInstruction &inst) = 0;
+  virtual void visit_eq(const EqInstruction &inst) = 0;
+  virtual void visit_lt(const LtInstruction &inst) = 0;
+  virtual void visit_mul(const MulInstruction &inst) = 0;
+  virtual void visit_shl(const ShlInstruction &inst) = 0;
+  virtual void visit_shr(const ShrInstruction &inst) = 0;
+  virtual void visit_asr(const AsrInstruction &inst) = 0;
+  virtual void visit_reduce_or(const ReduceOrInstruction &inst) = 0;
+  virtual void visit_reduce_and(const ReduceAndInstruction &inst) = 0;
+  virtual void visit_delay(const DelayInstruction &inst) = 0;
+  virtual void visit_lut(const LutInstruction &inst) = 0;
+  virtual void visit_memo(const MemoInstruction &inst) = 0;
+  virtual void visit_lazy_mux(const LazyMuxInstruction &inst) = 0;
+  virtual void visit_enabled_reg(const EnabledRegInstruction &inst) = 0;
 };
 
 /// \addtogroup instruction The supported instructions
@@ -154,6 +218,84 @@ struct XnorInstruction : BinaryInstruction {
   void visit(ConstInstructionVisitor &visitor) const override { visitor.visit_xnor(*this); }
 };
 
+/// \brief The `output = ADD lhs rhs` instruction.
+///
+/// The addition is done modulo 2^n where n is the output bus size.
+struct AddInstruction : BinaryInstruction {
+  void visit(ConstInstructionVisitor &visitor) const override { visitor.visit_add(*this); }
+};
+
+/// \brief The `output = SUB lhs rhs` instruction.
+///
+/// The subtraction is done modulo 2^n where n is the output bus size.
+struct SubInstruction : BinaryInstruction {
+  void visit(ConstInstructionVisitor &visitor) const override { visitor.visit_sub(*this); }
+};
+
+/// \brief The `output = EQ lhs rhs` instruction.
+///
+/// The output is a single bit set if both operands are equal.
+struct EqInstruction : BinaryInstruction {
+  void visit(ConstInstructionVisitor &visitor) const override { visitor.visit_eq(*this); }
+};
+
+/// \brief The `output = LT lhs rhs` instruction.
+///
+/// The output is a single bit set if lhs is less than rhs, both seen as unsigned integers.
+struct LtInstruction : BinaryInstruction {
+  void visit(ConstInstructionVisitor &visitor) const override { visitor.visit_lt(*this); }
+};
+
+/// \brief The `output = MUL lhs rhs` instruction.
+///
+/// The multiplication is done modulo 2^n where n is the output bus size.
+struct MulInstruction : BinaryInstruction {
+  void visit(ConstInstructionVisitor &visitor) const override { visitor.visit_mul(*this); }
+};
+
+/// \brief The `output = SHL lhs rhs` instruction.
+///
+/// lhs is shifted left by rhs bits, rhs being an unsigned integer of any bus size.
+/// See shift_left().
+struct ShlInstruction : BinaryInstruction {
+  void visit(ConstInstructionVisitor &visitor) const override { visitor.visit_shl(*this); }
+};
+
+/// \brief The `output = SHR lhs rhs` instruction.
+///
+/// lhs is logically shifted right by rhs bits, rhs being an unsigned integer of
+/// any bus size. See shift_right().
+struct ShrInstruction : BinaryInstruction {
+  void visit(ConstInstructionVisitor &visitor) const override { visitor.visit_shr(*this); }
+};
+
+/// \brief The `output = ASR lhs rhs` instruction.
+///
+/// lhs is arithmetically shifted right by rhs bits, rhs being an unsigned
+/// integer of any bus size. The sign bit is the most significant bit of the
+/// output bus. See arithmetic_shift_right().
+struct AsrInstruction : BinaryInstruction {
+  void visit(ConstInstructionVisitor &visitor) const override { visitor.visit_asr(*this); }
+};
+
+/// \brief The `output = REDOR input` instruction.
+///
+/// The output is a single bit set if at least one bit of input is set.
+struct ReduceOrInstruction : Instruction {
+  reg_t input = {};
+
+  void visit(ConstInstructionVisitor &visitor) const override { visitor.visit_reduce_or(*this); }
+};
+
+/// \brief The `output = REDAND input` instruction.
+///
+/// The output is a single bit set if all bits of input are set.
+struct ReduceAndInstruction : Instruction {
+  reg_t input = {};
+
+  void visit(ConstInstructionVisitor &visitor) const override { visitor.visit_reduce_and(*this); }
+};
+
 /// \brief The `output = SELECT i input` instruction.
 struct SelectInstruction : Instruction {
   reg_t input = {};
@@ -194,8 +336,183 @@ struct RamInstruction : MemoryInstruction {
   void visit(ConstInstructionVisitor &visitor) const override { visitor.visit_ram(*this); }
 };
 
+/// \brief The `output = GATHER ...` instruction, a pure permutation of bits.
+///
+/// This instruction is never generated by the parser but by the BitGatherPass to
+/// replace a whole tree of `SELECT`, `SLICE` and `CONCAT` instructions. The output
+/// is computed as `constant | (parts[0] | parts[1] | ...)` where each part moves
+/// the bits of its input selected by `extract_mask` to the positions indicated by
+/// `deposit_mask` (both masks have the same count of set bits and the bits order
+/// is preserved). This is exactly a `PEXT` followed by a `PDEP` in x86 BMI2 terms.
+struct GatherInstruction : Instruction {
+  struct Part {
+    reg_t input = {};
+    reg_value_t extract_mask = 0;
+    reg_value_t deposit_mask = 0;
+    /// If true, then `deposit_mask` is just `extract_mask` shifted by `shift`
+    /// bits (to the left if positive, to the right otherwise) and therefore the
+    /// part can be computed with a simple shift instead of a PEXT/PDEP pair.
+    bool is_shift = false;
+    int shift = 0;
+  };
+
+  /// The mask table describing where the bits of each input go.
+  std::vector<Part> parts;
+  /// Constant bits of the output (bits that do not come from any input).
+  reg_value_t constant = 0;
+
+  void visit(ConstInstructionVisitor &visitor) const override { visitor.visit_gather(*this); }
+};
+
+/// \brief The `output = DELAY depth input` instruction, equivalent to a chain of `depth` `REG` instructions.
+///
+/// This instruction is never generated by the parser but by the ShiftRegisterPass.
+/// The output is the value of input `depth` cycles ago (or zero during the first
+/// `depth` cycles). Simulators implement all the delays of the same input with a
+/// single ring buffer so that the cost of a cycle does not depend on `depth`.
+struct DelayInstruction : Instruction {
+  reg_t input = {};
+  /// The count of cycles, at least 1.
+  std::uint_least32_t depth = 1;
+
+  void visit(ConstInstructionVisitor &visitor) const override { visitor.visit_delay(*this); }
+};
+
+/// \brief The `output = LUT inputs...` instruction, a lookup in a precomputed truth table.
+///
+/// This instruction is never generated by the parser but by the LutMappingPass to
+/// replace a whole cone of combinational instructions. The bits of the inputs are
+/// concatenated (the first input in the lowest bits) to form the index of the
+/// entry giving the output value.
+///
+/// To keep the tables small, the entries are packed in 64-bit words. Each entry
+/// has `2^entry_shift` bits, the smallest power of two not less than the output
+/// bus size. Use ProgramBuilder::add_lut() to create the table.
+struct LutInstruction : Instruction {
+  std::vector<reg_t> inputs;
+  /// The packed entries, see get_entry().
+  std::vector<reg_value_t> table;
+  /// The base 2 logarithm of the count of bits per entry (in the range [0,6]).
+  std::uint_least8_t entry_shift = 6;
+
+  /// \brief Returns the entry at \a index.
+  [[nodiscard]] reg_value_t get_entry(std::size_t index) const {
+    const unsigned word_shift = 6 - entry_shift; // the base 2 logarithm of the count of entries per word
+    const auto word = table[index >> word_shift];
+    const auto bit = (index & ((std::size_t(1) << word_shift) - 1)) << entry_shift;
+    return (word >> bit) & get_bus_mask(1 << entry_shift);
+  }
+
+  void visit(ConstInstructionVisitor &visitor) const override { visitor.visit_lut(*this); }
+};
+
+/// \brief The `output = MEMO inputs... { body }` instruction, a memoized cone of instructions.
+///
+/// This instruction is never generated by the parser but by the MemoizationPass.
+/// The body is a sequence of combinational instructions computing the output
+/// from the inputs (the last one defines the output). Simulators may keep the
+/// last results of the body in a cache indexed by the concatenated bits of the
+/// inputs (the first input in the lowest bits) and skip the body on a hit.
+///
+/// The body instructions are owned by this instruction and their registers
+/// (except the output) are not used elsewhere in the program.
+struct MemoInstruction : Instruction {
+  std::vector<reg_t> inputs;
+  std::vector<Instruction *> body;
+  /// The base 2 logarithm of the count of entries of the cache.
+  std::uint_least8_t cache_bits = 8;
+
+  MemoInstruction() = default;
+  MemoInstruction(const MemoInstruction &other);
+  MemoInstruction &operator=(const MemoInstruction &) = delete;
+  ~MemoInstruction() override {
+    for (auto *instruction : body)
+      delete instruction;
+  }
+
+  void visit(ConstInstructionVisitor &visitor) const override { visitor.visit_memo(*this); }
+};
+
+/// \brief A `MUX` instruction that only evaluates the logic of the selected operand.
+///
+/// This instruction is never generated by the parser but by the LazyMuxPass.
+/// The instructions of `first_body` (resp. `second_body`) compute `first`
+/// (resp. `second`) and are only needed by this instruction, so they are only
+/// evaluated when `choice` selects that operand. An empty body means that the
+/// operand is computed outside of this instruction.
+///
+/// The body instructions are owned by this instruction and their registers
+/// (except `first` and `second`) are not used elsewhere in the program.
+struct LazyMuxInstruction : Instruction {
+  reg_t choice = {};
+  reg_t first = {};
+  reg_t second = {};
+  std::vector<Instruction *> first_body;
+  std::vector<Instruction *> second_body;
+  /// The registers read by the bodies that are defined outside of them.
+  std::vector<reg_t> body_inputs;
+
+  LazyMuxInstruction() = default;
+  LazyMuxInstruction(const LazyMuxInstruction &other);
+  LazyMuxInstruction &operator=(const LazyMuxInstruction &) = delete;
+  ~LazyMuxInstruction() override {
+    for (auto *instruction : first_body)
+      delete instruction;
+    for (auto *instruction : second_body)
+      delete instruction;
+  }
+
+  void visit(ConstInstructionVisitor &visitor) const override { visitor.visit_lazy_mux(*this); }
+};
+
+/// \brief The `output = REGEN enable input { body }` instruction, the data input of a register with an enable.
+///
+/// When `enable` is one, the instructions of `body` are evaluated and `output`
+/// gets the value of `input`. Otherwise, nothing is evaluated and `output`
+/// keeps its previous value (zero at the first cycle).
+///
+/// This instruction is never generated by the parser but by the
+/// EnabledRegisterPass which replaces the `d = MUX en q x` of the flip-flops
+/// with enable `q = REG d` by `d = REGEN en x`: when `en` is zero, `d` keeps
+/// its previous value which is the current value of `q`.
+///
+/// The body has the same invariants as the ones of LazyMuxInstruction. It may
+/// be empty, in which case `input` is computed outside of this instruction.
+struct EnabledRegInstruction : Instruction {
+  reg_t enable = {};
+  reg_t input = {};
+  std::vector<Instruction *> body;
+  /// The registers read by the body that are defined outside of it.
+  std::vector<reg_t> body_inputs;
+
+  EnabledRegInstruction() = default;
+  EnabledRegInstruction(const EnabledRegInstruction &other);
+  EnabledRegInstruction &operator=(const EnabledRegInstruction &) = delete;
+  ~EnabledRegInstruction() override {
+    for (auto *instruction : body)
+      delete instruction;
+  }
+
+  void visit(ConstInstructionVisitor &visitor) const override { visitor.visit_enabled_reg(*this); }
+};
+
 /// @}
 
+/// \brief Returns the registers read by the given instruction.
+///
+/// For `REG` and `DELAY`, this is the register read from a previous cycle. For `RAM`,
+/// the write port registers are also included. For `MEMO` and lazy `MUX`, the
+/// registers defined and read inside the bodies are not returned (and neither
+/// is `REGEN` input when it is computed by the body).
+[[nodiscard]] std::vector<reg_t> get_instruction_inputs(const Instruction &instruction);
+/// \brief Calls \a callback on each register read by the given instruction, the
+/// callback may modify the register to change the instruction operand.
+///
+/// The registers are visited in the same order as get_instruction_inputs().
+void rewrite_instruction_inputs(Instruction &instruction, const std::function<void(reg_t &)> &callback);
+/// \brief Returns a heap-allocated copy of the given instruction.
+[[nodiscard]] Instruction *clone_instruction(const Instruction &instruction);
+
 /// Meta information about a RAM or ROM memory block.
 struct MemoryInfo {
   /// The parent instruction (RAM or ROM) to who belongs this memory block.
@@ -208,7 +525,7 @@ struct MemoryInfo {
 };
 
 /// Possible flags for a register.
-/// \see RegisterInfo
+/// \see RegisterTable
 enum RegisterInfoFlag {
   RIF_NONE = 0x0,
   /// The register represents an input.
@@ -221,20 +538,57 @@ enum RegisterInfoFlag {
   RIF_INTERNAL = 0x4,
 };
 
-/// Meta information about a program's register.
-struct RegisterInfo {
-  /// The register's name (for debugging purposes). If the name is unknown,
-  /// an empty string can be used.
-  std::string name = {};
-  /// The size of the register. Must be in the range [1,64].
-  bus_size_t bus_size = 1;
+/// \brief Meta information about the registers of a program.
+///
+/// The bus sizes and the flags, read by the passes and the simulator, are kept
+/// in their own dense arrays. The names, only needed to print the program or to
+/// find a register, are stored one after the other in a single character arena
+/// and each register only keeps the index of its name (zero if it has none).
+class RegisterTable {
+public:
+  RegisterTable();
+
+  [[nodiscard]] std::size_t size() const { return m_bus_sizes.size(); }
+  [[nodiscard]] bool empty() const { return m_bus_sizes.empty(); }
+  void reserve(std::size_t count);
+
+  /// \brief Adds a register and returns it.
+  ///
+  /// The bus size must be in the range [1,64]. If the name is unknown, an
+  /// empty string can be used.
+  reg_t add(bus_size_t bus_size, std::string_view name = {}, unsigned flags = 0);
+
+  [[nodiscard]] bus_size_t get_bus_size(reg_t reg) const { return m_bus_sizes[reg.index]; }
+  /// \brief Returns the bus sizes of all registers, indexed by register.
+  [[nodiscard]] const std::vector<bus_size_t> &get_bus_sizes() const { return m_bus_sizes; }
+
   /// \see RegisterInfoFlag
-  unsigned flags = RIF_NONE;
+  [[nodiscard]] unsigned get_flags(reg_t reg) const { return m_flags[reg.index]; }
+  void set_flags(reg_t reg, unsigned flags) { m_flags[reg.index] = static_cast<std::uint_least8_t>(flags); }
+
+  /// \brief Returns the register's name, or an empty string if it has none.
+  [[nodiscard]] std::string_view get_name(reg_t reg) const;
+  /// \brief Changes the register's name, an empty string removing it.
+  ///
+  /// The characters of the previous name are only reclaimed by strip_names().
+  void set_name(reg_t reg, std::string_view name);
+
+  /// \brief Removes the names of all registers but the inputs and the outputs.
+  void strip_names();
+
+private:
+  std::vector<bus_size_t> m_bus_sizes;
+  std::vector<std::uint_least8_t> m_flags;
+  std::vector<std::uint_least32_t> m_name_ids;
+  /// The name `i` is made of the characters `[m_name_offsets[i - 1], m_name_offsets[i])`
+  /// of the arena, the name zero being the empty one.
+  std::vector<std::size_t> m_name_offsets;
+  std::string m_name_arena;
 };
 
 /// A Netlist program represented by a sequence of instructions to be simulated and a set of registers.
 struct Program {
-  std::vector<RegisterInfo> registers;
+  RegisterTable registers;
   std::vector<MemoryInfo> memories;
   std::vector<Instruction *> instructions;
 
@@ -247,6 +601,9 @@ struct Program {
   Program(const Program &) = delete;
   Program(Program &&) noexcept = default;
 
+  /// \brief Returns a deep copy of the program (instructions are copied too).
+  [[nodiscard]] std::shared_ptr<Program> clone() const;
+
   /// \brief Returns \c true if the program is empty, that is if it doesn't have any instruction.
   [[nodiscard]] bool is_empty() const { return instructions.empty(); }
 
@@ -265,8 +622,26 @@ struct Program {
   /// If the register has a name then it is returned, otherwise a dummy but
   /// valid identifier is returned uniquely identifying the register.
   [[nodiscard]] std::string get_register_name(reg_t reg) const;
+  /// \brief Returns the register named \a name or std::nullopt if there is none.
+  [[nodiscard]] std::optional<reg_t> find_register(std::string_view name) const;
 };
 
+/// \brief Renames all registers of \a program, the register `r` becoming `new_names[r.index]`.
+///
+/// The outputs and the operands of all instructions (including the ones in
+/// bodies) are renamed and the registers information is moved accordingly.
+/// Several registers may be merged into one, which keeps the information of
+/// the first of them, but the new names must be numbered without gaps.
+void rename_registers(Program &program, const std::vector<reg_t> &new_names);
+
+/// \brief Appends \a part, built by a ProgramBuilder following \a base_register_count registers, to \a program.
+///
+/// The first registers of \a program are the base ones, the registers of \a part
+/// are renumbered after all the registers of \a program (several parts built
+/// from the same base may be appended in turn). The instructions and the
+/// memories of \a part are moved to \a program.
+void append_program(Program &program, Program &part, reg_index_t base_register_count);
+
 /// \brief Utility class to simplify the creation of a Program instance.
 ///
 /// To create an instance of Program representing the following Netlist code:
@@ -290,6 +665,22 @@ struct Program {
 /// ```
 class ProgramBuilder {
 public:
+  ProgramBuilder() = default;
+  /// \brief Creates a builder that appends new registers and instructions to an
+  /// already existing program.
+  ///
+  /// This is useful for passes that need to add new instructions to the program.
+  explicit ProgramBuilder(const std::shared_ptr<Program> &program) : m_program(program) {}
+  /// \brief Creates a builder of a part of a program following the registers \a base_registers.
+  ///
+  /// The new registers are numbered after \a base_registers, which are only
+  /// read and may be used by the instructions. The built program only stores the
+  /// new registers and must be appended to the base program before use (see
+  /// append_program()). This is used by the Parser to parse the equations in
+  /// parallel.
+  explicit ProgramBuilder(const RegisterTable &base_registers)
+      : m_base_registers(&base_registers), m_first_register(static_cast<reg_index_t>(base_registers.size())) {}
+
   /// \brief Adds a new register to the program.
   ///
   /// \param bus_size The bus size of the register, must be included in the range [1,64].
@@ -302,6 +693,8 @@ public:
   /// It is undefined if \a reg was not created by add_register() in the same instance
   /// of ProgramBuilder.
   [[nodiscard]] bus_size_t get_register_bus_size(reg_t reg) const;
+  /// \brief Returns the registers added to the program, indexed from the first one added by this builder.
+  [[nodiscard]] const RegisterTable &get_registers() const { return m_program->registers; }
 
   ConstInstruction &add_const(reg_t output, reg_value_t value);
   LoadInstruction &add_load(reg_t output, reg_t input);
@@ -312,6 +705,16 @@ public:
   NorInstruction &add_nor(reg_t output, reg_t lhs, reg_t rhs);
   XorInstruction &add_xor(reg_t output, reg_t lhs, reg_t rhs);
   XnorInstruction &add_xnor(reg_t output, reg_t lhs, reg_t rhs);
+  AddInstruction &add_add(reg_t output, reg_t lhs, reg_t rhs);
+  SubInstruction &add_sub(reg_t output, reg_t lhs, reg_t rhs);
+  EqInstruction &add_eq(reg_t output, reg_t lhs, reg_t rhs);
+  LtInstruction &add_lt(reg_t output, reg_t lhs, reg_t rhs);
+  MulInstruction &add_mul(reg_t output, reg_t lhs, reg_t rhs);
+  ShlInstruction &add_shl(reg_t output, reg_t lhs, reg_t rhs);
+  ShrInstruction &add_shr(reg_t output, reg_t lhs, reg_t rhs);
+  AsrInstruction &add_asr(reg_t output, reg_t lhs, reg_t rhs);
+  ReduceOrInstruction &add_reduce_or(reg_t output, reg_t input);
+  ReduceAndInstruction &add_reduce_and(reg_t output, reg_t input);
   ConcatInstruction &add_concat(reg_t output, reg_t lhs, reg_t rhs);
   RegInstruction &add_reg(reg_t output, reg_t input);
   MuxInstruction &add_mux(reg_t output, reg_t choice, reg_t first, reg_t second);
@@ -320,6 +723,18 @@ public:
   RomInstruction &add_rom(reg_t output, bus_size_t addr_size, bus_size_t word_size, reg_t read_addr);
   RamInstruction &add_ram(reg_t output, bus_size_t addr_size, bus_size_t word_size, reg_t read_addr, reg_t write_enable,
                           reg_t write_addr, reg_t write_data);
+  /// \brief Adds a `GATHER` instruction.
+  ///
+  /// The GatherInstruction::Part::is_shift and GatherInstruction::Part::shift fields of
+  /// the given parts are computed by this function.
+  GatherInstruction &add_gather(reg_t output, std::vector<GatherInstruction::Part> parts, reg_value_t constant = 0);
+  DelayInstruction &add_delay(reg_t output, reg_t input, std::uint_least32_t depth);
+  /// \brief Adds a `LUT` instruction whose entry `i` is `entries[i]`.
+  ///
+  /// The count of entries must be `2^n` where `n` is the sum of the inputs bus sizes.
+  LutInstruction &add_lut(reg_t output, std::vector<reg_t> inputs, const std::vector<reg_value_t> &entries);
+  /// \brief Adds a `REGEN` instruction without body.
+  EnabledRegInstruction &add_enabled_reg(reg_t output, reg_t enable, reg_t input);
 
   /// \brief Builds the final Netlist program.
   ///
@@ -332,6 +747,9 @@ private:
 
 private:
   std::shared_ptr<Program> m_program = std::make_shared<Program>();
+  /// The registers preceding the ones of m_program, if it is a part of a program.
+  const RegisterTable *m_base_registers = nullptr;
+  reg_index_t m_first_register = 0;
 };
 
 #endif
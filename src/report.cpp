@@ -349,6 +349,9 @@ void Report::exit() {
 }
 
 void Report::exit(int error_code) {
+  if (const auto &handler = manager.get_exit_handler())
+    handler(*this);
+
   print(std::cerr);
   std::exit(error_code);
 }
@@ -358,9 +361,12 @@ void Report::exit(int error_code) {
 // ========================================================
 
 std::string_view ReportManager::get_line_at(uint32_t line_number) {
-  fill_line_map_if_needed();
+  // Scan the file until the start of the line is known.
+  constexpr uint64_t chunk_size = 64 * 1024;
+  while (m_line_map.get_line_count() < line_number && m_line_map.get_prefilled_end() < m_file_content.size())
+    fill_line_map_until(m_line_map.get_prefilled_end() + chunk_size);
 
-  uint32_t start_position = m_line_map.get_line_start_position(line_number);
+  uint64_t start_position = m_line_map.get_line_start_position(line_number);
 
   size_t line_length = 0;
   const char *begin = m_file_content.data() + start_position;
@@ -374,15 +380,22 @@ std::string_view ReportManager::get_line_at(uint32_t line_number) {
 }
 
 void ReportManager::resolve_source_location(SourceLocation location, uint32_t &line_number, uint32_t &column_number) {
-  fill_line_map_if_needed();
+  fill_line_map_until(location.offset);
 
   m_line_map.get_line_and_column_numbers(location.offset, line_number, column_number);
 }
 
-void ReportManager::fill_line_map_if_needed() {
-  if (m_line_map_filled)
+void ReportManager::fill_line_map_until(uint64_t position) {
+  if (m_source_file == nullptr) {
+    m_line_map.prefill(m_file_content, position);
     return;
+  }
 
-  m_line_map.prefill(m_file_content);
-  m_line_map_filled = true;
+  // Scan the file by windows, as the Lexer does.
+  position = std::min<uint64_t>(position, m_file_content.size());
+  while (m_line_map.get_prefilled_end() < position) {
+    const uint64_t start = m_line_map.get_prefilled_end();
+    m_line_map.prefill(m_file_content, std::min<uint64_t>(position, start + SourceFile::WINDOW_SIZE));
+    m_source_file->discard(start);
+  }
 }
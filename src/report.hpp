@@ -2,9 +2,11 @@
 #define NETLIST_REPORT_HPP
 
 #include "line_map.hpp"
+#include "source_file.hpp"
 #include "token.hpp"
 
 #include <cstdint>
+#include <functional>
 #include <iostream>
 #include <optional>
 #include <string_view>
@@ -231,13 +233,27 @@ public:
     m_file_name = file_name;
     m_file_content = file_content;
     m_line_map.clear();
-    m_line_map_filled = false;
+    m_source_file = nullptr;
+  }
+  /// Same as above, but the content of \a source_file is discarded as it is
+  /// scanned to resolve the source locations.
+  void register_file_info(std::string_view file_name, SourceFile &source_file) {
+    register_file_info(file_name, source_file.get_content());
+    m_source_file = &source_file;
   }
 
   ReportBuilder report(ReportSeverity severity) {
     return ReportBuilder(severity, *this);
   }
 
+  /// \brief Sets the function called by Report::exit() before printing the report and exiting.
+  ///
+  /// The handler may throw an exception to abandon the current operation
+  /// instead, for example when parsing speculatively (see Parser). Otherwise,
+  /// the program exits as usual.
+  void set_exit_handler(std::function<void(const Report &)> handler) { m_exit_handler = std::move(handler); }
+  [[nodiscard]] const std::function<void(const Report &)> &get_exit_handler() const { return m_exit_handler; }
+
   /// Gets the text of the requested line (1-numbered) for the current source
   /// file.
   [[nodiscard]] std::string_view get_line_at(uint32_t line_number);
@@ -247,14 +263,19 @@ public:
   [[nodiscard]] std::string_view get_file_name() const { return m_file_name; }
 
 private:
-  /// Fills the line map if it is not already.
-  void fill_line_map_if_needed();
+  /// Fills the line map up to the byte \a position of the source file.
+  ///
+  /// The line map is only filled when a report is emitted, and only up to the
+  /// last resolved location, so the reports at the start of a large file do not
+  /// scan all of it.
+  void fill_line_map_until(uint64_t position);
 
 private:
   std::string_view m_file_name;
   std::string_view m_file_content;
   LineMap m_line_map;
-  bool m_line_map_filled;
+  SourceFile *m_source_file = nullptr;
+  std::function<void(const Report &)> m_exit_handler;
 };
 
 /// @}
@@ -1,4 +1,5 @@
 #include "interpreter_backend.hpp"
+#include "utils.hpp"
 
 #include <cstring>
 
@@ -6,164 +7,317 @@
 // class InterpreterBackend::Detail
 // ========================================================
 
-struct InterpreterBackend::Detail final : ConstInstructionVisitor {
-  std::shared_ptr<Program> program;
-  size_t pc = 0; // the program counter
+struct InterpreterBackend::Detail final {
+  std::shared_ptr<const LoweredProgram> program;
   std::vector<reg_value_t> registers_value;
   std::vector<reg_value_t> saved_registers_value;
   std::vector<std::unique_ptr<reg_value_t[]>> memory_blocks;
   std::vector<std::unique_ptr<reg_value_t[]>> saved_memory_blocks;
 
-  /// Returns true if the end of the program was reached.
-  [[nodiscard]] bool at_end() const { return pc >= program->instructions.size(); }
-
-  void prepare(const std::shared_ptr<Program> &p) {
+  // All `DELAY` instructions reading the same register share a ring buffer
+  // holding the last values of that register. Instead of shifting the values
+  // at each cycle, the head index is moved and the newest value overwrites the
+  // oldest one. The capacity is a power of two so the index wraps with a mask.
+  struct DelayLine {
+    std::size_t head = 0; // the index of the value of the previous cycle
+    std::size_t index_mask = 0;
+    std::unique_ptr<reg_value_t[]> values;
+  };
+  std::vector<DelayLine> delay_lines;
+
+  // Each `MEMO` instruction has a direct-mapped cache from the concatenated
+  // bits of its inputs to its output value. The caches whose hit rate is below
+  // 50% after PROFILE_LOOKUPS lookups are disabled (the body is always evaluated).
+  static constexpr std::size_t PROFILE_LOOKUPS = 1024;
+  struct MemoCache {
+    struct Entry {
+      reg_value_t key = 0;
+      reg_value_t value = 0;
+      bool is_valid = false;
+    };
+    std::unique_ptr<Entry[]> entries;
+    unsigned hash_shift = 0; // 64 minus the base 2 logarithm of the count of entries
+    MemoStatistics statistics;
+  };
+  std::vector<MemoCache> memo_caches;
+
+  void prepare(const std::shared_ptr<const LoweredProgram> &p) {
     program = p;
-    pc = 0;
-    registers_value.resize(program->registers.size());
-    saved_registers_value.resize(program->registers.size());
     // Zero-initialize the registers just to be sure.
-    std::memset(registers_value.data(), 0, sizeof(reg_value_t) * registers_value.size());
-    std::memset(saved_registers_value.data(), 0, sizeof(reg_value_t) * saved_registers_value.size());
-
-    memory_blocks.resize(program->memories.size());
-    saved_memory_blocks.resize(program->memories.size());
-    for (uint_least32_t i = 0; i < program->memories.size(); ++i) {
-      const auto &memory_info = program->memories[i];
-      memory_blocks[i] = std::make_unique<reg_value_t[]>(memory_info.get_size());
-      saved_memory_blocks[i] = std::make_unique<reg_value_t[]>(memory_info.get_size());
+    registers_value.assign(program->slot_count, 0);
+    saved_registers_value.assign(program->slot_count, 0);
+    // The constants are shifted to their position in their slot.
+    for (const auto &[slot, value] : program->constants)
+      registers_value[slot] |= value;
+
+    memory_blocks.resize(program->memory_sizes.size());
+    saved_memory_blocks.resize(program->memory_sizes.size());
+    for (uint_least32_t i = 0; i < program->memory_sizes.size(); ++i) {
+      memory_blocks[i] = std::make_unique<reg_value_t[]>(program->memory_sizes[i]);
+      saved_memory_blocks[i] = std::make_unique<reg_value_t[]>(program->memory_sizes[i]);
     }
-  }
 
-  void step() {
-    program->instructions[pc]->visit(*this);
-    ++pc;
-  }
+    delay_lines.clear();
+    for (const auto &line : program->delay_lines)
+      delay_lines.push_back({0, line.capacity - 1, std::make_unique<reg_value_t[]>(line.capacity)});
 
-  void start_cycle() { pc = 0; }
+    memo_caches.clear();
+    for (const auto &instruction : program->instructions) {
+      if (instruction.opcode != LoweredOpcode::MEMO)
+        continue;
+
+      const auto &memo = program->memos[instruction.data];
+      auto &cache = memo_caches.emplace_back();
+      cache.entries = std::make_unique<MemoCache::Entry[]>(std::size_t(1) << memo.cache_bits);
+      cache.hash_shift = 64 - memo.cache_bits;
+      cache.statistics.output = {memo.output};
+    }
+  }
 
   void end_cycle() {
-    // Save registers.
-    std::memcpy(saved_registers_value.data(), registers_value.data(), sizeof(reg_value_t) * registers_value.size());
+    // Save the registers read by `REG` in the next cycle.
+    for (const auto reg : program->state_registers)
+      saved_registers_value[reg] = registers_value[reg];
 
     // Save memory blocks.
-    for (uint_least32_t i = 0; i < program->memories.size(); ++i) {
-      const auto &memory_info = program->memories[i];
-      std::memcpy(saved_memory_blocks[i].get(), memory_blocks[i].get(), sizeof(reg_value_t) * memory_info.get_size());
+    for (uint_least32_t i = 0; i < program->memory_sizes.size(); ++i) {
+      std::memcpy(saved_memory_blocks[i].get(), memory_blocks[i].get(),
+                  sizeof(reg_value_t) * program->memory_sizes[i]);
+    }
+
+    // Push the new values into the delay lines, this is O(1) whatever the depth.
+    for (std::size_t i = 0; i < delay_lines.size(); ++i) {
+      auto &line = delay_lines[i];
+      line.head = (line.head + 1) & line.index_mask;
+      line.values[line.head] = registers_value[program->delay_lines[i].input];
     }
   }
 
   void cycle() {
-    start_cycle();
-
-    while (!at_end())
-      step();
-
+    if (program->is_bit_packed)
+      execute<true>(0, program->instructions.size());
+    else
+      execute<false>(0, program->instructions.size());
     end_cycle();
   }
 
-  void visit_const(const ConstInstruction &inst) override { registers_value[inst.output.index] = inst.value; }
-
-  void visit_load(const LoadInstruction &inst) override {
-    registers_value[inst.output.index] = registers_value[inst.input.index];
-  }
-
-  void visit_not(const NotInstruction &inst) override {
-    registers_value[inst.output.index] = ~(registers_value[inst.input.index]);
-  }
-
-  void visit_and(const AndInstruction &inst) override {
-    const auto lhs = registers_value[inst.lhs.index];
-    const auto rhs = registers_value[inst.rhs.index];
-    registers_value[inst.output.index] = lhs & rhs;
-  }
-
-  void visit_nand(const NandInstruction &inst) override {
-    const auto lhs = registers_value[inst.lhs.index];
-    const auto rhs = registers_value[inst.rhs.index];
-    registers_value[inst.output.index] = ~(lhs & rhs);
-  }
-
-  void visit_or(const OrInstruction &inst) override {
-    const auto lhs = registers_value[inst.lhs.index];
-    const auto rhs = registers_value[inst.rhs.index];
-    registers_value[inst.output.index] = lhs | rhs;
-  }
-
-  void visit_nor(const NorInstruction &inst) override {
-    const auto lhs = registers_value[inst.lhs.index];
-    const auto rhs = registers_value[inst.rhs.index];
-    registers_value[inst.output.index] = ~(lhs | rhs);
+  /// Returns the concatenated bits of the given fields.
+  [[nodiscard]] reg_value_t concatenate(std::uint_least32_t first_field, std::uint_least32_t field_count) const {
+    reg_value_t result = 0;
+    for (std::size_t i = first_field; i < first_field + field_count; ++i) {
+      const auto &field = program->fields[i];
+      result |= (registers_value[field.input] & field.mask) << field.offset;
+    }
+    return result;
   }
 
-  void visit_xor(const XorInstruction &inst) override {
-    const auto lhs = registers_value[inst.lhs.index];
-    const auto rhs = registers_value[inst.rhs.index];
-    registers_value[inst.output.index] = lhs ^ rhs;
+  /// Returns the value of the operand \a i of \a inst, read from \a values.
+  template <bool IS_PACKED>
+  [[nodiscard]] static reg_value_t read_operand(const reg_value_t *values, const LoweredInstruction &inst,
+                                                unsigned i) {
+    if constexpr (IS_PACKED)
+      return values[inst.operands[i]] >> inst.shifts[i];
+    else
+      return values[inst.operands[i]];
   }
 
-  void visit_xnor(const XnorInstruction &inst) override {
-    const auto lhs = registers_value[inst.lhs.index];
-    const auto rhs = registers_value[inst.rhs.index];
-    registers_value[inst.output.index] = ~(lhs ^ rhs);
+  /// Executes the instructions in `[begin, end)`.
+  ///
+  /// When \a IS_PACKED is true, the program is bit-packed (see LoweredProgram):
+  /// the operands are shifted to the lowest bit and the outputs of a single bit
+  /// are merged into their slot.
+  template <bool IS_PACKED> void execute(std::size_t begin, std::size_t end) {
+    const auto *instructions = program->instructions.data();
+    auto *values = registers_value.data();
+    for (std::size_t pc = begin; pc < end; ++pc) {
+      const auto &inst = instructions[pc];
+      // The operands are read before the output is written.
+      const auto a = read_operand<IS_PACKED>(values, inst, 0) & inst.masks[0];
+      const auto b = read_operand<IS_PACKED>(values, inst, 1) & inst.masks[1];
+      // When bit-packed, the result is computed in a temporary (initialized to
+      // the current value for `REGEN`) then merged into the slot.
+      reg_value_t packed_output = IS_PACKED ? values[inst.output] >> inst.output_shift : 0;
+      auto &output = IS_PACKED ? packed_output : values[inst.output];
+
+      switch (inst.opcode) {
+      case LoweredOpcode::CONST:
+        output = inst.immediate;
+        break;
+      case LoweredOpcode::LOAD:
+        output = a;
+        break;
+      case LoweredOpcode::NOT:
+        output = ~a;
+        break;
+      case LoweredOpcode::AND:
+        output = a & b;
+        break;
+      case LoweredOpcode::NAND:
+        output = ~(a & b);
+        break;
+      case LoweredOpcode::OR:
+        output = a | b;
+        break;
+      case LoweredOpcode::NOR:
+        output = ~(a | b);
+        break;
+      case LoweredOpcode::XOR:
+        output = a ^ b;
+        break;
+      case LoweredOpcode::XNOR:
+        output = ~(a ^ b);
+        break;
+      case LoweredOpcode::ADD:
+        output = a + b;
+        break;
+      case LoweredOpcode::SUB:
+        output = a - b;
+        break;
+      case LoweredOpcode::MUL:
+        output = a * b;
+        break;
+      case LoweredOpcode::EQ:
+        output = a == b;
+        break;
+      case LoweredOpcode::LT:
+        output = a < b;
+        break;
+      case LoweredOpcode::SHL:
+        output = shift_left(a, b);
+        break;
+      case LoweredOpcode::SHR:
+        output = shift_right(a, b);
+        break;
+      case LoweredOpcode::ASR:
+        output = arithmetic_shift_right(a, b, inst.width);
+        break;
+      case LoweredOpcode::REDUCE_OR:
+        output = a != 0;
+        break;
+      case LoweredOpcode::REDUCE_AND:
+        output = a == inst.immediate;
+        break;
+      case LoweredOpcode::CONCAT:
+        output = a | (b << inst.immediate);
+        break;
+      case LoweredOpcode::SLICE:
+        output = a >> inst.immediate;
+        break;
+      case LoweredOpcode::SELECT:
+        output = (a >> inst.immediate) & 0b1;
+        break;
+      case LoweredOpcode::MUX:
+        output = a == 0 ? b : read_operand<IS_PACKED>(values, inst, 2);
+        break;
+      case LoweredOpcode::REG:
+        output = read_operand<IS_PACKED>(saved_registers_value.data(), inst, 0);
+        break;
+      case LoweredOpcode::DELAY: {
+        const auto &line = delay_lines[inst.data];
+        output = line.values[(line.head - (inst.immediate - 1)) & line.index_mask];
+        break;
+      }
+      case LoweredOpcode::LUT: {
+        // The inputs are masked as their high bits would overlap the next input.
+        const auto &lut = program->luts[inst.data];
+        output = lut.get_entry(concatenate(lut.first_field, lut.field_count));
+        break;
+      }
+      case LoweredOpcode::GATHER: {
+        const auto &gather = program->gathers[inst.data];
+        reg_value_t result = inst.immediate;
+        for (std::size_t i = gather.first_part; i < gather.first_part + gather.part_count; ++i) {
+          const auto &part = program->gather_parts[i];
+          const auto value = values[part.input.index] & part.extract_mask;
+          if (part.is_shift) {
+            result |= part.shift >= 0 ? (value << part.shift) : (value >> -part.shift);
+          } else {
+            result |= deposit_bits(extract_bits(value, part.extract_mask), part.deposit_mask);
+          }
+        }
+        output = result;
+        break;
+      }
+      case LoweredOpcode::ROM: {
+        const auto &port = program->memory_ports[inst.data];
+        const auto read_addr = values[port.read_addr] & port.read_addr_mask;
+        output = saved_memory_blocks[port.memory_block][read_addr];
+        break;
+      }
+      case LoweredOpcode::RAM: {
+        const auto &port = program->memory_ports[inst.data];
+        const auto read_addr = values[port.read_addr] & port.read_addr_mask;
+        const auto write_enable = values[port.write_enable] & port.write_enable_mask;
+        const auto write_addr = values[port.write_addr] & port.write_addr_mask;
+        const auto write_data = values[port.write_data];
+
+        output = saved_memory_blocks[port.memory_block][read_addr];
+        if (write_enable)
+          memory_blocks[port.memory_block][write_addr] = write_data;
+        break;
+      }
+      case LoweredOpcode::MEMO:
+        // The output has its own slot and is directly written.
+        execute_memo<IS_PACKED>(pc);
+        pc += inst.body_size;
+        continue;
+      case LoweredOpcode::LAZY_MUX:
+        if (a == 0) {
+          execute<IS_PACKED>(pc + 1, pc + 1 + inst.body_size);
+          output = read_operand<IS_PACKED>(values, inst, 1);
+        } else {
+          execute<IS_PACKED>(pc + 1 + inst.body_size, pc + 1 + inst.body_size + inst.data);
+          output = read_operand<IS_PACKED>(values, inst, 2);
+        }
+        pc += inst.body_size + inst.data;
+        break;
+      case LoweredOpcode::ENABLED_REG:
+        // The output keeps its value (the one of the associated `REG`) when disabled.
+        if (a != 0) {
+          execute<IS_PACKED>(pc + 1, pc + 1 + inst.body_size);
+          output = read_operand<IS_PACKED>(values, inst, 1);
+        }
+        pc += inst.body_size;
+        break;
+      }
+
+      if constexpr (IS_PACKED) {
+        if (inst.width == 1) {
+          const auto bit = reg_value_t(1) << inst.output_shift;
+          values[inst.output] = (values[inst.output] & ~bit) | ((packed_output << inst.output_shift) & bit);
+        } else {
+          values[inst.output] = packed_output;
+        }
+      }
+    }
   }
 
-  void visit_concat(const ConcatInstruction &inst) override {
-    const auto lhs = registers_value[inst.lhs.index];
-    const auto rhs = registers_value[inst.rhs.index];
-    registers_value[inst.output.index] = lhs | (rhs << inst.offset);
-  }
+  template <bool IS_PACKED> void execute_memo(std::size_t pc) {
+    const auto &inst = program->instructions[pc];
+    auto &cache = memo_caches[inst.data];
+    auto &statistics = cache.statistics;
+    if (statistics.is_disabled) {
+      ++statistics.misses;
+      execute<IS_PACKED>(pc + 1, pc + 1 + inst.body_size);
+      return;
+    }
 
-  void visit_reg(const RegInstruction &inst) override {
-    const auto previous_value = saved_registers_value[inst.input.index];
-    registers_value[inst.output.index] = previous_value;
-  }
+    const auto &memo = program->memos[inst.data];
+    const auto key = concatenate(memo.first_field, memo.field_count);
 
-  void visit_mux(const MuxInstruction &inst) override {
-    const auto choice = registers_value[inst.choice.index];
-    const auto first = registers_value[inst.first.index];
-    const auto second = registers_value[inst.second.index];
-    if (choice == 0) {
-      registers_value[inst.output.index] = first;
+    // Fibonacci hashing, the high bits of the product depend on all bits of the key.
+    auto &entry = cache.entries[(key * 0x9E3779B97F4A7C15) >> cache.hash_shift];
+    if (entry.is_valid && entry.key == key) {
+      ++statistics.hits;
+      registers_value[inst.output] = entry.value;
     } else {
-      registers_value[inst.output.index] = second;
+      ++statistics.misses;
+      execute<IS_PACKED>(pc + 1, pc + 1 + inst.body_size);
+      entry = {key, registers_value[inst.output], true};
     }
-  }
-
-  void visit_slice(const SliceInstruction &inst) override {
-    // The `+ 1` is because both end and first are inclusives.
-    const auto bit_width = inst.end - inst.start + 1;
-
-    const auto value = registers_value[inst.input.index];
-    // Mask is a binary integer whose least significant bit_width bits are set to 1.
-    const auto mask = (1 << (bit_width)) - 1;
-    registers_value[inst.output.index] = (value >> inst.start) & mask;
-  }
 
-  void visit_select(const SelectInstruction &inst) override {
-    const auto value = registers_value[inst.input.index];
-    registers_value[inst.output.index] = (value >> inst.i) & 0b1;
-  }
-
-  void visit_rom(const RomInstruction &inst) override {
-    const auto read_addr = registers_value[inst.read_addr.index];
-    const reg_value_t *memory_block = saved_memory_blocks[inst.memory_block].get();
-    registers_value[inst.output.index] = memory_block[read_addr];
-  }
-
-  void visit_ram(const RamInstruction &inst) override {
-    const auto read_addr = registers_value[inst.read_addr.index];
-    const auto write_enable = registers_value[inst.write_enable.index];
-    const auto write_addr = registers_value[inst.write_addr.index];
-    const auto write_data = registers_value[inst.write_data.index];
-
-    const reg_value_t *read_memory_block = saved_memory_blocks[inst.memory_block].get();
-    registers_value[inst.output.index] = read_memory_block[read_addr];
-
-    if (write_enable) {
-      reg_value_t *write_memory_block = memory_blocks[inst.memory_block].get();
-      write_memory_block[write_addr] = write_data;
-    }
+    if (statistics.hits + statistics.misses == PROFILE_LOOKUPS && statistics.hits < statistics.misses)
+      statistics.is_disabled = true;
   }
 };
 
@@ -184,7 +338,7 @@ reg_value_t *InterpreterBackend::get_registers() {
   return m_d->registers_value.data();
 }
 
-bool InterpreterBackend::prepare(const std::shared_ptr<Program> &program) {
+bool InterpreterBackend::prepare(const std::shared_ptr<const LoweredProgram> &program) {
   m_d->prepare(program);
   return true;
 }
@@ -192,3 +346,11 @@ bool InterpreterBackend::prepare(const std::shared_ptr<Program> &program) {
 void InterpreterBackend::cycle() {
   m_d->cycle();
 }
+
+std::vector<MemoStatistics> InterpreterBackend::get_memo_statistics() const {
+  std::vector<MemoStatistics> statistics;
+  statistics.reserve(m_d->memo_caches.size());
+  for (const auto &cache : m_d->memo_caches)
+    statistics.push_back(cache.statistics);
+  return statistics;
+}
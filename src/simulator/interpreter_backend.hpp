@@ -30,8 +30,9 @@ public:
   // ------------------------------------------------------
 
   [[nodiscard]] reg_value_t *get_registers() override;
-  bool prepare(const std::shared_ptr<Program> &program) override;
+  bool prepare(const std::shared_ptr<const LoweredProgram> &program) override;
   void cycle() override;
+  [[nodiscard]] std::vector<MemoStatistics> get_memo_statistics() const override;
 
 private:
   struct Detail;
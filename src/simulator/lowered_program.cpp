@@ -0,0 +1,593 @@
+#include "lowered_program.hpp"
+#include "passes/known_bits.hpp"
+
+#include <bit>
+#include <cassert>
+#include <fmt/format.h>
+#include <ostream>
+
+namespace {
+/// Counts the definitions of each register, including the ones in bodies.
+void count_definitions(const std::vector<Instruction *> &instructions, std::vector<std::uint_least32_t> &counts) {
+  for (const auto *instruction : instructions) {
+    ++counts[instruction->output.index];
+    if (const auto *memo = dynamic_cast<const MemoInstruction *>(instruction)) {
+      count_definitions(memo->body, counts);
+    } else if (const auto *lazy_mux = dynamic_cast<const LazyMuxInstruction *>(instruction)) {
+      count_definitions(lazy_mux->first_body, counts);
+      count_definitions(lazy_mux->second_body, counts);
+    } else if (const auto *enabled_reg = dynamic_cast<const EnabledRegInstruction *>(instruction)) {
+      count_definitions(enabled_reg->body, counts);
+    }
+  }
+}
+
+struct Lowerer final : ConstInstructionVisitor {
+  const Program &program;
+  const KnownBitsAnalysis known_bits;
+  LoweredProgram &lowered;
+  std::vector<std::uint_least32_t> definition_counts;
+  /// The index in LoweredProgram::delay_lines of the ring buffer of each register (if any).
+  std::vector<std::uint_least32_t> delay_line_indices;
+  std::vector<bool> is_state_register;
+
+  Lowerer(const Program &p, LoweredProgram &l)
+      : program(p), known_bits(KnownBitsAnalysis::analyze(p)), lowered(l),
+        definition_counts(p.registers.size(), 0), delay_line_indices(p.registers.size(), UINT_LEAST32_MAX),
+        is_state_register(p.registers.size(), false) {
+    count_definitions(p.instructions, definition_counts);
+  }
+
+  void lower(const std::vector<Instruction *> &instructions) {
+    for (const auto *instruction : instructions)
+      instruction->visit(*this);
+  }
+
+  LoweredInstruction &emit(LoweredOpcode opcode, const Instruction &inst, std::initializer_list<reg_t> operands) {
+    auto &lowered_inst = lowered.instructions.emplace_back();
+    lowered_inst.opcode = opcode;
+    lowered_inst.width = static_cast<std::uint_least8_t>(program.registers.get_bus_size(inst.output));
+    lowered_inst.output = inst.output.index;
+    std::size_t i = 0;
+    for (const auto operand : operands)
+      lowered_inst.operands[i++] = operand.index;
+    return lowered_inst;
+  }
+
+  void emit_binary(LoweredOpcode opcode, const BinaryInstruction &inst, bool mask_lhs = false, bool mask_rhs = false) {
+    auto &lowered_inst = emit(opcode, inst, {inst.lhs, inst.rhs});
+    if (mask_lhs)
+      lowered_inst.masks[0] = known_bits.get_mask(inst.lhs);
+    if (mask_rhs)
+      lowered_inst.masks[1] = known_bits.get_mask(inst.rhs);
+  }
+
+  /// Appends the fields concatenating the bits of \a inputs and returns the index of the first one.
+  std::uint_least32_t add_fields(const std::vector<reg_t> &inputs) {
+    const auto first_field = static_cast<std::uint_least32_t>(lowered.fields.size());
+    bus_size_t offset = 0;
+    for (const auto input : inputs) {
+      const auto bus_size = program.registers.get_bus_size(input);
+      lowered.fields.push_back({input.index, offset, get_bus_mask(bus_size)});
+      offset += bus_size;
+    }
+    return first_field;
+  }
+
+  /// Lowers \a body after the last lowered instruction and returns its size.
+  std::uint_least32_t lower_body(const std::vector<Instruction *> &body) {
+    const auto begin = lowered.instructions.size();
+    lower(body);
+    return static_cast<std::uint_least32_t>(lowered.instructions.size() - begin);
+  }
+
+  void visit_const(const ConstInstruction &inst) override {
+    // Nothing else writes the register, so it is enough to set it once.
+    const bool is_input = program.registers.get_flags(inst.output) & RIF_INPUT;
+    if (definition_counts[inst.output.index] == 1 && !is_input) {
+      lowered.constants.emplace_back(inst.output.index, inst.value);
+      return;
+    }
+
+    emit(LoweredOpcode::CONST, inst, {}).immediate = inst.value;
+  }
+
+  void visit_load(const LoadInstruction &inst) override { emit(LoweredOpcode::LOAD, inst, {inst.input}); }
+  void visit_not(const NotInstruction &inst) override { emit(LoweredOpcode::NOT, inst, {inst.input}); }
+  void visit_and(const AndInstruction &inst) override { emit_binary(LoweredOpcode::AND, inst); }
+  void visit_nand(const NandInstruction &inst) override { emit_binary(LoweredOpcode::NAND, inst); }
+  void visit_or(const OrInstruction &inst) override { emit_binary(LoweredOpcode::OR, inst); }
+  void visit_nor(const NorInstruction &inst) override { emit_binary(LoweredOpcode::NOR, inst); }
+  void visit_xor(const XorInstruction &inst) override { emit_binary(LoweredOpcode::XOR, inst); }
+  void visit_xnor(const XnorInstruction &inst) override { emit_binary(LoweredOpcode::XNOR, inst); }
+  // The low bits of the results only depend on the low bits of the operands, so no mask is needed.
+  void visit_add(const AddInstruction &inst) override { emit_binary(LoweredOpcode::ADD, inst); }
+  void visit_sub(const SubInstruction &inst) override { emit_binary(LoweredOpcode::SUB, inst); }
+  void visit_mul(const MulInstruction &inst) override { emit_binary(LoweredOpcode::MUL, inst); }
+  void visit_eq(const EqInstruction &inst) override { emit_binary(LoweredOpcode::EQ, inst, true, true); }
+  void visit_lt(const LtInstruction &inst) override { emit_binary(LoweredOpcode::LT, inst, true, true); }
+  void visit_shl(const ShlInstruction &inst) override { emit_binary(LoweredOpcode::SHL, inst, false, true); }
+  // The high bits of the left operand are shifted into the result, so they must be cleared.
+  void visit_shr(const ShrInstruction &inst) override { emit_binary(LoweredOpcode::SHR, inst, true, true); }
+  void visit_asr(const AsrInstruction &inst) override { emit_binary(LoweredOpcode::ASR, inst, false, true); }
+
+  void visit_reduce_or(const ReduceOrInstruction &inst) override {
+    emit(LoweredOpcode::REDUCE_OR, inst, {inst.input}).masks[0] = known_bits.get_mask(inst.input);
+  }
+
+  void visit_reduce_and(const ReduceAndInstruction &inst) override {
+    const auto mask = get_bus_mask(program.registers.get_bus_size(inst.input));
+    auto &lowered_inst = emit(LoweredOpcode::REDUCE_AND, inst, {inst.input});
+    lowered_inst.masks[0] = mask;
+    lowered_inst.immediate = mask;
+  }
+
+  void visit_concat(const ConcatInstruction &inst) override {
+    auto &lowered_inst = emit(LoweredOpcode::CONCAT, inst, {inst.lhs, inst.rhs});
+    lowered_inst.masks[0] = known_bits.get_mask(inst.lhs);
+    lowered_inst.immediate = inst.offset;
+  }
+
+  void visit_slice(const SliceInstruction &inst) override {
+    auto &lowered_inst = emit(LoweredOpcode::SLICE, inst, {inst.input});
+    lowered_inst.immediate = inst.start;
+    // The `+ 1` is because both end and first are inclusives.
+    lowered_inst.masks[0] = get_bus_mask(inst.end - inst.start + 1) << inst.start;
+  }
+
+  void visit_select(const SelectInstruction &inst) override {
+    emit(LoweredOpcode::SELECT, inst, {inst.input}).immediate = inst.i;
+  }
+
+  void visit_mux(const MuxInstruction &inst) override {
+    emit(LoweredOpcode::MUX, inst, {inst.choice, inst.first, inst.second}).masks[0] = known_bits.get_mask(inst.choice);
+  }
+
+  void visit_reg(const RegInstruction &inst) override {
+    emit(LoweredOpcode::REG, inst, {inst.input});
+    if (!is_state_register[inst.input.index]) {
+      is_state_register[inst.input.index] = true;
+      lowered.state_registers.push_back(inst.input.index);
+    }
+  }
+
+  void visit_delay(const DelayInstruction &inst) override {
+    // All `DELAY` instructions reading the same register share the same ring buffer.
+    auto &index = delay_line_indices[inst.input.index];
+    if (index == UINT_LEAST32_MAX) {
+      index = static_cast<std::uint_least32_t>(lowered.delay_lines.size());
+      lowered.delay_lines.push_back({inst.input.index, 1});
+    }
+
+    auto &line = lowered.delay_lines[index];
+    line.capacity = std::max(line.capacity, std::bit_ceil(std::size_t(inst.depth)));
+
+    auto &lowered_inst = emit(LoweredOpcode::DELAY, inst, {inst.input});
+    lowered_inst.immediate = inst.depth;
+    lowered_inst.data = index;
+  }
+
+  void visit_lut(const LutInstruction &inst) override {
+    auto &lut = lowered.luts.emplace_back();
+    lut.first_field = add_fields(inst.inputs);
+    lut.field_count = static_cast<std::uint_least32_t>(inst.inputs.size());
+    lut.table = inst.table;
+    lut.entry_shift = inst.entry_shift;
+    emit(LoweredOpcode::LUT, inst, {}).data = static_cast<std::uint_least32_t>(lowered.luts.size() - 1);
+  }
+
+  void visit_gather(const GatherInstruction &inst) override {
+    const auto first_part = static_cast<std::uint_least32_t>(lowered.gather_parts.size());
+    lowered.gather_parts.insert(lowered.gather_parts.end(), inst.parts.begin(), inst.parts.end());
+    lowered.gathers.push_back({first_part, static_cast<std::uint_least32_t>(inst.parts.size())});
+
+    auto &lowered_inst = emit(LoweredOpcode::GATHER, inst, {});
+    lowered_inst.immediate = inst.constant;
+    lowered_inst.data = static_cast<std::uint_least32_t>(lowered.gathers.size() - 1);
+  }
+
+  void visit_rom(const RomInstruction &inst) override {
+    const auto addr_size = program.memories[inst.memory_block].addr_size;
+    LoweredMemoryPort port;
+    port.memory_block = inst.memory_block;
+    port.read_addr = inst.read_addr.index;
+    port.read_addr_mask = known_bits.get_mask(inst.read_addr, addr_size);
+    lowered.memory_ports.push_back(port);
+    emit(LoweredOpcode::ROM, inst, {}).data =
+        static_cast<std::uint_least32_t>(lowered.memory_ports.size() - 1);
+  }
+
+  void visit_ram(const RamInstruction &inst) override {
+    const auto addr_size = program.memories[inst.memory_block].addr_size;
+    LoweredMemoryPort port;
+    port.memory_block = inst.memory_block;
+    port.read_addr = inst.read_addr.index;
+    port.read_addr_mask = known_bits.get_mask(inst.read_addr, addr_size);
+    port.write_enable = inst.write_enable.index;
+    port.write_enable_mask = known_bits.get_mask(inst.write_enable);
+    port.write_addr = inst.write_addr.index;
+    port.write_addr_mask = known_bits.get_mask(inst.write_addr, addr_size);
+    port.write_data = inst.write_data.index;
+    lowered.memory_ports.push_back(port);
+    emit(LoweredOpcode::RAM, inst, {}).data =
+        static_cast<std::uint_least32_t>(lowered.memory_ports.size() - 1);
+  }
+
+  void visit_memo(const MemoInstruction &inst) override {
+    const auto memo_index = static_cast<std::uint_least32_t>(lowered.memos.size());
+    lowered.memos.push_back({inst.output.index, add_fields(inst.inputs),
+                             static_cast<std::uint_least32_t>(inst.inputs.size()), inst.cache_bits});
+
+    const auto index = lowered.instructions.size();
+    emit(LoweredOpcode::MEMO, inst, {}).data = memo_index;
+    const auto body_size = lower_body(inst.body);
+    lowered.instructions[index].body_size = body_size;
+  }
+
+  void visit_lazy_mux(const LazyMuxInstruction &inst) override {
+    const auto index = lowered.instructions.size();
+    emit(LoweredOpcode::LAZY_MUX, inst, {inst.choice, inst.first, inst.second}).masks[0] =
+        known_bits.get_mask(inst.choice);
+    const auto first_body_size = lower_body(inst.first_body);
+    const auto second_body_size = lower_body(inst.second_body);
+    lowered.instructions[index].body_size = first_body_size;
+    lowered.instructions[index].data = second_body_size;
+  }
+
+  void visit_enabled_reg(const EnabledRegInstruction &inst) override {
+    const auto index = lowered.instructions.size();
+    emit(LoweredOpcode::ENABLED_REG, inst, {inst.enable, inst.input}).masks[0] = known_bits.get_mask(inst.enable);
+    const auto body_size = lower_body(inst.body);
+    lowered.instructions[index].body_size = body_size;
+  }
+};
+
+/// Returns the count of registers read by the given opcode that are stored in `operands`.
+unsigned get_operand_count(LoweredOpcode opcode);
+
+/// Packs the single bit registers of \a lowered 64 per slot and moves the
+/// operands of the instructions and of the side tables to their slot.
+void pack_bits(const Program &program, LoweredProgram &lowered) {
+  const auto register_count = program.registers.size();
+
+  // The single bit registers accessed through the side tables, which read and
+  // write whole slots, keep a slot of their own.
+  std::vector<bool> is_unpacked(register_count, false);
+  for (const auto &field : lowered.fields)
+    is_unpacked[field.input] = true;
+  for (const auto &part : lowered.gather_parts)
+    is_unpacked[part.input.index] = true;
+  for (const auto &line : lowered.delay_lines)
+    is_unpacked[line.input] = true;
+  for (const auto &port : lowered.memory_ports) {
+    is_unpacked[port.read_addr] = true;
+    if (port.write_enable != UINT_LEAST32_MAX) {
+      is_unpacked[port.write_enable] = true;
+      is_unpacked[port.write_addr] = true;
+      is_unpacked[port.write_data] = true;
+    }
+  }
+  for (const auto &memo : lowered.memos)
+    is_unpacked[memo.output] = true;
+
+  // The registers are numbered by first use at -O1 and above, so the bits
+  // packed together are likely to be used together.
+  reg_index_t slot_count = 0;
+  reg_index_t packed_slot = 0;
+  unsigned packed_bits = 64; // no packed slot yet
+  for (reg_index_t i = 0; i < register_count; ++i) {
+    auto &location = lowered.locations[i];
+    if (program.registers.get_bus_size({i}) != 1 || is_unpacked[i]) {
+      location = {slot_count++, 0};
+      continue;
+    }
+
+    if (packed_bits == 64) {
+      packed_slot = slot_count++;
+      packed_bits = 0;
+    }
+
+    location = {packed_slot, static_cast<std::uint_least8_t>(packed_bits++)};
+  }
+
+  lowered.slot_count = slot_count;
+  lowered.is_bit_packed = true;
+
+  const auto is_packed = [&](reg_index_t reg) {
+    return program.registers.get_bus_size({reg}) == 1 && !is_unpacked[reg];
+  };
+
+  for (auto &inst : lowered.instructions) {
+    const auto output_location = lowered.locations[inst.output];
+    inst.output = output_location.slot;
+    inst.output_shift = output_location.shift;
+
+    const auto operand_count = get_operand_count(inst.opcode);
+    for (unsigned i = 0; i < operand_count; ++i) {
+      const auto operand = inst.operands[i];
+      const auto location = lowered.locations[operand];
+      inst.operands[i] = location.slot;
+      inst.shifts[i] = location.shift;
+      // The bits above the shifted value belong to other registers.
+      if (i < inst.masks.size() && is_packed(operand))
+        inst.masks[i] &= 1;
+    }
+  }
+
+  for (auto &[reg, value] : lowered.constants) {
+    const auto location = lowered.locations[reg];
+    value = (value & get_bus_mask(program.registers.get_bus_size({reg}))) << location.shift;
+    reg = location.slot;
+  }
+
+  // Several state registers may share a slot, which is only saved once.
+  std::vector<bool> is_state_slot(slot_count, false);
+  std::vector<reg_index_t> state_slots;
+  for (const auto reg : lowered.state_registers) {
+    const auto slot = lowered.locations[reg].slot;
+    if (!is_state_slot[slot]) {
+      is_state_slot[slot] = true;
+      state_slots.push_back(slot);
+    }
+  }
+  lowered.state_registers = std::move(state_slots);
+
+  for (auto &field : lowered.fields)
+    field.input = lowered.locations[field.input].slot;
+  for (auto &part : lowered.gather_parts)
+    part.input = {lowered.locations[part.input.index].slot};
+  for (auto &line : lowered.delay_lines)
+    line.input = lowered.locations[line.input].slot;
+  for (auto &port : lowered.memory_ports) {
+    port.read_addr = lowered.locations[port.read_addr].slot;
+    if (port.write_enable != UINT_LEAST32_MAX) {
+      port.write_enable = lowered.locations[port.write_enable].slot;
+      port.write_addr = lowered.locations[port.write_addr].slot;
+      port.write_data = lowered.locations[port.write_data].slot;
+    }
+  }
+}
+
+const char *get_mnemonic(LoweredOpcode opcode) {
+  switch (opcode) {
+  case LoweredOpcode::CONST:
+    return "CONST";
+  case LoweredOpcode::LOAD:
+    return "LOAD";
+  case LoweredOpcode::NOT:
+    return "NOT";
+  case LoweredOpcode::AND:
+    return "AND";
+  case LoweredOpcode::NAND:
+    return "NAND";
+  case LoweredOpcode::OR:
+    return "OR";
+  case LoweredOpcode::NOR:
+    return "NOR";
+  case LoweredOpcode::XOR:
+    return "XOR";
+  case LoweredOpcode::XNOR:
+    return "XNOR";
+  case LoweredOpcode::ADD:
+    return "ADD";
+  case LoweredOpcode::SUB:
+    return "SUB";
+  case LoweredOpcode::MUL:
+    return "MUL";
+  case LoweredOpcode::EQ:
+    return "EQ";
+  case LoweredOpcode::LT:
+    return "LT";
+  case LoweredOpcode::SHL:
+    return "SHL";
+  case LoweredOpcode::SHR:
+    return "SHR";
+  case LoweredOpcode::ASR:
+    return "ASR";
+  case LoweredOpcode::REDUCE_OR:
+    return "REDOR";
+  case LoweredOpcode::REDUCE_AND:
+    return "REDAND";
+  case LoweredOpcode::CONCAT:
+    return "CONCAT";
+  case LoweredOpcode::SLICE:
+    return "SLICE";
+  case LoweredOpcode::SELECT:
+    return "SELECT";
+  case LoweredOpcode::MUX:
+  case LoweredOpcode::LAZY_MUX:
+    return "MUX";
+  case LoweredOpcode::REG:
+    return "REG";
+  case LoweredOpcode::DELAY:
+    return "DELAY";
+  case LoweredOpcode::LUT:
+    return "LUT";
+  case LoweredOpcode::GATHER:
+    return "GATHER";
+  case LoweredOpcode::ROM:
+    return "ROM";
+  case LoweredOpcode::RAM:
+    return "RAM";
+  case LoweredOpcode::MEMO:
+    return "MEMO";
+  case LoweredOpcode::ENABLED_REG:
+    return "REGEN";
+  }
+
+  assert(false && "unreachable");
+  return "";
+}
+
+/// Returns the count of registers read by the given opcode that are stored in `operands`.
+unsigned get_operand_count(LoweredOpcode opcode) {
+  switch (opcode) {
+  case LoweredOpcode::CONST:
+  case LoweredOpcode::LUT:
+  case LoweredOpcode::GATHER:
+  case LoweredOpcode::ROM:
+  case LoweredOpcode::RAM:
+  case LoweredOpcode::MEMO:
+    return 0;
+  case LoweredOpcode::LOAD:
+  case LoweredOpcode::NOT:
+  case LoweredOpcode::REDUCE_OR:
+  case LoweredOpcode::REDUCE_AND:
+  case LoweredOpcode::SLICE:
+  case LoweredOpcode::SELECT:
+  case LoweredOpcode::REG:
+  case LoweredOpcode::DELAY:
+    return 1;
+  case LoweredOpcode::MUX:
+  case LoweredOpcode::LAZY_MUX:
+    return 3;
+  default:
+    return 2;
+  }
+}
+
+/// Returns the slot \a reg, followed by the position of the value in the slot if bit-packed.
+std::string format_register(reg_index_t reg, reg_value_t mask = ~reg_value_t(0), unsigned shift = 0) {
+  const auto slot = shift == 0 ? fmt::format("%{}", reg) : fmt::format("%{}.{}", reg, shift);
+  if (mask == ~reg_value_t(0))
+    return slot;
+  return fmt::format("{}&{:#x}", slot, mask);
+}
+
+struct Dumper {
+  const LoweredProgram &program;
+  std::ostream &out;
+
+  /// Prints the instructions in `[begin, end)` indented by \a depth levels.
+  void dump(std::size_t begin, std::size_t end, unsigned depth) {
+    const std::string indent(2 * depth, ' ');
+    for (std::size_t i = begin; i < end; ++i) {
+      const auto &inst = program.instructions[i];
+      out << indent
+          << fmt::format("{}:{} = {}", format_register(inst.output, ~reg_value_t(0), inst.output_shift), inst.width,
+                         get_mnemonic(inst.opcode));
+      dump_operands(inst);
+
+      switch (inst.opcode) {
+      case LoweredOpcode::MEMO:
+      case LoweredOpcode::ENABLED_REG:
+        out << " {\n";
+        dump(i + 1, i + 1 + inst.body_size, depth + 1);
+        out << indent << "}";
+        i += inst.body_size;
+        break;
+      case LoweredOpcode::LAZY_MUX:
+        out << " {\n";
+        dump(i + 1, i + 1 + inst.body_size, depth + 1);
+        out << indent << "} {\n";
+        dump(i + 1 + inst.body_size, i + 1 + inst.body_size + inst.data, depth + 1);
+        out << indent << "}";
+        i += inst.body_size + inst.data;
+        break;
+      default:
+        break;
+      }
+
+      out << "\n";
+    }
+  }
+
+  void dump_operands(const LoweredInstruction &inst) {
+    switch (inst.opcode) {
+    case LoweredOpcode::CONST:
+      out << fmt::format(" {:#x}", inst.immediate);
+      return;
+    case LoweredOpcode::SLICE:
+      out << fmt::format(" {} {} {}", inst.immediate, inst.immediate + std::popcount(inst.masks[0]) - 1,
+                         format_register(inst.operands[0], ~reg_value_t(0), inst.shifts[0]));
+      return;
+    case LoweredOpcode::SELECT:
+    case LoweredOpcode::DELAY:
+      out << fmt::format(" {}", inst.immediate);
+      break;
+    case LoweredOpcode::ROM:
+    case LoweredOpcode::RAM: {
+      const auto &port = program.memory_ports[inst.data];
+      out << fmt::format(" #{} {}", port.memory_block, format_register(port.read_addr, port.read_addr_mask));
+      if (inst.opcode == LoweredOpcode::RAM) {
+        out << " " << format_register(port.write_enable, port.write_enable_mask);
+        out << " " << format_register(port.write_addr, port.write_addr_mask);
+        out << " " << format_register(port.write_data);
+      }
+      return;
+    }
+    case LoweredOpcode::LUT:
+    case LoweredOpcode::MEMO: {
+      const bool is_lut = inst.opcode == LoweredOpcode::LUT;
+      const auto first_field = is_lut ? program.luts[inst.data].first_field : program.memos[inst.data].first_field;
+      const auto field_count = is_lut ? program.luts[inst.data].field_count : program.memos[inst.data].field_count;
+      for (std::size_t i = first_field; i < first_field + field_count; ++i)
+        out << " " << format_register(program.fields[i].input, program.fields[i].mask);
+      return;
+    }
+    case LoweredOpcode::GATHER: {
+      const auto &gather = program.gathers[inst.data];
+      out << fmt::format(" {:#x}", inst.immediate);
+      for (std::size_t i = gather.first_part; i < gather.first_part + gather.part_count; ++i) {
+        const auto &part = program.gather_parts[i];
+        out << fmt::format(" {}:{:#x}->{:#x}", format_register(part.input.index), part.extract_mask, part.deposit_mask);
+      }
+      return;
+    }
+    default:
+      break;
+    }
+
+    const auto operand_count = get_operand_count(inst.opcode);
+    for (unsigned i = 0; i < operand_count; ++i)
+      out << " "
+          << format_register(inst.operands[i], i < inst.masks.size() ? inst.masks[i] : ~reg_value_t(0),
+                             inst.shifts[i]);
+    if (inst.opcode == LoweredOpcode::CONCAT)
+      out << fmt::format(" <<{}", inst.immediate);
+  }
+};
+} // namespace
+
+// ========================================================
+// class LoweredProgram
+// ========================================================
+
+LoweredProgram LoweredProgram::lower(const Program &program, bool pack_bits) {
+  LoweredProgram lowered;
+  lowered.register_count = program.registers.size();
+  lowered.slot_count = lowered.register_count;
+  lowered.locations.resize(lowered.register_count);
+  for (reg_index_t i = 0; i < lowered.register_count; ++i)
+    lowered.locations[i].slot = i;
+  lowered.instructions.reserve(program.instructions.size());
+  for (const auto &memory : program.memories)
+    lowered.memory_sizes.push_back(memory.get_size());
+
+  Lowerer lowerer(program, lowered);
+  lowerer.lower(program.instructions);
+  if (pack_bits)
+    ::pack_bits(program, lowered);
+  return lowered;
+}
+
+void LoweredProgram::dump(std::ostream &out) const {
+  out << fmt::format("; {} registers, {} instructions\n", register_count, instructions.size());
+  if (is_bit_packed)
+    out << fmt::format("; bit-packed into {} slots\n", slot_count);
+  for (std::size_t i = 0; i < memory_sizes.size(); ++i)
+    out << fmt::format("; memory #{}: {} words\n", i, memory_sizes[i]);
+  for (const auto &[reg, value] : constants)
+    out << fmt::format("; constant %{} = {:#x}\n", reg, value);
+  if (!state_registers.empty()) {
+    out << "; state";
+    for (const auto reg : state_registers)
+      out << " %" << reg;
+    out << "\n";
+  }
+  for (const auto &line : delay_lines)
+    out << fmt::format("; delay line %{}: {} values\n", line.input, line.capacity);
+
+  Dumper dumper = {*this, out};
+  dumper.dump(0, instructions.size(), 0);
+}
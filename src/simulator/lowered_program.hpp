@@ -0,0 +1,219 @@
+#ifndef NETLIST_SRC_SIMULATOR_LOWERED_PROGRAM_HPP
+#define NETLIST_SRC_SIMULATOR_LOWERED_PROGRAM_HPP
+
+#include "program.hpp"
+
+#include <array>
+#include <iosfwd>
+
+/// \addtogroup simulator
+/// @{
+
+/// The operation of a LoweredInstruction, one per Instruction subclass.
+enum class LoweredOpcode : std::uint_least8_t {
+  CONST,
+  LOAD,
+  NOT,
+  AND,
+  NAND,
+  OR,
+  NOR,
+  XOR,
+  XNOR,
+  ADD,
+  SUB,
+  MUL,
+  EQ,
+  LT,
+  SHL,
+  SHR,
+  ASR,
+  REDUCE_OR,
+  REDUCE_AND,
+  CONCAT,
+  SLICE,
+  SELECT,
+  MUX,
+  REG,
+  DELAY,
+  LUT,
+  GATHER,
+  ROM,
+  RAM,
+  MEMO,
+  LAZY_MUX,
+  ENABLED_REG,
+};
+
+/// \brief An instruction of a LoweredProgram.
+///
+/// All instructions have the same layout so the program is a flat array. The
+/// meaning of the fields depends on the opcode:
+/// - `operands` are the registers read, in the order of the Netlist syntax
+///   (`choice`, `first` and `second` for `MUX` and lazy `MUX`, `enable` and
+///   `input` for `REGEN`), except for `LUT`, `GATHER`, `ROM`, `RAM` and `MEMO`
+///   whose operands are in their side table;
+/// - `masks` are ANDed with the values of the two first operands before use,
+///   they are all ones when the high bits are not observable or known to be zero;
+/// - `immediate` is the value of `CONST`, the offset of `CONCAT`, the start of
+///   `SLICE`, the index of `SELECT`, the depth of `DELAY`, the constant bits of
+///   `GATHER` and the mask of the input of `REDUCE_AND`;
+/// - `data` is the index of the entry of the side table of `DELAY`, `LUT`,
+///   `GATHER`, `ROM`, `RAM` and `MEMO` and the size of the second body of lazy `MUX`;
+/// - `body_size` is the count of instructions following `MEMO`, lazy `MUX`
+///   (the first body, followed by the second one) and `REGEN` that belong to
+///   their body.
+///
+/// The output and the operands are slots of the register file (see
+/// LoweredLocation), the shifts giving the position of their value in the slot.
+struct LoweredInstruction {
+  LoweredOpcode opcode = LoweredOpcode::CONST;
+  /// The bus size of the output, at most 64 bits.
+  std::uint_least8_t width = 0;
+  std::uint_least8_t output_shift = 0;
+  std::array<std::uint_least8_t, 3> shifts = {};
+  reg_index_t output = 0;
+  std::array<reg_index_t, 3> operands = {};
+  std::array<reg_value_t, 2> masks = {~reg_value_t(0), ~reg_value_t(0)};
+  reg_value_t immediate = 0;
+  std::uint_least32_t data = 0;
+  std::uint_least32_t body_size = 0;
+};
+
+/// \brief Where the value of a register is stored in the register file of the backends.
+///
+/// The register file is an array of 64-bit words, the slots. Each register has
+/// its own slot, except when the program is lowered with bit packing: the
+/// single bit registers then share slots, 64 per slot.
+struct LoweredLocation {
+  reg_index_t slot = 0;
+  /// The position of the value in the slot, always zero if not bit-packed.
+  std::uint_least8_t shift = 0;
+};
+
+/// A register whose bits are concatenated to form the index of a `LUT` or the key of a `MEMO`.
+struct LoweredField {
+  reg_index_t input = 0;
+  /// The position of the lowest bit in the concatenation.
+  bus_size_t offset = 0;
+  /// The mask keeping the bus size bits of the value.
+  reg_value_t mask = 0;
+};
+
+/// \brief The read and write ports of a `ROM` or `RAM` memory block.
+///
+/// A `ROM` only has a read port (the write enable is then invalid). The
+/// addresses are masked to the address size of the block.
+struct LoweredMemoryPort {
+  std::uint_least32_t memory_block = 0;
+  reg_index_t read_addr = 0;
+  reg_value_t read_addr_mask = ~reg_value_t(0);
+  reg_index_t write_enable = UINT_LEAST32_MAX;
+  reg_value_t write_enable_mask = ~reg_value_t(0);
+  reg_index_t write_addr = 0;
+  reg_value_t write_addr_mask = ~reg_value_t(0);
+  reg_index_t write_data = 0;
+};
+
+/// \brief The ring buffer holding the last values of a register read by `DELAY` instructions.
+struct LoweredDelayLine {
+  reg_index_t input = 0;
+  /// The count of stored values, a power of two not less than the greatest depth.
+  std::size_t capacity = 0;
+};
+
+/// \brief The truth table of a `LUT` instruction (see LutInstruction).
+struct LoweredLut {
+  std::uint_least32_t first_field = 0;
+  std::uint_least32_t field_count = 0;
+  std::vector<reg_value_t> table;
+  std::uint_least8_t entry_shift = 6;
+
+  /// \brief Returns the entry at \a index.
+  [[nodiscard]] reg_value_t get_entry(std::size_t index) const {
+    const unsigned word_shift = 6 - entry_shift;
+    const auto word = table[index >> word_shift];
+    const auto bit = (index & ((std::size_t(1) << word_shift) - 1)) << entry_shift;
+    return (word >> bit) & get_bus_mask(1 << entry_shift);
+  }
+};
+
+/// \brief The cache parameters of a `MEMO` instruction (see MemoInstruction).
+struct LoweredMemo {
+  /// The register (not the slot) computed by the memoized cone.
+  reg_index_t output = 0;
+  std::uint_least32_t first_field = 0;
+  std::uint_least32_t field_count = 0;
+  std::uint_least8_t cache_bits = 8;
+};
+
+/// \brief The parts of a `GATHER` instruction (see GatherInstruction).
+struct LoweredGather {
+  std::uint_least32_t first_part = 0;
+  std::uint_least32_t part_count = 0;
+};
+
+// ========================================================
+// class LoweredProgram
+// ========================================================
+
+/// \brief A scheduled Program lowered to a flat form that backends simulate directly.
+///
+/// The facts that every backend needs are computed once here instead of being
+/// rederived from the Program instructions:
+/// - the instructions are stored by value, in order, with their operands,
+///   output width and masks (from KnownBitsAnalysis) explicit;
+/// - the bodies of `MEMO`, lazy `MUX` and `REGEN` directly follow their instruction;
+/// - the state elements are listed: the registers read by `REG` (the only ones
+///   whose value must be kept for the next cycle), the delay lines and the
+///   memory ports;
+/// - the registers only defined by a `CONST` are set once when the simulation
+///   starts and their instruction is removed.
+///
+/// By default, each register is stored in the slot of the index it has in the
+/// Program. The registers are only written by one instruction per cycle, except
+/// the ones shared by RegisterAllocationPass.
+///
+/// With bit packing, the single bit registers are stored 64 per slot, which
+/// divides the size of the register file by up to 64 for bit-level netlists
+/// (the parallel single bit operations being already merged into word
+/// operations by WordLevelPass). The instructions writing a single bit register
+/// then merge their result into its slot and the ones reading it shift it to
+/// the lowest bit and mask it. The single bit registers read or written through
+/// the side tables (`LUT`, `GATHER`, memory ports, delay lines and the output of
+/// `MEMO`) keep a slot of their own.
+class LoweredProgram {
+public:
+  /// \brief Lowers \a program, which must be scheduled.
+  ///
+  /// \param pack_bits Whether the single bit registers are packed 64 per slot.
+  [[nodiscard]] static LoweredProgram lower(const Program &program, bool pack_bits = false);
+
+  /// \brief Prints a textual representation of the program, for debugging purposes.
+  void dump(std::ostream &out) const;
+
+  std::size_t register_count = 0;
+  /// The count of words of the register file.
+  std::size_t slot_count = 0;
+  bool is_bit_packed = false;
+  /// The location of each register in the register file.
+  std::vector<LoweredLocation> locations;
+  std::vector<LoweredInstruction> instructions;
+  /// The slots of the registers only defined by a `CONST` and their value, shifted to its location.
+  std::vector<std::pair<reg_index_t, reg_value_t>> constants;
+  /// The slots of the registers read by `REG` instructions.
+  std::vector<reg_index_t> state_registers;
+  std::vector<LoweredDelayLine> delay_lines;
+  /// The count of words of each memory block.
+  std::vector<std::size_t> memory_sizes;
+  std::vector<LoweredMemoryPort> memory_ports;
+  std::vector<LoweredField> fields;
+  std::vector<LoweredLut> luts;
+  std::vector<LoweredMemo> memos;
+  std::vector<LoweredGather> gathers;
+  std::vector<GatherInstruction::Part> gather_parts;
+};
+
+/// @}
+
+#endif // NETLIST_SRC_SIMULATOR_LOWERED_PROGRAM_HPP
@@ -1,7 +1,9 @@
 #include "simulator.hpp"
 
+#include "dependency_graph.hpp"
 #include "interpreter_backend.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <fmt/format.h>
 
@@ -9,9 +11,10 @@
 // class Simulator
 // ========================================================
 
-Simulator::Simulator(const std::shared_ptr<Program> &program)
-    : m_program(program), m_backend(std::make_unique<InterpreterBackend>()) {
-  m_backend->prepare(m_program);
+Simulator::Simulator(const std::shared_ptr<Program> &program, bool pack_bits)
+    : m_original_program(program), m_program(program), m_pack_bits(pack_bits),
+      m_backend(std::make_unique<InterpreterBackend>()) {
+  prepare();
 }
 
 // ------------------------------------------------------
@@ -20,13 +23,59 @@ Simulator::Simulator(const std::shared_ptr<Program> &program)
 
 reg_value_t Simulator::get_register(reg_t reg) const {
   assert(is_valid_register(reg));
-  const auto mask = (1 << m_program->registers[reg.index].bus_size) - 1;
-  return m_backend->get_registers()[reg.index] & mask;
+  const auto location = m_lowered_program->locations[reg.index];
+  return (m_backend->get_registers()[location.slot] >> location.shift) &
+         get_bus_mask(m_program->registers.get_bus_size(reg));
 }
 
 void Simulator::set_register(reg_t reg, reg_value_t value) {
   assert(is_valid_register(reg));
-  m_backend->get_registers()[reg.index] = value;
+  // Backends assume that inputs are canonical (see KnownBitsAnalysis).
+  const auto bus_size = m_program->registers.get_bus_size(reg);
+  const auto location = m_lowered_program->locations[reg.index];
+  auto &slot = m_backend->get_registers()[location.slot];
+  if (m_lowered_program->is_bit_packed && bus_size == 1) {
+    const auto bit = reg_value_t(1) << location.shift;
+    slot = (slot & ~bit) | ((value << location.shift) & bit);
+  } else {
+    slot = value & get_bus_mask(bus_size);
+  }
+}
+
+void Simulator::fix_inputs(InputAssignment fixed_inputs) {
+  for (auto &[input, value] : fixed_inputs) {
+    assert(is_valid_register(input) && (m_original_program->registers.get_flags(input) & RIF_INPUT));
+    value &= get_bus_mask(m_original_program->registers.get_bus_size(input));
+  }
+
+  // Normalize the assignment so the same values given in another order hit the cache.
+  std::ranges::sort(fixed_inputs);
+
+  if (fixed_inputs.empty()) {
+    m_program = m_original_program;
+  } else if (auto it = m_specialized_programs.find(fixed_inputs); it != m_specialized_programs.end()) {
+    m_program = it->second;
+  } else {
+    auto program = m_original_program->clone();
+    InputSpecializationPass pass(fixed_inputs);
+    pass.run(program);
+
+    // The original program is schedulable and specializing it does not add
+    // any dependency, so no error can be reported.
+    ReportManager report_manager;
+    DependencyGraph graph = DependencyGraph::build(program);
+    graph.schedule(report_manager);
+
+    m_specialized_programs.emplace(std::move(fixed_inputs), program);
+    m_program = std::move(program);
+  }
+
+  prepare();
+}
+
+void Simulator::prepare() {
+  m_lowered_program = std::make_shared<const LoweredProgram>(LoweredProgram::lower(*m_program, m_pack_bits));
+  m_backend->prepare(m_lowered_program);
 }
 
 void Simulator::cycle() {
@@ -1,13 +1,26 @@
 #ifndef NETLIST_SRC_SIMULATOR_HPP
 #define NETLIST_SRC_SIMULATOR_HPP
 
+#include "lowered_program.hpp"
+#include "passes/input_specialization.hpp"
 #include "program.hpp"
 
 #include <cassert>
+#include <map>
 
 /// \addtogroup simulator The simulator
 /// @{
 
+/// \brief The counters of a memoized cone (see MemoInstruction).
+struct MemoStatistics {
+  /// The register computed by the cone.
+  reg_t output = {};
+  std::size_t hits = 0;
+  std::size_t misses = 0;
+  /// True if the cache was disabled because of its low hit rate.
+  bool is_disabled = false;
+};
+
 // ========================================================
 // class SimulatorBackend
 // ========================================================
@@ -36,8 +49,8 @@ public:
 
   /// \brief Returns the registers value.
   ///
-  /// The returned array should stores the registers value in the order of the
-  /// registers themself (registers are indexed).
+  /// The returned array should stores the registers value in the slots of the
+  /// prepared LoweredProgram (see LoweredLocation).
   ///
   /// Moreover, the returned array is mutable. That is, the returned pointer may
   /// be used to set the value of some registers and subclasses must account of
@@ -50,16 +63,16 @@ public:
   // The simulator API
   // ------------------------------------------------------
 
-  /// \brief Prepares the given Netlist program for simulation.
+  /// \brief Prepares the given lowered Netlist program for simulation.
   ///
   /// This function may be used to compile the given program to machine code
   /// or do any optimizations. After this call, all simulation will
-  /// be done on the given program.
+  /// be done on the given program, starting from a zero-initialized state.
   ///
   /// \param program The program that will be simulated.
   /// \return False in case of failure.
   /// \see cycle() and simulate()
-  virtual bool prepare(const std::shared_ptr<Program> &program) = 0;
+  virtual bool prepare(const std::shared_ptr<const LoweredProgram> &program) = 0;
   /// \brief Simulates a cycle of the Netlist program.
   ///
   /// How the Netlist program is effectively simulated is implementation defined.
@@ -83,6 +96,11 @@ public:
     while (n--)
       cycle();
   }
+
+  /// \brief Returns the counters of each memoized cone of the program.
+  ///
+  /// Backends that do not memoize the cones return an empty vector.
+  [[nodiscard]] virtual std::vector<MemoStatistics> get_memo_statistics() const { return {}; }
 };
 
 // ========================================================
@@ -107,9 +125,13 @@ public:
 /// \see SimulatorBackend
 class Simulator {
 public:
-  explicit Simulator(const std::shared_ptr<Program> &program);
+  /// \param pack_bits Whether the single bit registers are packed 64 per word (see LoweredProgram).
+  explicit Simulator(const std::shared_ptr<Program> &program, bool pack_bits = false);
 
   /// \brief Returns the current program being simulated.
+  ///
+  /// This is a specialized version of the program given to the constructor if
+  /// fix_inputs() was called.
   [[nodiscard]] std::shared_ptr<Program> get_program() const { return m_program; }
 
   /// \brief Returns the currently used simulator backend.
@@ -131,6 +153,19 @@ public:
   /// \param value The new register bits stored in the lowest bits.
   void set_register(reg_t reg, reg_value_t value);
 
+  /// \brief Fixes some inputs to a constant value for the whole simulation.
+  ///
+  /// The simulated program is specialized for the given values, so all the
+  /// logic that only depends on these inputs is folded away (see
+  /// InputSpecializationPass). The specialized programs are cached, so switching
+  /// back and forth between input assignments is cheap. An empty assignment
+  /// restores the original program.
+  ///
+  /// The registers keep their indices but the simulation state is reset.
+  ///
+  /// \param fixed_inputs The inputs (which must be inputs of the original program) and their values.
+  void fix_inputs(InputAssignment fixed_inputs);
+
   /// \brief Simulates a cycle of the Netlist program.
   ///
   /// This is exactly the same as `simulate(1)`.
@@ -147,8 +182,17 @@ public:
   void simulate(size_t n = 1);
 
 private:
+  /// Lowers the current program and prepares the backend for it.
+  void prepare();
+
+private:
+  std::shared_ptr<Program> m_original_program;
   std::shared_ptr<Program> m_program;
+  std::shared_ptr<const LoweredProgram> m_lowered_program;
+  bool m_pack_bits = false;
   std::unique_ptr<SimulatorBackend> m_backend;
+  /// The specialized programs indexed by their sorted input assignment.
+  std::map<InputAssignment, std::shared_ptr<Program>> m_specialized_programs;
 };
 
 /// @}
@@ -0,0 +1,129 @@
+#include "source_file.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+#if __has_include(<sys/mman.h>) && __has_include(<unistd.h>)
+#define NETLIST_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef NETLIST_HAS_MMAP
+/// Maps the regular file \a fd of \a size bytes followed by zero bytes up to the
+/// end of the next page, returns `nullptr` on failure.
+[[nodiscard]] static void *map_file(int fd, std::size_t size, std::size_t mapping_size) {
+  // Reserve zero-filled pages, then map the file over the first ones. The bytes
+  // past the end of the file in its last page are also zero.
+  void *mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapping == MAP_FAILED)
+    return nullptr;
+
+  if (size != 0) {
+    if (mmap(mapping, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+      munmap(mapping, mapping_size);
+      return nullptr;
+    }
+
+    // The lexer reads the file once from its start to its end.
+    madvise(mapping, size, MADV_SEQUENTIAL);
+  }
+
+  return mapping;
+}
+#endif
+
+std::optional<SourceFile> SourceFile::open(std::string_view path) {
+  const std::string path_string(path);
+  SourceFile file;
+
+#ifdef NETLIST_HAS_MMAP
+  const int fd = ::open(path_string.c_str(), O_RDONLY);
+  if (fd < 0)
+    return std::nullopt;
+
+  struct stat status = {};
+  if (fstat(fd, &status) == 0 && S_ISREG(status.st_mode)) {
+    const auto size = static_cast<std::size_t>(status.st_size);
+    const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    // Round up to the page size, keeping room for the NUL character.
+    const auto mapping_size = (size / page_size + 1) * page_size;
+    void *mapping = map_file(fd, size, mapping_size);
+    close(fd);
+    if (mapping == nullptr)
+      return std::nullopt;
+
+    file.m_data = static_cast<const char *>(mapping);
+    file.m_size = size;
+    file.m_mapping_size = mapping_size;
+    return file;
+  }
+
+  close(fd);
+#endif
+
+  // Not a regular file (or no mmap), read it into a buffer.
+  std::ifstream stream(path_string, std::ios_base::binary);
+  if (!stream)
+    return std::nullopt;
+
+  std::ostringstream buffer;
+  buffer << stream.rdbuf();
+  if (stream.bad())
+    return std::nullopt;
+
+  file.m_buffer = std::move(buffer).str();
+  file.m_data = file.m_buffer.c_str();
+  file.m_size = file.m_buffer.size();
+  return file;
+}
+
+void SourceFile::discard(std::uint64_t begin, std::uint64_t end) {
+#ifdef NETLIST_HAS_MMAP
+  if (m_mapping_size == 0)
+    return;
+
+  const auto page_size = static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+  const auto first = begin / page_size * page_size;
+  const auto last = std::min<std::uint64_t>(end, m_size) / page_size * page_size;
+  if (first < last)
+    madvise(const_cast<char *>(m_data) + first, last - first, MADV_DONTNEED);
+#else
+  (void)begin;
+  (void)end;
+#endif
+}
+
+SourceFile::SourceFile(SourceFile &&other) noexcept {
+  *this = std::move(other);
+}
+
+SourceFile &SourceFile::operator=(SourceFile &&other) noexcept {
+  if (this == &other)
+    return *this;
+
+  unmap();
+  m_size = std::exchange(other.m_size, 0);
+  m_mapping_size = std::exchange(other.m_mapping_size, 0);
+  m_buffer = std::move(other.m_buffer);
+  // Moving the buffer may move its content (small string optimization).
+  m_data = m_mapping_size != 0 ? other.m_data : m_buffer.c_str();
+  other.m_data = "";
+  return *this;
+}
+
+SourceFile::~SourceFile() {
+  unmap();
+}
+
+void SourceFile::unmap() {
+#ifdef NETLIST_HAS_MMAP
+  if (m_mapping_size != 0)
+    munmap(const_cast<char *>(m_data), m_mapping_size);
+#endif
+  m_mapping_size = 0;
+}
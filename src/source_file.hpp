@@ -0,0 +1,63 @@
+#ifndef NETLIST_SOURCE_FILE_HPP
+#define NETLIST_SOURCE_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/// \ingroup parser
+/// \brief The read-only content of a source file, followed by a NUL character.
+///
+/// When the system supports it, a regular file is memory-mapped instead of
+/// being copied into memory: loading a large netlist then only costs the page
+/// faults. The mapping is followed by at least one zero byte (the end of the
+/// last page of the file or an extra anonymous page) which is the sentinel
+/// required by the Lexer. The other files (pipes, etc.) are read into a buffer.
+///
+/// Large files are read as a stream: the Lexer and the ReportManager discard the
+/// pages they have already scanned (see discard()), so the memory used to load
+/// a file is bounded whatever its size.
+///
+/// The content must outlive the Lexer, the Parser and the ReportManager that
+/// reference it, because they all work directly on it through `std::string_view`.
+class SourceFile {
+public:
+  /// The count of bytes scanned between two discards when streaming the file.
+  static constexpr std::size_t WINDOW_SIZE = 64 * 1024 * 1024;
+
+  /// Opens the file at \a path, returns `std::nullopt` if it can not be read.
+  [[nodiscard]] static std::optional<SourceFile> open(std::string_view path);
+
+  SourceFile(SourceFile &&other) noexcept;
+  SourceFile &operator=(SourceFile &&other) noexcept;
+  ~SourceFile();
+
+  /// Returns the content of the file, `get_content().data()[get_content().size()]` is always `'\0'`.
+  [[nodiscard]] std::string_view get_content() const { return {m_data, m_size}; }
+
+  /// \brief Releases the memory of the content from the byte \a begin to the byte \a end.
+  ///
+  /// The pages are released from the one containing \a begin to the one
+  /// containing \a end, which is kept as it may still be read. The content is not
+  /// modified: the discarded pages are read again from the file if they are
+  /// accessed later (for example to print a report). This does nothing if the
+  /// file is not memory-mapped.
+  void discard(std::uint64_t begin, std::uint64_t end);
+  /// Same as above, from the start of the content.
+  void discard(std::uint64_t end) { discard(0, end); }
+
+private:
+  SourceFile() = default;
+  /// Releases the memory mapping, if any.
+  void unmap();
+
+  const char *m_data = "";
+  std::size_t m_size = 0;
+  /// The size of the memory mapping, zero if the content is stored in m_buffer.
+  std::size_t m_mapping_size = 0;
+  std::string m_buffer;
+};
+
+#endif // NETLIST_SOURCE_FILE_HPP
@@ -1,6 +1,7 @@
 #ifndef NETLIST_TOKEN_HPP
 #define NETLIST_TOKEN_HPP
 
+#include <cstdint>
 #include <string_view>
 
 /// \ingroup report parser
@@ -8,15 +9,17 @@
 ///
 /// Internally, this is represented as a byte offset from the start of the source
 /// code file. The mapping from the byte offset to more human-friendly line and
-/// column number is done by the LineMap class and the ReportManager.
+/// column number is done by the LineMap class and the ReportManager, only
+/// when a report is emitted. The offset has 64 bits to support files larger
+/// than 4 GiB.
 struct SourceLocation {
-  uint32_t offset;
+  uint64_t offset;
 
   [[nodiscard]] bool is_invalid() const {
-    return offset == UINT32_MAX;
+    return offset == UINT64_MAX;
   }
 
-  [[nodiscard]] static SourceLocation from_offset(uint32_t offset) {
+  [[nodiscard]] static SourceLocation from_offset(uint64_t offset) {
     return { offset };
   }
 };
@@ -28,7 +31,7 @@ struct SourceRange {
   uint32_t length;
 };
 
-static constexpr SourceLocation INVALID_LOCATION = { UINT32_MAX };
+static constexpr SourceLocation INVALID_LOCATION = { UINT64_MAX };
 
 /// \ingroup parser
 /// \brief The different supported token kinds.
@@ -81,6 +84,26 @@ enum class TokenKind {
   KEY_ROM,
   /// The keyword `RAM`.
   KEY_RAM,
+  /// The keyword `ADD`.
+  KEY_ADD,
+  /// The keyword `SUB`.
+  KEY_SUB,
+  /// The keyword `MUL`.
+  KEY_MUL,
+  /// The keyword `EQ`.
+  KEY_EQ,
+  /// The keyword `LT`.
+  KEY_LT,
+  /// The keyword `SHL`.
+  KEY_SHL,
+  /// The keyword `SHR`.
+  KEY_SHR,
+  /// The keyword `ASR`.
+  KEY_ASR,
+  /// The keyword `REDOR`.
+  KEY_REDOR,
+  /// The keyword `REDAND`.
+  KEY_REDAND,
 };
 
 /// \ingroup parser
@@ -1,6 +1,12 @@
 #ifndef NETLIST_SRC_UTILS_HPP
 #define NETLIST_SRC_UTILS_HPP
 
+#include <cstdint>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
 /// Returns true if the given ASCII character is a valid binary digit.
 [[nodiscard]] static inline bool is_bin_digit(char ch) {
   return ch == '0' || ch == '1';
@@ -16,4 +22,50 @@
   return is_digit(ch) || (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F');
 }
 
+/// Returns true if the given ASCII character is a valid first character for
+/// an identifier.
+[[nodiscard]] static inline bool is_start_ident(char ch) {
+  return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch == '_');
+}
+
+/// Returns true if the given ASCII character is a valid middle character for
+/// an identifier.
+[[nodiscard]] static inline bool is_cont_ident(char ch) {
+  return is_start_ident(ch) || is_digit(ch) || ch == '\'';
+}
+
+/// Gathers the bits of \a value selected by \a mask into the lowest bits of the result.
+///
+/// This is the `PEXT` instruction of x86 BMI2 and it is used when available.
+[[nodiscard]] static inline std::uint64_t extract_bits(std::uint64_t value, std::uint64_t mask) {
+#if defined(__BMI2__)
+  return _pext_u64(value, mask);
+#else
+  std::uint64_t result = 0;
+  for (std::uint64_t bit = 1; mask != 0; bit <<= 1) {
+    if (value & mask & -mask)
+      result |= bit;
+    mask &= mask - 1; // clear the lowest set bit
+  }
+  return result;
+#endif
+}
+
+/// Scatters the lowest bits of \a value to the bits selected by \a mask.
+///
+/// This is the `PDEP` instruction of x86 BMI2 and it is used when available.
+[[nodiscard]] static inline std::uint64_t deposit_bits(std::uint64_t value, std::uint64_t mask) {
+#if defined(__BMI2__)
+  return _pdep_u64(value, mask);
+#else
+  std::uint64_t result = 0;
+  for (std::uint64_t bit = 1; mask != 0; bit <<= 1) {
+    if (value & bit)
+      result |= mask & -mask;
+    mask &= mask - 1; // clear the lowest set bit
+  }
+  return result;
+#endif
+}
+
 #endif // NETLIST_SRC_UTILS_HPP
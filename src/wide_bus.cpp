@@ -0,0 +1,366 @@
+#include "wide_bus.hpp"
+
+#include <fmt/format.h>
+
+#include <cassert>
+
+WideBus WideBusBuilder::add_register(bus_size_t bus_size, std::string_view name, unsigned flags) {
+  assert(bus_size > 0);
+
+  WideBus bus;
+  bus.bus_size = bus_size;
+  for (std::size_t i = 0; i < bus.get_limb_count(); ++i) {
+    std::string limb_name;
+    if (!name.empty())
+      limb_name = i == 0 ? std::string(name) : get_limb_name(name, i * WideBus::LIMB_SIZE);
+
+    const auto limb = m_builder.add_register(bus.get_limb_size(i), limb_name, flags);
+    if (i == 0)
+      bus.first = limb;
+    // The limbs are found from the first one.
+    assert(limb == bus.get_limb(i));
+  }
+
+  return bus;
+}
+
+std::string WideBusBuilder::get_limb_name(std::string_view name, bus_size_t offset) {
+  return fmt::format("{}'{}", name, offset);
+}
+
+void WideBusBuilder::add_const(const WideBus &output, const std::vector<reg_value_t> &limbs) {
+  assert(limbs.size() == output.get_limb_count());
+
+  for (std::size_t i = 0; i < limbs.size(); ++i)
+    m_builder.add_const(output.get_limb(i), limbs[i] & get_bus_mask(output.get_limb_size(i)));
+}
+
+void WideBusBuilder::add_load(const WideBus &output, const WideBus &input) {
+  assert(output.bus_size == input.bus_size);
+
+  for (std::size_t i = 0; i < output.get_limb_count(); ++i)
+    m_builder.add_load(output.get_limb(i), input.get_limb(i));
+}
+
+void WideBusBuilder::add_not(const WideBus &output, const WideBus &input) {
+  assert(output.bus_size == input.bus_size);
+
+  for (std::size_t i = 0; i < output.get_limb_count(); ++i)
+    m_builder.add_not(output.get_limb(i), input.get_limb(i));
+}
+
+void WideBusBuilder::add_reg(const WideBus &output, const WideBus &input) {
+  assert(output.bus_size == input.bus_size);
+
+  for (std::size_t i = 0; i < output.get_limb_count(); ++i)
+    m_builder.add_reg(output.get_limb(i), input.get_limb(i));
+}
+
+template <class F>
+void WideBusBuilder::add_limbwise(const WideBus &output, const WideBus &lhs, const WideBus &rhs, F add_limb) {
+  assert(output.bus_size == lhs.bus_size && output.bus_size == rhs.bus_size);
+
+  for (std::size_t i = 0; i < output.get_limb_count(); ++i)
+    add_limb(output.get_limb(i), lhs.get_limb(i), rhs.get_limb(i));
+}
+
+void WideBusBuilder::add_and(const WideBus &output, const WideBus &lhs, const WideBus &rhs) {
+  add_limbwise(output, lhs, rhs, [this](reg_t o, reg_t a, reg_t b) { m_builder.add_and(o, a, b); });
+}
+
+void WideBusBuilder::add_nand(const WideBus &output, const WideBus &lhs, const WideBus &rhs) {
+  add_limbwise(output, lhs, rhs, [this](reg_t o, reg_t a, reg_t b) { m_builder.add_nand(o, a, b); });
+}
+
+void WideBusBuilder::add_or(const WideBus &output, const WideBus &lhs, const WideBus &rhs) {
+  add_limbwise(output, lhs, rhs, [this](reg_t o, reg_t a, reg_t b) { m_builder.add_or(o, a, b); });
+}
+
+void WideBusBuilder::add_nor(const WideBus &output, const WideBus &lhs, const WideBus &rhs) {
+  add_limbwise(output, lhs, rhs, [this](reg_t o, reg_t a, reg_t b) { m_builder.add_nor(o, a, b); });
+}
+
+void WideBusBuilder::add_xor(const WideBus &output, const WideBus &lhs, const WideBus &rhs) {
+  add_limbwise(output, lhs, rhs, [this](reg_t o, reg_t a, reg_t b) { m_builder.add_xor(o, a, b); });
+}
+
+void WideBusBuilder::add_xnor(const WideBus &output, const WideBus &lhs, const WideBus &rhs) {
+  add_limbwise(output, lhs, rhs, [this](reg_t o, reg_t a, reg_t b) { m_builder.add_xnor(o, a, b); });
+}
+
+reg_t WideBusBuilder::add_zero_extension(reg_t bit, bus_size_t bus_size) {
+  if (bus_size == 1)
+    return bit;
+
+  const auto zero = m_builder.add_register(bus_size - 1);
+  m_builder.add_const(zero, 0);
+  const auto extension = m_builder.add_register(bus_size);
+  m_builder.add_concat(extension, bit, zero);
+  return extension;
+}
+
+void WideBusBuilder::add_add(const WideBus &output, const WideBus &lhs, const WideBus &rhs) {
+  assert(output.bus_size == lhs.bus_size && output.bus_size == rhs.bus_size);
+
+  // Each limb is the sum of the operand limbs and of the carry of the previous
+  // limb. A sum overflows if and only if it is less than one of its operands.
+  reg_t carry = {};
+  for (std::size_t i = 0; i < output.get_limb_count(); ++i) {
+    const auto size = output.get_limb_size(i);
+    const auto a = lhs.get_limb(i);
+    const auto b = rhs.get_limb(i);
+    const auto o = output.get_limb(i);
+    const bool is_last = i + 1 == output.get_limb_count();
+
+    if (i == 0) {
+      m_builder.add_add(o, a, b);
+      carry = m_builder.add_register(1);
+      m_builder.add_lt(carry, o, a);
+      continue;
+    }
+
+    const auto partial_sum = m_builder.add_register(size);
+    m_builder.add_add(partial_sum, a, b);
+    m_builder.add_add(o, partial_sum, add_zero_extension(carry, size));
+    if (is_last)
+      break;
+
+    const auto first_carry = m_builder.add_register(1);
+    m_builder.add_lt(first_carry, partial_sum, a);
+    const auto second_carry = m_builder.add_register(1);
+    m_builder.add_lt(second_carry, o, partial_sum);
+    carry = m_builder.add_register(1);
+    m_builder.add_or(carry, first_carry, second_carry);
+  }
+}
+
+void WideBusBuilder::add_sub(const WideBus &output, const WideBus &lhs, const WideBus &rhs) {
+  assert(output.bus_size == lhs.bus_size && output.bus_size == rhs.bus_size);
+
+  // Same as add_add() but with a borrow, a difference underflows if and only if
+  // the subtrahend is greater than the minuend.
+  reg_t borrow = {};
+  for (std::size_t i = 0; i < output.get_limb_count(); ++i) {
+    const auto size = output.get_limb_size(i);
+    const auto a = lhs.get_limb(i);
+    const auto b = rhs.get_limb(i);
+    const auto o = output.get_limb(i);
+    const bool is_last = i + 1 == output.get_limb_count();
+
+    if (i == 0) {
+      m_builder.add_sub(o, a, b);
+      borrow = m_builder.add_register(1);
+      m_builder.add_lt(borrow, a, b);
+      continue;
+    }
+
+    const auto partial_difference = m_builder.add_register(size);
+    m_builder.add_sub(partial_difference, a, b);
+    const auto extended_borrow = add_zero_extension(borrow, size);
+    m_builder.add_sub(o, partial_difference, extended_borrow);
+    if (is_last)
+      break;
+
+    const auto first_borrow = m_builder.add_register(1);
+    m_builder.add_lt(first_borrow, a, b);
+    const auto second_borrow = m_builder.add_register(1);
+    m_builder.add_lt(second_borrow, partial_difference, extended_borrow);
+    borrow = m_builder.add_register(1);
+    m_builder.add_or(borrow, first_borrow, second_borrow);
+  }
+}
+
+void WideBusBuilder::add_reduction(reg_t output, const std::vector<reg_t> &bits, bool is_and) {
+  assert(!bits.empty());
+
+  if (bits.size() == 1) {
+    m_builder.add_load(output, bits.front());
+    return;
+  }
+
+  reg_t result = bits.front();
+  for (std::size_t i = 1; i < bits.size(); ++i) {
+    const auto next = i + 1 == bits.size() ? output : m_builder.add_register(1);
+    if (is_and)
+      m_builder.add_and(next, result, bits[i]);
+    else
+      m_builder.add_or(next, result, bits[i]);
+    result = next;
+  }
+}
+
+void WideBusBuilder::add_eq(reg_t output, const WideBus &lhs, const WideBus &rhs) {
+  assert(lhs.bus_size == rhs.bus_size);
+
+  std::vector<reg_t> limb_equalities;
+  for (std::size_t i = 0; i < lhs.get_limb_count(); ++i) {
+    const auto equality = m_builder.add_register(1);
+    m_builder.add_eq(equality, lhs.get_limb(i), rhs.get_limb(i));
+    limb_equalities.push_back(equality);
+  }
+
+  add_reduction(output, limb_equalities, /*is_and=*/true);
+}
+
+void WideBusBuilder::add_lt(reg_t output, const WideBus &lhs, const WideBus &rhs) {
+  assert(lhs.bus_size == rhs.bus_size);
+
+  // The comparison of the limbs up to i is the comparison of the limbs i if
+  // they differ, otherwise the comparison of the limbs below.
+  reg_t result = {};
+  for (std::size_t i = 0; i < lhs.get_limb_count(); ++i) {
+    const auto a = lhs.get_limb(i);
+    const auto b = rhs.get_limb(i);
+    const bool is_last = i + 1 == lhs.get_limb_count();
+
+    const auto limb_less = i == 0 && is_last ? output : m_builder.add_register(1);
+    m_builder.add_lt(limb_less, a, b);
+    if (i == 0) {
+      result = limb_less;
+      continue;
+    }
+
+    const auto limb_equal = m_builder.add_register(1);
+    m_builder.add_eq(limb_equal, a, b);
+    const auto less_below = m_builder.add_register(1);
+    m_builder.add_and(less_below, limb_equal, result);
+    result = is_last ? output : m_builder.add_register(1);
+    m_builder.add_or(result, limb_less, less_below);
+  }
+}
+
+void WideBusBuilder::add_reduce_or(reg_t output, const WideBus &input) {
+  std::vector<reg_t> limb_reductions;
+  for (std::size_t i = 0; i < input.get_limb_count(); ++i) {
+    const auto reduction = m_builder.add_register(1);
+    m_builder.add_reduce_or(reduction, input.get_limb(i));
+    limb_reductions.push_back(reduction);
+  }
+
+  add_reduction(output, limb_reductions, /*is_and=*/false);
+}
+
+void WideBusBuilder::add_reduce_and(reg_t output, const WideBus &input) {
+  std::vector<reg_t> limb_reductions;
+  for (std::size_t i = 0; i < input.get_limb_count(); ++i) {
+    const auto reduction = m_builder.add_register(1);
+    m_builder.add_reduce_and(reduction, input.get_limb(i));
+    limb_reductions.push_back(reduction);
+  }
+
+  add_reduction(output, limb_reductions, /*is_and=*/true);
+}
+
+void WideBusBuilder::add_mux(const WideBus &output, reg_t choice, const WideBus &first, const WideBus &second) {
+  assert(output.bus_size == first.bus_size && output.bus_size == second.bus_size);
+
+  for (std::size_t i = 0; i < output.get_limb_count(); ++i)
+    m_builder.add_mux(output.get_limb(i), choice, first.get_limb(i), second.get_limb(i));
+}
+
+void WideBusBuilder::add_bit_range(reg_t output, const std::vector<WideBus> &parts, bus_size_t start,
+                                   bus_size_t count) {
+  const auto output_size = m_builder.get_register_bus_size(output);
+  assert(count <= output_size);
+  const auto end = start + count;
+
+  // The registers whose concatenation is the output, the lowest bits first,
+  // with the slice of the limb they are made of (if not the whole limb).
+  struct Piece {
+    reg_t limb;
+    bus_size_t start;
+    bus_size_t size;
+    bool is_whole_limb;
+  };
+
+  std::vector<Piece> pieces;
+  bus_size_t piece_sizes = 0;
+  bus_size_t part_start = 0;
+  for (const auto &part : parts) {
+    for (std::size_t i = 0; i < part.get_limb_count(); ++i) {
+      const auto limb_start = part_start + static_cast<bus_size_t>(i * WideBus::LIMB_SIZE);
+      const auto limb_size = part.get_limb_size(i);
+      const auto first_bit = std::max(start, limb_start);
+      const auto last_bit = std::min(end, limb_start + limb_size);
+      if (first_bit >= last_bit)
+        continue;
+
+      pieces.push_back({part.get_limb(i), first_bit - limb_start, last_bit - first_bit,
+                        first_bit == limb_start && last_bit == limb_start + limb_size});
+      piece_sizes += last_bit - first_bit;
+    }
+
+    part_start += part.bus_size;
+  }
+
+  if (piece_sizes < output_size) {
+    const auto zero = m_builder.add_register(output_size - piece_sizes);
+    m_builder.add_const(zero, 0);
+    pieces.push_back({zero, 0, output_size - piece_sizes, true});
+  }
+
+  // A single piece is directly stored into the output.
+  const auto add_piece = [this](reg_t piece_output, const Piece &piece) {
+    if (piece.is_whole_limb)
+      m_builder.add_load(piece_output, piece.limb);
+    else
+      m_builder.add_slice(piece_output, piece.start, piece.start + piece.size - 1, piece.limb);
+  };
+
+  if (pieces.size() == 1) {
+    add_piece(output, pieces.front());
+    return;
+  }
+
+  const auto get_piece_register = [this, &add_piece](const Piece &piece) {
+    if (piece.is_whole_limb)
+      return piece.limb;
+
+    const auto reg = m_builder.add_register(piece.size);
+    add_piece(reg, piece);
+    return reg;
+  };
+
+  reg_t result = get_piece_register(pieces.front());
+  bus_size_t result_size = pieces.front().size;
+  for (std::size_t i = 1; i < pieces.size(); ++i) {
+    result_size += pieces[i].size;
+    const auto next = i + 1 == pieces.size() ? output : m_builder.add_register(result_size);
+    m_builder.add_concat(next, result, get_piece_register(pieces[i]));
+    result = next;
+  }
+}
+
+void WideBusBuilder::add_concat(const WideBus &output, const WideBus &lhs, const WideBus &rhs) {
+  const auto count = std::min(output.bus_size, lhs.bus_size + rhs.bus_size);
+  for (std::size_t i = 0; i < output.get_limb_count(); ++i) {
+    const auto start = static_cast<bus_size_t>(i * WideBus::LIMB_SIZE);
+    const auto limb_count = start < count ? std::min(output.get_limb_size(i), count - start) : 0;
+    add_bit_range(output.get_limb(i), {lhs, rhs}, start, limb_count);
+  }
+}
+
+void WideBusBuilder::add_slice(const WideBus &output, bus_size_t start, bus_size_t end, const WideBus &input) {
+  // Both start and end are inclusive.
+  const auto count = std::min(output.bus_size, end >= start ? end - start + 1 : 0);
+  for (std::size_t i = 0; i < output.get_limb_count(); ++i) {
+    const auto offset = static_cast<bus_size_t>(i * WideBus::LIMB_SIZE);
+    const auto limb_count = offset < count ? std::min(output.get_limb_size(i), count - offset) : 0;
+    add_bit_range(output.get_limb(i), {input}, start + offset, limb_count);
+  }
+}
+
+void WideBusBuilder::add_rom(const WideBus &output, bus_size_t addr_size, reg_t read_addr) {
+  for (std::size_t i = 0; i < output.get_limb_count(); ++i)
+    m_builder.add_rom(output.get_limb(i), addr_size, output.get_limb_size(i), read_addr);
+}
+
+void WideBusBuilder::add_ram(const WideBus &output, bus_size_t addr_size, reg_t read_addr, reg_t write_enable,
+                             reg_t write_addr, const WideBus &write_data) {
+  assert(output.bus_size == write_data.bus_size);
+
+  for (std::size_t i = 0; i < output.get_limb_count(); ++i) {
+    m_builder.add_ram(output.get_limb(i), addr_size, output.get_limb_size(i), read_addr, write_enable, write_addr,
+                      write_data.get_limb(i));
+  }
+}
@@ -0,0 +1,98 @@
+#ifndef NETLIST_SRC_WIDE_BUS_HPP
+#define NETLIST_SRC_WIDE_BUS_HPP
+
+#include "program.hpp"
+
+#include <algorithm>
+
+/// \addtogroup parser
+/// @{
+
+/// \brief A bus of any size, stored in consecutive registers of at most 64 bits.
+///
+/// The registers (the limbs of the bus) hold the bits of the bus 64 by 64, the
+/// lowest ones first. Only the last limb may be narrower than 64 bits. A bus of
+/// at most 64 bits is a single register.
+struct WideBus {
+  static constexpr bus_size_t LIMB_SIZE = 64;
+
+  reg_t first;
+  bus_size_t bus_size = 0;
+
+  [[nodiscard]] std::size_t get_limb_count() const { return (bus_size + LIMB_SIZE - 1) / LIMB_SIZE; }
+  [[nodiscard]] reg_t get_limb(std::size_t i) const { return {static_cast<reg_index_t>(first.index + i)}; }
+  [[nodiscard]] bus_size_t get_limb_size(std::size_t i) const {
+    return std::min<bus_size_t>(LIMB_SIZE, bus_size - i * LIMB_SIZE);
+  }
+};
+
+/// \brief Emits the instructions computing operations on buses wider than 64 bits.
+///
+/// The registers and the simulator only handle values of up to 64 bits
+/// (reg_value_t). Wider buses are therefore split into limbs (see WideBus) by
+/// the Parser and each operation is legalized into operations on the limbs:
+/// - the bitwise operations, `MUX`, `REG` and the memories (`ROM` and `RAM`,
+///   split into one memory block per limb of the word) work limb by limb;
+/// - `ADD` and `SUB` propagate a carry from the low limbs to the high ones;
+/// - `EQ`, `LT`, `REDOR` and `REDAND` combine the results of each limb;
+/// - `CONCAT`, `SELECT` and `SLICE` are rebuilt from slices of the limbs.
+///
+/// `MUL` and the shifts are not supported on wide buses. As the limbs are
+/// ordinary registers, the passes and the simulator see nothing special and
+/// the programs only made of narrow buses are unchanged.
+class WideBusBuilder {
+public:
+  explicit WideBusBuilder(ProgramBuilder &builder) : m_builder(builder) {}
+
+  /// \brief Adds the limbs of a new bus of \a bus_size bits.
+  ///
+  /// The first limb is named \a name, the next ones `name'64`, `name'128`, etc.
+  /// (after the index of their first bit).
+  WideBus add_register(bus_size_t bus_size, std::string_view name = {}, unsigned flags = 0);
+  /// \brief Returns the name of the limb starting at the bit \a offset of the bus \a name.
+  [[nodiscard]] static std::string get_limb_name(std::string_view name, bus_size_t offset);
+
+  /// \brief Sets \a output to \a limbs, its value split in 64-bit words, the lowest one first.
+  void add_const(const WideBus &output, const std::vector<reg_value_t> &limbs);
+  void add_load(const WideBus &output, const WideBus &input);
+  void add_not(const WideBus &output, const WideBus &input);
+  void add_reg(const WideBus &output, const WideBus &input);
+  void add_and(const WideBus &output, const WideBus &lhs, const WideBus &rhs);
+  void add_nand(const WideBus &output, const WideBus &lhs, const WideBus &rhs);
+  void add_or(const WideBus &output, const WideBus &lhs, const WideBus &rhs);
+  void add_nor(const WideBus &output, const WideBus &lhs, const WideBus &rhs);
+  void add_xor(const WideBus &output, const WideBus &lhs, const WideBus &rhs);
+  void add_xnor(const WideBus &output, const WideBus &lhs, const WideBus &rhs);
+  void add_add(const WideBus &output, const WideBus &lhs, const WideBus &rhs);
+  void add_sub(const WideBus &output, const WideBus &lhs, const WideBus &rhs);
+  void add_eq(reg_t output, const WideBus &lhs, const WideBus &rhs);
+  void add_lt(reg_t output, const WideBus &lhs, const WideBus &rhs);
+  void add_reduce_or(reg_t output, const WideBus &input);
+  void add_reduce_and(reg_t output, const WideBus &input);
+  void add_mux(const WideBus &output, reg_t choice, const WideBus &first, const WideBus &second);
+  void add_concat(const WideBus &output, const WideBus &lhs, const WideBus &rhs);
+  /// \brief Also used for `SELECT`, which is the slice of a single bit.
+  void add_slice(const WideBus &output, bus_size_t start, bus_size_t end, const WideBus &input);
+  void add_rom(const WideBus &output, bus_size_t addr_size, reg_t read_addr);
+  void add_ram(const WideBus &output, bus_size_t addr_size, reg_t read_addr, reg_t write_enable, reg_t write_addr,
+               const WideBus &write_data);
+
+private:
+  /// Applies \a add_limb to each limb of the output and the corresponding limbs of the operands.
+  template <class F> void add_limbwise(const WideBus &output, const WideBus &lhs, const WideBus &rhs, F add_limb);
+  /// Sets \a output to the AND (or the OR) of the single bit registers \a bits.
+  void add_reduction(reg_t output, const std::vector<reg_t> &bits, bool is_and);
+  /// Sets \a output to the \a count bits starting at \a start of the
+  /// concatenation of \a parts, its remaining high bits (and the ones past the
+  /// end of \a parts) to zero.
+  void add_bit_range(reg_t output, const std::vector<WideBus> &parts, bus_size_t start, bus_size_t count);
+  /// Returns a register set to the zero extension of the single bit \a bit to \a bus_size bits.
+  reg_t add_zero_extension(reg_t bit, bus_size_t bus_size);
+
+private:
+  ProgramBuilder &m_builder;
+};
+
+/// @}
+
+#endif // NETLIST_SRC_WIDE_BUS_HPP
@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+
+#include "dependency_graph.hpp"
+#include "passes/aig.hpp"
+#include "passes/aig_rewriting.hpp"
+#include "simulator/simulator.hpp"
+
+static void schedule(const std::shared_ptr<Program> &program) {
+  ReportManager report_manager;
+  DependencyGraph graph = DependencyGraph::build(program);
+  graph.schedule(report_manager);
+}
+
+/// Returns the instruction defining \a reg in \a program, or null.
+static const Instruction *find_definition(const std::shared_ptr<Program> &program, reg_t reg) {
+  for (const auto *instruction : program->instructions) {
+    if (instruction->output == reg)
+      return instruction;
+  }
+  return nullptr;
+}
+
+/// Returns the length of the longest chain of instructions computing \a reg.
+static std::size_t get_depth(const std::shared_ptr<Program> &program, reg_t reg) {
+  const auto *definition = find_definition(program, reg);
+  if (definition == nullptr)
+    return 0;
+
+  std::size_t depth = 0;
+  for (const auto input : get_instruction_inputs(*definition))
+    depth = std::max(depth, get_depth(program, input));
+  return depth + 1;
+}
+
+/// Checks that the 1-bit register \a output of \a program computes \a expected
+/// for all values of the 1-bit \a inputs.
+template <class F>
+static void check_truth_table(const std::shared_ptr<Program> &program, const std::vector<reg_t> &inputs, reg_t output,
+                              F expected) {
+  schedule(program);
+  Simulator simulator(program);
+  for (reg_value_t value = 0; value < (reg_value_t(1) << inputs.size()); ++value) {
+    for (std::size_t i = 0; i < inputs.size(); ++i)
+      simulator.set_register(inputs[i], (value >> i) & 1);
+    simulator.cycle();
+    EXPECT_EQ(simulator.get_register(output) & 1, expected(value) ? 1 : 0) << "for inputs " << value;
+  }
+}
+
+TEST(AigTest, structural_hashing_and_rules) {
+  Aig aig;
+  const auto a = aig.add_input();
+  const auto b = aig.add_input();
+  const auto c = aig.add_input();
+
+  const auto ab = aig.make_and(a, b);
+  EXPECT_EQ(aig.make_and(b, a), ab);
+  EXPECT_EQ(aig.make_and(ab, Aig::negate(a)), Aig::FALSE); // contradiction
+  EXPECT_EQ(aig.make_and(ab, a), ab);                      // idempotence
+  EXPECT_EQ(aig.make_and(Aig::negate(ab), Aig::negate(a)), Aig::negate(a)); // subsumption
+  EXPECT_EQ(aig.make_and(Aig::negate(ab), a), aig.make_and(a, Aig::negate(b))); // substitution
+  EXPECT_EQ(aig.make_and(Aig::negate(aig.make_and(a, c)), Aig::negate(aig.make_and(a, Aig::negate(c)))),
+            Aig::negate(a)); // resolution
+  EXPECT_EQ(aig.make_mux(c, a, a), a);
+  EXPECT_EQ(aig.make_xor(a, a), Aig::FALSE);
+}
+
+TEST(AigTest, balance) {
+  // A chain of 7 AND nodes has a depth of 7, a balanced tree a depth of 3.
+  Aig aig;
+  auto lit = aig.add_input();
+  for (int i = 0; i < 7; ++i)
+    lit = aig.make_and(lit, aig.add_input());
+  EXPECT_EQ(aig.get_level(Aig::get_node(lit)), 7);
+
+  std::vector<Aig::lit_t> roots = {lit};
+  const auto balanced = aig.balance(roots);
+  EXPECT_EQ(balanced.get_level(Aig::get_node(roots[0])), 3);
+  EXPECT_EQ(balanced.get_inputs().size(), 8);
+  EXPECT_EQ(balanced.get_node_count(), 1 + 8 + 7);
+}
+
+TEST(AigRewritingTest, duplicated_logic_is_shared) {
+  // o = OR (AND a b) c and p = OR (AND b a) c
+  ProgramBuilder builder;
+  auto a = builder.add_register(1, "a", RIF_INPUT);
+  auto b = builder.add_register(1, "b", RIF_INPUT);
+  auto c = builder.add_register(1, "c", RIF_INPUT);
+  auto o = builder.add_register(1, "o", RIF_OUTPUT);
+  auto p = builder.add_register(1, "p", RIF_OUTPUT);
+  auto t0 = builder.add_register(1);
+  auto t1 = builder.add_register(1);
+  builder.add_and(t0, a, b);
+  builder.add_or(o, t0, c);
+  builder.add_and(t1, b, a);
+  builder.add_or(p, t1, c);
+  auto program = builder.build();
+
+  AigRewritingPass pass;
+  EXPECT_TRUE(pass.run(program));
+  EXPECT_EQ(program->instructions.size(), 3);
+  const auto function = [](reg_value_t v) { return ((v & 1) && (v & 2)) || (v & 4); };
+  check_truth_table(program, {a, b, c}, o, function);
+  check_truth_table(program, {a, b, c}, p, function);
+}
+
+TEST(AigRewritingTest, redundant_logic) {
+  // o = AND a (OR a b) is a.
+  ProgramBuilder builder;
+  auto a = builder.add_register(1, "a", RIF_INPUT);
+  auto b = builder.add_register(1, "b", RIF_INPUT);
+  auto o = builder.add_register(1, "o", RIF_OUTPUT);
+  auto t = builder.add_register(1);
+  builder.add_or(t, a, b);
+  builder.add_and(o, a, t);
+  auto program = builder.build();
+
+  AigRewritingPass pass;
+  EXPECT_TRUE(pass.run(program));
+  const auto *load = dynamic_cast<const LoadInstruction *>(find_definition(program, o));
+  ASSERT_NE(load, nullptr);
+  EXPECT_EQ(load->input, a);
+  EXPECT_EQ(program->instructions.size(), 1);
+}
+
+TEST(AigRewritingTest, xor_and_mux_are_raised_back) {
+  // o = XOR a b and m = MUX s (NOT a) (NOT b) keep their form.
+  ProgramBuilder builder;
+  auto a = builder.add_register(1, "a", RIF_INPUT);
+  auto b = builder.add_register(1, "b", RIF_INPUT);
+  auto s = builder.add_register(1, "s", RIF_INPUT);
+  auto o = builder.add_register(1, "o", RIF_OUTPUT);
+  auto m = builder.add_register(1, "m", RIF_OUTPUT);
+  auto n = builder.add_register(1, "n", RIF_OUTPUT);
+  auto not_a = builder.add_register(1);
+  auto not_b = builder.add_register(1);
+  auto x = builder.add_register(1);
+  builder.add_xor(o, a, b);
+  builder.add_not(not_a, a);
+  builder.add_not(not_b, b);
+  builder.add_mux(m, s, not_a, not_b);
+  // n = NOT (XNOR (NOT a) b) is XNOR a b.
+  builder.add_xnor(x, not_a, b);
+  builder.add_not(n, x);
+  auto program = builder.build();
+
+  AigRewritingPass pass;
+  EXPECT_TRUE(pass.run(program));
+  EXPECT_NE(dynamic_cast<const XorInstruction *>(find_definition(program, o)), nullptr);
+  EXPECT_NE(dynamic_cast<const XnorInstruction *>(find_definition(program, n)), nullptr);
+  EXPECT_LE(program->instructions.size(), 5);
+  check_truth_table(program, {a, b, s}, o, [](reg_value_t v) { return (v & 1) != ((v >> 1) & 1); });
+  check_truth_table(program, {a, b, s}, m, [](reg_value_t v) { return (v & 4) ? !(v & 2) : !(v & 1); });
+  check_truth_table(program, {a, b, s}, n, [](reg_value_t v) { return (v & 1) == ((v >> 1) & 1); });
+}
+
+TEST(AigRewritingTest, balancing) {
+  // o = AND (AND (AND ... i0 i1) ...) i7
+  ProgramBuilder builder;
+  std::vector<reg_t> inputs;
+  for (int i = 0; i < 8; ++i)
+    inputs.push_back(builder.add_register(1, "i" + std::to_string(i), RIF_INPUT));
+  auto o = builder.add_register(1, "o", RIF_OUTPUT);
+  auto acc = inputs[0];
+  for (int i = 1; i < 8; ++i) {
+    auto next = (i == 7) ? o : builder.add_register(1);
+    builder.add_and(next, acc, inputs[i]);
+    acc = next;
+  }
+  auto program = builder.build();
+
+  AigRewritingPass rewriting;
+  EXPECT_FALSE(rewriting.run(program));
+
+  AigRewritingPass balancing(/* balance= */ true);
+  EXPECT_TRUE(balancing.run(program));
+  EXPECT_EQ(program->instructions.size(), 7);
+  EXPECT_EQ(get_depth(program, o), 3);
+  check_truth_table(program, inputs, o, [](reg_value_t v) { return v == 0xFF; });
+}
+
+TEST(AigRewritingTest, wide_logic_is_kept) {
+  ProgramBuilder builder;
+  auto a = builder.add_register(4, "a", RIF_INPUT);
+  auto b = builder.add_register(4, "b", RIF_INPUT);
+  auto o = builder.add_register(4, "o", RIF_OUTPUT);
+  auto t = builder.add_register(4);
+  builder.add_or(t, a, b);
+  builder.add_and(o, a, t);
+  auto program = builder.build();
+
+  AigRewritingPass pass(/* balance= */ true);
+  EXPECT_FALSE(pass.run(program));
+  EXPECT_EQ(program->instructions.size(), 2);
+}
@@ -0,0 +1,224 @@
+#include <gtest/gtest.h>
+
+#include "dependency_graph.hpp"
+#include "passes/arithmetic.hpp"
+#include "simulator/simulator.hpp"
+
+static void schedule(const std::shared_ptr<Program> &program) {
+  ReportManager report_manager;
+  DependencyGraph graph = DependencyGraph::build(program);
+  graph.schedule(report_manager);
+}
+
+/// Returns the instruction defining \a reg in \a program, or null.
+static const Instruction *find_definition(const std::shared_ptr<Program> &program, reg_t reg) {
+  for (const auto *instruction : program->instructions) {
+    if (instruction->output == reg)
+      return instruction;
+  }
+  return nullptr;
+}
+
+/// Returns the 1-bit registers `SELECT i reg` for each bit of \a reg.
+static std::vector<reg_t> select_bits(ProgramBuilder &builder, reg_t reg, bus_size_t bus_size) {
+  std::vector<reg_t> bits;
+  for (bus_size_t i = 0; i < bus_size; ++i) {
+    bits.push_back(builder.add_register(1));
+    builder.add_select(bits.back(), i, reg);
+  }
+  return bits;
+}
+
+/// Builds `o = CONCAT bits[0] (CONCAT bits[1] ...)`.
+static void concat_bits(ProgramBuilder &builder, reg_t o, const std::vector<reg_t> &bits) {
+  auto acc = bits.back();
+  for (auto i = bits.size() - 1; i-- > 0;) {
+    auto c = (i == 0) ? o : builder.add_register(bits.size() - i);
+    builder.add_concat(c, bits[i], acc);
+    acc = c;
+  }
+}
+
+/// Builds a ripple-carry adder computing \a sum (and the carry out in \a carry if valid).
+static void build_adder(ProgramBuilder &builder, reg_t sum, reg_t carry, reg_t a, reg_t b, bus_size_t bus_size) {
+  const auto a_bits = select_bits(builder, a, bus_size);
+  const auto b_bits = select_bits(builder, b, bus_size);
+  std::vector<reg_t> sum_bits;
+  reg_t c = {};
+  for (bus_size_t i = 0; i < bus_size; ++i) {
+    auto p = builder.add_register(1);
+    builder.add_xor(p, a_bits[i], b_bits[i]);
+    auto g = builder.add_register(1);
+    builder.add_and(g, a_bits[i], b_bits[i]);
+    if (i == 0) {
+      sum_bits.push_back(p);
+      c = g;
+      continue;
+    }
+
+    sum_bits.push_back(builder.add_register(1));
+    builder.add_xor(sum_bits.back(), p, c);
+    auto t = builder.add_register(1);
+    builder.add_and(t, p, c);
+    auto next = (i + 1 == bus_size && carry.index != reg_t{}.index) ? carry : builder.add_register(1);
+    builder.add_or(next, g, t);
+    c = next;
+  }
+
+  concat_bits(builder, sum, sum_bits);
+}
+
+TEST(ArithmeticTest, ripple_carry_adder) {
+  ProgramBuilder builder;
+  auto a = builder.add_register(8, "a", RIF_INPUT);
+  auto b = builder.add_register(8, "b", RIF_INPUT);
+  auto o = builder.add_register(8, "o", RIF_OUTPUT);
+  auto c = builder.add_register(1, "c", RIF_OUTPUT);
+  build_adder(builder, o, c, a, b, 8);
+  auto program = builder.build();
+
+  ArithmeticPass pass;
+  EXPECT_TRUE(pass.run(program));
+  const auto *add = dynamic_cast<const AddInstruction *>(find_definition(program, o));
+  ASSERT_NE(add, nullptr);
+  EXPECT_EQ(add->lhs, a);
+  EXPECT_EQ(add->rhs, b);
+  EXPECT_NE(dynamic_cast<const LtInstruction *>(find_definition(program, c)), nullptr);
+  EXPECT_LE(program->instructions.size(), 3);
+  schedule(program);
+
+  Simulator simulator(program);
+  const std::pair<reg_value_t, reg_value_t> cases[] = {{0, 0}, {3, 5}, {200, 100}, {255, 1}, {127, 128}};
+  for (const auto &[x, y] : cases) {
+    simulator.set_register(a, x);
+    simulator.set_register(b, y);
+    simulator.cycle();
+    EXPECT_EQ(simulator.get_register(o), (x + y) & 0xFF);
+    EXPECT_EQ(simulator.get_register(c), (x + y) >> 8);
+  }
+}
+
+TEST(ArithmeticTest, equality_comparator) {
+  // o = AND (XNOR a0 b0) (AND (XNOR a1 b1) ...)
+  ProgramBuilder builder;
+  auto a = builder.add_register(6, "a", RIF_INPUT);
+  auto b = builder.add_register(6, "b", RIF_INPUT);
+  auto o = builder.add_register(1, "o", RIF_OUTPUT);
+  const auto a_bits = select_bits(builder, a, 6);
+  const auto b_bits = select_bits(builder, b, 6);
+  reg_t acc = {};
+  for (bus_size_t i = 0; i < 6; ++i) {
+    auto e = builder.add_register(1);
+    builder.add_xnor(e, a_bits[i], b_bits[i]);
+    if (i == 0) {
+      acc = e;
+    } else {
+      auto next = (i == 5) ? o : builder.add_register(1);
+      builder.add_and(next, acc, e);
+      acc = next;
+    }
+  }
+  auto program = builder.build();
+
+  ArithmeticPass pass;
+  EXPECT_TRUE(pass.run(program));
+  EXPECT_NE(dynamic_cast<const EqInstruction *>(find_definition(program, o)), nullptr);
+  EXPECT_EQ(program->instructions.size(), 1);
+  schedule(program);
+
+  Simulator simulator(program);
+  simulator.set_register(a, 0b101101);
+  simulator.set_register(b, 0b101101);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(o), 1);
+  simulator.set_register(b, 0b101100);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(o), 0);
+}
+
+TEST(ArithmeticTest, constant_comparator) {
+  // o = NOT (a == 0b1001), as NAND of the bits or of their negations.
+  ProgramBuilder builder;
+  auto a = builder.add_register(4, "a", RIF_INPUT);
+  auto o = builder.add_register(1, "o", RIF_OUTPUT);
+  const auto bits = select_bits(builder, a, 4);
+  std::vector<reg_t> literals;
+  for (bus_size_t i = 0; i < 4; ++i) {
+    if (i == 0 || i == 3) {
+      literals.push_back(bits[i]);
+    } else {
+      literals.push_back(builder.add_register(1));
+      builder.add_not(literals.back(), bits[i]);
+    }
+  }
+  auto t0 = builder.add_register(1);
+  auto t1 = builder.add_register(1);
+  builder.add_and(t0, literals[0], literals[1]);
+  builder.add_and(t1, literals[2], literals[3]);
+  builder.add_nand(o, t0, t1);
+  auto program = builder.build();
+
+  ArithmeticPass pass;
+  EXPECT_TRUE(pass.run(program));
+  EXPECT_NE(dynamic_cast<const NotInstruction *>(find_definition(program, o)), nullptr);
+  schedule(program);
+
+  Simulator simulator(program);
+  for (reg_value_t value = 0; value < 16; ++value) {
+    simulator.set_register(a, value);
+    simulator.cycle();
+    EXPECT_EQ(simulator.get_register(o), value == 0b1001 ? 0 : 1);
+  }
+}
+
+TEST(ArithmeticTest, counter) {
+  // r = REG (r + 1) as a chain of half adders.
+  ProgramBuilder builder;
+  auto r = builder.add_register(4, "r", RIF_OUTPUT);
+  auto next = builder.add_register(4);
+  const auto bits = select_bits(builder, r, 4);
+  auto carry = builder.add_register(1);
+  builder.add_const(carry, 1);
+  std::vector<reg_t> sum_bits;
+  for (bus_size_t i = 0; i < 4; ++i) {
+    sum_bits.push_back(builder.add_register(1));
+    builder.add_xor(sum_bits.back(), bits[i], carry);
+    auto next_carry = builder.add_register(1);
+    builder.add_and(next_carry, bits[i], carry);
+    carry = next_carry;
+  }
+  concat_bits(builder, next, sum_bits);
+  builder.add_reg(r, next);
+  auto program = builder.build();
+
+  ArithmeticPass pass;
+  EXPECT_TRUE(pass.run(program));
+  EXPECT_NE(dynamic_cast<const AddInstruction *>(find_definition(program, next)), nullptr);
+  schedule(program);
+
+  Simulator simulator(program);
+  for (reg_value_t i = 0; i < 20; ++i) {
+    simulator.cycle();
+    EXPECT_EQ(simulator.get_register(r), i & 0xF);
+  }
+}
+
+TEST(ArithmeticTest, bitwise_logic_is_kept) {
+  // o = CONCAT (XOR a0 b0) (XOR a1 b1) is not arithmetic.
+  ProgramBuilder builder;
+  auto a = builder.add_register(2, "a", RIF_INPUT);
+  auto b = builder.add_register(2, "b", RIF_INPUT);
+  auto o = builder.add_register(2, "o", RIF_OUTPUT);
+  const auto a_bits = select_bits(builder, a, 2);
+  const auto b_bits = select_bits(builder, b, 2);
+  std::vector<reg_t> bits;
+  for (bus_size_t i = 0; i < 2; ++i) {
+    bits.push_back(builder.add_register(1));
+    builder.add_xor(bits.back(), a_bits[i], b_bits[i]);
+  }
+  concat_bits(builder, o, bits);
+  auto program = builder.build();
+
+  ArithmeticPass pass;
+  EXPECT_FALSE(pass.run(program));
+}
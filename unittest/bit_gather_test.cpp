@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+
+#include "dependency_graph.hpp"
+#include "passes/bit_gather.hpp"
+#include "simulator/simulator.hpp"
+#include "utils.hpp"
+
+static void schedule(const std::shared_ptr<Program> &program) {
+  ReportManager report_manager;
+  DependencyGraph graph = DependencyGraph::build(program);
+  graph.schedule(report_manager);
+}
+
+TEST(BitGatherTest, extract_and_deposit_bits) {
+  EXPECT_EQ(extract_bits(0b10110100, 0b11110000), 0b1011);
+  EXPECT_EQ(extract_bits(0b10110100, 0b10100101), 0b1110);
+  EXPECT_EQ(extract_bits(UINT64_MAX, 0), 0);
+  EXPECT_EQ(deposit_bits(0b1011, 0b11110000), 0b10110000);
+  EXPECT_EQ(deposit_bits(0b1100, 0b10100101), 0b10100000);
+  EXPECT_EQ(deposit_bits(UINT64_MAX, 0x8000000000000001), 0x8000000000000001);
+}
+
+TEST(BitGatherTest, select_chain) {
+  // x = SELECT 0 (SLICE 1 2 (SLICE 1 3 a)), that is SELECT 2 a
+  ProgramBuilder builder;
+  auto a = builder.add_register(4, "a", RIF_INPUT);
+  auto s1 = builder.add_register(3, "s1");
+  auto s2 = builder.add_register(2, "s2");
+  auto x = builder.add_register(1, "x", RIF_OUTPUT);
+  builder.add_slice(s1, 1, 3, a);
+  builder.add_slice(s2, 1, 2, s1);
+  builder.add_select(x, 0, s2);
+  auto program = builder.build();
+
+  BitGatherPass pass;
+  EXPECT_TRUE(pass.run(program));
+  ASSERT_EQ(program->instructions.size(), 1);
+  const auto *select = dynamic_cast<const SelectInstruction *>(program->instructions[0]);
+  ASSERT_NE(select, nullptr);
+  EXPECT_EQ(select->input, a);
+  EXPECT_EQ(select->i, 2);
+}
+
+TEST(BitGatherTest, concat_tree) {
+  // o = CONCAT o0 (CONCAT o1 (CONCAT o2 o3)) with oi = OR (SELECT i a) (SELECT i b)
+  ProgramBuilder builder;
+  auto a = builder.add_register(4, "a", RIF_INPUT);
+  auto b = builder.add_register(4, "b", RIF_INPUT);
+  reg_t bits[4];
+  for (bus_size_t i = 0; i < 4; ++i) {
+    auto ai = builder.add_register(1);
+    auto bi = builder.add_register(1);
+    bits[i] = builder.add_register(1);
+    builder.add_select(ai, i, a);
+    builder.add_select(bi, i, b);
+    builder.add_or(bits[i], ai, bi);
+  }
+  auto c1 = builder.add_register(2);
+  auto c2 = builder.add_register(3);
+  auto o = builder.add_register(4, "o", RIF_OUTPUT);
+  builder.add_concat(c1, bits[2], bits[3]);
+  builder.add_concat(c2, bits[1], c1);
+  builder.add_concat(o, bits[0], c2);
+  auto program = builder.build();
+
+  BitGatherPass pass;
+  EXPECT_TRUE(pass.run(program));
+  // 8 SELECT, 4 OR and a single GATHER.
+  EXPECT_EQ(program->instructions.size(), 13);
+  schedule(program);
+
+  Simulator simulator(program);
+  simulator.set_register(a, 0b1001);
+  simulator.set_register(b, 0b0011);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(o), 0b1011);
+}
+
+TEST(BitGatherTest, bit_reversal_with_constants) {
+  // o = CONCAT (SELECT 3 a) (CONCAT (SELECT 2 a) (CONCAT (SELECT 1 a) (CONCAT (SELECT 0 a) 01)))
+  ProgramBuilder builder;
+  auto a = builder.add_register(4, "a", RIF_INPUT);
+  reg_t bits[4];
+  for (bus_size_t i = 0; i < 4; ++i) {
+    bits[i] = builder.add_register(1);
+    builder.add_select(bits[i], i, a);
+  }
+  auto k = builder.add_register(2);
+  builder.add_const(k, 0b01);
+  auto c0 = builder.add_register(3);
+  auto c1 = builder.add_register(4);
+  auto c2 = builder.add_register(5);
+  auto o = builder.add_register(6, "o", RIF_OUTPUT);
+  builder.add_concat(c0, bits[0], k);
+  builder.add_concat(c1, bits[1], c0);
+  builder.add_concat(c2, bits[2], c1);
+  builder.add_concat(o, bits[3], c2);
+  auto program = builder.build();
+
+  BitGatherPass pass;
+  EXPECT_TRUE(pass.run(program));
+  ASSERT_EQ(program->instructions.size(), 1);
+  const auto *gather = dynamic_cast<const GatherInstruction *>(program->instructions[0]);
+  ASSERT_NE(gather, nullptr);
+  EXPECT_EQ(gather->constant, 0b010000);
+
+  Simulator simulator(program);
+  simulator.set_register(a, 0b1101);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(o), 0b011011);
+}
+
+TEST(BitGatherTest, order_preserving_gather) {
+  // o = CONCAT (SLICE 0 1 a) (CONCAT (SLICE 4 5 a) (SLICE 9 10 a))
+  ProgramBuilder builder;
+  auto a = builder.add_register(16, "a", RIF_INPUT);
+  auto s0 = builder.add_register(2);
+  auto s1 = builder.add_register(2);
+  auto s2 = builder.add_register(2);
+  auto c = builder.add_register(4);
+  auto o = builder.add_register(6, "o", RIF_OUTPUT);
+  builder.add_slice(s0, 0, 1, a);
+  builder.add_slice(s1, 4, 5, a);
+  builder.add_slice(s2, 9, 10, a);
+  builder.add_concat(c, s1, s2);
+  builder.add_concat(o, s0, c);
+  auto program = builder.build();
+
+  BitGatherPass pass;
+  EXPECT_TRUE(pass.run(program));
+  ASSERT_EQ(program->instructions.size(), 1);
+  const auto *gather = dynamic_cast<const GatherInstruction *>(program->instructions[0]);
+  ASSERT_NE(gather, nullptr);
+  ASSERT_EQ(gather->parts.size(), 1);
+  EXPECT_FALSE(gather->parts[0].is_shift);
+  EXPECT_EQ(gather->parts[0].extract_mask, 0b11000110011);
+  EXPECT_EQ(gather->parts[0].deposit_mask, 0b111111);
+
+  Simulator simulator(program);
+  simulator.set_register(a, 0b1010110101110);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(o), 0b101010);
+}
+
+TEST(BitGatherTest, shared_subtree_is_kept) {
+  // The intermediate register `s` is an output, so it must be kept.
+  ProgramBuilder builder;
+  auto a = builder.add_register(8, "a", RIF_INPUT);
+  auto s = builder.add_register(4, "s", RIF_OUTPUT);
+  auto o = builder.add_register(2, "o", RIF_OUTPUT);
+  builder.add_slice(s, 2, 5, a);
+  builder.add_slice(o, 1, 2, s);
+  auto program = builder.build();
+
+  BitGatherPass pass;
+  EXPECT_FALSE(pass.run(program));
+  EXPECT_EQ(program->instructions.size(), 2);
+}
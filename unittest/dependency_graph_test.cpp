@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+
+#include "dependency_graph.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "simulator/simulator.hpp"
+
+#include <map>
+
+static void schedule(const std::shared_ptr<Program> &program, ScheduleStrategy strategy) {
+  ReportManager report_manager;
+  DependencyGraph graph = DependencyGraph::build(program);
+  graph.schedule(report_manager, strategy);
+}
+
+/// Returns the greatest count of computed values that are still to be read at
+/// some point of the instruction order (an instruction may reuse the storage
+/// of the operands it reads last).
+static std::size_t get_max_live_values(const std::shared_ptr<Program> &program) {
+  std::map<reg_t, std::size_t> last_uses;
+  for (std::size_t i = 0; i < program->instructions.size(); ++i) {
+    for (const auto input : get_instruction_inputs(*program->instructions[i])) {
+      if (!(program->registers.get_flags(input) & RIF_INPUT))
+        last_uses[input] = i;
+    }
+  }
+
+  std::size_t live_values = 0;
+  std::size_t max_live_values = 0;
+  for (std::size_t i = 0; i < program->instructions.size(); ++i) {
+    for (const auto input : get_instruction_inputs(*program->instructions[i])) {
+      if (last_uses.contains(input) && last_uses[input] == i)
+        --live_values;
+    }
+
+    if (last_uses.contains(program->instructions[i]->output)) {
+      ++live_values;
+      max_live_values = std::max(max_live_values, live_values);
+    }
+  }
+
+  return max_live_values;
+}
+
+/// o = AND (NOT a) (XOR (AND a b) (OR c d)), with the temporaries declared first.
+static std::shared_ptr<Program> build_program() {
+  ProgramBuilder builder;
+  auto x = builder.add_register(1, "x");
+  auto y = builder.add_register(1, "y");
+  auto p = builder.add_register(1, "p");
+  auto q = builder.add_register(1, "q");
+  auto o = builder.add_register(1, "o", RIF_OUTPUT);
+  auto a = builder.add_register(1, "a", RIF_INPUT);
+  auto b = builder.add_register(1, "b", RIF_INPUT);
+  auto c = builder.add_register(1, "c", RIF_INPUT);
+  auto d = builder.add_register(1, "d", RIF_INPUT);
+  builder.add_and(o, x, y);
+  builder.add_xor(y, p, q);
+  builder.add_or(q, c, d);
+  builder.add_and(p, a, b);
+  builder.add_not(x, a);
+  return builder.build();
+}
+
+TEST(DependencyGraphTest, locality_strategy) {
+  auto dfs_program = build_program();
+  schedule(dfs_program, ScheduleStrategy::DFS);
+  // The NOT is computed first and kept while computing the XOR.
+  EXPECT_EQ(get_max_live_values(dfs_program), 3);
+
+  auto program = build_program();
+  schedule(program, ScheduleStrategy::LOCALITY);
+  EXPECT_EQ(get_max_live_values(program), 2);
+  ASSERT_EQ(program->instructions.size(), 5);
+  EXPECT_NE(dynamic_cast<const AndInstruction *>(program->instructions.front()), nullptr);
+  EXPECT_NE(dynamic_cast<const NotInstruction *>(program->instructions[3]), nullptr);
+  EXPECT_EQ(program->instructions.back()->output, *program->find_register("o"));
+
+  Simulator simulator(program);
+  const auto inputs = program->get_inputs();
+  const auto output = *program->find_register("o");
+  for (reg_value_t value = 0; value < 16; ++value) {
+    for (std::size_t i = 0; i < inputs.size(); ++i)
+      simulator.set_register(inputs[i], (value >> i) & 1);
+    simulator.cycle();
+    const auto a = value & 1, b = (value >> 1) & 1, c = (value >> 2) & 1, d = (value >> 3) & 1;
+    EXPECT_EQ(simulator.get_register(output) & 1, (!a) & ((a & b) ^ (c | d))) << "for inputs " << value;
+  }
+}
+
+TEST(DependencyGraphTest, ram_write_port_is_computed_first) {
+  // The written data is not read by any other instruction.
+  const char *source = R"(
+INPUT ra, we, wa, d
+OUTPUT o
+VAR ra : 2, we, wa : 2, d : 4, o : 4, w : 4
+IN
+o = RAM 2 4 ra we wa w
+w = NOT d
+)";
+
+  for (const auto strategy : {ScheduleStrategy::DFS, ScheduleStrategy::LOCALITY}) {
+    ReportManager report_manager;
+    Lexer lexer(report_manager, source);
+    Parser parser(report_manager, lexer);
+    auto program = parser.parse_program();
+    schedule(program, strategy);
+
+    Simulator simulator(program);
+    simulator.set_register(*program->find_register("we"), 1);
+    simulator.set_register(*program->find_register("wa"), 0b01);
+    simulator.set_register(*program->find_register("d"), 0b0011);
+    simulator.cycle();
+    simulator.set_register(*program->find_register("we"), 0);
+    simulator.set_register(*program->find_register("ra"), 0b01);
+    simulator.cycle();
+    EXPECT_EQ(simulator.get_register(*program->find_register("o")), 0b1100);
+  }
+}
+
+TEST(DependencyGraphTest, ram_write_port_reading_the_ram) {
+  // The written data depends on the read value, the previous one is written.
+  const char *source = R"(
+INPUT ra, we, wa
+OUTPUT o
+VAR ra : 2, we, wa : 2, o : 4, w : 4
+IN
+o = RAM 2 4 ra we wa w
+w = NOT o
+)";
+
+  ReportManager report_manager;
+  Lexer lexer(report_manager, source);
+  Parser parser(report_manager, lexer);
+  auto program = parser.parse_program();
+  schedule(program, ScheduleStrategy::LOCALITY);
+  EXPECT_EQ(program->instructions.size(), 2);
+}
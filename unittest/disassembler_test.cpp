@@ -21,6 +21,34 @@ IN
 )");
 }
 
+TEST(DisassemblerTest, stripped_names) {
+  ProgramBuilder builder;
+  const auto a = builder.add_register(4, "a", RIF_INPUT);
+  const auto t = builder.add_register(4, "t");
+  const auto o = builder.add_register(4, "o", RIF_OUTPUT);
+  builder.add_not(t, a);
+  builder.add_not(o, t);
+  auto program = builder.build();
+  program->registers.set_name(t, "tmp");
+  EXPECT_EQ(program->registers.get_name(t), "tmp");
+
+  program->registers.strip_names();
+  EXPECT_EQ(program->registers.get_name(a), "a");
+  EXPECT_EQ(program->registers.get_name(t), "");
+  EXPECT_FALSE(program->find_register("tmp").has_value());
+  EXPECT_EQ(program->registers.get_bus_size(t), 4);
+
+  std::stringstream out;
+  Disassembler::disassemble(program, out);
+  EXPECT_EQ(out.str(), R"(INPUT a
+OUTPUT o
+VAR a:4, __r1:4, o:4
+IN
+__r1 = NOT a
+o = NOT __r1
+)");
+}
+
 TEST(DisassemblerTest, constants) {
   ProgramBuilder builder;
   (void)builder.add_register(1, {}, RIF_INPUT);
@@ -131,6 +159,51 @@ o6 = XNOR a b
 )");
 }
 
+TEST(DisassemblerTest, arithmetic_expressions) {
+  ProgramBuilder builder;
+  const auto a = builder.add_register(4, "a", RIF_INPUT);
+  const auto b = builder.add_register(4, "b", RIF_INPUT);
+  const auto o1 = builder.add_register(4, "o1", RIF_OUTPUT);
+  const auto o2 = builder.add_register(4, "o2", RIF_OUTPUT);
+  const auto o3 = builder.add_register(4, "o3", RIF_OUTPUT);
+  const auto o4 = builder.add_register(1, "o4", RIF_OUTPUT);
+  const auto o5 = builder.add_register(1, "o5", RIF_OUTPUT);
+  const auto o6 = builder.add_register(4, "o6", RIF_OUTPUT);
+  const auto o7 = builder.add_register(4, "o7", RIF_OUTPUT);
+  const auto o8 = builder.add_register(4, "o8", RIF_OUTPUT);
+  const auto o9 = builder.add_register(1, "o9", RIF_OUTPUT);
+  const auto o10 = builder.add_register(1, "o10", RIF_OUTPUT);
+  builder.add_add(o1, a, b);
+  builder.add_sub(o2, a, b);
+  builder.add_mul(o3, a, b);
+  builder.add_eq(o4, a, b);
+  builder.add_lt(o5, a, b);
+  builder.add_shl(o6, a, b);
+  builder.add_shr(o7, a, b);
+  builder.add_asr(o8, a, b);
+  builder.add_reduce_or(o9, a);
+  builder.add_reduce_and(o10, a);
+  auto program = builder.build();
+
+  std::stringstream out;
+  Disassembler::disassemble(program, out);
+  EXPECT_EQ(out.str(), R"(INPUT a, b
+OUTPUT o1, o2, o3, o4, o5, o6, o7, o8, o9, o10
+VAR a:4, b:4, o1:4, o2:4, o3:4, o4:1, o5:1, o6:4, o7:4, o8:4, o9:1, o10:1
+IN
+o1 = ADD a b
+o2 = SUB a b
+o3 = MUL a b
+o4 = EQ a b
+o5 = LT a b
+o6 = SHL a b
+o7 = SHR a b
+o8 = ASR a b
+o9 = REDOR a
+o10 = REDAND a
+)");
+}
+
 TEST(DisassemblerTest, ram_rom) {
   ProgramBuilder builder;
   const auto read_addr = builder.add_register(8, "read_addr", RIF_INPUT);
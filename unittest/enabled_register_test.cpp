@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include "dependency_graph.hpp"
+#include "passes/enabled_register.hpp"
+#include "simulator/simulator.hpp"
+
+static void schedule(const std::shared_ptr<Program> &program) {
+  ReportManager report_manager;
+  DependencyGraph graph = DependencyGraph::build(program);
+  graph.schedule(report_manager);
+}
+
+/// Returns the instruction defining \a reg in \a program, or null.
+static const Instruction *find_definition(const std::shared_ptr<Program> &program, reg_t reg) {
+  for (const auto *instruction : program->instructions) {
+    if (instruction->output == reg)
+      return instruction;
+  }
+  return nullptr;
+}
+
+/// Builds the counter with enable `q = REG d; d = MUX en q (ADD (XOR q a) 1)`,
+/// or `d = MUX en (ADD ...) q` if \a is_active_low.
+static std::shared_ptr<Program> build_counter(reg_t &en, reg_t &a, reg_t &q, reg_t &d, bool is_active_low) {
+  ProgramBuilder builder;
+  en = builder.add_register(1, "en", RIF_INPUT);
+  a = builder.add_register(4, "a", RIF_INPUT);
+  q = builder.add_register(4, "q", RIF_OUTPUT);
+  d = builder.add_register(4);
+  auto one = builder.add_register(4);
+  auto t = builder.add_register(4);
+  auto x = builder.add_register(4);
+  builder.add_reg(q, d);
+  builder.add_const(one, 1);
+  builder.add_xor(t, q, a);
+  builder.add_add(x, t, one);
+  if (is_active_low) {
+    builder.add_mux(d, en, x, q);
+  } else {
+    builder.add_mux(d, en, q, x);
+  }
+  return builder.build();
+}
+
+static void check_counter(const std::shared_ptr<Program> &program, reg_t en, reg_t a, reg_t q, bool is_active_low) {
+  Simulator simulator(program);
+  reg_value_t expected = 0;
+  for (reg_value_t i = 0; i < 40; ++i) {
+    const bool enable = (i % 3) != 0;
+    const reg_value_t value = (i * 7) & 0xF;
+    simulator.set_register(en, enable != is_active_low);
+    simulator.set_register(a, value);
+    simulator.cycle();
+    EXPECT_EQ(simulator.get_register(q) & 0xF, expected);
+    if (enable)
+      expected = ((expected ^ value) + 1) & 0xF;
+  }
+}
+
+TEST(EnabledRegisterTest, enable_pattern) {
+  reg_t en, a, q, d;
+  auto program = build_counter(en, a, q, d, false);
+
+  EnabledRegisterPass pass;
+  EXPECT_TRUE(pass.run(program));
+  const auto *enabled_reg = dynamic_cast<const EnabledRegInstruction *>(find_definition(program, d));
+  ASSERT_NE(enabled_reg, nullptr);
+  EXPECT_EQ(enabled_reg->enable, en);
+  // The XOR and the ADD are only evaluated when enabled.
+  EXPECT_EQ(enabled_reg->body.size(), 2);
+  EXPECT_EQ(enabled_reg->body_inputs.size(), 3);
+  schedule(program);
+  check_counter(program, en, a, q, false);
+}
+
+TEST(EnabledRegisterTest, inverted_enable) {
+  reg_t en, a, q, d;
+  auto program = build_counter(en, a, q, d, true);
+
+  EnabledRegisterPass pass;
+  EXPECT_TRUE(pass.run(program));
+  const auto *enabled_reg = dynamic_cast<const EnabledRegInstruction *>(find_definition(program, d));
+  ASSERT_NE(enabled_reg, nullptr);
+  EXPECT_NE(dynamic_cast<const NotInstruction *>(find_definition(program, enabled_reg->enable)), nullptr);
+  schedule(program);
+  check_counter(program, en, a, q, true);
+}
+
+TEST(EnabledRegisterTest, shared_data_is_kept) {
+  // x is also an output, so it is computed every cycle.
+  ProgramBuilder builder;
+  auto en = builder.add_register(1, "en", RIF_INPUT);
+  auto a = builder.add_register(4, "a", RIF_INPUT);
+  auto q = builder.add_register(4, "q", RIF_OUTPUT);
+  auto x = builder.add_register(4, "x", RIF_OUTPUT);
+  auto d = builder.add_register(4);
+  builder.add_reg(q, d);
+  builder.add_not(x, a);
+  builder.add_mux(d, en, q, x);
+  auto program = builder.build();
+
+  EnabledRegisterPass pass;
+  EXPECT_TRUE(pass.run(program));
+  const auto *enabled_reg = dynamic_cast<const EnabledRegInstruction *>(find_definition(program, d));
+  ASSERT_NE(enabled_reg, nullptr);
+  EXPECT_TRUE(enabled_reg->body.empty());
+  EXPECT_NE(find_definition(program, x), nullptr);
+}
+
+TEST(EnabledRegisterTest, plain_mux_is_kept) {
+  // o = REG (MUX en a b) does not hold its value.
+  ProgramBuilder builder;
+  auto en = builder.add_register(1, "en", RIF_INPUT);
+  auto a = builder.add_register(4, "a", RIF_INPUT);
+  auto b = builder.add_register(4, "b", RIF_INPUT);
+  auto o = builder.add_register(4, "o", RIF_OUTPUT);
+  auto d = builder.add_register(4);
+  builder.add_mux(d, en, a, b);
+  builder.add_reg(o, d);
+  auto program = builder.build();
+
+  EnabledRegisterPass pass;
+  EXPECT_FALSE(pass.run(program));
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include "passes/input_specialization.hpp"
+#include "simulator/simulator.hpp"
+
+/// o = MUX mode (XOR a b) (AND a b), with the `mode` input used as a configuration strap.
+struct ConfigurableProgram {
+  reg_t mode, a, b, o;
+  std::shared_ptr<Program> program;
+
+  ConfigurableProgram() {
+    ProgramBuilder builder;
+    mode = builder.add_register(1, "mode", RIF_INPUT);
+    a = builder.add_register(1, "a", RIF_INPUT);
+    b = builder.add_register(1, "b", RIF_INPUT);
+    o = builder.add_register(1, "o", RIF_OUTPUT);
+    auto x = builder.add_register(1, "x");
+    auto y = builder.add_register(1, "y");
+    builder.add_xor(x, a, b);
+    builder.add_and(y, a, b);
+    builder.add_mux(o, mode, x, y);
+    program = builder.build();
+  }
+};
+
+TEST(InputSpecializationTest, configuration_is_folded) {
+  ConfigurableProgram p;
+
+  InputSpecializationPass pass({{p.mode, 1}});
+  EXPECT_TRUE(pass.run(p.program));
+  EXPECT_EQ(p.program->get_inputs(), (std::vector<reg_t>{p.a, p.b}));
+  // Only y = AND a b and o = LOAD y remain.
+  ASSERT_EQ(p.program->instructions.size(), 2);
+  EXPECT_NE(dynamic_cast<const AndInstruction *>(p.program->instructions[0]), nullptr);
+  const auto *load = dynamic_cast<const LoadInstruction *>(p.program->instructions[1]);
+  ASSERT_NE(load, nullptr);
+  EXPECT_EQ(load->output, p.o);
+}
+
+TEST(InputSpecializationTest, program_clone) {
+  ProgramBuilder builder;
+  auto a = builder.add_register(2, "a", RIF_INPUT);
+  auto o = builder.add_register(4, "o", RIF_OUTPUT);
+  builder.add_ram(o, 2, 4, a, a, a, a);
+  auto program = builder.build();
+
+  auto copy = program->clone();
+  ASSERT_EQ(copy->instructions.size(), 1);
+  EXPECT_NE(copy->instructions[0], program->instructions[0]);
+  EXPECT_EQ(copy->memories[0].parent, copy->instructions[0]);
+  EXPECT_EQ(program->memories[0].parent, program->instructions[0]);
+  EXPECT_EQ(copy->registers.get_name(a), "a");
+}
+
+TEST(InputSpecializationTest, simulator_api) {
+  ConfigurableProgram p;
+  Simulator simulator(p.program);
+
+  simulator.fix_inputs({{p.mode, 0}});
+  const auto xor_program = simulator.get_program();
+  EXPECT_NE(xor_program, p.program);
+  EXPECT_FALSE(xor_program->registers.get_flags(p.mode) & RIF_INPUT);
+  simulator.set_register(p.a, 1);
+  simulator.set_register(p.b, 1);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(p.o), 0);
+
+  simulator.fix_inputs({{p.mode, 1}});
+  simulator.set_register(p.a, 1);
+  simulator.set_register(p.b, 1);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(p.o), 1);
+
+  // The specialized programs are cached.
+  simulator.fix_inputs({{p.mode, 0}});
+  EXPECT_EQ(simulator.get_program(), xor_program);
+
+  // The original program is left untouched.
+  simulator.fix_inputs({});
+  EXPECT_EQ(simulator.get_program(), p.program);
+  EXPECT_EQ(p.program->instructions.size(), 3);
+  simulator.set_register(p.mode, 1);
+  simulator.set_register(p.a, 1);
+  simulator.set_register(p.b, 0);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(p.o), 0);
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include "passes/known_bits.hpp"
+#include "simulator/simulator.hpp"
+
+TEST(KnownBitsTest, canonical_registers) {
+  ProgramBuilder builder;
+  auto a = builder.add_register(4, "a", RIF_INPUT);
+  auto n = builder.add_register(4, "n");
+  auto x = builder.add_register(4, "x");
+  auto y = builder.add_register(4, "y");
+  auto s = builder.add_register(1, "s");
+  auto r = builder.add_register(4, "r");
+  builder.add_not(n, a);
+  builder.add_and(x, n, a);
+  builder.add_or(y, n, a);
+  builder.add_select(s, 0, n);
+  builder.add_reg(r, n);
+  auto program = builder.build();
+
+  const auto analysis = KnownBitsAnalysis::analyze(*program);
+  EXPECT_TRUE(analysis.is_canonical(a));
+  EXPECT_FALSE(analysis.is_canonical(n));
+  EXPECT_TRUE(analysis.is_canonical(x));
+  EXPECT_FALSE(analysis.is_canonical(y));
+  EXPECT_TRUE(analysis.is_canonical(s));
+  EXPECT_FALSE(analysis.is_canonical(r));
+  EXPECT_EQ(analysis.get_mask(x), ~reg_value_t(0));
+  EXPECT_EQ(analysis.get_mask(y), 0b1111);
+}
+
+TEST(KnownBitsTest, constants) {
+  ProgramBuilder builder;
+  auto c = builder.add_register(1, "c", RIF_INPUT);
+  auto k1 = builder.add_register(4);
+  auto k2 = builder.add_register(4);
+  auto m = builder.add_register(4, "m");
+  auto o = builder.add_register(6, "o");
+  builder.add_const(k1, 0b1100);
+  builder.add_const(k2, 0b1010);
+  builder.add_mux(m, c, k1, k2);
+  builder.add_concat(o, m, k2);
+  auto program = builder.build();
+
+  const auto analysis = KnownBitsAnalysis::analyze(*program);
+  const auto &mux_bits = analysis.get_known_bits(m);
+  EXPECT_EQ(mux_bits.one, 0b1000);
+  EXPECT_EQ(mux_bits.zero, ~reg_value_t(0b1110));
+  const auto &concat_bits = analysis.get_known_bits(o);
+  EXPECT_EQ(concat_bits.one, 0b1010'1000);
+  EXPECT_EQ(concat_bits.zero, ~reg_value_t(0b1010'1110));
+}
+
+TEST(KnownBitsTest, register_loops) {
+  // r1 = REG x1, x1 = XOR r1 a is always canonical.
+  // r2 = REG x2, x2 = NOT r2 is not canonical from the second cycle.
+  ProgramBuilder builder;
+  auto a = builder.add_register(2, "a", RIF_INPUT);
+  auto r1 = builder.add_register(2, "r1");
+  auto x1 = builder.add_register(2, "x1");
+  auto r2 = builder.add_register(2, "r2");
+  auto x2 = builder.add_register(2, "x2");
+  builder.add_reg(r1, x1);
+  builder.add_xor(x1, r1, a);
+  builder.add_reg(r2, x2);
+  builder.add_not(x2, r2);
+  auto program = builder.build();
+
+  const auto analysis = KnownBitsAnalysis::analyze(*program);
+  EXPECT_TRUE(analysis.is_canonical(r1));
+  EXPECT_TRUE(analysis.is_canonical(x1));
+  EXPECT_FALSE(analysis.is_canonical(r2));
+  EXPECT_FALSE(analysis.is_canonical(x2));
+}
+
+TEST(KnownBitsTest, high_bits_are_not_observable) {
+  ProgramBuilder builder;
+  auto a = builder.add_register(1, "a", RIF_INPUT);
+  auto b = builder.add_register(2, "b", RIF_INPUT);
+  auto z = builder.add_register(2, "z", RIF_INPUT);
+  auto n = builder.add_register(1, "n");
+  auto m = builder.add_register(2, "m", RIF_OUTPUT);
+  auto c = builder.add_register(3, "c", RIF_OUTPUT);
+  auto addr = builder.add_register(2, "addr");
+  auto r = builder.add_register(4, "r", RIF_OUTPUT);
+  builder.add_not(n, a);
+  builder.add_mux(m, n, b, z);
+  builder.add_concat(c, n, b);
+  builder.add_not(addr, b);
+  builder.add_ram(r, 2, 4, addr, a, addr, b);
+  auto program = builder.build();
+
+  Simulator simulator(program);
+  simulator.set_register(a, 0b1);
+  simulator.set_register(b, 0b10);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(m), 0b10);
+  EXPECT_EQ(simulator.get_register(c), 0b100);
+  EXPECT_EQ(simulator.get_register(r), 0);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(r), 0b10);
+}
+
+TEST(KnownBitsTest, wide_registers) {
+  ProgramBuilder builder;
+  auto a = builder.add_register(64, "a", RIF_INPUT);
+  auto s = builder.add_register(40, "s", RIF_OUTPUT);
+  builder.add_slice(s, 8, 47, a);
+  auto program = builder.build();
+
+  Simulator simulator(program);
+  simulator.set_register(a, 0xfedcba9876543210);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(a), 0xfedcba9876543210);
+  EXPECT_EQ(simulator.get_register(s), 0xba98765432);
+}
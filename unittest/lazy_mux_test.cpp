@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+
+#include "dependency_graph.hpp"
+#include "passes/lazy_mux.hpp"
+#include "simulator/simulator.hpp"
+
+static void schedule(const std::shared_ptr<Program> &program) {
+  ReportManager report_manager;
+  DependencyGraph graph = DependencyGraph::build(program);
+  graph.schedule(report_manager);
+}
+
+/// Returns the instruction defining \a reg in \a program, or null.
+static const Instruction *find_definition(const std::shared_ptr<Program> &program, reg_t reg) {
+  for (const auto *instruction : program->instructions) {
+    if (instruction->output == reg)
+      return instruction;
+  }
+  return nullptr;
+}
+
+TEST(LazyMuxTest, exclusive_logic_is_guarded) {
+  // o = MUX s (AND (XOR a b) a) (NOT (OR a b))
+  ProgramBuilder builder;
+  auto s = builder.add_register(1, "s", RIF_INPUT);
+  auto a = builder.add_register(8, "a", RIF_INPUT);
+  auto b = builder.add_register(8, "b", RIF_INPUT);
+  auto o = builder.add_register(8, "o", RIF_OUTPUT);
+  auto t0 = builder.add_register(8);
+  auto t1 = builder.add_register(8);
+  auto t2 = builder.add_register(8);
+  auto t3 = builder.add_register(8);
+  builder.add_xor(t0, a, b);
+  builder.add_and(t1, t0, a);
+  builder.add_or(t2, a, b);
+  builder.add_not(t3, t2);
+  builder.add_mux(o, s, t1, t3);
+  auto program = builder.build();
+
+  LazyMuxPass pass;
+  EXPECT_TRUE(pass.run(program));
+  ASSERT_EQ(program->instructions.size(), 1);
+  const auto *lazy_mux = dynamic_cast<const LazyMuxInstruction *>(find_definition(program, o));
+  ASSERT_NE(lazy_mux, nullptr);
+  EXPECT_EQ(lazy_mux->first_body.size(), 2);
+  EXPECT_EQ(lazy_mux->second_body.size(), 2);
+  EXPECT_EQ(lazy_mux->body_inputs, (std::vector<reg_t>{a, b}));
+  schedule(program);
+
+  Simulator simulator(program);
+  for (reg_value_t i = 0; i < 16; ++i) {
+    const reg_value_t choice = i % 2, x = 37 * i, y = 0xA5 ^ i;
+    simulator.set_register(s, choice);
+    simulator.set_register(a, x);
+    simulator.set_register(b, y);
+    simulator.cycle();
+    const auto expected = choice == 0 ? ((x ^ y) & x) : ~(x | y);
+    EXPECT_EQ(simulator.get_register(o) & 0xFF, expected & 0xFF);
+  }
+}
+
+TEST(LazyMuxTest, shared_logic_is_kept) {
+  // t0 is used by both operands and t1 is an output, only t2 is guarded.
+  ProgramBuilder builder;
+  auto s = builder.add_register(1, "s", RIF_INPUT);
+  auto a = builder.add_register(4, "a", RIF_INPUT);
+  auto o = builder.add_register(4, "o", RIF_OUTPUT);
+  auto t0 = builder.add_register(4);
+  auto t1 = builder.add_register(4, "t1", RIF_OUTPUT);
+  auto t2 = builder.add_register(4);
+  builder.add_not(t0, a);
+  builder.add_and(t1, t0, a);
+  builder.add_or(t2, t0, a);
+  builder.add_mux(o, s, t1, t2);
+  auto program = builder.build();
+
+  LazyMuxPass pass;
+  EXPECT_TRUE(pass.run(program));
+  const auto *lazy_mux = dynamic_cast<const LazyMuxInstruction *>(find_definition(program, o));
+  ASSERT_NE(lazy_mux, nullptr);
+  EXPECT_TRUE(lazy_mux->first_body.empty());
+  ASSERT_EQ(lazy_mux->second_body.size(), 1);
+  EXPECT_EQ(lazy_mux->second_body[0]->output, t2);
+  EXPECT_NE(find_definition(program, t0), nullptr);
+  EXPECT_NE(find_definition(program, t1), nullptr);
+}
+
+TEST(LazyMuxTest, nested_muxes) {
+  // o = MUX s0 (MUX s1 (NOT a) (NOT b)) (NOT c)
+  ProgramBuilder builder;
+  auto s0 = builder.add_register(1, "s0", RIF_INPUT);
+  auto s1 = builder.add_register(1, "s1", RIF_INPUT);
+  auto a = builder.add_register(1, "a", RIF_INPUT);
+  auto b = builder.add_register(1, "b", RIF_INPUT);
+  auto c = builder.add_register(1, "c", RIF_INPUT);
+  auto o = builder.add_register(1, "o", RIF_OUTPUT);
+  auto na = builder.add_register(1);
+  auto nb = builder.add_register(1);
+  auto nc = builder.add_register(1);
+  auto inner = builder.add_register(1);
+  builder.add_not(na, a);
+  builder.add_not(nb, b);
+  builder.add_not(nc, c);
+  builder.add_mux(inner, s1, na, nb);
+  builder.add_mux(o, s0, inner, nc);
+  auto program = builder.build();
+
+  LazyMuxPass pass;
+  EXPECT_TRUE(pass.run(program));
+  ASSERT_EQ(program->instructions.size(), 1);
+  const auto *lazy_mux = dynamic_cast<const LazyMuxInstruction *>(find_definition(program, o));
+  ASSERT_NE(lazy_mux, nullptr);
+  ASSERT_EQ(lazy_mux->first_body.size(), 1);
+  EXPECT_NE(dynamic_cast<const LazyMuxInstruction *>(lazy_mux->first_body[0]), nullptr);
+  EXPECT_EQ(lazy_mux->body_inputs, (std::vector<reg_t>{s1, a, b, c}));
+  schedule(program);
+
+  Simulator simulator(program);
+  for (reg_value_t i = 0; i < 32; ++i) {
+    const reg_value_t x0 = i & 1, x1 = (i >> 1) & 1, x = (i >> 2) & 1, y = (i >> 3) & 1, z = (i >> 4) & 1;
+    simulator.set_register(s0, x0);
+    simulator.set_register(s1, x1);
+    simulator.set_register(a, x);
+    simulator.set_register(b, y);
+    simulator.set_register(c, z);
+    simulator.cycle();
+    const auto expected = x0 == 0 ? (x1 == 0 ? !x : !y) : !z;
+    EXPECT_EQ(simulator.get_register(o) & 1, expected);
+  }
+}
+
+TEST(LazyMuxTest, registers_are_kept) {
+  // r = REG t is read by a register, so t must be computed every cycle.
+  ProgramBuilder builder;
+  auto s = builder.add_register(1, "s", RIF_INPUT);
+  auto a = builder.add_register(1, "a", RIF_INPUT);
+  auto o = builder.add_register(1, "o", RIF_OUTPUT);
+  auto t = builder.add_register(1);
+  auto r = builder.add_register(1, "r", RIF_OUTPUT);
+  builder.add_not(t, a);
+  builder.add_reg(r, t);
+  builder.add_mux(o, s, t, a);
+  auto program = builder.build();
+
+  LazyMuxPass pass;
+  EXPECT_FALSE(pass.run(program));
+}
+
+TEST(LazyMuxTest, clone_copies_bodies) {
+  LazyMuxInstruction lazy_mux;
+  auto *body_instruction = new NotInstruction();
+  body_instruction->output = reg_t{3};
+  body_instruction->input = reg_t{2};
+  lazy_mux.output = reg_t{4};
+  lazy_mux.choice = reg_t{0};
+  lazy_mux.first = reg_t{3};
+  lazy_mux.second = reg_t{1};
+  lazy_mux.first_body.push_back(body_instruction);
+  lazy_mux.body_inputs = {reg_t{2}};
+
+  std::unique_ptr<Instruction> clone(clone_instruction(lazy_mux));
+  const auto *copy = dynamic_cast<const LazyMuxInstruction *>(clone.get());
+  ASSERT_NE(copy, nullptr);
+  ASSERT_EQ(copy->first_body.size(), 1);
+  EXPECT_NE(copy->first_body[0], body_instruction);
+  EXPECT_EQ(copy->first_body[0]->output, reg_t{3});
+  EXPECT_EQ(get_instruction_inputs(*copy), (std::vector<reg_t>{reg_t{0}, reg_t{1}, reg_t{2}}));
+}
@@ -75,6 +75,38 @@ TEST(LexerTest, keywords) {
   EXPECT_EQ(token.position.offset, 10);
 }
 
+TEST(LexerTest, all_keywords) {
+  const std::pair<std::string_view, TokenKind> keywords[] = {
+      {"OUTPUT", TokenKind::KEY_OUTPUT}, {"INPUT", TokenKind::KEY_INPUT},   {"VAR", TokenKind::KEY_VAR},
+      {"IN", TokenKind::KEY_IN},         {"NOT", TokenKind::KEY_NOT},       {"AND", TokenKind::KEY_AND},
+      {"NAND", TokenKind::KEY_NAND},     {"OR", TokenKind::KEY_OR},         {"NOR", TokenKind::KEY_NOR},
+      {"XOR", TokenKind::KEY_XOR},       {"XNOR", TokenKind::KEY_XNOR},     {"MUX", TokenKind::KEY_MUX},
+      {"REG", TokenKind::KEY_REG},       {"CONCAT", TokenKind::KEY_CONCAT}, {"SELECT", TokenKind::KEY_SELECT},
+      {"SLICE", TokenKind::KEY_SLICE},   {"ROM", TokenKind::KEY_ROM},       {"RAM", TokenKind::KEY_RAM},
+      {"ADD", TokenKind::KEY_ADD},       {"SUB", TokenKind::KEY_SUB},       {"MUL", TokenKind::KEY_MUL},
+      {"EQ", TokenKind::KEY_EQ},         {"LT", TokenKind::KEY_LT},         {"SHL", TokenKind::KEY_SHL},
+      {"SHR", TokenKind::KEY_SHR},       {"ASR", TokenKind::KEY_ASR},       {"REDOR", TokenKind::KEY_REDOR},
+      {"REDAND", TokenKind::KEY_REDAND},
+  };
+
+  for (const auto &[spelling, kind] : keywords) {
+    ReportManager report_manager;
+    Lexer lexer(report_manager, spelling.data());
+    Token token;
+    lexer.tokenize(token);
+    EXPECT_EQ(token.kind, kind) << spelling;
+  }
+
+  // Close to keywords but identifiers.
+  for (const char *spelling : {"ADDR", "EQU", "LTE", "RED", "SH", "REDXOR", "ASL"}) {
+    ReportManager report_manager;
+    Lexer lexer(report_manager, spelling);
+    Token token;
+    lexer.tokenize(token);
+    EXPECT_EQ(token.kind, TokenKind::IDENTIFIER) << spelling;
+  }
+}
+
 TEST(LexerTest, integers) {
   ReportManager report_manager;
   Lexer lexer(report_manager, "0 42 0b1101 0xff 0d42");
@@ -126,3 +158,29 @@ TEST(LexerTest, comments) {
   EXPECT_EQ(token.spelling, "");
   EXPECT_EQ(token.position.offset, 11);
 }
+
+TEST(LexerTest, range) {
+  ReportManager report_manager;
+  Lexer lexer(report_manager, "a = b\n  c = d # e\nf = g\n");
+  Token token;
+
+  // Lexes the second line, the whitespaces of the third one are skipped.
+  Lexer range_lexer(report_manager, lexer, 6, 18);
+
+  range_lexer.tokenize(token);
+  EXPECT_EQ(token.kind, TokenKind::IDENTIFIER);
+  EXPECT_EQ(token.spelling, "c");
+  EXPECT_EQ(token.position.offset, 8);
+
+  range_lexer.tokenize(token);
+  EXPECT_EQ(token.kind, TokenKind::EQUAL);
+
+  range_lexer.tokenize(token);
+  EXPECT_EQ(token.kind, TokenKind::IDENTIFIER);
+  EXPECT_EQ(token.spelling, "d");
+  EXPECT_EQ(token.position.offset, 12);
+
+  range_lexer.tokenize(token);
+  EXPECT_EQ(token.kind, TokenKind::EOI);
+  EXPECT_EQ(token.position.offset, 18);
+}
@@ -80,6 +80,41 @@ TEST(LineMapTest, prefill)
   EXPECT_EQ(lm.get_line_number(11), 3);
 }
 
+TEST(LineMapTest, lazy_prefill)
+{
+  LineMap lm;
+  const std::string_view buffer = "foo\nbar\r\nhello\r\rworld";
+
+  // Only the line endings before the position 8 are scanned, the CR-LF one is
+  // fully read.
+  lm.prefill(buffer, 8);
+  EXPECT_EQ(lm.get_prefilled_end(), 9);
+  EXPECT_EQ(lm.get_line_count(), 3);
+  EXPECT_EQ(lm.get_line_number(6), 2);
+
+  // Continue from there.
+  lm.prefill(buffer);
+  EXPECT_EQ(lm.get_prefilled_end(), buffer.size());
+  EXPECT_EQ(lm.get_line_count(), 5);
+  EXPECT_EQ(lm.get_line_start_position(4), 15);
+  EXPECT_EQ(lm.get_line_start_position(5), 16);
+  EXPECT_EQ(lm.get_line_number(17), 5);
+  EXPECT_EQ(lm.get_column_number(17), 2);
+}
+
+TEST(LineMapTest, large_positions)
+{
+  // Positions past 4 GiB.
+  LineMap lm;
+  const uint64_t position = uint64_t(5) << 30;
+  lm.add_newline(position);
+
+  EXPECT_EQ(lm.get_line_number(position - 1), 1);
+  EXPECT_EQ(lm.get_line_number(position + 10), 2);
+  EXPECT_EQ(lm.get_column_number(position + 10), 11);
+  EXPECT_EQ(lm.get_line_start_position(2), position);
+}
+
 TEST(LineMapTest, clear) {
   LineMap lm;
 
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include "simulator/lowered_program.hpp"
+
+TEST(LoweredProgramTest, state_elements) {
+  // o = AND (REG t) c where t = NOT a and c = CONST 0101.
+  ProgramBuilder builder;
+  auto a = builder.add_register(4, "a", RIF_INPUT);
+  auto o = builder.add_register(4, "o", RIF_OUTPUT);
+  auto t = builder.add_register(4, "t");
+  auto r = builder.add_register(4, "r");
+  auto c = builder.add_register(4, "c");
+  builder.add_const(c, 0b0101);
+  builder.add_not(t, a);
+  builder.add_reg(r, t);
+  builder.add_and(o, r, c);
+  auto program = builder.build();
+
+  const auto lowered = LoweredProgram::lower(*program);
+  EXPECT_EQ(lowered.register_count, 5);
+  // The constant is set once and its instruction removed.
+  ASSERT_EQ(lowered.instructions.size(), 3);
+  EXPECT_EQ(lowered.constants, (std::vector<std::pair<reg_index_t, reg_value_t>>{{c.index, 0b0101}}));
+  EXPECT_EQ(lowered.state_registers, std::vector<reg_index_t>{t.index});
+
+  const auto &reg = lowered.instructions[1];
+  EXPECT_EQ(reg.opcode, LoweredOpcode::REG);
+  EXPECT_EQ(reg.output, r.index);
+  EXPECT_EQ(reg.operands[0], t.index);
+  EXPECT_EQ(reg.width, 4);
+}
+
+TEST(LoweredProgramTest, dump) {
+  // o = EQ (NOT a) b, the result of NOT is masked as its high bits are garbage.
+  ProgramBuilder builder;
+  auto a = builder.add_register(4, "a", RIF_INPUT);
+  auto b = builder.add_register(4, "b", RIF_INPUT);
+  auto o = builder.add_register(1, "o", RIF_OUTPUT);
+  auto t = builder.add_register(4, "t");
+  builder.add_not(t, a);
+  builder.add_eq(o, t, b);
+  auto program = builder.build();
+
+  std::stringstream out;
+  LoweredProgram::lower(*program).dump(out);
+  EXPECT_EQ(out.str(), R"(; 4 registers, 2 instructions
+%3:4 = NOT %0
+%2:1 = EQ %3&0xf %1
+)");
+}
+
+TEST(LoweredProgramTest, bit_packing) {
+  // o = XOR a b and p = NOT w, with a constant single bit c.
+  ProgramBuilder builder;
+  auto a = builder.add_register(1, "a", RIF_INPUT);
+  auto b = builder.add_register(1, "b", RIF_INPUT);
+  auto w = builder.add_register(4, "w", RIF_INPUT);
+  auto c = builder.add_register(1, "c", RIF_OUTPUT);
+  auto o = builder.add_register(1, "o", RIF_OUTPUT);
+  auto p = builder.add_register(4, "p", RIF_OUTPUT);
+  builder.add_const(c, 1);
+  builder.add_xor(o, a, b);
+  builder.add_not(p, w);
+  auto program = builder.build();
+
+  const auto lowered = LoweredProgram::lower(*program, true);
+  EXPECT_TRUE(lowered.is_bit_packed);
+  EXPECT_EQ(lowered.register_count, 6);
+  // The single bit registers share the first slot.
+  EXPECT_EQ(lowered.slot_count, 3);
+  EXPECT_EQ(lowered.locations[b.index].slot, lowered.locations[a.index].slot);
+  EXPECT_EQ(lowered.locations[b.index].shift, 1);
+  EXPECT_EQ(lowered.locations[w.index].shift, 0);
+  EXPECT_EQ(lowered.constants, (std::vector<std::pair<reg_index_t, reg_value_t>>{{0, 1 << 2}}));
+
+  ASSERT_EQ(lowered.instructions.size(), 2);
+  const auto &xor_inst = lowered.instructions[0];
+  EXPECT_EQ(xor_inst.output, 0);
+  EXPECT_EQ(xor_inst.output_shift, 3);
+  EXPECT_EQ(xor_inst.shifts, (std::array<std::uint_least8_t, 3>{0, 1, 0}));
+  EXPECT_EQ(xor_inst.masks[0], 1);
+  EXPECT_EQ(lowered.instructions[1].output, lowered.locations[p.index].slot);
+
+  // Without bit packing, each register has its own slot.
+  const auto unpacked = LoweredProgram::lower(*program);
+  EXPECT_FALSE(unpacked.is_bit_packed);
+  EXPECT_EQ(unpacked.slot_count, 6);
+  EXPECT_EQ(unpacked.locations[c.index].slot, c.index);
+  EXPECT_EQ(unpacked.locations[o.index].shift, 0);
+}
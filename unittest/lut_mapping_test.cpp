@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+
+#include "dependency_graph.hpp"
+#include "passes/lut_mapping.hpp"
+#include "simulator/simulator.hpp"
+
+static void schedule(const std::shared_ptr<Program> &program) {
+  ReportManager report_manager;
+  DependencyGraph graph = DependencyGraph::build(program);
+  graph.schedule(report_manager);
+}
+
+/// Returns the instruction defining \a reg in \a program, or null.
+static const Instruction *find_definition(const std::shared_ptr<Program> &program, reg_t reg) {
+  for (const auto *instruction : program->instructions) {
+    if (instruction->output == reg)
+      return instruction;
+  }
+  return nullptr;
+}
+
+/// Builds a 1-bit full adder, the sum in \a s and the carry out in \a c.
+static void build_full_adder(ProgramBuilder &builder, reg_t s, reg_t c, reg_t a, reg_t b, reg_t cin) {
+  auto p = builder.add_register(1);
+  auto g = builder.add_register(1);
+  auto t = builder.add_register(1);
+  builder.add_xor(p, a, b);
+  builder.add_and(g, a, b);
+  builder.add_xor(s, p, cin);
+  builder.add_and(t, p, cin);
+  builder.add_or(c, g, t);
+}
+
+TEST(LutMappingTest, lut_entries) {
+  ProgramBuilder builder;
+  auto a = builder.add_register(2, "a", RIF_INPUT);
+  auto b = builder.add_register(1, "b", RIF_INPUT);
+  auto o = builder.add_register(3, "o", RIF_OUTPUT);
+  const std::vector<reg_value_t> entries = {7, 1, 2, 3, 4, 5, 6, 0};
+  const auto &lut = builder.add_lut(o, {a, b}, entries);
+  EXPECT_EQ(lut.entry_shift, 2);
+  EXPECT_EQ(lut.table.size(), 1);
+  for (size_t i = 0; i < entries.size(); ++i)
+    EXPECT_EQ(lut.get_entry(i), entries[i]);
+  auto program = builder.build();
+  schedule(program);
+
+  // The first input is in the low bits of the index.
+  Simulator simulator(program);
+  for (reg_value_t i = 0; i < 8; ++i) {
+    simulator.set_register(a, i & 0b11);
+    simulator.set_register(b, i >> 2);
+    simulator.cycle();
+    EXPECT_EQ(simulator.get_register(o), entries[i]);
+  }
+}
+
+TEST(LutMappingTest, full_adder) {
+  ProgramBuilder builder;
+  auto a = builder.add_register(1, "a", RIF_INPUT);
+  auto b = builder.add_register(1, "b", RIF_INPUT);
+  auto cin = builder.add_register(1, "cin", RIF_INPUT);
+  auto s = builder.add_register(1, "s", RIF_OUTPUT);
+  auto c = builder.add_register(1, "c", RIF_OUTPUT);
+  build_full_adder(builder, s, c, a, b, cin);
+  auto program = builder.build();
+
+  // `p = XOR a b` is used twice so it is kept, the carry cone absorbs the other gates.
+  LutMappingPass pass;
+  EXPECT_TRUE(pass.run(program));
+  EXPECT_NE(dynamic_cast<const LutInstruction *>(find_definition(program, c)), nullptr);
+  schedule(program);
+
+  Simulator simulator(program);
+  for (reg_value_t i = 0; i < 8; ++i) {
+    simulator.set_register(a, i & 1);
+    simulator.set_register(b, (i >> 1) & 1);
+    simulator.set_register(cin, i >> 2);
+    simulator.cycle();
+    const auto sum = (i & 1) + ((i >> 1) & 1) + (i >> 2);
+    EXPECT_EQ(simulator.get_register(s), sum & 1);
+    EXPECT_EQ(simulator.get_register(c), sum >> 1);
+  }
+}
+
+TEST(LutMappingTest, input_bits_limit) {
+  // o = XOR (AND a b) (AND c d) (OR e f) with 4-bit inputs does not fit in 8 bits.
+  ProgramBuilder builder;
+  std::vector<reg_t> inputs;
+  for (const char *name : {"a", "b", "c", "d", "e", "f"})
+    inputs.push_back(builder.add_register(4, name, RIF_INPUT));
+  auto o = builder.add_register(4, "o", RIF_OUTPUT);
+  auto t0 = builder.add_register(4);
+  auto t1 = builder.add_register(4);
+  auto t2 = builder.add_register(4);
+  auto t3 = builder.add_register(4);
+  builder.add_and(t0, inputs[0], inputs[1]);
+  builder.add_and(t1, inputs[2], inputs[3]);
+  builder.add_or(t2, inputs[4], inputs[5]);
+  builder.add_xor(t3, t0, t1);
+  builder.add_xor(o, t3, t2);
+  auto program = builder.build();
+
+  LutMappingPass pass(8);
+  pass.run(program);
+  for (const auto *instruction : program->instructions) {
+    if (const auto *lut = dynamic_cast<const LutInstruction *>(instruction)) {
+      bus_size_t input_bits = 0;
+      for (const auto input : lut->inputs)
+        input_bits += program->registers.get_bus_size(input);
+      EXPECT_LE(input_bits, 8);
+    }
+  }
+  schedule(program);
+
+  Simulator simulator(program);
+  const reg_value_t values[] = {0b1010, 0b0110, 0b1111, 0b0011, 0b0101, 0b1000};
+  for (size_t i = 0; i < inputs.size(); ++i)
+    simulator.set_register(inputs[i], values[i]);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(o), ((values[0] & values[1]) ^ (values[2] & values[3])) ^ (values[4] | values[5]));
+}
+
+TEST(LutMappingTest, registers_are_kept) {
+  // r = REG (NOT (AND r a)) must keep its REG.
+  ProgramBuilder builder;
+  auto a = builder.add_register(1, "a", RIF_INPUT);
+  auto r = builder.add_register(1, "r", RIF_OUTPUT);
+  auto t = builder.add_register(1);
+  auto n = builder.add_register(1);
+  builder.add_and(t, r, a);
+  builder.add_not(n, t);
+  builder.add_reg(r, n);
+  auto program = builder.build();
+
+  LutMappingPass pass;
+  EXPECT_TRUE(pass.run(program));
+  EXPECT_NE(dynamic_cast<const RegInstruction *>(find_definition(program, r)), nullptr);
+  EXPECT_NE(dynamic_cast<const LutInstruction *>(find_definition(program, n)), nullptr);
+}
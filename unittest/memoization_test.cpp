@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include "dependency_graph.hpp"
+#include "passes/memoization.hpp"
+#include "simulator/simulator.hpp"
+
+static void schedule(const std::shared_ptr<Program> &program) {
+  ReportManager report_manager;
+  DependencyGraph graph = DependencyGraph::build(program);
+  graph.schedule(report_manager);
+}
+
+/// Returns the instruction defining \a reg in \a program, or null.
+static const Instruction *find_definition(const std::shared_ptr<Program> &program, reg_t reg) {
+  for (const auto *instruction : program->instructions) {
+    if (instruction->output == reg)
+      return instruction;
+  }
+  return nullptr;
+}
+
+/// Builds `o = ((a XOR b) AND (NOT a)) OR ((a AND b) XOR c)`, a cone of 6 gates.
+static std::shared_ptr<Program> build_cone(reg_t &a, reg_t &b, reg_t &c, reg_t &o) {
+  ProgramBuilder builder;
+  a = builder.add_register(8, "a", RIF_INPUT);
+  b = builder.add_register(8, "b", RIF_INPUT);
+  c = builder.add_register(8, "c", RIF_INPUT);
+  o = builder.add_register(8, "o", RIF_OUTPUT);
+  auto t0 = builder.add_register(8);
+  auto t1 = builder.add_register(8);
+  auto t2 = builder.add_register(8);
+  auto t3 = builder.add_register(8);
+  auto t4 = builder.add_register(8);
+  builder.add_xor(t0, a, b);
+  builder.add_not(t1, a);
+  builder.add_and(t2, t0, t1);
+  builder.add_and(t3, a, b);
+  builder.add_xor(t4, t3, c);
+  builder.add_or(o, t2, t4);
+  return builder.build();
+}
+
+static reg_value_t expected_cone(reg_value_t a, reg_value_t b, reg_value_t c) {
+  return (((a ^ b) & ~a) | ((a & b) ^ c)) & 0xFF;
+}
+
+TEST(MemoizationTest, cone_is_memoized) {
+  reg_t a, b, c, o;
+  auto program = build_cone(a, b, c, o);
+
+  MemoizationPass pass(/* min_gate_count= */ 4);
+  EXPECT_TRUE(pass.run(program));
+  ASSERT_EQ(program->instructions.size(), 1);
+  const auto *memo = dynamic_cast<const MemoInstruction *>(find_definition(program, o));
+  ASSERT_NE(memo, nullptr);
+  EXPECT_EQ(memo->inputs.size(), 3);
+  EXPECT_EQ(memo->body.size(), 6);
+  schedule(program);
+
+  // Only 4 distinct input patterns.
+  Simulator simulator(program);
+  for (reg_value_t i = 0; i < 40; ++i) {
+    const reg_value_t x = 17 * (i % 4), y = 0xF0 ^ (i % 4), z = 3;
+    simulator.set_register(a, x);
+    simulator.set_register(b, y);
+    simulator.set_register(c, z);
+    simulator.cycle();
+    EXPECT_EQ(simulator.get_register(o), expected_cone(x, y, z));
+  }
+
+  const auto statistics = simulator.get_backend()->get_memo_statistics();
+  ASSERT_EQ(statistics.size(), 1);
+  EXPECT_EQ(statistics[0].output, o);
+  EXPECT_EQ(statistics[0].misses, 4);
+  EXPECT_EQ(statistics[0].hits, 36);
+  EXPECT_FALSE(statistics[0].is_disabled);
+}
+
+TEST(MemoizationTest, low_hit_rate_disables_cache) {
+  reg_t a, b, c, o;
+  auto program = build_cone(a, b, c, o);
+
+  MemoizationPass pass(/* min_gate_count= */ 4);
+  EXPECT_TRUE(pass.run(program));
+  schedule(program);
+
+  // All input patterns are distinct.
+  Simulator simulator(program);
+  for (reg_value_t i = 0; i < 2000; ++i) {
+    simulator.set_register(a, i & 0xFF);
+    simulator.set_register(b, i >> 8);
+    simulator.set_register(c, 0);
+    simulator.cycle();
+    EXPECT_EQ(simulator.get_register(o), expected_cone(i & 0xFF, i >> 8, 0));
+  }
+
+  const auto statistics = simulator.get_backend()->get_memo_statistics();
+  ASSERT_EQ(statistics.size(), 1);
+  EXPECT_TRUE(statistics[0].is_disabled);
+  EXPECT_EQ(statistics[0].misses, 2000);
+}
+
+TEST(MemoizationTest, profiling_ends_on_a_hit) {
+  reg_t a, b, c, o;
+  auto program = build_cone(a, b, c, o);
+
+  MemoizationPass pass(/* min_gate_count= */ 4);
+  EXPECT_TRUE(pass.run(program));
+  schedule(program);
+
+  // All input patterns are distinct, except the 1024th lookup which repeats the previous one.
+  Simulator simulator(program);
+  for (reg_value_t i = 0; i < 1500; ++i) {
+    const reg_value_t value = (i == 1023) ? 1022 : i;
+    simulator.set_register(a, value & 0xFF);
+    simulator.set_register(b, value >> 8);
+    simulator.set_register(c, 0);
+    simulator.cycle();
+    EXPECT_EQ(simulator.get_register(o), expected_cone(value & 0xFF, value >> 8, 0));
+  }
+
+  const auto statistics = simulator.get_backend()->get_memo_statistics();
+  ASSERT_EQ(statistics.size(), 1);
+  EXPECT_TRUE(statistics[0].is_disabled);
+  EXPECT_EQ(statistics[0].hits, 1);
+  EXPECT_EQ(statistics[0].misses, 1499);
+}
+
+TEST(MemoizationTest, small_cones_are_kept) {
+  reg_t a, b, c, o;
+  auto program = build_cone(a, b, c, o);
+
+  MemoizationPass pass;
+  EXPECT_FALSE(pass.run(program));
+}
+
+TEST(MemoizationTest, clone_copies_body) {
+  reg_t a, b, c, o;
+  auto program = build_cone(a, b, c, o);
+
+  MemoizationPass pass(/* min_gate_count= */ 4);
+  EXPECT_TRUE(pass.run(program));
+  auto copy = program->clone();
+  program.reset(); // the copy must not share the body instructions
+  schedule(copy);
+
+  Simulator simulator(copy);
+  simulator.set_register(a, 0x5A);
+  simulator.set_register(b, 0x3C);
+  simulator.set_register(c, 0x81);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(o), expected_cone(0x5A, 0x3C, 0x81));
+}
@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include "passes/output_cone.hpp"
+#include "simulator/simulator.hpp"
+
+TEST(OutputConeTest, unused_logic_is_removed) {
+  ProgramBuilder builder;
+  auto a = builder.add_register(1, "a", RIF_INPUT);
+  auto b = builder.add_register(1, "b", RIF_INPUT);
+  auto o1 = builder.add_register(1, "o1", RIF_OUTPUT);
+  auto o2 = builder.add_register(1, "o2", RIF_OUTPUT);
+  auto t = builder.add_register(1, "t");
+  builder.add_not(t, a);
+  builder.add_and(o1, t, a);
+  builder.add_xor(o2, a, b);
+  auto program = builder.build();
+
+  OutputConePass pass({o1});
+  EXPECT_TRUE(pass.run(program));
+  EXPECT_EQ(program->instructions.size(), 2);
+  EXPECT_EQ(program->get_outputs(), std::vector<reg_t>{o1});
+  EXPECT_EQ(program->get_inputs(), std::vector<reg_t>{a});
+}
+
+TEST(OutputConeTest, state_is_followed) {
+  // o = REG c, c = XOR o a: the cone of `o` contains `c` through the REG.
+  ProgramBuilder builder;
+  auto a = builder.add_register(1, "a", RIF_INPUT);
+  auto o = builder.add_register(1, "o", RIF_OUTPUT);
+  auto c = builder.add_register(1, "c");
+  auto debug = builder.add_register(1, "debug", RIF_OUTPUT);
+  builder.add_reg(o, c);
+  builder.add_xor(c, o, a);
+  builder.add_not(debug, c);
+  auto program = builder.build();
+
+  OutputConePass pass({o});
+  EXPECT_TRUE(pass.run(program));
+  EXPECT_EQ(program->instructions.size(), 2);
+
+  Simulator simulator(program);
+  simulator.set_register(a, 1);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(o), 0);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(o), 1);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(o), 0);
+}
+
+TEST(OutputConeTest, memories_are_renumbered) {
+  // The first ROM is not in the cone of `o` but the RAM (and its write ports) is.
+  ProgramBuilder builder;
+  auto a = builder.add_register(2, "a", RIF_INPUT);
+  auto we = builder.add_register(1, "we", RIF_INPUT);
+  auto d = builder.add_register(4, "d", RIF_INPUT);
+  auto unused = builder.add_register(4, "unused", RIF_OUTPUT);
+  auto o = builder.add_register(4, "o", RIF_OUTPUT);
+  builder.add_rom(unused, 2, 4, a);
+  builder.add_ram(o, 2, 4, a, we, a, d);
+  auto program = builder.build();
+
+  OutputConePass pass({o});
+  EXPECT_TRUE(pass.run(program));
+  ASSERT_EQ(program->instructions.size(), 1);
+  ASSERT_EQ(program->memories.size(), 1);
+  const auto *ram = dynamic_cast<const RamInstruction *>(program->instructions[0]);
+  ASSERT_NE(ram, nullptr);
+  EXPECT_EQ(ram->memory_block, 0);
+  EXPECT_EQ(program->memories[0].parent, ram);
+  EXPECT_EQ(program->get_inputs(), (std::vector<reg_t>{a, we, d}));
+
+  Simulator simulator(program);
+  simulator.set_register(a, 0b10);
+  simulator.set_register(we, 1);
+  simulator.set_register(d, 0b1001);
+  simulator.cycle();
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(o), 0b1001);
+}
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+
+#include "disassembler.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+
+#include <fmt/format.h>
+
+#include <sstream>
+
+/// Returns a netlist of about 1 MiB using the different kinds of equations, \a error
+/// being inserted after the equation \a error_line if not empty.
+static std::string generate_netlist(std::string_view error = {}, std::size_t error_line = 0) {
+  constexpr std::size_t variable_count = 40000;
+
+  std::string source = "INPUT a, w, r, we\nOUTPUT o\nVAR a : 4, w : 130, r : 2, we, o : 4";
+  for (std::size_t i = 0; i < variable_count; ++i)
+    source += fmt::format(", v{} : 4", i);
+  source += "\nIN\n";
+
+  for (std::size_t i = 0; i < variable_count; ++i) {
+    switch (i % 6) {
+    case 0:
+      source += fmt::format("v{} = AND a 0101\n", i);
+      break;
+    case 1:
+      source += fmt::format("  v{} = XOR v{} a # comment\n", i, i - 1);
+      break;
+    case 2:
+      source += fmt::format("v{} = RAM 2 4 r we r\n  v{}\n", i, i - 1);
+      break;
+    case 3:
+      source += fmt::format("v{}=SLICE 64 67 w\n", i);
+      break;
+    case 4:
+      source += fmt::format("# v{} = NOT a\nv{} = SLICE 62 65 0x123456789abcdef0123456789abcdef01\n", i, i);
+      break;
+    default:
+      source += fmt::format("v{} = ROM 2 4 r\n", i);
+      break;
+    }
+
+    if (!error.empty() && i == error_line)
+      source += error;
+  }
+
+  source += fmt::format("o = v{}\n", variable_count - 1);
+  return source;
+}
+
+static std::string parse_and_disassemble(ReportManager &report_manager, const std::string &source,
+                                         unsigned thread_count) {
+  Lexer lexer(report_manager, source.c_str());
+  Parser parser(report_manager, lexer);
+  parser.set_thread_count(thread_count);
+  auto program = parser.parse_program();
+
+  for (std::size_t i = 0; i < program->memories.size(); ++i)
+    EXPECT_EQ(static_cast<const MemoryInstruction *>(program->memories[i].parent)->memory_block, i);
+
+  std::stringstream out;
+  Disassembler::disassemble(program, out);
+  return out.str();
+}
+
+TEST(ParserTest, parallel) {
+  const auto source = generate_netlist();
+  ASSERT_GT(source.size(), 1024 * 1024);
+
+  ReportManager report_manager;
+  const auto expected = parse_and_disassemble(report_manager, source, 1);
+  EXPECT_EQ(parse_and_disassemble(report_manager, source, 2), expected);
+  EXPECT_EQ(parse_and_disassemble(report_manager, source, 4), expected);
+  EXPECT_EQ(parse_and_disassemble(report_manager, source, 7), expected);
+}
+
+TEST(ParserTest, parallel_error) {
+  // The error of the first chunk is reported even if the other chunks have errors.
+  struct ParseError {
+    std::uint64_t offset;
+  };
+
+  auto source = generate_netlist("x = NOT a\n", 30000);
+  const auto first_error = source.size() / 2;
+  source.insert(source.find('\n', first_error) + 1, "v0 = undefined_variable\n");
+
+  ReportManager report_manager;
+  report_manager.set_exit_handler([](const Report &report) { throw ParseError{report.location->offset}; });
+  for (const unsigned thread_count : {1, 4}) {
+    try {
+      (void)parse_and_disassemble(report_manager, source, thread_count);
+      ADD_FAILURE() << "no error reported";
+    } catch (const ParseError &error) {
+      EXPECT_EQ(error.offset, source.find("v0 = undefined_variable") + 5);
+    }
+  }
+}
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+
+#include "passes/peephole.hpp"
+#include "simulator/simulator.hpp"
+
+/// Returns the instruction defining \a reg in \a program, or null.
+static const Instruction *find_definition(const std::shared_ptr<Program> &program, reg_t reg) {
+  for (const auto *instruction : program->instructions) {
+    if (instruction->output == reg)
+      return instruction;
+  }
+  return nullptr;
+}
+
+TEST(PeepholeTest, not_not) {
+  ProgramBuilder builder;
+  auto a = builder.add_register(8, "a", RIF_INPUT);
+  auto t = builder.add_register(8, "t");
+  auto o = builder.add_register(8, "o", RIF_OUTPUT);
+  builder.add_not(t, a);
+  builder.add_not(o, t);
+  auto program = builder.build();
+
+  PeepholePass pass;
+  EXPECT_TRUE(pass.run(program));
+  ASSERT_EQ(program->instructions.size(), 1);
+  const auto *load = dynamic_cast<const LoadInstruction *>(program->instructions[0]);
+  ASSERT_NE(load, nullptr);
+  EXPECT_EQ(load->output, o);
+  EXPECT_EQ(load->input, a);
+}
+
+TEST(PeepholeTest, same_operands) {
+  ProgramBuilder builder;
+  auto a = builder.add_register(4, "a", RIF_INPUT);
+  auto o1 = builder.add_register(4, "o1", RIF_OUTPUT);
+  auto o2 = builder.add_register(4, "o2", RIF_OUTPUT);
+  auto o3 = builder.add_register(4, "o3", RIF_OUTPUT);
+  auto o4 = builder.add_register(4, "o4", RIF_OUTPUT);
+  builder.add_and(o1, a, a);
+  builder.add_xor(o2, a, a);
+  builder.add_xnor(o3, a, a);
+  builder.add_nand(o4, a, a);
+  auto program = builder.build();
+
+  PeepholePass pass;
+  EXPECT_TRUE(pass.run(program));
+  EXPECT_NE(dynamic_cast<const LoadInstruction *>(find_definition(program, o1)), nullptr);
+  const auto *c2 = dynamic_cast<const ConstInstruction *>(find_definition(program, o2));
+  ASSERT_NE(c2, nullptr);
+  EXPECT_EQ(c2->value, 0);
+  const auto *c3 = dynamic_cast<const ConstInstruction *>(find_definition(program, o3));
+  ASSERT_NE(c3, nullptr);
+  EXPECT_EQ(c3->value, 0b1111);
+  EXPECT_NE(dynamic_cast<const NotInstruction *>(find_definition(program, o4)), nullptr);
+}
+
+TEST(PeepholeTest, nand_not_to_and) {
+  ProgramBuilder builder;
+  auto a = builder.add_register(1, "a", RIF_INPUT);
+  auto b = builder.add_register(1, "b", RIF_INPUT);
+  auto t = builder.add_register(1, "t");
+  auto o = builder.add_register(1, "o", RIF_OUTPUT);
+  builder.add_nand(t, a, b);
+  builder.add_not(o, t);
+  auto program = builder.build();
+
+  PeepholePass pass;
+  EXPECT_TRUE(pass.run(program));
+  ASSERT_EQ(program->instructions.size(), 1);
+  const auto *and_inst = dynamic_cast<const AndInstruction *>(program->instructions[0]);
+  ASSERT_NE(and_inst, nullptr);
+  EXPECT_EQ(and_inst->lhs, a);
+  EXPECT_EQ(and_inst->rhs, b);
+}
+
+TEST(PeepholeTest, mux_and_full_slice) {
+  ProgramBuilder builder;
+  auto c = builder.add_register(1, "c", RIF_INPUT);
+  auto a = builder.add_register(8, "a", RIF_INPUT);
+  auto s = builder.add_register(8, "s");
+  auto o = builder.add_register(8, "o", RIF_OUTPUT);
+  builder.add_slice(s, 0, 7, a);
+  builder.add_mux(o, c, s, a);
+  auto program = builder.build();
+
+  // SLICE 0 7 a is a, so the MUX selects between the same values.
+  PeepholePass pass;
+  EXPECT_TRUE(pass.run(program));
+  ASSERT_EQ(program->instructions.size(), 1);
+  const auto *load = dynamic_cast<const LoadInstruction *>(program->instructions[0]);
+  ASSERT_NE(load, nullptr);
+  EXPECT_EQ(load->input, a);
+}
+
+TEST(PeepholeTest, constant_folding_fixed_point) {
+  // o = AND a (XOR (NOT 0101) 1010), that is AND a 0000 then 0000
+  ProgramBuilder builder;
+  auto a = builder.add_register(4, "a", RIF_INPUT);
+  auto k1 = builder.add_register(4);
+  auto k2 = builder.add_register(4);
+  auto n = builder.add_register(4);
+  auto x = builder.add_register(4);
+  auto o = builder.add_register(4, "o", RIF_OUTPUT);
+  builder.add_const(k1, 0b0101);
+  builder.add_const(k2, 0b1010);
+  builder.add_not(n, k1);
+  builder.add_xor(x, n, k2);
+  builder.add_and(o, a, x);
+  auto program = builder.build();
+
+  PeepholePass pass;
+  EXPECT_TRUE(pass.run(program));
+  ASSERT_EQ(program->instructions.size(), 1);
+  const auto *constant = dynamic_cast<const ConstInstruction *>(program->instructions[0]);
+  ASSERT_NE(constant, nullptr);
+  EXPECT_EQ(constant->value, 0);
+}
+
+TEST(PeepholeTest, registers_are_not_folded) {
+  // o = REG k where k is constant, at the first cycle o is 0.
+  ProgramBuilder builder;
+  auto k = builder.add_register(1);
+  auto o = builder.add_register(1, "o", RIF_OUTPUT);
+  builder.add_const(k, 1);
+  builder.add_reg(o, k);
+  auto program = builder.build();
+
+  PeepholePass pass;
+  EXPECT_FALSE(pass.run(program));
+
+  Simulator simulator(program);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(o), 0);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(o), 1);
+}
+
+TEST(PeepholeTest, copy_propagation) {
+  ProgramBuilder builder;
+  auto a = builder.add_register(1, "a", RIF_INPUT);
+  auto b = builder.add_register(1, "b", RIF_INPUT);
+  auto t = builder.add_register(1, "t");
+  auto o = builder.add_register(1, "o", RIF_OUTPUT);
+  builder.add_load(t, a);
+  builder.add_or(o, t, b);
+  auto program = builder.build();
+
+  PeepholePass pass;
+  EXPECT_TRUE(pass.run(program));
+  ASSERT_EQ(program->instructions.size(), 1);
+  const auto *or_inst = dynamic_cast<const OrInstruction *>(program->instructions[0]);
+  ASSERT_NE(or_inst, nullptr);
+  EXPECT_EQ(or_inst->lhs, a);
+  EXPECT_EQ(or_inst->rhs, b);
+}
@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+
+#include "dependency_graph.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "passes/lazy_mux.hpp"
+#include "passes/pass.hpp"
+#include "passes/register_allocation.hpp"
+#include "passes/register_renumbering.hpp"
+#include "simulator/simulator.hpp"
+
+static void schedule(const std::shared_ptr<Program> &program) {
+  ReportManager report_manager;
+  DependencyGraph graph = DependencyGraph::build(program);
+  graph.schedule(report_manager);
+}
+
+TEST(RegisterAllocationTest, temporaries_are_shared) {
+  // o = NOT (NOT (NOT (NOT a))) and p = AND (REG q) s where q = NOT s and s = SELECT 0 a.
+  ProgramBuilder builder;
+  auto a = builder.add_register(4, "a", RIF_INPUT);
+  auto o = builder.add_register(4, "o", RIF_OUTPUT);
+  auto p = builder.add_register(1, "p", RIF_OUTPUT);
+  auto t1 = builder.add_register(4, "t1");
+  auto t2 = builder.add_register(4, "t2");
+  auto t3 = builder.add_register(4, "t3");
+  auto s = builder.add_register(1, "s");
+  auto q = builder.add_register(1, "q");
+  auto u = builder.add_register(1, "u");
+  builder.add_not(t1, a);
+  builder.add_not(t2, t1);
+  builder.add_not(t3, t2);
+  builder.add_not(o, t3);
+  builder.add_select(s, 0, a);
+  builder.add_not(q, s);
+  builder.add_reg(u, q);
+  builder.add_and(p, u, s);
+  auto program = builder.build();
+  schedule(program);
+
+  RegisterAllocationPass pass;
+  EXPECT_TRUE(pass.run(program));
+  // The three 4-bit temporaries share a register, q is read in the next cycle.
+  EXPECT_EQ(program->registers.size(), 7);
+  EXPECT_FALSE(program->find_register("t1").has_value());
+  EXPECT_TRUE(program->find_register("q").has_value());
+  EXPECT_EQ(program->get_inputs().size(), 1);
+  EXPECT_EQ(program->get_outputs().size(), 2);
+
+  // Nothing left to share.
+  EXPECT_FALSE(pass.run(program));
+
+  Simulator simulator(program);
+  const auto new_a = *program->find_register("a");
+  const auto new_o = *program->find_register("o");
+  const auto new_p = *program->find_register("p");
+  simulator.set_register(new_a, 0b1001);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(new_o), 0b1001);
+  EXPECT_EQ(simulator.get_register(new_p), 0);
+  simulator.set_register(new_a, 0b0101);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(new_o), 0b0101);
+  EXPECT_EQ(simulator.get_register(new_p), 0);
+  simulator.set_register(new_a, 0b0010);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(new_p), 0);
+  simulator.set_register(new_a, 0b0001);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(new_p), 1); // q was one in the previous cycle
+}
+
+TEST(RegisterAllocationTest, bodies_are_kept) {
+  // o = MUX s a (NOT (AND a b)), with the second operand guarded.
+  ProgramBuilder builder;
+  auto o = builder.add_register(1, "o", RIF_OUTPUT);
+  auto s = builder.add_register(1, "s", RIF_INPUT);
+  auto a = builder.add_register(1, "a", RIF_INPUT);
+  auto b = builder.add_register(1, "b", RIF_INPUT);
+  auto t = builder.add_register(1, "t");
+  auto n = builder.add_register(1, "n");
+  builder.add_and(t, a, b);
+  builder.add_not(n, t);
+  builder.add_mux(o, s, a, n);
+  auto program = builder.build();
+
+  LazyMuxPass lazy_mux;
+  ASSERT_TRUE(lazy_mux.run(program));
+  schedule(program);
+
+  RegisterAllocationPass pass;
+  EXPECT_FALSE(pass.run(program));
+  EXPECT_EQ(program->registers.size(), 6);
+}
+
+static std::shared_ptr<Program> parse(const char *source) {
+  ReportManager report_manager;
+  Lexer lexer(report_manager, source);
+  Parser parser(report_manager, lexer);
+  return parser.parse_program();
+}
+
+TEST(RegisterAllocationTest, same_results_as_unoptimized) {
+  const char *source = R"(
+INPUT a, b, s
+OUTPUT o, p, q
+VAR a : 4, b : 4, s, o : 4, p, q : 4, t1 : 4, t2 : 4, t3 : 4, t4 : 4, r : 4, n : 4,
+    x : 4, y : 4, c, d, e, f, g, h, k : 4, m : 4
+IN
+t1 = ADD a r
+t2 = XOR t1 b
+t3 = AND t2 n
+t4 = MUX s t3 t2
+r = REG t4
+n = NOT r
+x = SUB t4 a
+y = OR x t1
+k = MUL y n
+m = REG k
+o = ADD m t3
+c = SELECT 0 a
+d = SELECT 1 b
+e = XOR c d
+f = AND e s
+g = REG f
+h = NOR g e
+p = XNOR h f
+q = MUX h x y
+)";
+
+  // The same pipeline as `-O2`.
+  auto reference = parse(source);
+  auto program = parse(source);
+  PassManager pass_manager;
+  pass_manager.add_default_passes(2);
+  pass_manager.run(program);
+  schedule(reference);
+  schedule(program);
+  RegisterAllocationPass allocation_pass;
+  allocation_pass.run(program);
+  RegisterRenumberingPass renumbering_pass;
+  renumbering_pass.run(program);
+  EXPECT_LT(program->registers.size(), reference->registers.size());
+
+  Simulator reference_simulator(reference);
+  Simulator simulator(program);
+  reg_value_t seed = 1;
+  for (int cycle = 0; cycle < 64; ++cycle) {
+    for (const auto *name : {"a", "b", "s"}) {
+      seed = seed * 6364136223846793005 + 1442695040888963407;
+      reference_simulator.set_register(*reference->find_register(name), seed >> 40);
+      simulator.set_register(*program->find_register(name), seed >> 40);
+    }
+
+    reference_simulator.cycle();
+    simulator.cycle();
+    for (const auto *name : {"o", "p", "q"}) {
+      EXPECT_EQ(simulator.get_register(*program->find_register(name)),
+                reference_simulator.get_register(*reference->find_register(name)))
+          << "for " << name << " at cycle " << cycle;
+    }
+  }
+}
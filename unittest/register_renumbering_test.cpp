@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include "dependency_graph.hpp"
+#include "passes/lazy_mux.hpp"
+#include "passes/register_renumbering.hpp"
+#include "simulator/simulator.hpp"
+
+static void schedule(const std::shared_ptr<Program> &program) {
+  ReportManager report_manager;
+  DependencyGraph graph = DependencyGraph::build(program);
+  graph.schedule(report_manager);
+}
+
+TEST(RegisterRenumberingTest, layout) {
+  // The temporaries are declared in the reverse order of their use.
+  ProgramBuilder builder;
+  auto t2 = builder.add_register(4, "t2");
+  auto t1 = builder.add_register(4, "t1");
+  auto o = builder.add_register(4, "o", RIF_OUTPUT);
+  auto r = builder.add_register(4, "r");
+  auto a = builder.add_register(4, "a", RIF_INPUT);
+  auto b = builder.add_register(4, "b", RIF_INPUT);
+  builder.add_and(t1, a, b);
+  builder.add_not(t2, t1);
+  builder.add_reg(r, t2);
+  builder.add_xor(o, r, a);
+  auto program = builder.build();
+  schedule(program);
+
+  RegisterRenumberingPass pass;
+  EXPECT_TRUE(pass.run(program));
+  std::vector<std::string> names;
+  for (reg_index_t i = 0; i < program->registers.size(); ++i)
+    names.emplace_back(program->registers.get_name({i}));
+  const std::vector<std::string> expected = {"a", "b", "o", "t2", "t1", "r"};
+  EXPECT_EQ(names, expected);
+  EXPECT_EQ(program->get_inputs(), (std::vector<reg_t>{{0}, {1}}));
+  EXPECT_EQ(program->get_outputs(), (std::vector<reg_t>{{2}}));
+  EXPECT_EQ(program->find_register("t1"), reg_t{4});
+  EXPECT_EQ(program->registers.get_flags({0}), RIF_INPUT);
+  EXPECT_EQ(program->registers.get_flags({2}), RIF_OUTPUT);
+
+  const auto *and_instruction = dynamic_cast<const AndInstruction *>(program->instructions.front());
+  ASSERT_NE(and_instruction, nullptr);
+  EXPECT_EQ(and_instruction->output, reg_t{4});
+  EXPECT_EQ(and_instruction->lhs, reg_t{0});
+  EXPECT_EQ(and_instruction->rhs, reg_t{1});
+
+  // Already renumbered.
+  EXPECT_FALSE(pass.run(program));
+
+  Simulator simulator(program);
+  simulator.set_register(reg_t{0}, 0b1100);
+  simulator.set_register(reg_t{1}, 0b1010);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(reg_t{2}), 0b1100);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(reg_t{2}), 0b1100 ^ 0b0111);
+}
+
+TEST(RegisterRenumberingTest, bodies_are_renamed) {
+  // o = MUX s a (NOT (AND a b)), with the second operand guarded.
+  ProgramBuilder builder;
+  auto t = builder.add_register(1, "t");
+  auto n = builder.add_register(1, "n");
+  auto o = builder.add_register(1, "o", RIF_OUTPUT);
+  auto s = builder.add_register(1, "s", RIF_INPUT);
+  auto a = builder.add_register(1, "a", RIF_INPUT);
+  auto b = builder.add_register(1, "b", RIF_INPUT);
+  builder.add_and(t, a, b);
+  builder.add_not(n, t);
+  builder.add_mux(o, s, a, n);
+  auto program = builder.build();
+
+  LazyMuxPass lazy_mux;
+  ASSERT_TRUE(lazy_mux.run(program));
+  schedule(program);
+
+  RegisterRenumberingPass pass;
+  EXPECT_TRUE(pass.run(program));
+  schedule(program);
+
+  Simulator simulator(program);
+  const auto new_s = *program->find_register("s");
+  const auto new_a = *program->find_register("a");
+  const auto new_b = *program->find_register("b");
+  const auto new_o = *program->find_register("o");
+  for (reg_value_t value = 0; value < 8; ++value) {
+    simulator.set_register(new_s, value & 1);
+    simulator.set_register(new_a, (value >> 1) & 1);
+    simulator.set_register(new_b, (value >> 2) & 1);
+    simulator.cycle();
+    const auto expected = (value & 1) ? !((value >> 1) & (value >> 2) & 1) : (value >> 1) & 1;
+    EXPECT_EQ(simulator.get_register(new_o) & 1, expected) << "for inputs " << value;
+  }
+}
@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+
+#include "dependency_graph.hpp"
+#include "passes/sequential_redundancy.hpp"
+#include "simulator/simulator.hpp"
+
+#include <algorithm>
+
+static void schedule(const std::shared_ptr<Program> &program) {
+  ReportManager report_manager;
+  DependencyGraph graph = DependencyGraph::build(program);
+  graph.schedule(report_manager);
+}
+
+/// Returns the instruction defining \a reg in \a program, or null.
+static const Instruction *find_definition(const std::shared_ptr<Program> &program, reg_t reg) {
+  for (const auto *instruction : program->instructions) {
+    if (instruction->output == reg)
+      return instruction;
+  }
+  return nullptr;
+}
+
+/// Returns the count of `REG` instructions in \a program.
+static std::size_t count_registers(const std::shared_ptr<Program> &program) {
+  return std::ranges::count_if(program->instructions, [](const Instruction *instruction) {
+    return dynamic_cast<const RegInstruction *>(instruction) != nullptr;
+  });
+}
+
+TEST(SequentialRedundancyTest, duplicated_counters) {
+  // Two counters incremented when en is one, o = XOR c1 c2 is always zero.
+  ProgramBuilder builder;
+  auto en = builder.add_register(1, "en", RIF_INPUT);
+  auto o = builder.add_register(4, "o", RIF_OUTPUT);
+  auto one = builder.add_register(4);
+  builder.add_const(one, 1);
+  reg_t counters[2];
+  for (auto &c : counters) {
+    c = builder.add_register(4);
+    auto next = builder.add_register(4);
+    auto d = builder.add_register(4);
+    builder.add_add(next, c, one);
+    builder.add_mux(d, en, c, next);
+    builder.add_reg(c, d);
+  }
+  builder.add_xor(o, counters[0], counters[1]);
+  auto program = builder.build();
+
+  SequentialRedundancyPass pass;
+  EXPECT_TRUE(pass.run(program));
+  EXPECT_EQ(count_registers(program), 1);
+  const auto *xor_instruction = dynamic_cast<const XorInstruction *>(find_definition(program, o));
+  ASSERT_NE(xor_instruction, nullptr);
+  EXPECT_EQ(xor_instruction->lhs, xor_instruction->rhs);
+  schedule(program);
+
+  Simulator simulator(program);
+  for (reg_value_t i = 0; i < 20; ++i) {
+    simulator.set_register(en, i % 3 != 0);
+    simulator.cycle();
+    EXPECT_EQ(simulator.get_register(o) & 0xF, 0);
+  }
+}
+
+TEST(SequentialRedundancyTest, constant_register) {
+  // s = REG (AND s a) never leaves its initial zero state.
+  ProgramBuilder builder;
+  auto a = builder.add_register(1, "a", RIF_INPUT);
+  auto s = builder.add_register(1, "s", RIF_OUTPUT);
+  auto d = builder.add_register(1);
+  builder.add_and(d, s, a);
+  builder.add_reg(s, d);
+  auto program = builder.build();
+
+  SequentialRedundancyPass pass;
+  EXPECT_TRUE(pass.run(program));
+  const auto *constant = dynamic_cast<const ConstInstruction *>(find_definition(program, s));
+  ASSERT_NE(constant, nullptr);
+  EXPECT_EQ(constant->value, 0);
+  EXPECT_EQ(program->instructions.size(), 1);
+}
+
+TEST(SequentialRedundancyTest, equal_outputs_are_kept_defined) {
+  // q1 = REG a and q2 = REG a are both outputs.
+  ProgramBuilder builder;
+  auto a = builder.add_register(8, "a", RIF_INPUT);
+  auto q1 = builder.add_register(8, "q1", RIF_OUTPUT);
+  auto q2 = builder.add_register(8, "q2", RIF_OUTPUT);
+  builder.add_reg(q1, a);
+  builder.add_reg(q2, a);
+  auto program = builder.build();
+
+  SequentialRedundancyPass pass;
+  EXPECT_TRUE(pass.run(program));
+  EXPECT_EQ(count_registers(program), 1);
+  const auto *load = dynamic_cast<const LoadInstruction *>(find_definition(program, q2));
+  ASSERT_NE(load, nullptr);
+  EXPECT_EQ(load->input, q1);
+}
+
+TEST(SequentialRedundancyTest, different_registers_are_kept) {
+  // The registers only differ at some cycles: q1 = REG a, q2 = REG (AND a b).
+  ProgramBuilder builder;
+  auto a = builder.add_register(1, "a", RIF_INPUT);
+  auto b = builder.add_register(1, "b", RIF_INPUT);
+  auto q1 = builder.add_register(1, "q1", RIF_OUTPUT);
+  auto q2 = builder.add_register(1, "q2", RIF_OUTPUT);
+  auto t = builder.add_register(1);
+  builder.add_reg(q1, a);
+  builder.add_and(t, a, b);
+  builder.add_reg(q2, t);
+  auto program = builder.build();
+
+  SequentialRedundancyPass pass;
+  EXPECT_FALSE(pass.run(program));
+  EXPECT_EQ(count_registers(program), 2);
+}
+
+TEST(SequentialRedundancyTest, non_inductive_candidates_are_split) {
+  // r counts from zero and o = REG (EQ r 200) is zero during the first 201
+  // cycles, so the random simulation sees a zero register. The induction fails
+  // as nothing is assumed about r.
+  ProgramBuilder builder;
+  auto o = builder.add_register(1, "o", RIF_OUTPUT);
+  auto r = builder.add_register(8);
+  auto next = builder.add_register(8);
+  auto one = builder.add_register(8);
+  auto limit = builder.add_register(8);
+  auto is_limit = builder.add_register(1);
+  builder.add_const(one, 1);
+  builder.add_const(limit, 200);
+  builder.add_add(next, r, one);
+  builder.add_reg(r, next);
+  builder.add_eq(is_limit, r, limit);
+  builder.add_reg(o, is_limit);
+  auto program = builder.build();
+
+  SequentialRedundancyPass pass;
+  EXPECT_FALSE(pass.run(program));
+  EXPECT_NE(dynamic_cast<const RegInstruction *>(find_definition(program, o)), nullptr);
+}
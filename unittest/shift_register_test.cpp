@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include "dependency_graph.hpp"
+#include "passes/shift_register.hpp"
+#include "simulator/simulator.hpp"
+
+static void schedule(const std::shared_ptr<Program> &program) {
+  ReportManager report_manager;
+  DependencyGraph graph = DependencyGraph::build(program);
+  graph.schedule(report_manager);
+}
+
+/// Returns the instruction defining \a reg in \a program, or null.
+static const Instruction *find_definition(const std::shared_ptr<Program> &program, reg_t reg) {
+  for (const auto *instruction : program->instructions) {
+    if (instruction->output == reg)
+      return instruction;
+  }
+  return nullptr;
+}
+
+TEST(ShiftRegisterTest, delay_line) {
+  // o = REG (REG (REG ... a)) with 10 stages.
+  ProgramBuilder builder;
+  auto a = builder.add_register(8, "a", RIF_INPUT);
+  auto o = builder.add_register(8, "o", RIF_OUTPUT);
+  auto previous = a;
+  for (int i = 0; i < 10; ++i) {
+    auto stage = (i == 9) ? o : builder.add_register(8);
+    builder.add_reg(stage, previous);
+    previous = stage;
+  }
+  auto program = builder.build();
+
+  ShiftRegisterPass pass;
+  EXPECT_TRUE(pass.run(program));
+  ASSERT_EQ(program->instructions.size(), 1);
+  const auto *delay = dynamic_cast<const DelayInstruction *>(find_definition(program, o));
+  ASSERT_NE(delay, nullptr);
+  EXPECT_EQ(delay->input, a);
+  EXPECT_EQ(delay->depth, 10);
+  schedule(program);
+
+  Simulator simulator(program);
+  for (reg_value_t i = 0; i < 30; ++i) {
+    simulator.set_register(a, i + 1);
+    simulator.cycle();
+    EXPECT_EQ(simulator.get_register(o), i >= 10 ? i - 9 : 0);
+  }
+}
+
+TEST(ShiftRegisterTest, taps) {
+  // Intermediate stages used elsewhere all read the same delay line.
+  ProgramBuilder builder;
+  auto a = builder.add_register(4, "a", RIF_INPUT);
+  auto r1 = builder.add_register(4, "r1", RIF_OUTPUT);
+  auto r2 = builder.add_register(4, "r2");
+  auto r3 = builder.add_register(4, "r3", RIF_OUTPUT);
+  auto o = builder.add_register(4, "o", RIF_OUTPUT);
+  builder.add_reg(r1, a);
+  builder.add_reg(r2, r1);
+  builder.add_reg(r3, r2);
+  builder.add_xor(o, r2, a);
+  auto program = builder.build();
+
+  ShiftRegisterPass pass;
+  EXPECT_TRUE(pass.run(program));
+  EXPECT_NE(dynamic_cast<const RegInstruction *>(find_definition(program, r1)), nullptr);
+  const auto *delay = dynamic_cast<const DelayInstruction *>(find_definition(program, r3));
+  ASSERT_NE(delay, nullptr);
+  EXPECT_EQ(delay->input, a);
+  EXPECT_EQ(delay->depth, 3);
+  schedule(program);
+
+  Simulator simulator(program);
+  const reg_value_t inputs[] = {3, 9, 12, 5, 0, 7, 15};
+  for (size_t i = 0; i < std::size(inputs); ++i) {
+    simulator.set_register(a, inputs[i]);
+    simulator.cycle();
+    const auto delayed = [&](size_t depth) { return i >= depth ? inputs[i - depth] : 0; };
+    EXPECT_EQ(simulator.get_register(r1), delayed(1));
+    EXPECT_EQ(simulator.get_register(r3), delayed(3));
+    EXPECT_EQ(simulator.get_register(o), delayed(2) ^ inputs[i]);
+  }
+}
+
+TEST(ShiftRegisterTest, loop) {
+  // a = REG c, b = REG a, c = REG b is a ring counter of period 3.
+  ProgramBuilder builder;
+  auto a = builder.add_register(1, "a", RIF_OUTPUT);
+  auto b = builder.add_register(1, "b");
+  auto c = builder.add_register(1, "c");
+  auto na = builder.add_register(1, "na");
+  builder.add_reg(a, c);
+  builder.add_reg(b, na);
+  builder.add_not(na, a);
+  builder.add_reg(c, b);
+  auto program = builder.build();
+
+  ShiftRegisterPass pass;
+  EXPECT_TRUE(pass.run(program));
+  schedule(program);
+
+  // a(t) = NOT a(t - 3), starting from zero.
+  Simulator simulator(program);
+  for (reg_value_t i = 0; i < 12; ++i) {
+    simulator.cycle();
+    EXPECT_EQ(simulator.get_register(a), (i / 3) % 2);
+  }
+}
+
+TEST(ShiftRegisterTest, single_register_is_kept) {
+  ProgramBuilder builder;
+  auto a = builder.add_register(1, "a", RIF_INPUT);
+  auto o = builder.add_register(1, "o", RIF_OUTPUT);
+  builder.add_reg(o, a);
+  auto program = builder.build();
+
+  ShiftRegisterPass pass;
+  EXPECT_FALSE(pass.run(program));
+}
@@ -296,3 +296,148 @@ TEST(SimulatorTest, slice_expr) {
   EXPECT_EQ(simulator.get_register(b1), 0b10011101);
   EXPECT_EQ(simulator.get_register(b2), 1);
 }
+
+TEST(SimulatorTest, arithmetic_expr) {
+  ProgramBuilder builder;
+  auto a = builder.add_register(8, "a", RIF_INPUT);
+  auto b = builder.add_register(8, "b", RIF_INPUT);
+  auto add = builder.add_register(8, "add", RIF_OUTPUT);
+  auto sub = builder.add_register(8, "sub", RIF_OUTPUT);
+  auto mul = builder.add_register(8, "mul", RIF_OUTPUT);
+  auto eq = builder.add_register(1, "eq", RIF_OUTPUT);
+  auto lt = builder.add_register(1, "lt", RIF_OUTPUT);
+  builder.add_add(add, a, b);
+  builder.add_sub(sub, a, b);
+  builder.add_mul(mul, a, b);
+  builder.add_eq(eq, a, b);
+  builder.add_lt(lt, a, b);
+  auto program = builder.build();
+  ASSERT_NE(program, nullptr);
+
+  // no scheduling needed.
+
+  Simulator simulator(program);
+  simulator.set_register(a, 200);
+  simulator.set_register(b, 100);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(add), 44);  // modulo 256
+  EXPECT_EQ(simulator.get_register(sub), 100);
+  EXPECT_EQ(simulator.get_register(mul), 32);  // 20000 modulo 256
+  EXPECT_EQ(simulator.get_register(eq), 0);
+  EXPECT_EQ(simulator.get_register(lt), 0);
+
+  simulator.set_register(a, 3);
+  simulator.set_register(b, 250);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(sub), 9);
+  EXPECT_EQ(simulator.get_register(lt), 1); // unsigned comparison
+}
+
+TEST(SimulatorTest, shift_expr) {
+  ProgramBuilder builder;
+  auto a = builder.add_register(8, "a", RIF_INPUT);
+  auto n = builder.add_register(4, "n", RIF_INPUT);
+  auto shl = builder.add_register(8, "shl", RIF_OUTPUT);
+  auto shr = builder.add_register(8, "shr", RIF_OUTPUT);
+  auto asr = builder.add_register(8, "asr", RIF_OUTPUT);
+  builder.add_shl(shl, a, n);
+  builder.add_shr(shr, a, n);
+  builder.add_asr(asr, a, n);
+  auto program = builder.build();
+  ASSERT_NE(program, nullptr);
+
+  // no scheduling needed.
+
+  Simulator simulator(program);
+  simulator.set_register(a, 0b10011101);
+  simulator.set_register(n, 2);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(shl), 0b01110100);
+  EXPECT_EQ(simulator.get_register(shr), 0b00100111);
+  EXPECT_EQ(simulator.get_register(asr), 0b11100111);
+
+  // Shifting by the bus size or more.
+  simulator.set_register(n, 12);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(shl), 0);
+  EXPECT_EQ(simulator.get_register(shr), 0);
+  EXPECT_EQ(simulator.get_register(asr), 0b11111111);
+
+  simulator.set_register(a, 0b01011101);
+  simulator.set_register(n, 3);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(asr), 0b00001011);
+}
+
+TEST(SimulatorTest, reduce_expr) {
+  ProgramBuilder builder;
+  auto a = builder.add_register(4, "a", RIF_INPUT);
+  auto any = builder.add_register(1, "any", RIF_OUTPUT);
+  auto all = builder.add_register(1, "all", RIF_OUTPUT);
+  auto not_a = builder.add_register(4, "not_a");
+  auto none = builder.add_register(1, "none", RIF_OUTPUT);
+  builder.add_reduce_or(any, a);
+  builder.add_reduce_and(all, a);
+  // The high bits of `NOT a` must not be seen by the reduction.
+  builder.add_not(not_a, a);
+  builder.add_reduce_and(none, not_a);
+  auto program = builder.build();
+  ASSERT_NE(program, nullptr);
+
+  // no scheduling needed.
+
+  Simulator simulator(program);
+  const std::tuple<reg_value_t, reg_value_t, reg_value_t, reg_value_t> cases[] = {
+      {0b0000, 0, 0, 1}, {0b0100, 1, 0, 0}, {0b1111, 1, 1, 0}};
+  for (const auto &[value, expected_any, expected_all, expected_none] : cases) {
+    simulator.set_register(a, value);
+    simulator.cycle();
+    EXPECT_EQ(simulator.get_register(any), expected_any);
+    EXPECT_EQ(simulator.get_register(all), expected_all);
+    EXPECT_EQ(simulator.get_register(none), expected_none);
+  }
+}
+
+TEST(SimulatorTest, pack_bits) {
+  ProgramBuilder builder;
+  auto a = builder.add_register(1, "a", RIF_INPUT);
+  auto b = builder.add_register(1, "b", RIF_INPUT);
+  auto s = builder.add_register(1, "s", RIF_INPUT);
+  auto w = builder.add_register(4, "w", RIF_INPUT);
+  auto n = builder.add_register(1, "n", RIF_OUTPUT);
+  auto c = builder.add_register(2, "c", RIF_OUTPUT);
+  auto q = builder.add_register(1, "q", RIF_OUTPUT);
+  auto g = builder.add_register(1, "g", RIF_OUTPUT);
+  auto x = builder.add_register(1, "x");
+  auto r = builder.add_register(1, "r");
+  auto m = builder.add_register(1, "m");
+  auto e = builder.add_register(1, "e");
+  builder.add_xor(x, a, b);
+  builder.add_reg(r, x);
+  builder.add_mux(m, s, r, a);
+  builder.add_not(n, m);
+  builder.add_select(e, 2, w);
+  builder.add_concat(c, a, b);
+  builder.add_and(q, n, e);
+  builder.add_enabled_reg(g, s, q);
+  auto program = builder.build();
+  ASSERT_NE(program, nullptr);
+
+  // no scheduling needed.
+
+  // The packed single bit registers must be simulated as the unpacked ones.
+  Simulator simulator(program);
+  Simulator packed_simulator(program, true);
+  for (reg_value_t inputs = 0; inputs < 64; ++inputs) {
+    for (auto *sim : {&simulator, &packed_simulator}) {
+      sim->set_register(a, inputs & 1);
+      sim->set_register(b, (inputs >> 1) & 1);
+      sim->set_register(s, (inputs >> 2) & 1);
+      sim->set_register(w, inputs >> 2);
+      sim->cycle();
+    }
+
+    for (const auto output : {n, c, q, g, x, r})
+      EXPECT_EQ(packed_simulator.get_register(output), simulator.get_register(output));
+  }
+}
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include "lexer.hpp"
+#include "source_file.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+/// Writes \a content to a temporary file and returns its path.
+static std::string write_temporary_file(std::string_view name, std::string_view content) {
+  const auto path = std::filesystem::temp_directory_path() / name;
+  std::ofstream stream(path, std::ios_base::binary);
+  stream.write(content.data(), static_cast<std::streamsize>(content.size()));
+  return path.string();
+}
+
+TEST(SourceFileTest, content) {
+  // The sizes around a page, whose NUL sentinel is in an extra page.
+  for (const std::size_t size : {0, 1, 4095, 4096, 4097, 65536}) {
+    const std::string content(size, 'a');
+    const auto path = write_temporary_file("netlist_source_file_test.net", content);
+    auto file = SourceFile::open(path);
+    ASSERT_TRUE(file.has_value());
+    EXPECT_EQ(file->get_content(), content);
+    EXPECT_EQ(file->get_content().data()[size], '\0');
+
+    // The content does not move with the SourceFile.
+    const auto *data = file->get_content().data();
+    const SourceFile moved = std::move(*file);
+    EXPECT_EQ(moved.get_content().data(), data);
+    std::filesystem::remove(path);
+  }
+}
+
+TEST(SourceFileTest, discard) {
+  std::string content;
+  for (int i = 0; i < 100000; ++i)
+    content += "t = NOT a\n";
+  const auto path = write_temporary_file("netlist_source_file_discard_test.net", content);
+  auto file = SourceFile::open(path);
+  ASSERT_TRUE(file.has_value());
+
+  // The discarded pages are read again from the file.
+  file->discard(content.size() / 2);
+  EXPECT_EQ(file->get_content(), content);
+  file->discard(content.size());
+  EXPECT_EQ(file->get_content(), content);
+  EXPECT_EQ(file->get_content().data()[content.size()], '\0');
+  std::filesystem::remove(path);
+}
+
+TEST(SourceFileTest, missing_file) {
+  EXPECT_FALSE(SourceFile::open("netlist_this_file_does_not_exist.net").has_value());
+}
+
+TEST(SourceFileTest, lexing) {
+  const auto path = write_temporary_file("netlist_source_file_lexing_test.net", "a = b");
+  auto file = SourceFile::open(path);
+  ASSERT_TRUE(file.has_value());
+
+  ReportManager report_manager;
+  Lexer lexer(report_manager, file->get_content());
+  Token token;
+  lexer.tokenize(token);
+  EXPECT_EQ(token.kind, TokenKind::IDENTIFIER);
+  // The tokens refer to the file content.
+  EXPECT_EQ(token.spelling.data(), file->get_content().data());
+  lexer.tokenize(token);
+  lexer.tokenize(token);
+  EXPECT_EQ(token.spelling, "b");
+  lexer.tokenize(token);
+  EXPECT_EQ(token.kind, TokenKind::EOI);
+  EXPECT_EQ(token.position.offset, 5);
+  std::filesystem::remove(path);
+}
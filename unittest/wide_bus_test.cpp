@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+
+#include "dependency_graph.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "passes/pass.hpp"
+#include "simulator/simulator.hpp"
+
+static std::shared_ptr<Program> parse(const char *source, int optimization_level = 0) {
+  ReportManager report_manager;
+  Lexer lexer(report_manager, source);
+  Parser parser(report_manager, lexer);
+  auto program = parser.parse_program();
+  if (optimization_level > 0) {
+    PassManager pass_manager;
+    pass_manager.add_default_passes(optimization_level);
+    pass_manager.run(program);
+  }
+
+  DependencyGraph graph = DependencyGraph::build(program);
+  graph.schedule(report_manager);
+  return program;
+}
+
+/// A 128-bit value, the lowest limb first.
+using Value128 = std::array<reg_value_t, 2>;
+
+static void set_bus(Simulator &simulator, std::string_view name, const Value128 &value) {
+  const auto program = simulator.get_program();
+  simulator.set_register(*program->find_register(name), value[0]);
+  simulator.set_register(*program->find_register(WideBusBuilder::get_limb_name(name, 64)), value[1]);
+}
+
+static Value128 get_bus(const Simulator &simulator, std::string_view name) {
+  const auto program = simulator.get_program();
+  return {simulator.get_register(*program->find_register(name)),
+          simulator.get_register(*program->find_register(WideBusBuilder::get_limb_name(name, 64)))};
+}
+
+TEST(WideBusTest, limbs) {
+  const char *source = R"(
+INPUT a
+OUTPUT o
+VAR a : 130, o : 130
+IN
+o = NOT a
+)";
+
+  auto program = parse(source);
+  EXPECT_EQ(program->get_inputs().size(), 3);
+  EXPECT_EQ(program->registers.get_bus_size(*program->find_register("a")), 64);
+  EXPECT_EQ(program->registers.get_bus_size(*program->find_register("a'64")), 64);
+  EXPECT_EQ(program->registers.get_bus_size(*program->find_register("a'128")), 2);
+  EXPECT_EQ(program->instructions.size(), 3);
+}
+
+TEST(WideBusTest, arithmetic) {
+  const char *source = R"(
+INPUT a, b
+OUTPUT s, d, e, l, x, m
+VAR a : 128, b : 128, s : 128, d : 128, e, l, x : 128, m : 128
+IN
+s = ADD a b
+d = SUB a b
+e = EQ a b
+l = LT a b
+x = XNOR a b
+m = MUX l a b
+)";
+
+  const Value128 values[] = {
+      {0, 0}, {~reg_value_t(0), 0}, {1, 0}, {0, 1}, {~reg_value_t(0), ~reg_value_t(0)}, {42, 7}, {41, 7}, {42, 8},
+  };
+
+  for (const int optimization_level : {0, 2}) {
+    auto program = parse(source, optimization_level);
+    Simulator simulator(program);
+    for (const auto &a : values) {
+      for (const auto &b : values) {
+        set_bus(simulator, "a", a);
+        set_bus(simulator, "b", b);
+        simulator.cycle();
+
+        const reg_value_t carry = a[0] + b[0] < a[0];
+        const reg_value_t borrow = a[0] < b[0];
+        const bool less = a[1] < b[1] || (a[1] == b[1] && a[0] < b[0]);
+        EXPECT_EQ(get_bus(simulator, "s"), (Value128{a[0] + b[0], a[1] + b[1] + carry}));
+        EXPECT_EQ(get_bus(simulator, "d"), (Value128{a[0] - b[0], a[1] - b[1] - borrow}));
+        EXPECT_EQ(simulator.get_register(*program->find_register("e")), a == b);
+        EXPECT_EQ(simulator.get_register(*program->find_register("l")), less);
+        EXPECT_EQ(get_bus(simulator, "x"), (Value128{~(a[0] ^ b[0]), ~(a[1] ^ b[1])}));
+        EXPECT_EQ(get_bus(simulator, "m"), less ? b : a);
+      }
+    }
+  }
+}
+
+TEST(WideBusTest, bits) {
+  const char *source = R"(
+INPUT a
+OUTPUT c, s, t, b, r1, r2
+VAR a : 128, k : 128, c : 128, s : 40, t : 128, b, r1, r2
+IN
+k = 0x0123456789abcdef00112233445566ff
+c = CONCAT s k
+s = SLICE 60 99 k
+t = SLICE 8 135 a
+b = SELECT 127 a
+r1 = REDOR a
+r2 = REDAND a
+)";
+
+  auto program = parse(source);
+  Simulator simulator(program);
+  set_bus(simulator, "a", {0x8000000000000001, 0x8000000000000000});
+  simulator.cycle();
+
+  const reg_value_t k_low = 0x00112233445566ff;
+  const reg_value_t k_high = 0x0123456789abcdef;
+  const reg_value_t s = (k_low >> 60) | ((k_high & 0xfffffffff) << 4);
+  EXPECT_EQ(simulator.get_register(*program->find_register("s")), s);
+  EXPECT_EQ(get_bus(simulator, "c"), (Value128{s | (k_low << 40), (k_low >> 24) | (k_high << 40)}));
+  // The bits past the end of a are zero.
+  EXPECT_EQ(get_bus(simulator, "t"), (Value128{0x0080000000000000, 0x0080000000000000}));
+  EXPECT_EQ(simulator.get_register(*program->find_register("b")), 1);
+  EXPECT_EQ(simulator.get_register(*program->find_register("r1")), 1);
+  EXPECT_EQ(simulator.get_register(*program->find_register("r2")), 0);
+
+  set_bus(simulator, "a", {~reg_value_t(0), ~reg_value_t(0)});
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(*program->find_register("r2")), 1);
+}
+
+TEST(WideBusTest, constants) {
+  const char *source = R"(
+INPUT
+OUTPUT b, h, d
+VAR b : 65, h : 68, d : 128
+IN
+b = 10000000000000000000000000000000000000000000000000000000000000001
+h = 0xf0000000000000001
+d = 0d340282366920938463463374607431768211455 : 128
+)";
+
+  auto program = parse(source);
+  Simulator simulator(program);
+  simulator.cycle();
+  EXPECT_EQ(get_bus(simulator, "b"), (Value128{1, 1}));
+  EXPECT_EQ(get_bus(simulator, "h"), (Value128{1, 0xf}));
+  EXPECT_EQ(get_bus(simulator, "d"), (Value128{~reg_value_t(0), ~reg_value_t(0)}));
+}
+
+TEST(WideBusTest, ram) {
+  const char *source = R"(
+INPUT we, wa, ra, d
+OUTPUT o
+VAR we, wa : 2, ra : 2, d : 128, o : 128
+IN
+o = RAM 2 128 ra we wa d
+)";
+
+  auto program = parse(source);
+  EXPECT_EQ(program->memories.size(), 2);
+
+  Simulator simulator(program);
+  simulator.set_register(*program->find_register("we"), 1);
+  simulator.set_register(*program->find_register("wa"), 2);
+  set_bus(simulator, "d", {5, 6});
+  simulator.cycle();
+  simulator.set_register(*program->find_register("we"), 0);
+  simulator.set_register(*program->find_register("ra"), 2);
+  simulator.cycle();
+  EXPECT_EQ(get_bus(simulator, "o"), (Value128{5, 6}));
+}
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+
+#include "dependency_graph.hpp"
+#include "passes/pass.hpp"
+#include "passes/word_level.hpp"
+#include "simulator/simulator.hpp"
+
+#include <algorithm>
+
+static void schedule(const std::shared_ptr<Program> &program) {
+  ReportManager report_manager;
+  DependencyGraph graph = DependencyGraph::build(program);
+  graph.schedule(report_manager);
+}
+
+/// Returns the instruction defining \a reg in \a program, or null.
+static const Instruction *find_definition(const std::shared_ptr<Program> &program, reg_t reg) {
+  for (const auto *instruction : program->instructions) {
+    if (instruction->output == reg)
+      return instruction;
+  }
+  return nullptr;
+}
+
+/// Builds `o = CONCAT (op (SELECT 0 a) (SELECT 0 b)) (CONCAT ...)` for a bus of \a bus_size bits.
+template <class T>
+static void build_bit_blasted(ProgramBuilder &builder, reg_t o, reg_t a, reg_t b, bus_size_t bus_size) {
+  std::vector<reg_t> bits;
+  for (bus_size_t i = 0; i < bus_size; ++i) {
+    auto ai = builder.add_register(1);
+    auto bi = builder.add_register(1);
+    auto oi = builder.add_register(1);
+    builder.add_select(ai, i, a);
+    builder.add_select(bi, i, b);
+    if constexpr (std::is_same_v<T, AndInstruction>)
+      builder.add_and(oi, ai, bi);
+    else
+      builder.add_xor(oi, ai, bi);
+    bits.push_back(oi);
+  }
+
+  auto acc = bits.back();
+  for (bus_size_t i = bus_size - 1; i-- > 0;) {
+    auto c = (i == 0) ? o : builder.add_register(bus_size - i);
+    builder.add_concat(c, bits[i], acc);
+    acc = c;
+  }
+}
+
+TEST(WordLevelTest, bit_blasted_and) {
+  ProgramBuilder builder;
+  auto a = builder.add_register(8, "a", RIF_INPUT);
+  auto b = builder.add_register(8, "b", RIF_INPUT);
+  auto o = builder.add_register(8, "o", RIF_OUTPUT);
+  build_bit_blasted<AndInstruction>(builder, o, a, b, 8);
+  auto program = builder.build();
+
+  WordLevelPass pass;
+  EXPECT_TRUE(pass.run(program));
+  ASSERT_EQ(program->instructions.size(), 1);
+  const auto *and_inst = dynamic_cast<const AndInstruction *>(program->instructions[0]);
+  ASSERT_NE(and_inst, nullptr);
+  EXPECT_EQ(and_inst->output, o);
+  EXPECT_EQ(and_inst->lhs, a);
+  EXPECT_EQ(and_inst->rhs, b);
+}
+
+TEST(WordLevelTest, nested_operations) {
+  // o = XOR x c where x = AND a b, all bit-blasted over 4 bits.
+  ProgramBuilder builder;
+  auto a = builder.add_register(4, "a", RIF_INPUT);
+  auto b = builder.add_register(4, "b", RIF_INPUT);
+  auto c = builder.add_register(4, "c", RIF_INPUT);
+  auto x = builder.add_register(4, "x");
+  auto o = builder.add_register(4, "o", RIF_OUTPUT);
+  build_bit_blasted<AndInstruction>(builder, x, a, b, 4);
+  build_bit_blasted<XorInstruction>(builder, o, x, c, 4);
+  auto program = builder.build();
+
+  PassManager pass_manager;
+  pass_manager.add_default_passes(1);
+  EXPECT_TRUE(pass_manager.run(program));
+  EXPECT_EQ(program->instructions.size(), 2);
+  EXPECT_NE(dynamic_cast<const XorInstruction *>(find_definition(program, o)), nullptr);
+  schedule(program);
+
+  Simulator simulator(program);
+  simulator.set_register(a, 0b1100);
+  simulator.set_register(b, 0b1010);
+  simulator.set_register(c, 0b0110);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(o), 0b1110);
+}
+
+TEST(WordLevelTest, mux_and_registers) {
+  // o = CONCAT (REG (MUX s a0 b0)) (REG (MUX s a1 b1)) where ai/bi are bits of a/b in reverse order.
+  ProgramBuilder builder;
+  auto s = builder.add_register(1, "s", RIF_INPUT);
+  auto a = builder.add_register(2, "a", RIF_INPUT);
+  auto b = builder.add_register(2, "b", RIF_INPUT);
+  auto o = builder.add_register(2, "o", RIF_OUTPUT);
+  reg_t bits[2];
+  for (bus_size_t i = 0; i < 2; ++i) {
+    auto ai = builder.add_register(1);
+    auto bi = builder.add_register(1);
+    auto mi = builder.add_register(1);
+    bits[i] = builder.add_register(1);
+    builder.add_select(ai, 1 - i, a);
+    builder.add_select(bi, 1 - i, b);
+    builder.add_mux(mi, s, ai, bi);
+    builder.add_reg(bits[i], mi);
+  }
+  builder.add_concat(o, bits[0], bits[1]);
+  auto program = builder.build();
+
+  WordLevelPass pass;
+  EXPECT_TRUE(pass.run(program));
+  EXPECT_NE(dynamic_cast<const RegInstruction *>(find_definition(program, o)), nullptr);
+  EXPECT_EQ(std::ranges::count_if(program->instructions,
+                                  [](const auto *inst) { return dynamic_cast<const MuxInstruction *>(inst); }),
+            1);
+  schedule(program);
+
+  Simulator simulator(program);
+  simulator.set_register(s, 1);
+  simulator.set_register(a, 0b01);
+  simulator.set_register(b, 0b10);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(o), 0);
+  simulator.cycle();
+  EXPECT_EQ(simulator.get_register(o), 0b01);
+}
+
+TEST(WordLevelTest, shared_bits_are_kept) {
+  // The 1-bit AND of bit 0 is also an output so nothing is merged.
+  ProgramBuilder builder;
+  auto a = builder.add_register(2, "a", RIF_INPUT);
+  auto b = builder.add_register(2, "b", RIF_INPUT);
+  auto o = builder.add_register(2, "o", RIF_OUTPUT);
+  auto o0 = builder.add_register(1, "o0", RIF_OUTPUT);
+  auto a1 = builder.add_register(1);
+  auto b1 = builder.add_register(1);
+  auto a0 = builder.add_register(1);
+  auto b0 = builder.add_register(1);
+  auto o1 = builder.add_register(1);
+  builder.add_select(a0, 0, a);
+  builder.add_select(b0, 0, b);
+  builder.add_select(a1, 1, a);
+  builder.add_select(b1, 1, b);
+  builder.add_and(o0, a0, b0);
+  builder.add_and(o1, a1, b1);
+  builder.add_concat(o, o0, o1);
+  auto program = builder.build();
+
+  WordLevelPass pass;
+  EXPECT_FALSE(pass.run(program));
+}